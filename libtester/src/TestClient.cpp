@@ -92,6 +92,27 @@ void TestClient::Disconnect()
     mConnection->Close();
 }
 
+void TestClient::StopReading()
+{
+    // Stop handling the socket so data sent by the server backs up
+    mService.stop();
+
+    if(mServiceThread.joinable())
+    {
+        mServiceThread.join();
+    }
+}
+
+void TestClient::ResumeReading()
+{
+    mService.restart();
+
+    mServiceThread = std::thread([&]()
+    {
+        mService.run();
+    });
+}
+
 std::shared_ptr<libcomp::EncryptedConnection> TestClient::GetConnection()
 {
     return mConnection;
@@ -62,6 +62,9 @@ public:
 
     void Disconnect();
 
+    void StopReading();
+    void ResumeReading();
+
     bool WaitEncrypted(double& waitTime, asio::steady_timer::duration
         timeout = DEFAULT_TIMEOUT);
 
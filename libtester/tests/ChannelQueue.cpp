@@ -0,0 +1,177 @@
+/**
+ * @file libcomp/tests/ChannelQueue.cpp
+ * @ingroup libcomp
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Test the channel server send queue limits.
+ *
+ * This file is part of the COMP_hack Tester Library (libtester).
+ *
+ * Copyright (C) 2014-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+#include <PopIgnore.h>
+
+// libtester Includes
+#include <ChannelClient.h>
+#include <ServerTest.h>
+#include <TestConfig.h>
+
+// Standard C++11 Includes
+#include <chrono>
+#include <thread>
+
+using namespace libcomp;
+
+TEST(ChannelQueue, SlowClientDisconnected)
+{
+    EXPECT_SERVER(libtester::ServerConfig::SingleChannel(), []()
+    {
+        std::shared_ptr<libtester::ChannelClient> slowClient(
+            new libtester::ChannelClient);
+
+        slowClient->Login(LOGIN_USERNAME, LOGIN_PASSWORD, "CrashDummy");
+        slowClient->SendData();
+
+        std::shared_ptr<libtester::ChannelClient> client(
+            new libtester::ChannelClient);
+
+        client->Login(LOGIN_USERNAME2, LOGIN_PASSWORD2, "TheInstigator");
+        client->SendData();
+
+        // Stop reading on the first client then fill its send queue with
+        // zone chat for longer than the testing config lets data wait
+        slowClient->StopReading();
+
+        libcomp::String msg;
+        for(int i = 0; i < 30; i++)
+        {
+            msg += "Can you hear me now? ";
+        }
+
+        auto stop = std::chrono::steady_clock::now() +
+            std::chrono::seconds(30);
+        while(std::chrono::steady_clock::now() < stop)
+        {
+            for(int i = 0; i < 100; i++)
+            {
+                client->Say(msg);
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        // Reading again should only drain what was sent before the server
+        // gave up on the client
+        slowClient->ResumeReading();
+
+        double waitTime;
+        EXPECT_TRUE(slowClient->WaitForDisconnect(waitTime));
+
+        // The client that kept reading should still be connected
+        libcomp::ReadOnlyPacket reply;
+        client->Say("Still here");
+        EXPECT_TRUE(client->WaitForPacket(
+            ChannelToClientPacketCode_t::PACKET_CHAT, reply, waitTime));
+    });
+}
+
+TEST(ChannelQueue, FastClientStaysConnected)
+{
+    EXPECT_SERVER(libtester::ServerConfig::SingleChannel(), []()
+    {
+        std::shared_ptr<libtester::ChannelClient> listener(
+            new libtester::ChannelClient);
+
+        listener->Login(LOGIN_USERNAME, LOGIN_PASSWORD, "CrashDummy");
+        listener->SendData();
+
+        std::shared_ptr<libtester::ChannelClient> client(
+            new libtester::ChannelClient);
+
+        client->Login(LOGIN_USERNAME2, LOGIN_PASSWORD2, "TheInstigator");
+        client->SendData();
+
+        libcomp::String msg;
+        for(int i = 0; i < 30; i++)
+        {
+            msg += "Can you hear me now? ";
+        }
+
+        // Send the listener several times the hard limit of the testing
+        // config as zone chat. Each burst stays well under the limit and the
+        // listener keeps reading so none of it should count against it.
+        const uint64_t hardLimit = 1048576;
+
+        uint64_t sent = 0;
+        double waitTime;
+        while(sent < hardLimit * 4)
+        {
+            for(int i = 0; i < 100; i++)
+            {
+                client->Say(msg);
+                sent += (uint64_t)msg.Length();
+            }
+
+            libcomp::ReadOnlyPacket reply;
+            ASSERT_TRUE(listener->WaitForPacket(
+                ChannelToClientPacketCode_t::PACKET_CHAT, reply, waitTime));
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        // Wait past the max age of the testing config with the zone quiet
+        std::this_thread::sleep_for(std::chrono::seconds(6));
+
+        client->ClearMessages();
+        listener->ClearMessages();
+
+        // The listener should still be connected and receiving
+        libcomp::ReadOnlyPacket reply;
+        client->Say("Still here");
+        EXPECT_TRUE(listener->WaitForPacket(
+            ChannelToClientPacketCode_t::PACKET_CHAT, reply, waitTime));
+    });
+}
+
+static void SignalHandler(int signum)
+{
+    extern pthread_t gSelf;
+
+    if(SIGUSR2 == signum)
+    {
+        pthread_kill(gSelf, SIGUSR2);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    signal(SIGUSR2, SignalHandler);
+
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
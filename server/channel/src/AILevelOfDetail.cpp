@@ -0,0 +1,73 @@
+/**
+ * @file server/channel/src/AILevelOfDetail.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief AI level-of-detail update throttling.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AILevelOfDetail.h"
+
+using namespace channel;
+
+AILevelOfDetail::AILevelOfDetail(float distance, float freezeDistance,
+    uint32_t interval) : mDistanceSq(distance * distance),
+    mFreezeDistanceSq(freezeDistance * freezeDistance),
+    mInterval((uint64_t)interval * 1000ULL), mEnabled(distance > 0.f)
+{
+}
+
+bool AILevelOfDetail::IsEnabled() const
+{
+    return mEnabled;
+}
+
+bool AILevelOfDetail::Skip(float closest, bool moving, uint64_t& nextUpdate,
+    uint64_t now) const
+{
+    if(!mEnabled)
+    {
+        return false;
+    }
+
+    if(closest >= 0.f && closest <= mDistanceSq)
+    {
+        // Near a player, update every tick again
+        nextUpdate = 0;
+        return false;
+    }
+
+    if(mFreezeDistanceSq > 0.f && !moving &&
+        (closest < 0.f || closest > mFreezeDistanceSq))
+    {
+        // Frozen in place until a player comes closer
+        return true;
+    }
+
+    if(nextUpdate > now)
+    {
+        return true;
+    }
+
+    nextUpdate = now + mInterval;
+
+    return false;
+}
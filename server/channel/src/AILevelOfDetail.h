@@ -0,0 +1,93 @@
+/**
+ * @file server/channel/src/AILevelOfDetail.h
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief AI level-of-detail update throttling.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_AILEVELOFDETAIL_H
+#define SERVER_CHANNEL_SRC_AILEVELOFDETAIL_H
+
+// Standard C++11 Includes
+#include <stdint.h>
+
+namespace channel
+{
+
+/**
+ * Distance based throttling of AI updates for idle and wandering entities.
+ * Entities within the level-of-detail distance of a player update every
+ * tick, entities further out update on an interval and entities beyond the
+ * freeze distance do not update until a player comes closer. The limits
+ * are set once from the channel config.
+ */
+class AILevelOfDetail
+{
+public:
+    /**
+     * Create a new level-of-detail policy.
+     * @param distance Distance from the nearest player beyond which
+     *  updates are throttled or 0 to disable throttling
+     * @param freezeDistance Distance from the nearest player beyond which
+     *  non-moving entities stop updating or 0 to never freeze them
+     * @param interval Milliseconds between throttled updates
+     */
+    AILevelOfDetail(float distance = 0.f, float freezeDistance = 0.f,
+        uint32_t interval = 0);
+
+    /**
+     * Check if throttling is enabled.
+     * @return true if any entity can have its update skipped
+     */
+    bool IsEnabled() const;
+
+    /**
+     * Determine if the update of an idle or wandering entity should be
+     * skipped this tick.
+     * @param closest Squared distance from the entity to the nearest
+     *  player or a negative value if there are no players
+     * @param moving true if the entity is currently moving
+     * @param nextUpdate Next throttled update time of the entity, updated
+     *  when the entity is allowed to update. 0 means no update is scheduled.
+     * @param now Current timestamp of the server
+     * @return true if the update should be skipped
+     */
+    bool Skip(float closest, bool moving, uint64_t& nextUpdate,
+        uint64_t now) const;
+
+private:
+    /// Squared distance beyond which updates are throttled
+    float mDistanceSq;
+
+    /// Squared distance beyond which non-moving entities are frozen or 0
+    float mFreezeDistanceSq;
+
+    /// Microseconds between throttled updates
+    uint64_t mInterval;
+
+    /// Indicates throttling is enabled
+    bool mEnabled;
+};
+
+} // namespace channel
+
+#endif // SERVER_CHANNEL_SRC_AILEVELOFDETAIL_H
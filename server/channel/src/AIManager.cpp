@@ -59,6 +59,7 @@
 #include <MiTargetData.h>
 #include <Spawn.h>
 #include <SpawnLocation.h>
+#include <ChannelConfig.h>
 #include <WorldSharedConfig.h>
 
 // channel Includes
@@ -68,8 +69,12 @@
 #include "EventManager.h"
 #include "SkillManager.h"
 #include "TokuseiManager.h"
+#include "ZoneGeometry.h"
 #include "ZoneManager.h"
 
+// Standard C++11 Includes
+#include <algorithm>
+
 #define FOLLOW_DISTANCE_MAX (MAX_ENTITY_DRAW_DISTANCE * 0.66f)
 #define FOLLOW_DISTANCE_FAR (MAX_ENTITY_DRAW_DISTANCE * 0.25f)
 #define FOLLOW_DISTANCE_CLOSE (300.f)
@@ -118,6 +123,10 @@ AIManager::AIManager()
 AIManager::AIManager(const std::weak_ptr<ChannelServer>& server)
     : mServer(server)
 {
+    auto conf = std::dynamic_pointer_cast<objects::ChannelConfig>(
+        server.lock()->GetConfig());
+    mLOD = AILevelOfDetail(conf->GetAILODDistance(),
+        conf->GetAILODFreezeDistance(), conf->GetAILODInterval());
 }
 
 AIManager::~AIManager()
@@ -304,9 +313,33 @@ bool AIManager::Prepare(const std::shared_ptr<ActiveEntityState>& eState,
 void AIManager::UpdateActiveStates(const std::shared_ptr<Zone>& zone,
     uint64_t now, bool isNight)
 {
+    bool lodEnabled = mLOD.IsEnabled();
+
+    // Gather player positions once for AI level-of-detail checks
+    std::list<Point> players;
+    if(lodEnabled)
+    {
+        auto connections = zone->GetConnectionSnapshot();
+        for(auto& client : *connections)
+        {
+            // Bring the player up to the tick time first so the distance
+            // is not measured from where they started moving
+            auto cState = client->GetClientState()->GetCharacterState();
+            cState->RefreshCurrentPosition(now);
+            players.push_back(Point(cState->GetCurrentX(),
+                cState->GetCurrentY()));
+        }
+    }
+
     std::list<std::shared_ptr<ActiveEntityState>> updated;
-    for(auto eState : zone->GetEnemiesAndAllies())
+    auto eStates = zone->GetEnemyAndAllySnapshot();
+    for(auto& eState : *eStates)
     {
+        if(lodEnabled && SkipDistantUpdate(eState, players, now))
+        {
+            continue;
+        }
+
         if(UpdateState(eState, now, isNight))
         {
             updated.push_back(eState);
@@ -1455,6 +1488,40 @@ bool AIManager::UpdateState(const std::shared_ptr<ActiveEntityState>& eState,
     return false;
 }
 
+bool AIManager::SkipDistantUpdate(
+    const std::shared_ptr<ActiveEntityState>& eState,
+    const std::list<Point>& players, uint64_t now)
+{
+    auto aiState = eState->GetAIState();
+    if(!aiState || !(aiState->IsIdle() || aiState->IsWandering()) ||
+        aiState->GetTargetEntityID() > 0 || aiState->GetDespawnTimeout() ||
+        eState->GetOpponentIDs().size() > 0)
+    {
+        // Always update anything that is not simply idling or wandering
+        return false;
+    }
+
+    // Compare against where the entity is now, not where it was when it
+    // was last updated
+    eState->RefreshCurrentPosition(now);
+
+    float closest = -1.f;
+    for(auto& p : players)
+    {
+        float dist = eState->GetDistance(p.x, p.y, true);
+        if(closest < 0.f || dist < closest)
+        {
+            closest = dist;
+        }
+    }
+
+    uint64_t nextUpdate = aiState->GetNextLODUpdateTime();
+    bool skip = mLOD.Skip(closest, eState->IsMoving(), nextUpdate, now);
+    aiState->SetNextLODUpdateTime(nextUpdate);
+
+    return skip;
+}
+
 bool AIManager::UpdateEnemyState(
     const std::shared_ptr<ActiveEntityState>& eState,
     const std::shared_ptr<objects::EnemyBase>& eBase, uint64_t now,
@@ -2098,10 +2165,10 @@ std::shared_ptr<ActiveEntityState> AIManager::Retarget(
         // Currently in combat, only pull from opponents. Use deaggro
         // distance instead of the normal aggro distance since the AI
         // should technically be aggro until no opponents are still around
-        auto inRange = zone->GetActiveEntitiesInRadius(
-            sourceX, sourceY, aiState->GetDeaggroDistance(isNight));
+        zone->GetActiveEntitiesInRadius(mTargetBuffer, sourceX, sourceY,
+            aiState->GetDeaggroDistance(isNight), false, now);
 
-        for(auto entity : inRange)
+        for(auto& entity : mTargetBuffer)
         {
             if(opponentIDs.find(entity->GetEntityID()) != opponentIDs.end()
                 && entity->IsAlive() && entity->Ready() &&
@@ -2110,6 +2177,9 @@ std::shared_ptr<ActiveEntityState> AIManager::Retarget(
                 possibleTargets.push_back(entity);
             }
         }
+
+        // Keep the capacity but do not hold onto the entities
+        mTargetBuffer.clear();
     }
     else
     {
@@ -2143,11 +2213,13 @@ std::shared_ptr<ActiveEntityState> AIManager::Retarget(
         std::list<std::shared_ptr<ActiveEntityState>> inFoV;
         for(auto aggro : { aggroCast, aggroNormal })
         {
-            auto filtered = zone->GetActiveEntitiesInRadius(sourceX,
-                sourceY, (double)aggro.first);
+            auto& filtered = mTargetBuffer;
+            zone->GetActiveEntitiesInRadius(filtered, sourceX, sourceY,
+                (double)aggro.first, false, now);
 
             // Remove allies, entities not ready yet or in an invalid state
-            filtered.remove_if([eState, castingOnly, now](
+            filtered.erase(std::remove_if(filtered.begin(), filtered.end(),
+                [eState, castingOnly, now](
                 const std::shared_ptr<ActiveEntityState>& entity)
                 {
                     entity->ExpireStatusTimes(now);
@@ -2156,17 +2228,18 @@ std::shared_ptr<ActiveEntityState> AIManager::Retarget(
                         entity->GetStatusTimes(STATUS_IGNORE) ||
                         !entity->Ready() || entity->GetAIIgnored() ||
                         !entity->IsAlive();
-                });
+                }), filtered.end());
 
             // If the aggro level limit could potentially exclude a target
             // filter them out now
             if(aggroLevelLimit < 99)
             {
-                filtered.remove_if([aggroLevelLimit](
+                filtered.erase(std::remove_if(filtered.begin(),
+                    filtered.end(), [aggroLevelLimit](
                     const std::shared_ptr<ActiveEntityState>& entity)
                     {
                         return entity->GetLevel() > aggroLevelLimit;
-                    });
+                    }), filtered.end());
             }
 
             // If aggro limiting is enabled, remove targets based upon level
@@ -2249,32 +2322,32 @@ std::shared_ptr<ActiveEntityState> AIManager::Retarget(
                     max = 1;
                 }
 
-                filtered.remove_if([max](
+                filtered.erase(std::remove_if(filtered.begin(),
+                    filtered.end(), [max](
                     const std::shared_ptr<ActiveEntityState>& entity)
                     {
                         return entity->AggroIDsCount() >= max;
-                    });
+                    }), filtered.end());
             }
 
-            if(filtered.size() > 0)
+            // Filter the set down to only entities in the FoV
+            float sourceRot = eState->GetCurrentRotation();
+            for(auto& entity : filtered)
             {
-                // Targets found, check if they're visible
-                for(auto entity : filtered)
+                entity->RefreshCurrentPosition(now);
+                if(ZoneManager::PointInFoV(Point(entity->GetCurrentX(),
+                    entity->GetCurrentY()), 0.f, sourceX, sourceY,
+                    sourceRot, aggro.second))
                 {
-                    entity->RefreshCurrentPosition(now);
-                }
-
-                // Filter the set down to only entities in the FoV
-                for(auto fovEntity : ZoneManager::GetEntitiesInFoV(filtered, sourceX,
-                    sourceY, eState->GetCurrentRotation(), aggro.second))
-                {
-                    inFoV.push_back(fovEntity);
+                    inFoV.push_back(entity);
                 }
             }
 
             castingOnly = false;
         }
 
+        mTargetBuffer.clear();
+
         if(inFoV.size() > 0)
         {
             auto geometry = zone->GetGeometry();
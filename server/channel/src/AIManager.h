@@ -29,6 +29,7 @@
 
 // channel Includes
 #include "ActiveEntityState.h"
+#include "AILevelOfDetail.h"
 #include "AIState.h"
 #include "ClientState.h"
 
@@ -275,6 +276,21 @@ private:
     bool UpdateState(const std::shared_ptr<ActiveEntityState>& eState, uint64_t now,
         bool isNight);
 
+    /**
+     * Determine if the AI update for an entity should be skipped this tick
+     * because it is far from every player in its zone. Idle and wandering
+     * entities beyond the configured AI level-of-detail distance are only
+     * updated on an interval and entities beyond the freeze distance are
+     * not updated at all until a player comes closer. Position is caught
+     * up by the next update that does occur.
+     * @param eState Pointer to the entity state to check
+     * @param players Current positions of all players in the zone
+     * @param now Current timestamp of the server
+     * @return true if the update should be skipped
+     */
+    bool SkipDistantUpdate(const std::shared_ptr<ActiveEntityState>& eState,
+        const std::list<Point>& players, uint64_t now);
+
     /**
      * Update the state of an enemy or ally, processing AI directly or queuing
      * commands to be procssed on next update
@@ -479,6 +495,13 @@ private:
 
     /// Pointer to the channel server.
     std::weak_ptr<ChannelServer> mServer;
+
+    /// Level-of-detail throttling read from the channel config
+    AILevelOfDetail mLOD;
+
+    /// Reusable buffer for the zone entity queries made while retargeting.
+    /// AI is only updated from the main worker so this is never shared.
+    std::vector<std::shared_ptr<ActiveEntityState>> mTargetBuffer;
 };
 
 } // namespace channel
@@ -108,6 +108,7 @@
 #include "ChannelServer.h"
 #include "ChannelSyncManager.h"
 #include "CharacterManager.h"
+#include "DropTable.h"
 #include "EventManager.h"
 #include "ManagerConnection.h"
 #include "MatchManager.h"
@@ -1036,8 +1037,8 @@ bool ActionManager::AddRemoveItems(ActionContext& ctx)
             if(dropSet)
             {
                 // Value of 0 does not require or limit the number of drops
-                auto drops = characterManager->DetermineDrops(dropSet
-                    ->GetDrops(), 0, pair.second != 0);
+                auto drops = characterManager->DetermineDrops(dropSet,
+                    0, pair.second != 0);
                 auto loot = characterManager->CreateLootFromDrops(drops);
 
                 // Limit drop count
@@ -2607,7 +2608,7 @@ bool ActionManager::UpdatePoints(ActionContext& ctx)
                 pEntry->SetPoints(newVals);
                 if(pEntry->Update(server->GetWorldDatabase()))
                 {
-                    server->GetChannelSyncManager()->SyncRecordUpdate(pEntry,
+                    server->GetChannelSyncManager()->QueueRecordUpdate(pEntry,
                         "PentalphaEntry");
                 }
                 else
@@ -3372,6 +3373,15 @@ bool ActionManager::CreateLoot(ActionContext& ctx)
         bossGroupID = act->GetBossGroupID();
     }
 
+    auto sharedConfig = server->GetWorldSharedConfig();
+    float globalDropBonus = sharedConfig->GetDropRateBonus();
+    float scalingCap = sharedConfig->GetDropLuckScalingCap();
+
+    // Every box is rolled into the same buffer
+    auto actDrops = act->GetDrops();
+    DropRollBuffer dropBuffer;
+    std::vector<std::shared_ptr<DropTable>> dropTables;
+
     std::list<int32_t> entityIDs;
     for(auto loc : locations)
     {
@@ -3386,17 +3396,35 @@ bool ActionManager::CreateLoot(ActionContext& ctx)
         }
         lBox->SetLootTime(lootTime);
 
-        auto drops = act->GetDrops();
-        for(auto dropSet : characterManager->DetermineDropSets(act
-            ->GetDropSetIDs(), ctx.CurrentZone, ctx.Client))
+        characterManager->GetDropTables(characterManager->DetermineDropSets(
+            act->GetDropSetIDs(), ctx.CurrentZone, ctx.Client), dropTables);
+
+        dropBuffer.Clear();
+        DropTable::Roll(actDrops, globalDropBonus, scalingCap, dropBuffer);
+
+        std::shared_ptr<objects::ItemDrop> lastDrop;
+        if(actDrops.size() > 0)
+        {
+            lastDrop = actDrops.back();
+        }
+
+        for(auto& table : dropTables)
         {
-            for(auto drop : dropSet->GetDrops())
+            table->Roll(dropBuffer);
+            if(table->GetDrops().size() > 0)
             {
-                drops.push_back(drop);
+                lastDrop = table->GetDrops().back();
             }
         }
 
-        characterManager->CreateLootFromDrops(lBox, drops, 0, true);
+        // The box needs at least one item so fall back to the last drop
+        auto& drops = dropBuffer.GetDrops();
+        if(drops.size() == 0 && lastDrop)
+        {
+            drops.push_back(lastDrop);
+        }
+
+        characterManager->CreateLootFromDrops(lBox, drops);
 
         auto lState = std::make_shared<LootBoxState>(lBox);
 
@@ -28,12 +28,56 @@
 
 #include "ChannelServer.h"
 
+// libcomp Includes
+#include <Log.h>
+#include <PacketCodes.h>
+
+// Standard C++11 Includes
+#include <algorithm>
+
 using namespace channel;
 
+/// Server time between queue age checkpoints and between flushes of a
+/// client that is behind, which bounds how many checkpoints are kept for a
+/// client that has stopped reading
+const uint64_t QUEUE_TIME_RESOLUTION = 100000ULL;
+
+/**
+ * Get the ID of the entity a packet updates the position of.
+ * @param packet Packet to check
+ * @return Entity ID or -1 if the packet is not a position update
+ */
+static int32_t GetPositionEntityID(libcomp::Packet& packet)
+{
+    int32_t entityID = -1;
+    if(packet.Size() >= 6)
+    {
+        packet.Seek(0);
+
+        uint16_t code = packet.ReadU16Little();
+        if(code == to_underlying(ChannelToClientPacketCode_t::PACKET_MOVE) ||
+            code == to_underlying(
+                ChannelToClientPacketCode_t::PACKET_ROTATE) ||
+            code == to_underlying(
+                ChannelToClientPacketCode_t::PACKET_STOP_MOVEMENT))
+        {
+            entityID = packet.ReadS32Little();
+        }
+
+        packet.Seek(packet.Size());
+    }
+
+    return entityID;
+}
+
 ChannelClientConnection::ChannelClientConnection(asio::ip::tcp::socket& socket,
     const std::shared_ptr<libcomp::Crypto::DiffieHellman>& diffieHellman) :
     ChannelConnection(socket, diffieHellman), mClientState(
-        std::shared_ptr<ClientState>(new ClientState)), mTimeout(0)
+        std::shared_ptr<ClientState>(new ClientState)), mTimeout(0),
+    mQueueSoftLimit(0), mQueueHardLimit(0), mQueueMaxAge(0), mQueuedBytes(0),
+    mSentBytes(0), mFlushedBytes(0), mCompletedBytes(0), mPeakQueuedBytes(0),
+    mDroppedUpdates(0),
+    mCoalescedSends(0), mLastQueueFlush(0), mQueueClosed(false)
 {
 }
 
@@ -62,25 +106,193 @@ void ChannelClientConnection::Kill()
     Close();
 }
 
-void ChannelClientConnection::BroadcastPacket(const std::list<std::shared_ptr<
-    ChannelClientConnection>>& clients, libcomp::Packet& packet, bool queue)
+void ChannelClientConnection::SetQueueLimits(uint32_t softLimit,
+    uint32_t hardLimit, uint32_t maxAge)
+{
+    std::lock_guard<std::mutex> lock(mQueueLock);
+    mQueueSoftLimit = softLimit;
+    mQueueHardLimit = hardLimit;
+    mQueueMaxAge = (uint64_t)maxAge * 1000000ULL;
+}
+
+ClientQueueMetrics ChannelClientConnection::GetQueueMetrics()
 {
-    if(queue)
+    uint64_t now = ChannelServer::GetServerTime();
+
+    std::lock_guard<std::mutex> lock(mQueueLock);
+
+    ClientQueueMetrics metrics;
+    metrics.QueuedBytes = GetUnsentBytes();
+    metrics.PeakQueuedBytes = mPeakQueuedBytes;
+    metrics.OldestAge = GetOldestAge(now);
+    metrics.HeldPositionUpdates = (uint32_t)mHeldUpdates.size();
+    metrics.DroppedPositionUpdates = mDroppedUpdates;
+    metrics.CoalescedSends = mCoalescedSends;
+
+    return metrics;
+}
+
+bool ChannelClientConnection::QueueBoundedPacket(libcomp::Packet& packet,
+    int32_t positionEntityID)
+{
+    uint64_t now = ChannelServer::GetServerTime();
+
+    std::list<libcomp::Packet> released;
+    uint64_t unsent = 0;
+    uint64_t age = 0;
+    bool flush = true;
+    bool close = false;
     {
-        for(auto client : clients)
+        std::lock_guard<std::mutex> lock(mQueueLock);
+        if(mQueueClosed)
         {
-            client->QueuePacketCopy(packet);
+            return false;
+        }
+
+        if(CheckQueueLimits(now, unsent, age))
+        {
+            close = true;
+        }
+        else if(mQueueSoftLimit && unsent > mQueueSoftLimit)
+        {
+            if(positionEntityID != -1)
+            {
+                // Hold the latest position of the entity until the client
+                // catches up, dropping any update it supersedes
+                auto it = mHeldUpdates.find(positionEntityID);
+                if(it != mHeldUpdates.end())
+                {
+                    it->second = packet;
+                    mDroppedUpdates++;
+                }
+                else
+                {
+                    mHeldUpdates[positionEntityID] = packet;
+                }
+
+                return false;
+            }
+
+            // Let the packet go out with the next flush instead unless
+            // nothing has been flushed for a while
+            if((now - mLastQueueFlush) < QUEUE_TIME_RESOLUTION)
+            {
+                flush = false;
+                mCoalescedSends++;
+            }
+        }
+        else
+        {
+            // Release held position updates ahead of the new packet
+            for(auto& pair : mHeldUpdates)
+            {
+                released.push_back(pair.second);
+            }
+
+            mHeldUpdates.clear();
+        }
+
+        if(!close)
+        {
+            for(auto& p : released)
+            {
+                AddQueuedBytes(p.Size(), now);
+            }
+
+            AddQueuedBytes(packet.Size(), now);
+
+            if(flush)
+            {
+                MarkQueueFlush(now);
+            }
         }
     }
-    else
+
+    if(close)
     {
-        std::list<std::shared_ptr<libcomp::TcpConnection>> connections;
-        for(auto client : clients)
+        CloseQueue(unsent, age);
+
+        return false;
+    }
+
+    for(auto& p : released)
+    {
+        QueuePacket(p);
+    }
+
+    QueuePacketCopy(packet);
+
+    return flush;
+}
+
+void ChannelClientConnection::ReleaseQueue()
+{
+    uint64_t now = ChannelServer::GetServerTime();
+
+    std::list<libcomp::Packet> released;
+    uint64_t unsent = 0;
+    uint64_t age = 0;
+    bool close = false;
+    {
+        std::lock_guard<std::mutex> lock(mQueueLock);
+        if(mQueueClosed)
         {
-            connections.push_back(client);
+            return;
         }
 
-        libcomp::TcpConnection::BroadcastPacket(connections, packet);
+        // A stalled client in a quiet zone has nothing new queued that
+        // would otherwise disconnect it
+        if(CheckQueueLimits(now, unsent, age))
+        {
+            close = true;
+        }
+        else
+        {
+            if(!mQueueSoftLimit || unsent <= mQueueSoftLimit)
+            {
+                for(auto& pair : mHeldUpdates)
+                {
+                    released.push_back(pair.second);
+                    AddQueuedBytes(pair.second.Size(), now);
+                }
+
+                mHeldUpdates.clear();
+            }
+
+            if(mFlushedBytes == mQueuedBytes)
+            {
+                // Nothing is waiting on a flush
+                return;
+            }
+
+            MarkQueueFlush(now);
+        }
+    }
+
+    if(close)
+    {
+        CloseQueue(unsent, age);
+
+        return;
+    }
+
+    for(auto& p : released)
+    {
+        QueuePacket(p);
+    }
+
+    FlushOutgoing();
+}
+
+void ChannelClientConnection::BroadcastPacket(const std::list<std::shared_ptr<
+    ChannelClientConnection>>& clients, libcomp::Packet& packet, bool queue)
+{
+    for(auto client : clients)
+    {
+        if(client->QueueBoundedPacket(packet) && !queue)
+        {
+            client->FlushOutgoing();
+        }
     }
 }
 
@@ -89,12 +301,16 @@ void ChannelClientConnection::BroadcastPackets(const std::list<std::shared_ptr<
 {
     for(auto client : clients)
     {
+        bool flush = true;
         for(auto& packet : packets)
         {
-            client->QueuePacketCopy(packet);
+            flush &= client->QueueBoundedPacket(packet);
         }
 
-        client->FlushOutgoing();
+        if(flush)
+        {
+            client->FlushOutgoing();
+        }
     }
 }
 
@@ -112,6 +328,8 @@ void ChannelClientConnection::SendRelativeTimePacket(
     libcomp::Packet& packet, const RelativeTimeMap& timeMap,
     bool queue)
 {
+    int32_t positionEntityID = GetPositionEntityID(packet);
+
     for(auto client : clients)
     {
         libcomp::Packet pCopy(packet);
@@ -123,13 +341,117 @@ void ChannelClientConnection::SendRelativeTimePacket(
             pCopy.WriteFloat(state->ToClientTime(tPair.second));
         }
 
-        if(queue)
+        if(client->QueueBoundedPacket(pCopy, positionEntityID) && !queue)
         {
-            client->QueuePacket(pCopy);
+            client->FlushOutgoing();
         }
-        else
+    }
+}
+
+void ChannelClientConnection::PacketSent(libcomp::ReadOnlyPacket& packet)
+{
+    {
+        std::lock_guard<std::mutex> lock(mQueueLock);
+
+        // Wire packets are combined and compressed so their size cannot be
+        // used. The write that completed started no sooner than the one
+        // before it completed so it included everything queued by then. If
+        // it started from idle, it was sent by the oldest flush still
+        // waiting instead.
+        uint64_t sent = mCompletedBytes;
+        if(mFlushMarks.size() > 0)
+        {
+            sent = std::max(sent, mFlushMarks.front());
+        }
+
+        mSentBytes = std::max(mSentBytes, std::min(sent, mQueuedBytes));
+        mCompletedBytes = mQueuedBytes;
+
+        while(mFlushMarks.size() > 0 && mFlushMarks.front() <= mSentBytes)
         {
-            client->SendPacket(pCopy);
+            mFlushMarks.pop_front();
         }
+
+        while(mQueueTimes.size() > 0 &&
+            mQueueTimes.front().first <= mSentBytes)
+        {
+            mQueueTimes.pop_front();
+        }
+    }
+
+    libcomp::ChannelConnection::PacketSent(packet);
+}
+
+bool ChannelClientConnection::CheckQueueLimits(uint64_t now,
+    uint64_t& unsent, uint64_t& age)
+{
+    unsent = GetUnsentBytes();
+    age = GetOldestAge(now);
+
+    if((mQueueHardLimit && unsent > mQueueHardLimit) ||
+        (mQueueMaxAge && age > mQueueMaxAge))
+    {
+        // The client is not keeping up, stop queueing and disconnect
+        mQueueClosed = true;
+        mHeldUpdates.clear();
+
+        return true;
+    }
+
+    return false;
+}
+
+void ChannelClientConnection::CloseQueue(uint64_t unsent, uint64_t age)
+{
+    LogGeneralWarning([&]()
+    {
+        return libcomp::String("Disconnecting client %1 that is not"
+            " keeping up with sent data: %2 bytes queued for %3 ms.\n")
+            .Arg(GetRemoteAddress()).Arg(unsent).Arg(age / 1000);
+    });
+
+    Close();
+}
+
+void ChannelClientConnection::MarkQueueFlush(uint64_t now)
+{
+    mLastQueueFlush = now;
+    mFlushedBytes = mQueuedBytes;
+
+    if(mFlushMarks.size() == 0 || mFlushMarks.back() < mQueuedBytes)
+    {
+        mFlushMarks.push_back(mQueuedBytes);
     }
 }
+
+void ChannelClientConnection::AddQueuedBytes(uint64_t size, uint64_t now)
+{
+    mQueuedBytes += size;
+
+    if(mQueueTimes.size() == 0 ||
+        (now - mQueueTimes.back().second) > QUEUE_TIME_RESOLUTION)
+    {
+        mQueueTimes.push_back(std::make_pair(mQueuedBytes, now));
+    }
+    else
+    {
+        mQueueTimes.back().first = mQueuedBytes;
+    }
+
+    mPeakQueuedBytes = std::max(mPeakQueuedBytes, GetUnsentBytes());
+}
+
+uint64_t ChannelClientConnection::GetUnsentBytes() const
+{
+    return mQueuedBytes - mSentBytes;
+}
+
+uint64_t ChannelClientConnection::GetOldestAge(uint64_t now) const
+{
+    if(mQueueTimes.size() == 0 || now < mQueueTimes.front().second)
+    {
+        return 0;
+    }
+
+    return now - mQueueTimes.front().second;
+}
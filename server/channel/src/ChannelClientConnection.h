@@ -33,11 +33,42 @@
 // libcomp Includes
 #include <ChannelConnection.h>
 
+// Standard C++11 Includes
+#include <deque>
+#include <mutex>
+
 namespace channel
 {
 
 typedef std::unordered_map<uint32_t, uint64_t> RelativeTimeMap;
 
+/**
+ * Snapshot of the outgoing queue accounting of a client connection.
+ */
+struct ClientQueueMetrics
+{
+    /// Bytes queued for the client that have not been sent yet
+    uint64_t QueuedBytes;
+
+    /// Most bytes queued at once since the client connected
+    uint64_t PeakQueuedBytes;
+
+    /// Server time in microseconds since the oldest unsent bytes were
+    /// queued or 0 if nothing is waiting to be sent
+    uint64_t OldestAge;
+
+    /// Number of position updates held back until the client catches up
+    uint32_t HeldPositionUpdates;
+
+    /// Number of held position updates replaced by a newer update for the
+    /// same entity
+    uint64_t DroppedPositionUpdates;
+
+    /// Number of packets queued without flushing because the client was
+    /// behind
+    uint64_t CoalescedSends;
+};
+
 /**
  * Represents a connection to the game client.
  */
@@ -84,6 +115,51 @@ public:
      */
     void Kill();
 
+    /**
+     * Set the limits applied to packets queued for the client through the
+     * broadcast functions. Once the soft limit is passed, position updates
+     * are held back with only the latest one kept per entity and other
+     * packets are queued without flushing so they go out together. Once
+     * the hard limit or max age is passed the client is disconnected.
+     * @param softLimit Queued bytes before position updates are held and
+     *  sends are coalesced or 0 for no limit
+     * @param hardLimit Queued bytes before the client is disconnected or 0
+     *  for no limit
+     * @param maxAge Seconds the oldest queued bytes can wait to be sent
+     *  before the client is disconnected or 0 for no limit
+     */
+    void SetQueueLimits(uint32_t softLimit, uint32_t hardLimit,
+        uint32_t maxAge);
+
+    /**
+     * Get the current outgoing queue accounting of the client.
+     * @return Queue metrics of the client
+     */
+    ClientQueueMetrics GetQueueMetrics();
+
+    /**
+     * Queue a copy of a packet for the client, applying the queue limits
+     * to it.
+     * @param packet Packet to queue a copy of
+     * @param positionEntityID ID of the entity the packet updates the
+     *  position of or -1 if it is not a position update
+     * @return true if the client can be flushed now, false if the packet
+     *  was held back, dropped or should go out with the next flush
+     */
+    bool QueueBoundedPacket(libcomp::Packet& packet,
+        int32_t positionEntityID = -1);
+
+    /**
+     * Apply the queue limits without queueing anything new and flush
+     * packets the bounded queue kept back from the client. The client is
+     * disconnected if it passed the hard limit or max age. Otherwise
+     * packets queued without flushing are flushed and, if the client has
+     * caught up to the soft limit, held position updates are released.
+     * Called from the zone tick so a zone that goes quiet neither leaves
+     * them waiting nor keeps a stalled client connected.
+     */
+    void ReleaseQueue();
+
     /**
      * Broadcast the supplied packet to each client connection in the list.
      * @param clients List of client connections to send the packet to
@@ -124,13 +200,122 @@ public:
         libcomp::Packet& p, const RelativeTimeMap& timeMap,
         bool queue = false);
 
+protected:
+    /**
+     * Account for a write to the client completing. The write is counted
+     * as sending everything queued when the previous write completed or,
+     * if more, everything up to the oldest flush still waiting on a write.
+     * @param packet Packet that was sent
+     */
+    virtual void PacketSent(libcomp::ReadOnlyPacket& packet);
+
 private:
+    /**
+     * Check the unsent bytes against the hard limit and max age, closing
+     * the queue if either is passed. The queue lock must be held when
+     * calling this.
+     * @param now Current server time
+     * @param unsent Output parameter set to the unsent byte count
+     * @param age Output parameter set to the age of the oldest unsent bytes
+     * @return true if the queue was closed and the client should be
+     *  disconnected with CloseQueue
+     */
+    bool CheckQueueLimits(uint64_t now, uint64_t& unsent, uint64_t& age);
+
+    /**
+     * Disconnect the client after its queue was closed. The queue lock
+     * must not be held when calling this.
+     * @param unsent Unsent byte count to report
+     * @param age Age of the oldest unsent bytes to report
+     */
+    void CloseQueue(uint64_t unsent, uint64_t age);
+
+    /**
+     * Record that everything queued so far is being flushed. The queue
+     * lock must be held when calling this.
+     * @param now Current server time
+     */
+    void MarkQueueFlush(uint64_t now);
+
+    /**
+     * Account for bytes queued through the bounded queue. The queue lock
+     * must be held when calling this.
+     * @param size Number of bytes queued
+     * @param now Current server time
+     */
+    void AddQueuedBytes(uint64_t size, uint64_t now);
+
+    /**
+     * Get the number of queued bytes that have not been sent yet. The
+     * queue lock must be held when calling this.
+     * @return Unsent byte count
+     */
+    uint64_t GetUnsentBytes() const;
+
+    /**
+     * Get the age of the oldest unsent bytes. The queue lock must be held
+     * when calling this.
+     * @param now Current server time
+     * @return Age in microseconds or 0 if nothing is unsent
+     */
+    uint64_t GetOldestAge(uint64_t now) const;
+
     /// State of the client
     std::shared_ptr<ClientState> mClientState;
 
     /// Server timestamp used to disconnect the client should it pass
     /// without refreshing beforehand.
     uint64_t mTimeout;
+
+    /// Queued bytes before position updates are held and sends coalesced
+    uint64_t mQueueSoftLimit;
+
+    /// Queued bytes before the client is disconnected
+    uint64_t mQueueHardLimit;
+
+    /// Microseconds unsent bytes can wait before the client is disconnected
+    uint64_t mQueueMaxAge;
+
+    /// Total bytes queued through the bounded queue
+    uint64_t mQueuedBytes;
+
+    /// Total queued bytes known to have been written to the client
+    uint64_t mSentBytes;
+
+    /// Total bytes queued when the bounded queue last allowed a flush
+    uint64_t mFlushedBytes;
+
+    /// Total bytes queued when the last write to the client completed
+    uint64_t mCompletedBytes;
+
+    /// Total bytes queued at each flush that has not been counted as sent
+    /// yet, oldest first
+    std::deque<uint64_t> mFlushMarks;
+
+    /// Most unsent bytes seen at once
+    uint64_t mPeakQueuedBytes;
+
+    /// Pairs of queued byte totals and the server time the first of the
+    /// bytes leading up to that total was queued, oldest first
+    std::deque<std::pair<uint64_t, uint64_t>> mQueueTimes;
+
+    /// Latest position update held back for each entity
+    std::unordered_map<int32_t, libcomp::Packet> mHeldUpdates;
+
+    /// Number of held position updates replaced by a newer one
+    uint64_t mDroppedUpdates;
+
+    /// Number of packets queued without flushing
+    uint64_t mCoalescedSends;
+
+    /// Server time the bounded queue last allowed a flush
+    uint64_t mLastQueueFlush;
+
+    /// Indicates the client passed a hard limit and is being disconnected
+    bool mQueueClosed;
+
+    /// Lock for the queue accounting
+    std::mutex mQueueLock;
 };
 
 static inline ClientState* state(
@@ -39,6 +39,7 @@
 // object Includes
 #include <Account.h>
 #include <ChannelConfig.h>
+#include <ChannelTelemetry.h>
 #include <WorldSharedConfig.h>
 
 // channel Includes
@@ -57,6 +58,7 @@
 #include "PerformanceTimer.h"
 #include "MatchManager.h"
 #include "SkillManager.h"
+#include "StartupTaskGraph.h"
 #include "TokuseiManager.h"
 #include "ZoneManager.h"
 
@@ -105,7 +107,9 @@ ChannelServer::ChannelServer(const char *szProgram,
     mEventManager(0), mFusionManager(0), mMatchManager(0), mSkillManager(0),
     mZoneManager(0), mDefinitionManager(0), mServerDataManager(0),
     mRecalcTimeDependents(false), mMaxEntityID(0), mMaxObjectID(0),
-    mTicksPending(0), mTickRunning(true)
+    mTelemetryTickCount(0), mTelemetryTickTotal(0), mTelemetryTickMax(0),
+    mTelemetryTickOverruns(0), mTelemetryTicksMissed(0), mTelemetryDBMax(0),
+    mTelemetryLastSent(0), mTicksPending(0), mTickRunning(true)
 {
 }
 
@@ -118,38 +122,77 @@ bool ChannelServer::Initialize()
         return false;
     }
 
-    // Load newcharacter.xml for use when initializing new characters
-    std::string newCharacterPath = GetConfigPath() + "newcharacter.xml";
-    if(!LoadDataFromFile(newCharacterPath, mDefaultCharacterObjectMap, true,
-        std::set<std::string>{ "Character", "CharacterProgress", "Demon",
-            "EntityStats", "Expertise", "Hotbar", "Item" }))
-    {
-        LogGeneralInfoMsg("No default character file loaded. New characters"
-            " will start with nothing but chosen equipment and base"
-            " expertise skills.\n");
-    }
-
     auto conf = std::dynamic_pointer_cast<objects::ChannelConfig>(mConfig);
+    auto channelPtr = std::dynamic_pointer_cast<ChannelServer>(self);
 
     mDefinitionManager = new libcomp::DefinitionManager();
-    if(!mDefinitionManager->LoadAllData(GetDataStore()))
+    mServerDataManager = new libcomp::ServerDataManager();
+    mEventManager = new EventManager(channelPtr);
+    mFusionManager = new FusionManager(channelPtr);
+    mTokuseiManager = new TokuseiManager(channelPtr);
+
+    // Load the bulk data as a graph of tasks so anything that does not
+    // depend on each other is loaded at the same time. Server data adds
+    // its own definitions (tokusei, enchantments, etc) to the definition
+    // manager so anything reading those waits for the server data too.
+    StartupTaskGraph loader(conf->GetParallelStartup());
+
+    bool tasksAdded = loader.AddTask("newcharacter", [&]()
     {
-        return false;
-    }
+        // Load newcharacter.xml for use when initializing new characters
+        std::string newCharacterPath = GetConfigPath() + "newcharacter.xml";
+        if(!LoadDataFromFile(newCharacterPath, mDefaultCharacterObjectMap,
+            true, std::set<std::string>{ "Character", "CharacterProgress",
+                "Demon", "EntityStats", "Expertise", "Hotbar", "Item" }))
+        {
+            LogGeneralInfoMsg("No default character file loaded. New"
+                " characters will start with nothing but chosen equipment"
+                " and base expertise skills.\n");
+        }
 
-    mServerDataManager = new libcomp::ServerDataManager();
-    if(!mServerDataManager->LoadData(GetDataStore(), mDefinitionManager))
+        return true;
+    });
+
+    tasksAdded = loader.AddTask("definitions", [&]()
     {
-        return false;
-    }
+        return mDefinitionManager->LoadAllData(GetDataStore());
+    }) && tasksAdded;
+
+    tasksAdded = loader.AddTask("serverdata", [&]()
+    {
+        return mServerDataManager->LoadData(GetDataStore(),
+            mDefinitionManager);
+    }, { "definitions" }) && tasksAdded;
 
     if(conf->GetVerifyServerData())
     {
-        LogGeneralDebugMsg("Verifying server data integrity...\n");
-        if(!mServerDataManager->VerifyDataIntegrity(mDefinitionManager))
+        tasksAdded = loader.AddTask("verify", [&]()
         {
-            return false;
-        }
+            LogGeneralDebugMsg("Verifying server data integrity...\n");
+
+            return mServerDataManager->VerifyDataIntegrity(
+                mDefinitionManager);
+        }, { "serverdata" }) && tasksAdded;
+    }
+
+    tasksAdded = loader.AddTask("events", [&]()
+    {
+        return mEventManager->Initialize();
+    }, { "serverdata" }) && tasksAdded;
+
+    tasksAdded = loader.AddTask("fusion", [&]()
+    {
+        return mFusionManager->Initialize();
+    }, { "serverdata" }) && tasksAdded;
+
+    tasksAdded = loader.AddTask("tokusei", [&]()
+    {
+        return mTokuseiManager->Initialize();
+    }, { "serverdata" }) && tasksAdded;
+
+    if(!tasksAdded || !loader.Run())
+    {
+        return false;
     }
 
     mManagerConnection = std::make_shared<ManagerConnection>(self);
@@ -719,24 +762,14 @@ bool ChannelServer::Initialize()
         worker->AddManager(mManagerConnection);
     }
 
-    auto channelPtr = std::dynamic_pointer_cast<ChannelServer>(self);
     mAccountManager = new AccountManager(channelPtr);
     mActionManager = new ActionManager(channelPtr);
     mAIManager = new AIManager(channelPtr);
     mCharacterManager = new CharacterManager(channelPtr);
     mChatManager = new ChatManager(channelPtr);
-    mEventManager = new EventManager(channelPtr);
-    mFusionManager = new FusionManager(channelPtr);
     mMatchManager = new MatchManager(channelPtr);
     mSkillManager = new SkillManager(channelPtr);
     mSyncManager = new ChannelSyncManager(channelPtr);
-
-	mTokuseiManager = new TokuseiManager(channelPtr);
-    if(!mTokuseiManager->Initialize())
-    {
-        return false;
-    }
-
     mZoneManager = new ZoneManager(channelPtr);
 
     // Now connect to the world server.
@@ -905,6 +938,10 @@ void ChannelServer::SetTimeOffset(uint32_t offset)
     mWorldClock.SystemTime = 0;
     mNextEventTime = 0;
     mLastEventTrigger = WorldClockTime();
+
+    // Game times move with the offset so every time must be rescheduled
+    mWorldClockEventTimes.clear();
+    mWorldClockCalendar.clear();
 }
 
 const std::shared_ptr<objects::RegisteredChannel> ChannelServer::GetRegisteredChannel()
@@ -1093,6 +1130,53 @@ TokuseiManager* ChannelServer::GetTokuseiManager() const
     return mTokuseiManager;
 }
 
+uint64_t ChannelServer::GetStartupDigest()
+{
+    StartupDigest digest;
+
+    std::map<uint32_t, std::set<uint32_t>> zoneIDs;
+    for(auto& zonePair : mServerDataManager->GetAllZoneIDs())
+    {
+        zoneIDs[zonePair.first].insert(zonePair.second.begin(),
+            zonePair.second.end());
+    }
+
+    for(auto& zonePair : zoneIDs)
+    {
+        digest.Add(zonePair.first);
+        for(uint32_t dynamicMapID : zonePair.second)
+        {
+            digest.Add(dynamicMapID);
+        }
+    }
+
+    std::set<uint32_t> instanceIDs;
+    for(uint32_t instanceID : mServerDataManager->GetAllZoneInstanceIDs())
+    {
+        instanceIDs.insert(instanceID);
+    }
+
+    for(uint32_t instanceID : instanceIDs)
+    {
+        digest.Add(instanceID);
+    }
+
+    std::set<int32_t> tokuseiIDs;
+    for(auto& tPair : mDefinitionManager->GetAllTokuseiData())
+    {
+        tokuseiIDs.insert(tPair.first);
+    }
+
+    for(int32_t tokuseiID : tokuseiIDs)
+    {
+        digest.Add(tokuseiID);
+    }
+
+    mZoneManager->DigestStartupState(digest);
+
+    return digest.Get();
+}
+
 std::shared_ptr<objects::WorldSharedConfig>
     ChannelServer::GetWorldSharedConfig() const
 {
@@ -1134,6 +1218,7 @@ void ChannelServer::Tick()
     perf.Stop("UpdateActiveZoneStates");
 
     // Process queued world database changes
+    ServerTime dbStart = GetServerTime();
     perf.Start();
     auto worldFailures = mWorldDatabase->ProcessTransactionQueue();
     perf.Stop("WorldDatabaseTransactions");
@@ -1142,6 +1227,7 @@ void ChannelServer::Tick()
     perf.Start();
     auto lobbyFailures = mLobbyDatabase->ProcessTransactionQueue();
     perf.Stop("LobbyDatabaseTransactions");
+    ServerTime dbTime = GetServerTime() - dbStart;
 
     if(worldFailures.size() > 0 || lobbyFailures.size() > 0)
     {
@@ -1213,7 +1299,36 @@ void ChannelServer::Tick()
     }
     perf.Stop("ScheduleWork");
 
+    // Send all sync records batched since the last tick
+    perf.Start();
+    mSyncManager->FlushScheduledSync();
+    perf.Stop("SyncOutgoing");
+
     tickPerf.Stop("Tick");
+
+    // Record the tick health for the next telemetry report
+    ServerTime tickDuration = GetServerTime() - tickTime;
+    {
+        std::lock_guard<std::mutex> lock(mTickLock);
+        mTelemetryTickCount++;
+        mTelemetryTickTotal += tickDuration;
+
+        if(tickDuration > mTelemetryTickMax)
+        {
+            mTelemetryTickMax = tickDuration;
+        }
+
+        // Ticks are queued every 100ms so anything longer is an overrun
+        if(tickDuration > 100000ULL)
+        {
+            mTelemetryTickOverruns++;
+        }
+
+        if(dbTime > mTelemetryDBMax)
+        {
+            mTelemetryDBMax = dbTime;
+        }
+    }
 }
 
 void ChannelServer::StartGameTick()
@@ -1251,6 +1366,7 @@ void ChannelServer::StartGameTick()
                     else
                     {
                         ticksMissed++;
+                        mTelemetryTicksMissed++;
                     }
                 }
 
@@ -1366,6 +1482,20 @@ void ChannelServer::ScheduleRecurringActions()
     {
         mManagerConnection->ScheduleClientTimeoutHandler(conf->GetTimeout());
     }
+
+    // Schedule the telemetry report to the world
+    if(conf->GetTelemetryInterval() > 0)
+    {
+        mTelemetryLastSent = (uint32_t)std::time(0);
+
+        auto telemetrySch = std::chrono::milliseconds(
+            (int64_t)conf->GetTelemetryInterval() * 1000);
+        mTimerManager.SchedulePeriodicEvent(telemetrySch, []
+            (ChannelServer* pServer)
+            {
+                pServer->SendTelemetry();
+            }, this);
+    }
 }
 
 bool ChannelServer::RegisterClockEvent(WorldClockTime time, uint8_t type,
@@ -1398,6 +1528,7 @@ bool ChannelServer::RegisterClockEvent(WorldClockTime time, uint8_t type,
         if(mWorldClockEvents[time].size() == 0)
         {
             mWorldClockEvents.erase(time);
+            UnscheduleWorldClockEvent(time);
             recalcNext = true;
         }
     }
@@ -1405,6 +1536,11 @@ bool ChannelServer::RegisterClockEvent(WorldClockTime time, uint8_t type,
     {
         recalcNext = mWorldClockEvents.find(time) == mWorldClockEvents.end();
         mWorldClockEvents[time].insert(type);
+
+        if(recalcNext && mWorldClock.IsSet())
+        {
+            ScheduleWorldClockEvent(time);
+        }
     }
 
     if(recalcNext)
@@ -1481,6 +1617,51 @@ void ChannelServer::HandleDemonQuestReset()
         }, this);
 }
 
+void ChannelServer::SendTelemetry()
+{
+    auto worldConnection = mManagerConnection->GetWorldConnection();
+    if(!worldConnection || !mRegisteredWorld || !mRegisteredChannel)
+    {
+        return;
+    }
+
+    uint32_t now = (uint32_t)time(0);
+
+    auto telemetry = std::make_shared<objects::ChannelTelemetry>();
+    telemetry->SetWorldID(mRegisteredWorld->GetID());
+    telemetry->SetChannelID(mRegisteredChannel->GetID());
+    telemetry->SetTimestamp(now);
+
+    // Pull the tick statistics and reset them for the next report
+    {
+        std::lock_guard<std::mutex> lock(mTickLock);
+        telemetry->SetInterval(now - mTelemetryLastSent);
+        telemetry->SetTickCount(mTelemetryTickCount);
+        telemetry->SetTickAverage(mTelemetryTickCount
+            ? (uint32_t)(mTelemetryTickTotal / mTelemetryTickCount) : 0);
+        telemetry->SetTickMax((uint32_t)mTelemetryTickMax);
+        telemetry->SetTickOverruns(mTelemetryTickOverruns);
+        telemetry->SetTicksMissed(mTelemetryTicksMissed);
+        telemetry->SetDatabaseTimeMax((uint32_t)mTelemetryDBMax);
+
+        mTelemetryTickCount = 0;
+        mTelemetryTickTotal = 0;
+        mTelemetryTickMax = 0;
+        mTelemetryTickOverruns = 0;
+        mTelemetryTicksMissed = 0;
+        mTelemetryDBMax = 0;
+        mTelemetryLastSent = now;
+    }
+
+    telemetry->SetConnectionCount((uint16_t)mManagerConnection
+        ->GetAllConnections().size());
+
+    mZoneManager->GetPopulationTelemetry(telemetry);
+
+    mSyncManager->UpdateRecord(telemetry, "ChannelTelemetry");
+    mSyncManager->ScheduleSyncOutgoing();
+}
+
 std::shared_ptr<libcomp::TcpConnection> ChannelServer::CreateConnection(
     asio::ip::tcp::socket& socket)
 {
@@ -1491,6 +1672,10 @@ std::shared_ptr<libcomp::TcpConnection> ChannelServer::CreateConnection(
     connection->SetServerConfig(mConfig);
     connection->SetName(libcomp::String("client:%1").Arg(connectionID++));
 
+    auto conf = std::dynamic_pointer_cast<objects::ChannelConfig>(mConfig);
+    connection->SetQueueLimits(conf->GetClientQueueSoftLimit(),
+        conf->GetClientQueueHardLimit(), conf->GetClientQueueMaxAge());
+
     if(AssignMessageQueue(connection))
     {
         // Make sure this is called after connecting.
@@ -1531,74 +1716,83 @@ ServerTime ChannelServer::GetServerTimeHighResolution()
 
 void ChannelServer::RecalcNextWorldEventTime()
 {
-    if(mWorldClock.IsSet() && mWorldClockEvents.size() > 0)
+    if(!mWorldClock.IsSet() || mWorldClockEvents.size() == 0)
     {
-        uint32_t timeToMidnight = (uint32_t)(
-            ((23 - mWorldClock.SystemHour) * 3600) +
-            ((59 - mWorldClock.SystemMin) * 60) + (60 - mWorldClock.SystemSec));
-
-        // Midnight is always an option as day based times are not compared
-        // at that level
-        std::set<uint32_t> nextTimes = { timeToMidnight };
-
-        uint8_t secOffset = (uint8_t)(mWorldClock.SystemSec % 2);
+        mNextEventTime = 0;
+        return;
+    }
 
-        int32_t timeSum = mWorldClock.Hour * 120 + mWorldClock.Min * 2 +
-            secOffset;
-        int32_t sysTimeSum = mWorldClock.SystemHour * 3600 +
-            mWorldClock.SystemMin * 60 + mWorldClock.SystemSec;
+    if(mWorldClockEventTimes.size() != mWorldClockEvents.size())
+    {
+        // Times were registered before the clock was set or the schedule
+        // was cleared so every time needs to be scheduled
+        mWorldClockEventTimes.clear();
+        mWorldClockCalendar.clear();
 
         for(auto& pair : mWorldClockEvents)
         {
-            const WorldClockTime& t = pair.first;
-
-            // If the current time is not in the current phase,
-            // calculate next time to phase no matter what
-            bool inPhase = t.MoonPhase == -1 ||
-                t.MoonPhase == mWorldClock.MoonPhase;
-
-            uint32_t min = 0;
-            if(inPhase && t.SystemHour != -1)
-            {
-                // Time to system time
-                int32_t sysTimeSum2 = t.SystemHour * 3600 +
-                    t.SystemMin * 60;
-                min = (uint32_t)(sysTimeSum > sysTimeSum2
-                    ? (DAY_SEC - sysTimeSum + sysTimeSum2)
-                    : (sysTimeSum2 - sysTimeSum));
-            }
-            else if(inPhase && t.Hour != -1)
-            {
-                // Time to game time
-                int32_t timeSum2 = t.Hour * 120 + t.Min * 2;
-                min = (uint32_t)(timeSum > timeSum2
-                    ? (1440 - timeSum + timeSum2)
-                    : (timeSum2 - timeSum));
-            }
-            else
-            {
-                // Time to phase (full cycle if in phase)
-                uint8_t phaseDelta = (uint8_t)(
-                    mWorldClock.MoonPhase > t.MoonPhase
-                    ? (16 - mWorldClock.MoonPhase + t.MoonPhase)
-                    : t.MoonPhase - mWorldClock.MoonPhase);
-
-                // Scale to seconds and reduce by time in current phase
-                min = (uint32_t)((phaseDelta * 1440) - (timeSum % 1440));
-            }
+            ScheduleWorldClockEvent(pair.first);
+        }
+    }
+    else
+    {
+        // Only reschedule the times that have been reached, each one will
+        // be after the current time when scheduled again
+        while(mWorldClockCalendar.size() > 0 &&
+            mWorldClockCalendar.begin()->first <= mWorldClock.SystemTime)
+        {
+            auto times = mWorldClockCalendar.begin()->second;
+            mWorldClockCalendar.erase(mWorldClockCalendar.begin());
 
-            if(min != 0)
+            for(auto& t : times)
             {
-                nextTimes.insert(min);
+                ScheduleWorldClockEvent(t);
             }
         }
+    }
 
-        // Offset by the first one in the set
-        mNextEventTime = (uint32_t)(
-            mWorldClock.SystemTime + *nextTimes.begin());
+    // Midnight is always an option as day based times are not compared
+    // at that level
+    uint32_t timeToMidnight = (uint32_t)(
+        ((23 - mWorldClock.SystemHour) * 3600) +
+        ((59 - mWorldClock.SystemMin) * 60) + (60 - mWorldClock.SystemSec));
+
+    mNextEventTime = mWorldClock.SystemTime + timeToMidnight;
+    if(mWorldClockCalendar.size() > 0 &&
+        mWorldClockCalendar.begin()->first < mNextEventTime)
+    {
+        mNextEventTime = mWorldClockCalendar.begin()->first;
     }
-    else
+}
+
+void ChannelServer::ScheduleWorldClockEvent(const WorldClockTime& time)
+{
+    UnscheduleWorldClockEvent(time);
+
+    uint32_t next = mWorldClock.SystemTime +
+        mWorldClock.GetSecondsUntil(time);
+
+    mWorldClockEventTimes[time] = next;
+    mWorldClockCalendar[next].insert(time);
+}
+
+void ChannelServer::UnscheduleWorldClockEvent(const WorldClockTime& time)
+{
+    auto it = mWorldClockEventTimes.find(time);
+    if(it == mWorldClockEventTimes.end())
     {
-        mNextEventTime = 0;
+        return;
     }
+
+    auto calIter = mWorldClockCalendar.find(it->second);
+    if(calIter != mWorldClockCalendar.end())
+    {
+        calIter->second.erase(time);
+        if(calIter->second.size() == 0)
+        {
+            mWorldClockCalendar.erase(calIter);
+        }
+    }
+
+    mWorldClockEventTimes.erase(it);
 }
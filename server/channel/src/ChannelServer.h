@@ -302,6 +302,14 @@ public:
      */
     TokuseiManager* GetTokuseiManager() const;
 
+    /**
+     * Get a digest of the data loaded during startup. The digest is the
+     * same no matter what order the data was loaded in so it can be used
+     * to check that a parallel startup matches a serial one.
+     * @return Digest of the loaded zones, instances, tokusei and geometry
+     */
+    uint64_t GetStartupDigest();
+
     /**
      * Get the world server supplied shared config settings.
      * @return Pointer to the world shared config
@@ -406,6 +414,13 @@ public:
      */
     void HandleDemonQuestReset();
 
+    /**
+     * Gather the population and tick health of the channel since the last
+     * report into a telemetry record and send it to the world. By default
+     * this is scheduled to execute every 30 seconds.
+     */
+    void SendTelemetry();
+
     /**
      * Schedule code work to be queued by the next server tick that occurs
      * following the specified time.
@@ -464,9 +479,24 @@ protected:
     /**
      * Recalculate the next time the world clock will fire an event on.
      * This will be stored as a system timestamp for easy comparison.
+     * Only the registered times that have been reached are rescheduled
+     * unless the schedule has not been built for the current clock yet.
      */
     void RecalcNextWorldEventTime();
 
+    /**
+     * Schedule the next system time a registered world clock time will
+     * be reached, replacing any time it was scheduled for before.
+     * @param time Registered time to schedule
+     */
+    void ScheduleWorldClockEvent(const WorldClockTime& time);
+
+    /**
+     * Remove a world clock time from the schedule.
+     * @param time Registered time to remove
+     */
+    void UnscheduleWorldClockEvent(const WorldClockTime& time);
+
     /// Timestamp ordered map of prepared Execute messages and timestamps
     /// associated to when they should be queued following a server tick
     std::map<ServerTime,
@@ -480,6 +510,14 @@ protected:
     /// 4) Global zone event trigger
     std::map<WorldClockTime, std::set<uint8_t>> mWorldClockEvents;
 
+    /// Map of each world clock time in mWorldClockEvents to the next
+    /// system time it will be reached
+    std::map<WorldClockTime, uint32_t> mWorldClockEventTimes;
+
+    /// Calendar of the next system time each world clock time will be
+    /// reached to the times reached then, earliest first
+    std::map<uint32_t, std::set<WorldClockTime>> mWorldClockCalendar;
+
     /// Pointer to the manager in charge of connection messages.
     std::shared_ptr<ManagerConnection> mManagerConnection;
 
@@ -563,6 +601,32 @@ protected:
     /// Highest unique object ID currently assigned
     int64_t mMaxObjectID;
 
+    /// Number of ticks processed since the last telemetry report
+    uint32_t mTelemetryTickCount;
+
+    /// Total time (in microseconds) spent processing ticks since the last
+    /// telemetry report
+    uint64_t mTelemetryTickTotal;
+
+    /// Longest time (in microseconds) spent processing a single tick since
+    /// the last telemetry report
+    uint64_t mTelemetryTickMax;
+
+    /// Number of ticks that took longer than the tick delta to process
+    /// since the last telemetry report
+    uint32_t mTelemetryTickOverruns;
+
+    /// Number of ticks skipped by the tick thread since the last telemetry
+    /// report
+    uint32_t mTelemetryTicksMissed;
+
+    /// Longest time (in microseconds) spent processing the database
+    /// transaction queues in a single tick since the last telemetry report
+    uint64_t mTelemetryDBMax;
+
+    /// System time of the last telemetry report
+    uint32_t mTelemetryLastSent;
+
     /// Inidicates how many tick messages are sitting in the queue.
     /// Incremented by StartTick and decremented by Tick.
     uint8_t mTicksPending;
@@ -576,7 +640,8 @@ protected:
     /// Server lock for server time calculation
     std::mutex mTimeLock;
 
-    /// Server lock for setting the tick pending indicator
+    /// Server lock for setting the tick pending indicator and the
+    /// telemetry tick statistics
     std::mutex mTickLock;
 
     /// If the tick thread should continue running.
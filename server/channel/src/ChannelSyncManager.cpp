@@ -35,6 +35,8 @@
 
 // object Includes
 #include <Account.h>
+#include <ChannelPlacement.h>
+#include <ChannelTelemetry.h>
 #include <CharacterLogin.h>
 #include <EventCounter.h>
 #include <InstanceAccess.h>
@@ -89,7 +91,7 @@ namespace libcomp
 }
 
 ChannelSyncManager::ChannelSyncManager(const std::weak_ptr<
-    ChannelServer>& server) : mServer(server)
+    ChannelServer>& server) : mSyncScheduled(false), mServer(server)
 {
 }
 
@@ -122,6 +124,18 @@ bool ChannelSyncManager::Initialize()
 
     mRegisteredTypes["CharacterLogin"] = cfg;
 
+    cfg = std::make_shared<ObjectConfig>("ChannelPlacement", false);
+    cfg->BuildHandler = &DataSyncManager::New<objects::ChannelPlacement>;
+    cfg->UpdateHandler = &DataSyncManager::Update<ChannelSyncManager,
+        objects::ChannelPlacement>;
+
+    mRegisteredTypes["ChannelPlacement"] = cfg;
+
+    cfg = std::make_shared<ObjectConfig>("ChannelTelemetry", false);
+    cfg->BuildHandler = &DataSyncManager::New<objects::ChannelTelemetry>;
+
+    mRegisteredTypes["ChannelTelemetry"] = cfg;
+
     cfg = std::make_shared<ObjectConfig>("CharacterProgress", false, worldDB);
 
     mRegisteredTypes["CharacterProgress"] = cfg;
@@ -197,6 +211,8 @@ bool ChannelSyncManager::Initialize()
     const std::set<std::string> worldTypes =
         {
             "Account",
+            "ChannelPlacement",
+            "ChannelTelemetry",
             "CharacterLogin",
             "CharacterProgress",
             "EventCounter",
@@ -243,6 +259,51 @@ std::shared_ptr<objects::EventCounter>
     return it != mEventCounters.end() ? it->second : nullptr;
 }
 
+void ChannelSyncManager::ScheduleSyncOutgoing()
+{
+    mSyncScheduled = true;
+}
+
+void ChannelSyncManager::FlushScheduledSync()
+{
+    if(mSyncScheduled.exchange(false))
+    {
+        SyncOutgoing();
+    }
+}
+
+bool ChannelSyncManager::QueueRecordUpdate(
+    const std::shared_ptr<libcomp::Object>& record,
+    const libcomp::String& type)
+{
+    if(UpdateRecord(record, type))
+    {
+        ScheduleSyncOutgoing();
+        return true;
+    }
+
+    return false;
+}
+
+bool ChannelSyncManager::QueueRecordRemoval(
+    const std::shared_ptr<libcomp::Object>& record,
+    const libcomp::String& type)
+{
+    if(RemoveRecord(record, type))
+    {
+        ScheduleSyncOutgoing();
+        return true;
+    }
+
+    return false;
+}
+
+int8_t ChannelSyncManager::GetPlacementChannelID()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    return mChannelPlacement ? (int8_t)mChannelPlacement->GetChannelID() : -1;
+}
+
 namespace channel
 {
 template<>
@@ -445,6 +506,30 @@ void ChannelSyncManager::SyncComplete<objects::CharacterLogin>(
         removes);
 }
 
+template<>
+int8_t ChannelSyncManager::Update<objects::ChannelPlacement>(
+    const libcomp::String& type, const std::shared_ptr<libcomp::Object>& obj,
+    bool isRemove, const libcomp::String& source)
+{
+    (void)type;
+    (void)source;
+
+    auto placement = std::dynamic_pointer_cast<objects::ChannelPlacement>(obj);
+    if(isRemove)
+    {
+        if(mChannelPlacement == placement)
+        {
+            mChannelPlacement = nullptr;
+        }
+    }
+    else
+    {
+        mChannelPlacement = placement;
+    }
+
+    return SYNC_HANDLED;
+}
+
 template<>
 int8_t ChannelSyncManager::Update<objects::EventCounter>(
     const libcomp::String& type, const std::shared_ptr<libcomp::Object>& obj,
@@ -35,8 +35,12 @@
 // object Includes
 #include <SearchEntry.h>
 
+// Standard C++11 Includes
+#include <atomic>
+
 namespace objects
 {
+class ChannelPlacement;
 class EventCounter;
 }
 
@@ -91,6 +95,47 @@ public:
      */
     std::shared_ptr<objects::EventCounter> GetWorldEventCounter(int32_t type);
 
+    /**
+     * Mark the queued outgoing records to be sent on the next server tick
+     * instead of immediately. All records queued between ticks are sent
+     * together and records updated more than once are only sent once.
+     */
+    void ScheduleSyncOutgoing();
+
+    /**
+     * Send all queued outgoing records if a sync was scheduled since the
+     * last call. This is called once per server tick.
+     */
+    void FlushScheduledSync();
+
+    /**
+     * Queue an update of the supplied record and schedule it to be sent
+     * on the next server tick.
+     * @param record Pointer to the record to update
+     * @param type Type name of the record
+     * @return true if the record was queued
+     */
+    bool QueueRecordUpdate(const std::shared_ptr<libcomp::Object>& record,
+        const libcomp::String& type);
+
+    /**
+     * Queue a removal of the supplied record and schedule it to be sent
+     * on the next server tick.
+     * @param record Pointer to the record to remove
+     * @param type Type name of the record
+     * @return true if the record was queued
+     */
+    bool QueueRecordRemoval(const std::shared_ptr<libcomp::Object>& record,
+        const libcomp::String& type);
+
+    /**
+     * Get the channel the world has selected for new placements based
+     * upon the load reported by each channel.
+     * @return ID of the placement channel or -1 if the world has not
+     *  selected one
+     */
+    int8_t GetPlacementChannelID();
+
     /**
      * Server specific handler for explicit types of non-persistent records
      * being updated.
@@ -126,6 +171,13 @@ private:
     std::unordered_map<int32_t,
         std::shared_ptr<objects::EventCounter>> mEventCounters;
 
+    /// Indicates that queued outgoing records should be sent on the next
+    /// server tick
+    std::atomic<bool> mSyncScheduled;
+
+    /// Current channel placement selected by the world
+    std::shared_ptr<objects::ChannelPlacement> mChannelPlacement;
+
     /// Pointer to the channel server.
     std::weak_ptr<ChannelServer> mServer;
 };
@@ -116,8 +116,10 @@
 #include "ChannelServer.h"
 #include "ChannelSyncManager.h"
 #include "CultureMachineState.h"
+#include "DropTable.h"
 #include "EventManager.h"
 #include "FusionManager.h"
+#include "ItemBoxIndex.h"
 #include "ManagerConnection.h"
 #include "MatchManager.h"
 #include "SkillManager.h"
@@ -2113,6 +2115,9 @@ bool CharacterManager::AddRemoveItems(const std::shared_ptr<
         }
     }
 
+    // Index the box once for every item type being processed
+    ItemBoxIndex index(itemBox);
+
     // Loop until we're done
     std::list<uint16_t> updatedSlots;
     while(itemCounts.size() > 0)
@@ -2130,7 +2135,7 @@ bool CharacterManager::AddRemoveItems(const std::shared_ptr<
             return false;
         }
 
-        auto existing = GetExistingItems(character, itemType);
+        auto existing = index.GetItems(itemType);
         uint32_t maxStack = (uint32_t)def->GetPossession()->GetStackSize();
         if(add)
         {
@@ -2156,14 +2161,7 @@ bool CharacterManager::AddRemoveItems(const std::shared_ptr<
                 }
             }
 
-            std::list<size_t> freeSlots;
-            for(size_t i = 0; i < 50; i++)
-            {
-                if(itemBox->GetItems(i).IsNull())
-                {
-                    freeSlots.push_back(i);
-                }
-            }
+            std::list<size_t> freeSlots = index.GetFreeSlots();
 
             if(quantityLeft <= (freeSlots.size() * maxStack))
             {
@@ -2195,6 +2193,7 @@ bool CharacterManager::AddRemoveItems(const std::shared_ptr<
                                 // Remove the current item and add the compressed item
                                 // to the set
                                 itemBox->SetItems((size_t)item->GetBoxSlot(), NULLUUID);
+                                index.Remove(item, (size_t)item->GetBoxSlot());
                                 updatedSlots.push_back((uint16_t)item->GetBoxSlot());
                                 dbChanges->Delete(item);
 
@@ -2258,6 +2257,7 @@ bool CharacterManager::AddRemoveItems(const std::shared_ptr<
                             return false;
                         }
 
+                        index.Add(item);
                         updatedSlots.push_back((uint16_t)freeSlot);
                         dbChanges->Insert(item);
 
@@ -2366,6 +2366,7 @@ bool CharacterManager::AddRemoveItems(const std::shared_ptr<
                         return false;
                     }
 
+                    index.Remove(item, (size_t)slot);
                     dbChanges->Delete(item);
                 }
                 else
@@ -2398,23 +2399,12 @@ bool CharacterManager::AddRemoveItems(const std::shared_ptr<
 uint64_t CharacterManager::GetTotalMacca(const std::shared_ptr<
     objects::Character>& character)
 {
-    auto macca = GetExistingItems(character, SVR_CONST.ITEM_MACCA,
-        character->GetItemBoxes(0).Get());
-    auto maccaNotes = GetExistingItems(character,
-        SVR_CONST.ITEM_MACCA_NOTE, character->GetItemBoxes(0).Get());
-
-    uint64_t totalMacca = 0;
-    for(auto m : macca)
-    {
-        totalMacca += m->GetStackSize();
-    }
+    // Index once for both macca types
+    ItemBoxIndex index(character->GetItemBoxes(0).Get());
 
-    for(auto m : maccaNotes)
-    {
-        totalMacca += (uint64_t)(m->GetStackSize() * ITEM_MACCA_NOTE_AMOUNT);
-    }
-
-    return totalMacca;
+    return (uint64_t)index.GetCount(SVR_CONST.ITEM_MACCA) +
+        (uint64_t)index.GetCount(SVR_CONST.ITEM_MACCA_NOTE) *
+        (uint64_t)ITEM_MACCA_NOTE_AMOUNT;
 }
 
 bool CharacterManager::PayMacca(const std::shared_ptr<
@@ -2435,34 +2425,33 @@ bool CharacterManager::PayMacca(const std::shared_ptr<
 bool CharacterManager::CalculateMaccaPayment(const std::shared_ptr<
     channel::ChannelClientConnection>& client, uint64_t amount,
     std::list<std::shared_ptr<objects::Item>>& insertItems,
-    std::unordered_map<std::shared_ptr<objects::Item>, uint16_t>& stackAdjustItems)
+    std::unordered_map<std::shared_ptr<objects::Item>, uint16_t>& stackAdjustItems,
+    const ItemBoxIndex* index)
 {
     auto state = client->GetClientState();
     auto cState = state->GetCharacterState();
     auto character = cState->GetEntity();
     auto inventory = character->GetItemBoxes(0).Get();
 
-    auto macca = GetExistingItems(character, SVR_CONST.ITEM_MACCA, inventory);
-    auto maccaNotes = GetExistingItems(character, SVR_CONST.ITEM_MACCA_NOTE,
-        inventory);
-
-    uint64_t totalMacca = 0;
-    for(auto m : macca)
-    {
-        totalMacca += m->GetStackSize();
-    }
-
-    for(auto m : maccaNotes)
+    // Index once for both macca types if the caller did not
+    std::unique_ptr<ItemBoxIndex> localIndex;
+    if(!index)
     {
-        totalMacca += (uint64_t)(m->GetStackSize() * ITEM_MACCA_NOTE_AMOUNT);
+        localIndex.reset(new ItemBoxIndex(inventory));
+        index = localIndex.get();
     }
 
+    uint64_t totalMacca = (uint64_t)index->GetCount(SVR_CONST.ITEM_MACCA) +
+        (uint64_t)index->GetCount(SVR_CONST.ITEM_MACCA_NOTE) *
+        (uint64_t)ITEM_MACCA_NOTE_AMOUNT;
     if(totalMacca < amount)
     {
         return false;
     }
 
     // Remove last first, starting with macca
+    auto macca = index->GetItems(SVR_CONST.ITEM_MACCA);
+    auto maccaNotes = index->GetItems(SVR_CONST.ITEM_MACCA_NOTE);
     macca.reverse();
     maccaNotes.reverse();
 
@@ -2534,13 +2523,15 @@ bool CharacterManager::CalculateMaccaPayment(const std::shared_ptr<
 
 uint64_t CharacterManager::CalculateItemRemoval(const std::shared_ptr<
     channel::ChannelClientConnection>& client, uint32_t itemID, uint64_t amount,
-    std::unordered_map<std::shared_ptr<objects::Item>, uint16_t>& stackAdjustItems)
+    std::unordered_map<std::shared_ptr<objects::Item>, uint16_t>& stackAdjustItems,
+    const ItemBoxIndex* index)
 {
     auto state = client->GetClientState();
     auto cState = state->GetCharacterState();
     auto character = cState->GetEntity();
 
-    auto items = GetExistingItems(character, itemID);
+    auto items = index ? index->GetItems(itemID)
+        : GetExistingItems(character, itemID);
     items.reverse();
 
     uint64_t left = amount;
@@ -2936,7 +2927,8 @@ std::list<std::shared_ptr<objects::DropSet>>
                 else if(dropSet->ConditionsCount() > 0)
                 {
                     if(!server->GetEventManager()->EvaluateEventConditions(
-                        zone, dropSet->GetConditions(), client))
+                        zone, dropSet.get(), dropSet->GetConditions(),
+                        client))
                     {
                         valid = false;
                     }
@@ -2967,35 +2959,12 @@ std::list<std::shared_ptr<objects::ItemDrop>> CharacterManager::DetermineDrops(
     float globalDropBonus = sharedConfig->GetDropRateBonus();
     float scalingCap = sharedConfig->GetDropLuckScalingCap();
 
-    for(auto drop : drops)
+    for(auto& drop : drops)
     {
-        double baseRate = (double)drop->GetRate();
-        uint32_t dropRate = (uint32_t)(baseRate * 100.0);
-        if(luck > 0 && scalingCap != 0.f)
-        {
-            // Scale drop rates based on luck, more for high drop rates and higher luck.
-            // Estimates roughly to:
-            // 75% base -> 76.47% at 10 luck, 87.26% at 30 luck, 100+% at 44+ luck
-            // 50% base -> 51.83% at 20 luck, 57.05% at 40 luck, 100+% at 114+ luck
-            // 10% base -> 10.57% at 40 luck, 22.7% at 200 luck, 100+% at 600+ luck
-            // 1% base -> 3.33% at 300 luck, 6.83% at 500 luck, 12.78% at 750 luck
-            // 0.1% base -> 0.89% at 600 luck, 1.39% at 800 luck, 1.95% at 999 luck
-            double deltaDiff = (double)(100.0 - baseRate);
-            dropRate = (uint32_t)(baseRate * (100.f +
-                100.f * (float)(((double)luck / 30.0) * 10.0 * (double)luck) /
-                (1000.0 + 7.0 * (double)luck + (deltaDiff * deltaDiff))));
-
-            // Limit luck scaling based on cap
-            if(scalingCap > 0.f &&
-                (float)((double)dropRate / (baseRate * 100.0)) > (1.f + scalingCap))
-            {
-                dropRate = (uint32_t)(baseRate * 100.0 * (1.0 + (double)scalingCap));
-            }
-        }
-
-        dropRate = (uint32_t)((double)dropRate * (double)(1.f + globalDropBonus));
+        uint32_t dropRate = DropTable::GetDropRate((double)drop->GetRate(),
+            luck, globalDropBonus, scalingCap);
 
-        if(dropRate >= 10000 || RNG(uint16_t, 1, 10000) <= dropRate ||
+        if(DropTable::RollRate(dropRate) ||
             (minLast && results.size() == 0 && drops.back() == drop))
         {
             results.push_back(drop);
@@ -3005,12 +2974,86 @@ std::list<std::shared_ptr<objects::ItemDrop>> CharacterManager::DetermineDrops(
     return results;
 }
 
+std::list<std::shared_ptr<objects::ItemDrop>> CharacterManager::DetermineDrops(
+    const std::shared_ptr<objects::DropSet>& dropSet, int16_t luck,
+    bool minLast)
+{
+    std::list<std::shared_ptr<objects::ItemDrop>> results;
+
+    auto table = dropSet ? GetDropTable(dropSet) : nullptr;
+    if(table)
+    {
+        table->Roll(luck, minLast, results);
+    }
+
+    return results;
+}
+
+std::shared_ptr<DropTable> CharacterManager::GetDropTable(
+    const std::shared_ptr<objects::DropSet>& dropSet)
+{
+    auto sharedConfig = mServer.lock()->GetWorldSharedConfig();
+    float globalDropBonus = sharedConfig->GetDropRateBonus();
+    float scalingCap = sharedConfig->GetDropLuckScalingCap();
+
+    std::lock_guard<std::mutex> lock(mDropTableLock);
+
+    auto& table = mDropTables[dropSet->GetID()];
+    if(!table || !table->Matches(dropSet, globalDropBonus, scalingCap))
+    {
+        table = std::make_shared<DropTable>(dropSet, globalDropBonus,
+            scalingCap);
+    }
+
+    return table;
+}
+
+void CharacterManager::GetDropTables(
+    const std::list<std::shared_ptr<objects::DropSet>>& dropSets,
+    std::vector<std::shared_ptr<DropTable>>& tables)
+{
+    tables.clear();
+    if(dropSets.size() == 0)
+    {
+        return;
+    }
+
+    auto sharedConfig = mServer.lock()->GetWorldSharedConfig();
+    float globalDropBonus = sharedConfig->GetDropRateBonus();
+    float scalingCap = sharedConfig->GetDropLuckScalingCap();
+
+    // Look up every table under one lock instead of one per drop set
+    std::lock_guard<std::mutex> lock(mDropTableLock);
+
+    for(auto& dropSet : dropSets)
+    {
+        auto& table = mDropTables[dropSet->GetID()];
+        if(!table || !table->Matches(dropSet, globalDropBonus, scalingCap))
+        {
+            table = std::make_shared<DropTable>(dropSet, globalDropBonus,
+                scalingCap);
+        }
+
+        tables.push_back(table);
+    }
+}
+
 bool CharacterManager::CreateLootFromDrops(const std::shared_ptr<objects::LootBox>& box,
     const std::list<std::shared_ptr<objects::ItemDrop>>& drops, int16_t luck,
     bool minLast, float maccaRate, float magRate)
 {
     auto dSet = DetermineDrops(drops, luck, minLast);
-    auto lootItems = CreateLootFromDrops(dSet, maccaRate, magRate);
+
+    return CreateLootFromDrops(box, std::vector<std::shared_ptr<
+        objects::ItemDrop>>(dSet.begin(), dSet.end()), maccaRate, magRate);
+}
+
+bool CharacterManager::CreateLootFromDrops(
+    const std::shared_ptr<objects::LootBox>& box,
+    const std::vector<std::shared_ptr<objects::ItemDrop>>& drops,
+    float maccaRate, float magRate)
+{
+    auto lootItems = CreateLootFromDrops(drops, maccaRate, magRate);
 
     bool added = false;
     if(lootItems.size() > 0)
@@ -3037,6 +3080,14 @@ bool CharacterManager::CreateLootFromDrops(const std::shared_ptr<objects::LootBo
 std::list<std::shared_ptr<objects::Loot>> CharacterManager::CreateLootFromDrops(
     const std::list<std::shared_ptr<objects::ItemDrop>>& drops,
     float maccaRate, float magRate)
+{
+    return CreateLootFromDrops(std::vector<std::shared_ptr<
+        objects::ItemDrop>>(drops.begin(), drops.end()), maccaRate, magRate);
+}
+
+std::list<std::shared_ptr<objects::Loot>> CharacterManager::CreateLootFromDrops(
+    const std::vector<std::shared_ptr<objects::ItemDrop>>& drops,
+    float maccaRate, float magRate)
 {
     auto server = mServer.lock();
     auto definitionManager = server->GetDefinitionManager();
@@ -3948,14 +3999,18 @@ bool CharacterManager::ReunionDemon(
             std::list<std::shared_ptr<objects::Item>> inserts;
             std::unordered_map<std::shared_ptr<objects::Item>, uint16_t> cost;
 
+            // Index once for both payments
+            ItemBoxIndex index(cState->GetEntity()->GetItemBoxes(0).Get());
+
             uint64_t maccaCost = (uint64_t)((rank > 0 ? rank : 1) * 500 *
                 cs->GetLevel());
-            success = CalculateMaccaPayment(client, maccaCost, inserts, cost);
+            success = CalculateMaccaPayment(client, maccaCost, inserts, cost,
+                &index);
 
             if(costItemType)
             {
                 success &= CalculateItemRemoval(client, costItemType,
-                    (uint64_t)itemsRequired, cost) == 0;
+                    (uint64_t)itemsRequired, cost, &index) == 0;
             }
 
             success &= UpdateItems(client, false, inserts, cost);
@@ -4786,7 +4841,7 @@ bool CharacterManager::UpdateEventCounter(const std::shared_ptr<
 
     if(!noSync)
     {
-        server->GetChannelSyncManager()->SyncRecordUpdate(eCounter,
+        server->GetChannelSyncManager()->QueueRecordUpdate(eCounter,
             "EventCounter");
     }
 
@@ -33,6 +33,9 @@
 // object Includes
 #include <MiCorrectTbl.h>
 
+// Standard C++11 Includes
+#include <mutex>
+
 // channel Includes
 #include "ChannelClientConnection.h"
 #include "Zone.h"
@@ -65,6 +68,8 @@ namespace channel
 {
 
 class ChannelServer;
+class DropTable;
+class ItemBoxIndex;
 
 /**
  * Manager to handle Character focused actions.
@@ -440,12 +445,16 @@ public:
      * @param insertItems Output list of new items to insert
      * @param stackAdjustItems Output map of items to adjust the stack size of
      *  including deletes listed with stack size 0
+     * @param index Optional index of the inventory shared by the other item
+     *  calculations of the same operation, the inventory is indexed here
+     *  if not supplied
      * @return true if the amount can be paid, false it cannot
      */
     bool CalculateMaccaPayment(const std::shared_ptr<
         channel::ChannelClientConnection>& client, uint64_t amount,
         std::list<std::shared_ptr<objects::Item>>& insertItems,
-        std::unordered_map<std::shared_ptr<objects::Item>, uint16_t>& stackAdjustItems);
+        std::unordered_map<std::shared_ptr<objects::Item>, uint16_t>& stackAdjustItems,
+        const ItemBoxIndex* index = nullptr);
 
     /**
      * Calculate the item updates needed to remove a number of items of a
@@ -455,11 +464,14 @@ public:
      * @param amount Amount to reduce the stacks by
      * @param stackAdjustItems Output map of items to adjust the stack size of
      *  including deletes listed with stack size 0
+     * @param index Optional index of the inventory shared by the other item
+     *  calculations of the same operation
      * @return Amount that could not be removed
      */
     uint64_t CalculateItemRemoval(const std::shared_ptr<
         channel::ChannelClientConnection>& client, uint32_t itemID, uint64_t amount,
-        std::unordered_map<std::shared_ptr<objects::Item>, uint16_t>& stackAdjustItems);
+        std::unordered_map<std::shared_ptr<objects::Item>, uint16_t>& stackAdjustItems,
+        const ItemBoxIndex* index = nullptr);
 
     /**
      * Update or validate a set of item changes to be applied simultaneously,
@@ -517,6 +529,39 @@ public:
         const std::list<std::shared_ptr<objects::ItemDrop>>& drops,
         int16_t luck, bool minLast = false);
 
+    /**
+     * Filter the item drops of a drop set based on drop rate and luck
+     * using the compiled drop table of the set.
+     * @param dropSet Pointer to the drop set to determine drops from
+     * @param luck Current luck value to use when calculating drop chances
+     * @param minLast Optional param to specify if the set needs at least
+     *  one item in which case the last item will be used
+     * @return List of item drops that should be "dropped"
+     */
+    std::list<std::shared_ptr<objects::ItemDrop>> DetermineDrops(
+        const std::shared_ptr<objects::DropSet>& dropSet,
+        int16_t luck, bool minLast = false);
+
+    /**
+     * Get the compiled drop table of a drop set, compiling it the first
+     * time it is requested or if the world drop rate config has changed.
+     * @param dropSet Pointer to the drop set
+     * @return Pointer to the drop table
+     */
+    std::shared_ptr<DropTable> GetDropTable(
+        const std::shared_ptr<objects::DropSet>& dropSet);
+
+    /**
+     * Get the compiled drop tables of multiple drop sets at once, compiling
+     * any that have not been requested yet or are out of date.
+     * @param dropSets Pointers to the drop sets
+     * @param tables Output vector to replace with the drop table of each
+     *  drop set in order
+     */
+    void GetDropTables(
+        const std::list<std::shared_ptr<objects::DropSet>>& dropSets,
+        std::vector<std::shared_ptr<DropTable>>& tables);
+
     /**
      * Create loot from drops based upon the supplied luck value (can be 0)
      * and add them to the supplied loot box.
@@ -536,6 +581,21 @@ public:
         const std::list<std::shared_ptr<objects::ItemDrop>>& drops, int16_t luck,
         bool minLast = false, float maccaRate = 1.f, float magRate = 1.f);
 
+    /**
+     * Create loot from pre-filtered drops and add them to the supplied
+     * loot box.
+     * @param box Pointer to the loot box
+     * @param drops Pointers to the item drops already rolled
+     * @param maccaRate Optional param to scale macca dropped. Does not
+     *  affect notes.
+     * @param magRate Optional param to scale mag dropped. Does not
+     *  affect pressers.
+     * @return true if one or more item was added, false if none were
+     */
+    bool CreateLootFromDrops(const std::shared_ptr<objects::LootBox>& box,
+        const std::vector<std::shared_ptr<objects::ItemDrop>>& drops,
+        float maccaRate = 1.f, float magRate = 1.f);
+
     /**
      * Create loot from pre-filtered drops
      * @param drops List of pointers to item drops
@@ -549,6 +609,19 @@ public:
         const std::list<std::shared_ptr<objects::ItemDrop>>& drops,
         float maccaRate = 1.f, float magRate = 1.f);
 
+    /**
+     * Create loot from pre-filtered drops
+     * @param drops Pointers to item drops
+     * @param maccaRate Optional param to scale macca dropped. Does not
+     *  affect notes.
+     * @param magRate Optional param to scale mag dropped. Does not
+     *  affect pressers.
+     * @return List of pointers to converted Loot representations
+     */
+    std::list<std::shared_ptr<objects::Loot>> CreateLootFromDrops(
+        const std::vector<std::shared_ptr<objects::ItemDrop>>& drops,
+        float maccaRate = 1.f, float magRate = 1.f);
+
     /**
      * Send the loot item data related to a loot box to one or more clients.
      * @param clients List of clients to send the packet to
@@ -1545,6 +1618,12 @@ private:
 
     /// Pointer to the channel server
     std::weak_ptr<ChannelServer> mServer;
+
+    /// Map of drop set IDs to their compiled drop tables
+    std::unordered_map<uint32_t, std::shared_ptr<DropTable>> mDropTables;
+
+    /// Lock for the compiled drop tables
+    std::mutex mDropTableLock;
 };
 
 } // namespace channel
@@ -2006,7 +2006,8 @@ bool ChatManager::GMCommand_Help(const std::shared_ptr<
         { "online", {
             "@online [NAME]",
             "Print how many players are online or check if the",
-            "character with a specific NAME is online."
+            "character with a specific NAME is online. Characters",
+            "on the current channel also show their send queue."
         } },
         { "penalty", {
             "@penalty [NAME]",
@@ -2749,9 +2750,10 @@ bool ChatManager::GMCommand_Online(const std::shared_ptr<
     if(GetStringArg(name, argsCopy))
     {
         // Get location of specific character
-        targetCharacter = objects::Character::LoadCharacterByName(
-            server->GetWorldDatabase(), name);
-        if(!targetCharacter)
+        std::shared_ptr<objects::Account> targetAccount;
+        std::shared_ptr<channel::ChannelClientConnection> targetClient;
+        if(!GetTargetCharacterAccount(name, true, targetCharacter,
+            targetAccount, targetClient))
         {
             return SendChatMessage(client, ChatType_t::CHAT_SELF,
                 libcomp::String("Invalid character name supplied for"
@@ -2764,9 +2766,26 @@ bool ChatManager::GMCommand_Online(const std::shared_ptr<
         uint32_t zoneID = login ? login->GetZoneID() : 0;
         if(zoneID)
         {
-            return SendChatMessage(client, ChatType_t::CHAT_SELF,
+            SendChatMessage(client, ChatType_t::CHAT_SELF,
                 libcomp::String("%1 is currently in zone %2")
                 .Arg(name).Arg(zoneID));
+
+            if(targetClient)
+            {
+                // Print the outgoing queue of characters on this channel
+                auto metrics = targetClient->GetQueueMetrics();
+                SendChatMessage(client, ChatType_t::CHAT_SELF,
+                    libcomp::String("Send queue: %1 bytes (peak %2) waiting"
+                        " %3 ms, %4 held moves, %5 dropped moves, %6"
+                        " coalesced sends")
+                    .Arg(metrics.QueuedBytes).Arg(metrics.PeakQueuedBytes)
+                    .Arg(metrics.OldestAge / 1000)
+                    .Arg(metrics.HeldPositionUpdates)
+                    .Arg(metrics.DroppedPositionUpdates)
+                    .Arg(metrics.CoalescedSends));
+            }
+
+            return true;
         }
         else
         {
@@ -0,0 +1,215 @@
+/**
+ * @file server/channel/src/DropTable.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Precompiled drop rates of a drop set.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DropTable.h"
+
+// libcomp Includes
+#include <Randomizer.h>
+
+// objects Includes
+#include <DropSet.h>
+#include <ItemDrop.h>
+
+// Standard C++11 Includes
+#include <atomic>
+
+using namespace channel;
+
+namespace
+{
+
+/// ID of the next table compiled
+std::atomic<uint64_t> gNextTableID(1);
+
+}
+
+DropRollBuffer::DropRollBuffer(int16_t luck) : mLuck(luck)
+{
+}
+
+int16_t DropRollBuffer::GetLuck() const
+{
+    return mLuck;
+}
+
+std::vector<std::shared_ptr<objects::ItemDrop>>& DropRollBuffer::GetDrops()
+{
+    return mDrops;
+}
+
+void DropRollBuffer::Clear()
+{
+    mDrops.clear();
+}
+
+DropTable::DropTable(const std::shared_ptr<objects::DropSet>& dropSet,
+    float globalDropBonus, float scalingCap) : mID(gNextTableID++),
+    mDropSet(dropSet), mGlobalDropBonus(globalDropBonus),
+    mScalingCap(scalingCap)
+{
+    auto drops = dropSet->GetDrops();
+
+    mEntries.reserve(drops.size());
+    mDrops.reserve(drops.size());
+
+    for(auto& drop : drops)
+    {
+        Entry entry;
+        entry.BaseRate = (double)drop->GetRate();
+        entry.Rate = GetDropRate(entry.BaseRate, 0, globalDropBonus,
+            scalingCap);
+
+        mEntries.push_back(entry);
+        mDrops.push_back(drop);
+    }
+}
+
+bool DropTable::Matches(const std::shared_ptr<objects::DropSet>& dropSet,
+    float globalDropBonus, float scalingCap) const
+{
+    // The table holds the drop set so it can be compared without locking
+    return mDropSet == dropSet && mGlobalDropBonus == globalDropBonus &&
+        mScalingCap == scalingCap;
+}
+
+std::shared_ptr<objects::DropSet> DropTable::GetDropSet() const
+{
+    return mDropSet;
+}
+
+const std::vector<std::shared_ptr<objects::ItemDrop>>&
+    DropTable::GetDrops() const
+{
+    return mDrops;
+}
+
+void DropTable::Roll(DropRollBuffer& buffer, bool minLast) const
+{
+    const uint32_t* rates = GetRates(buffer);
+
+    bool selected = false;
+    for(size_t i = 0; i < mEntries.size(); i++)
+    {
+        if(RollRate(rates ? rates[i] : mEntries[i].Rate) ||
+            (minLast && !selected && i + 1 == mEntries.size()))
+        {
+            buffer.mDrops.push_back(mDrops[i]);
+            selected = true;
+        }
+    }
+}
+
+void DropTable::Roll(int16_t luck, bool minLast,
+    std::list<std::shared_ptr<objects::ItemDrop>>& results) const
+{
+    // Luck only changes the rates if it can scale them at all
+    bool scaled = luck > 0 && mScalingCap != 0.f;
+
+    bool selected = false;
+    for(size_t i = 0; i < mEntries.size(); i++)
+    {
+        const Entry& entry = mEntries[i];
+
+        uint32_t dropRate = scaled ? GetDropRate(entry.BaseRate, luck,
+            mGlobalDropBonus, mScalingCap) : entry.Rate;
+
+        if(RollRate(dropRate) ||
+            (minLast && !selected && i + 1 == mEntries.size()))
+        {
+            results.push_back(mDrops[i]);
+            selected = true;
+        }
+    }
+}
+
+void DropTable::Roll(const std::list<std::shared_ptr<objects::ItemDrop>>& drops,
+    float globalDropBonus, float scalingCap, DropRollBuffer& buffer)
+{
+    for(auto& drop : drops)
+    {
+        if(RollRate(GetDropRate((double)drop->GetRate(), buffer.mLuck,
+            globalDropBonus, scalingCap)))
+        {
+            buffer.mDrops.push_back(drop);
+        }
+    }
+}
+
+uint32_t DropTable::GetDropRate(double baseRate, int16_t luck,
+    float globalDropBonus, float scalingCap)
+{
+    uint32_t dropRate = (uint32_t)(baseRate * 100.0);
+    if(luck > 0 && scalingCap != 0.f)
+    {
+        // Scale drop rates based on luck, more for high drop rates and higher luck.
+        // Estimates roughly to:
+        // 75% base -> 76.47% at 10 luck, 87.26% at 30 luck, 100+% at 44+ luck
+        // 50% base -> 51.83% at 20 luck, 57.05% at 40 luck, 100+% at 114+ luck
+        // 10% base -> 10.57% at 40 luck, 22.7% at 200 luck, 100+% at 600+ luck
+        // 1% base -> 3.33% at 300 luck, 6.83% at 500 luck, 12.78% at 750 luck
+        // 0.1% base -> 0.89% at 600 luck, 1.39% at 800 luck, 1.95% at 999 luck
+        double deltaDiff = (double)(100.0 - baseRate);
+        dropRate = (uint32_t)(baseRate * (100.f +
+            100.f * (float)(((double)luck / 30.0) * 10.0 * (double)luck) /
+            (1000.0 + 7.0 * (double)luck + (deltaDiff * deltaDiff))));
+
+        // Limit luck scaling based on cap
+        if(scalingCap > 0.f &&
+            (float)((double)dropRate / (baseRate * 100.0)) > (1.f + scalingCap))
+        {
+            dropRate = (uint32_t)(baseRate * 100.0 * (1.0 + (double)scalingCap));
+        }
+    }
+
+    return (uint32_t)((double)dropRate * (double)(1.f + globalDropBonus));
+}
+
+bool DropTable::RollRate(uint32_t dropRate)
+{
+    return dropRate >= 10000 || RNG(uint16_t, 1, 10000) <= dropRate;
+}
+
+const uint32_t* DropTable::GetRates(DropRollBuffer& buffer) const
+{
+    // Luck only changes the rates if it can scale them at all
+    if(buffer.mLuck <= 0 || mScalingCap == 0.f || mEntries.empty())
+    {
+        return nullptr;
+    }
+
+    auto& rates = buffer.mRates[mID];
+    if(rates.empty())
+    {
+        rates.reserve(mEntries.size());
+        for(auto& entry : mEntries)
+        {
+            rates.push_back(GetDropRate(entry.BaseRate, buffer.mLuck,
+                mGlobalDropBonus, mScalingCap));
+        }
+    }
+
+    return rates.data();
+}
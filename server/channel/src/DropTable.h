@@ -0,0 +1,224 @@
+/**
+ * @file server/channel/src/DropTable.h
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Precompiled drop rates of a drop set.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_DROPTABLE_H
+#define SERVER_CHANNEL_SRC_DROPTABLE_H
+
+// Standard C++11 Includes
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace objects
+{
+class DropSet;
+class ItemDrop;
+}
+
+namespace channel
+{
+
+class DropTable;
+
+/**
+ * Reusable output of rolling drop tables at one luck value. Selected drops
+ * are appended to the buffer and the luck scaled rates of each table rolled
+ * are kept so rolling the same table again only draws the random numbers.
+ * A buffer must only be used by one thread at a time.
+ */
+class DropRollBuffer
+{
+public:
+    /**
+     * Create a new buffer
+     * @param luck Luck value to use when calculating drop chances
+     */
+    DropRollBuffer(int16_t luck = 0);
+
+    /**
+     * Get the luck value the buffer rolls with
+     * @return Luck value
+     */
+    int16_t GetLuck() const;
+
+    /**
+     * Get the drops selected since the buffer was last cleared
+     * @return Selected drops in the order they were rolled
+     */
+    std::vector<std::shared_ptr<objects::ItemDrop>>& GetDrops();
+
+    /**
+     * Clear the selected drops, keeping the scaled rates
+     */
+    void Clear();
+
+private:
+    friend class DropTable;
+
+    /// Luck value the buffer rolls with
+    int16_t mLuck;
+
+    /// Drops selected since the buffer was last cleared
+    std::vector<std::shared_ptr<objects::ItemDrop>> mDrops;
+
+    /// Luck scaled rates of each table rolled, keyed by table ID
+    std::unordered_map<uint64_t, std::vector<uint32_t>> mRates;
+};
+
+/**
+ * Flattened copy of the item drops in a drop set with the luck independent
+ * drop rate of each one already scaled by the world drop rate bonus. Rolling
+ * the table draws the same random numbers against the same rates as rolling
+ * the drops one at a time but does not touch the drop objects until they
+ * are selected. Tables are built once per drop set and world config and are
+ * not modified after that so they can be shared between threads.
+ */
+class DropTable
+{
+public:
+    /**
+     * Compile the drops of a drop set.
+     * @param dropSet Pointer to the drop set to compile
+     * @param globalDropBonus World drop rate bonus to apply
+     * @param scalingCap World cap on the luck scaling of drop rates
+     */
+    DropTable(const std::shared_ptr<objects::DropSet>& dropSet,
+        float globalDropBonus, float scalingCap);
+
+    /**
+     * Check if the table was compiled from the supplied drop set and world
+     * config values.
+     * @param dropSet Pointer to the drop set to compare
+     * @param globalDropBonus World drop rate bonus to compare
+     * @param scalingCap World luck scaling cap to compare
+     * @return true if the table is still current, false if it needs to be
+     *  compiled again
+     */
+    bool Matches(const std::shared_ptr<objects::DropSet>& dropSet,
+        float globalDropBonus, float scalingCap) const;
+
+    /**
+     * Get the drop set the table was compiled from
+     * @return Pointer to the drop set
+     */
+    std::shared_ptr<objects::DropSet> GetDropSet() const;
+
+    /**
+     * Get every drop in the table
+     * @return Item drops in drop set order
+     */
+    const std::vector<std::shared_ptr<objects::ItemDrop>>& GetDrops() const;
+
+    /**
+     * Roll each drop in the table at the luck of a buffer.
+     * @param buffer Buffer to append the selected drops to
+     * @param minLast If true and nothing is rolled, select the last drop
+     */
+    void Roll(DropRollBuffer& buffer, bool minLast = false) const;
+
+    /**
+     * Roll each drop in the table.
+     * @param luck Current luck value to use when calculating drop chances
+     * @param minLast If true and nothing is rolled, select the last drop
+     * @param results Output list to append the selected drops to
+     */
+    void Roll(int16_t luck, bool minLast,
+        std::list<std::shared_ptr<objects::ItemDrop>>& results) const;
+
+    /**
+     * Roll drops that do not belong to a drop set at the luck of a buffer.
+     * @param drops Item drops to roll
+     * @param globalDropBonus World drop rate bonus to apply
+     * @param scalingCap World cap on the luck scaling of drop rates
+     * @param buffer Buffer to append the selected drops to
+     */
+    static void Roll(const std::list<std::shared_ptr<objects::ItemDrop>>& drops,
+        float globalDropBonus, float scalingCap, DropRollBuffer& buffer);
+
+    /**
+     * Calculate the drop rate of a single drop out of 10000.
+     * @param baseRate Base drop rate percentage of the drop
+     * @param luck Current luck value to use when calculating the rate
+     * @param globalDropBonus World drop rate bonus to apply
+     * @param scalingCap World cap on the luck scaling of drop rates
+     * @return Drop rate out of 10000, which may exceed 10000
+     */
+    static uint32_t GetDropRate(double baseRate, int16_t luck,
+        float globalDropBonus, float scalingCap);
+
+    /**
+     * Check if a drop succeeds at the supplied rate, only rolling the
+     * random number if the drop is not guaranteed.
+     * @param dropRate Drop rate out of 10000
+     * @return true if the drop succeeds, false if it does not
+     */
+    static bool RollRate(uint32_t dropRate);
+
+private:
+    /**
+     * Get the rate of each entry at a luck value, scaling them into the
+     * buffer the first time the table is rolled with it.
+     * @param buffer Buffer holding the luck value and scaled rates
+     * @return Pointer to the scaled rates or null if luck does not change
+     *  the compiled rates
+     */
+    const uint32_t* GetRates(DropRollBuffer& buffer) const;
+
+    /**
+     * Compiled item drop.
+     */
+    struct Entry
+    {
+        /// Base drop rate percentage
+        double BaseRate;
+
+        /// Drop rate out of 10000 without luck, scaled by the world bonus
+        uint32_t Rate;
+    };
+
+    /// Unique ID of the table used to key the rates scaled in a buffer
+    uint64_t mID;
+
+    /// Drop set the table was compiled from
+    std::shared_ptr<objects::DropSet> mDropSet;
+
+    /// World drop rate bonus the table was compiled with
+    float mGlobalDropBonus;
+
+    /// World luck scaling cap the table was compiled with
+    float mScalingCap;
+
+    /// Compiled entries in drop set order
+    std::vector<Entry> mEntries;
+
+    /// Item drops matching each entry, only read once selected
+    std::vector<std::shared_ptr<objects::ItemDrop>> mDrops;
+};
+
+} // namespace channel
+
+#endif // SERVER_CHANNEL_SRC_DROPTABLE_H
@@ -0,0 +1,102 @@
+/**
+ * @file server/channel/src/EventConditionProgram.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Compiled event condition lists.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EventConditionProgram.h"
+
+// object Includes
+#include <EventFlagCondition.h>
+#include <EventScriptCondition.h>
+
+using namespace channel;
+
+EventConditionOp EventConditionOp::Compile(
+    const std::shared_ptr<objects::EventCondition>& condition)
+{
+    EventConditionOp op;
+    op.Negate = condition->GetNegate();
+    op.CharacterFlags = false;
+    op.InstanceFlags = false;
+    op.Condition = condition;
+
+    switch(condition->GetType())
+    {
+    case objects::EventCondition::Type_t::SCRIPT:
+        op.Kind = Kind_t::SCRIPT;
+        op.ScriptCondition = std::dynamic_pointer_cast<
+            objects::EventScriptCondition>(condition);
+        break;
+    case objects::EventCondition::Type_t::ZONE_FLAGS:
+    case objects::EventCondition::Type_t::ZONE_CHARACTER_FLAGS:
+    case objects::EventCondition::Type_t::ZONE_INSTANCE_FLAGS:
+    case objects::EventCondition::Type_t::ZONE_INSTANCE_CHARACTER_FLAGS:
+        op.Kind = Kind_t::FLAGS;
+        op.CharacterFlags = condition->GetType() ==
+            objects::EventCondition::Type_t::ZONE_CHARACTER_FLAGS ||
+            condition->GetType() ==
+            objects::EventCondition::Type_t::ZONE_INSTANCE_CHARACTER_FLAGS;
+        op.InstanceFlags = condition->GetType() ==
+            objects::EventCondition::Type_t::ZONE_INSTANCE_FLAGS ||
+            condition->GetType() ==
+            objects::EventCondition::Type_t::ZONE_INSTANCE_CHARACTER_FLAGS;
+        op.FlagCondition = std::dynamic_pointer_cast<
+            objects::EventFlagCondition>(condition);
+        break;
+    case objects::EventCondition::Type_t::PARTNER_ALIVE:
+    case objects::EventCondition::Type_t::PARTNER_FAMILIARITY:
+    case objects::EventCondition::Type_t::PARTNER_LEVEL:
+    case objects::EventCondition::Type_t::PARTNER_LOCKED:
+    case objects::EventCondition::Type_t::PARTNER_SKILL_LEARNED:
+    case objects::EventCondition::Type_t::PARTNER_STAT_VALUE:
+    case objects::EventCondition::Type_t::SOUL_POINTS:
+        op.Kind = Kind_t::PARTNER;
+        break;
+    case objects::EventCondition::Type_t::QUEST_AVAILABLE:
+    case objects::EventCondition::Type_t::QUEST_PHASE:
+    case objects::EventCondition::Type_t::QUEST_PHASE_REQUIREMENTS:
+    case objects::EventCondition::Type_t::QUEST_FLAGS:
+        op.Kind = Kind_t::QUEST;
+        break;
+    default:
+        op.Kind = Kind_t::STANDARD;
+        break;
+    }
+
+    return op;
+}
+
+EventConditionProgram EventConditionProgram::Compile(
+    const std::list<std::shared_ptr<objects::EventCondition>>& conditions)
+{
+    EventConditionProgram program;
+    program.Ops.reserve(conditions.size());
+
+    for(auto& condition : conditions)
+    {
+        program.Ops.push_back(EventConditionOp::Compile(condition));
+    }
+
+    return program;
+}
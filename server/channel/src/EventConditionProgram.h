@@ -0,0 +1,136 @@
+/**
+ * @file server/channel/src/EventConditionProgram.h
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Compiled event condition lists.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_EVENTCONDITIONPROGRAM_H
+#define SERVER_CHANNEL_SRC_EVENTCONDITIONPROGRAM_H
+
+// object Includes
+#include <EventCondition.h>
+
+// Standard C++11 Includes
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace objects
+{
+class EventFlagCondition;
+class EventScriptCondition;
+}
+
+namespace channel
+{
+
+/**
+ * Event condition with the path used to evaluate it and the typed condition
+ * that path reads resolved ahead of time so the type does not need to be
+ * switched on and cast again for every check.
+ */
+struct EventConditionOp
+{
+    /// Paths an event condition can be evaluated through
+    enum class Kind_t : uint8_t
+    {
+        SCRIPT = 0,     //!< Condition script
+        FLAGS,          //!< Zone or zone instance flag states
+        PARTNER,        //!< Partner demon of the client
+        QUEST,          //!< Quest progress of the client
+        STANDARD,       //!< Standard condition on the context entity
+    };
+
+    /**
+     * Compile an event condition
+     * @param condition Event condition to compile
+     * @return Compiled event condition
+     */
+    static EventConditionOp Compile(
+        const std::shared_ptr<objects::EventCondition>& condition);
+
+    /// Path to evaluate the condition through
+    Kind_t Kind;
+
+    /// true if the result of the condition is negated
+    bool Negate;
+
+    /// true if flag states of the client's character are checked
+    bool CharacterFlags;
+
+    /// true if zone instance flag states are checked instead of zone ones
+    bool InstanceFlags;
+
+    /// Condition being evaluated
+    std::shared_ptr<objects::EventCondition> Condition;
+
+    /// Condition as a script condition, only set for SCRIPT conditions
+    std::shared_ptr<objects::EventScriptCondition> ScriptCondition;
+
+    /// Condition as a flag condition, only set for FLAGS conditions
+    std::shared_ptr<objects::EventFlagCondition> FlagCondition;
+};
+
+/**
+ * Event condition list compiled when the server data is loaded. Every
+ * condition must pass, checked in list order.
+ */
+struct EventConditionProgram
+{
+    /**
+     * Compile an event condition list into a program that can be
+     * evaluated without switching on the condition types again.
+     * @param conditions Event conditions to compile
+     * @return Compiled condition program
+     */
+    static EventConditionProgram Compile(
+        const std::list<std::shared_ptr<objects::EventCondition>>& conditions);
+
+    /**
+     * Evaluate the program. Conditions are checked in list order, stopping
+     * at the first one that fails.
+     * @param leaf Function taking an EventConditionOp and returning true
+     *  if the single condition passes
+     * @return true if the entire condition list passes
+     */
+    template<typename F>
+    bool Evaluate(const F& leaf) const
+    {
+        for(auto& op : Ops)
+        {
+            if(!leaf(op))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// Conditions to evaluate, in list order
+    std::vector<EventConditionOp> Ops;
+};
+
+} // namespace channel
+
+#endif // SERVER_CHANNEL_SRC_EVENTCONDITIONPROGRAM_H
@@ -41,6 +41,10 @@
 // object Includes
 #include <Account.h>
 #include <AccountWorldData.h>
+#include <ActionCreateLoot.h>
+#include <ActionDelay.h>
+#include <ActionSpawn.h>
+#include <ActionStartEvent.h>
 #include <ChannelConfig.h>
 #include <ChannelLogin.h>
 #include <CharacterProgress.h>
@@ -97,6 +101,8 @@
 #include <ServerObject.h>
 #include <ServerZone.h>
 #include <ServerZoneInstance.h>
+#include <ServerZoneSpot.h>
+#include <ServerZoneTrigger.h>
 #include <Spawn.h>
 #include <SpawnGroup.h>
 #include <Team.h>
@@ -134,6 +140,184 @@ EventManager::~EventManager()
 {
 }
 
+bool EventManager::Initialize()
+{
+    auto serverDataManager = mServer.lock()->GetServerDataManager();
+
+    // Events and drop sets are only loaded by ID so gather every one the
+    // zones can reach, starting from the zone definitions themselves
+    std::set<libcomp::String> eventIDs;
+    std::set<uint32_t> dropSetIDs;
+    for(auto zonePair : serverDataManager->GetAllZoneIDs())
+    {
+        for(uint32_t dynamicMapID : zonePair.second)
+        {
+            auto zoneData = serverDataManager->GetZoneData(zonePair.first,
+                dynamicMapID, true);
+            if(!zoneData)
+            {
+                continue;
+            }
+
+            for(uint32_t dropSetID : zoneData->GetDropSetIDs())
+            {
+                dropSetIDs.insert(dropSetID);
+            }
+
+            for(uint32_t giftSetID : zoneData->GetGiftSetIDs())
+            {
+                dropSetIDs.insert(giftSetID);
+            }
+
+            for(auto npc : zoneData->GetNPCs())
+            {
+                GatherConditionReferences(npc->GetActions(), eventIDs,
+                    dropSetIDs);
+            }
+
+            for(auto obj : zoneData->GetObjects())
+            {
+                GatherConditionReferences(obj->GetActions(), eventIDs,
+                    dropSetIDs);
+            }
+
+            for(auto& spawnPair : zoneData->GetSpawns())
+            {
+                for(uint32_t dropSetID : spawnPair.second->GetDropSetIDs())
+                {
+                    dropSetIDs.insert(dropSetID);
+                }
+
+                for(uint32_t giftSetID : spawnPair.second->GetGiftSetIDs())
+                {
+                    dropSetIDs.insert(giftSetID);
+                }
+            }
+
+            for(auto& sgPair : zoneData->GetSpawnGroups())
+            {
+                GatherConditionReferences(sgPair.second->GetSpawnActions(),
+                    eventIDs, dropSetIDs);
+                GatherConditionReferences(sgPair.second->GetDefeatActions(),
+                    eventIDs, dropSetIDs);
+            }
+
+            for(auto& spotPair : zoneData->GetSpots())
+            {
+                GatherConditionReferences(spotPair.second->GetActions(),
+                    eventIDs, dropSetIDs);
+                GatherConditionReferences(spotPair.second->GetLeaveActions(),
+                    eventIDs, dropSetIDs);
+            }
+
+            for(auto trigger : zoneData->GetTriggers())
+            {
+                GatherConditionReferences(trigger->GetActions(), eventIDs,
+                    dropSetIDs);
+            }
+        }
+    }
+
+    // Follow every event to the ones it can move on to
+    std::set<libcomp::String> seen;
+    std::list<libcomp::String> pending(eventIDs.begin(), eventIDs.end());
+    auto addEventID = [&](const libcomp::String& nextID)
+        {
+            if(!nextID.IsEmpty() && seen.find(nextID) == seen.end())
+            {
+                pending.push_back(nextID);
+            }
+        };
+
+    auto addNext = [&](const std::shared_ptr<objects::EventBase>& eBase)
+        {
+            addEventID(eBase->GetNext());
+            addEventID(eBase->GetQueueNext());
+
+            for(auto branch : eBase->GetBranches())
+            {
+                AddConditionProgram(branch.get(), branch->GetConditions());
+                addEventID(branch->GetNext());
+                addEventID(branch->GetQueueNext());
+            }
+        };
+
+    while(pending.size() > 0)
+    {
+        libcomp::String eventID = pending.front();
+        pending.pop_front();
+
+        if(!seen.insert(eventID).second)
+        {
+            continue;
+        }
+
+        auto event = serverDataManager->GetEventData(eventID);
+        if(!event)
+        {
+            continue;
+        }
+
+        AddConditionProgram(event.get(), event->GetConditions());
+        addNext(event);
+
+        std::set<libcomp::String> actionEventIDs;
+        switch(event->GetEventType())
+        {
+        case objects::Event::EventType_t::ITIME:
+            for(auto choice : std::dynamic_pointer_cast<
+                objects::EventITime>(event)->GetChoices())
+            {
+                if(choice)
+                {
+                    AddConditionProgram(choice.get(),
+                        choice->GetConditions());
+                    addNext(choice);
+                }
+            }
+            break;
+        case objects::Event::EventType_t::PERFORM_ACTIONS:
+            GatherConditionReferences(std::dynamic_pointer_cast<
+                objects::EventPerformActions>(event)->GetActions(),
+                actionEventIDs, dropSetIDs);
+            break;
+        case objects::Event::EventType_t::PROMPT:
+            for(auto choice : std::dynamic_pointer_cast<
+                objects::EventPrompt>(event)->GetChoices())
+            {
+                AddConditionProgram(choice.get(), choice->GetConditions());
+                addNext(choice);
+            }
+            break;
+        default:
+            break;
+        }
+
+        for(auto& actionEventID : actionEventIDs)
+        {
+            addEventID(actionEventID);
+        }
+    }
+
+    for(uint32_t dropSetID : dropSetIDs)
+    {
+        auto dropSet = serverDataManager->GetDropSetData(dropSetID);
+        if(dropSet)
+        {
+            AddConditionProgram(dropSet.get(), dropSet->GetConditions());
+        }
+    }
+
+    LogEventManagerDebug([&]()
+    {
+        return libcomp::String("Compiled %1 event condition list(s) from"
+            " %2 event(s)\n").Arg(mConditionPrograms.size())
+            .Arg(seen.size());
+    });
+
+    return true;
+}
+
 bool EventManager::HandleEvent(
     const std::shared_ptr<ChannelClientConnection>& client,
     const libcomp::String& eventID, int32_t sourceEntityID,
@@ -919,17 +1103,18 @@ bool EventManager::EvaluateQuestConditions(EventContext& ctx, int16_t questID)
     return false;
 }
 
-bool EventManager::EvaluateEventCondition(EventContext& ctx, const std::shared_ptr<
-    objects::EventCondition>& condition)
+bool EventManager::EvaluateEventCondition(EventContext& ctx,
+    const EventConditionOp& op,
+    const std::shared_ptr<ActiveEntityState>& eState)
 {
     auto client = ctx.Client;
-    bool negate = condition->GetNegate();
-    switch(condition->GetType())
+    auto& condition = op.Condition;
+    bool negate = op.Negate;
+    switch(op.Kind)
     {
-    case objects::EventCondition::Type_t::SCRIPT:
+    case EventConditionOp::Kind_t::SCRIPT:
         {
-            auto scriptCondition = std::dynamic_pointer_cast<
-                objects::EventScriptCondition>(condition);
+            auto& scriptCondition = op.ScriptCondition;
             if(!scriptCondition)
             {
                 LogEventManagerErrorMsg(
@@ -996,68 +1181,37 @@ bool EventManager::EvaluateEventCondition(EventContext& ctx, const std::shared_p
             }
         }
         break;
-    case objects::EventCondition::Type_t::ZONE_FLAGS:
-    case objects::EventCondition::Type_t::ZONE_CHARACTER_FLAGS:
-    case objects::EventCondition::Type_t::ZONE_INSTANCE_FLAGS:
-    case objects::EventCondition::Type_t::ZONE_INSTANCE_CHARACTER_FLAGS:
+    case EventConditionOp::Kind_t::FLAGS:
         {
             int32_t worldCID = 0;
-            bool instanceCheck = false;
-            switch(condition->GetType())
+            if(op.CharacterFlags)
             {
-            case objects::EventCondition::Type_t::ZONE_FLAGS:
-                break;
-            case objects::EventCondition::Type_t::ZONE_CHARACTER_FLAGS:
                 if(client)
                 {
                     worldCID = client->GetClientState()->GetWorldCID();
                 }
                 else
                 {
+                    bool instanceCheck = op.InstanceFlags;
                     auto eventID = ctx.EventInstance->GetEvent()->GetID();
-                    LogEventManagerError([eventID]()
+                    LogEventManagerError([eventID, instanceCheck]()
                     {
-                        return libcomp::String("Attempted to check zone"
-                            " character flags with no associated client: %1\n")
+                        return libcomp::String("Attempted to check zone%1"
+                            " character flags with no associated client: %2\n")
+                            .Arg(instanceCheck ? " instance" : "")
                             .Arg(eventID);
                     });
 
                     return false;
                 }
-                break;
-            case objects::EventCondition::Type_t::ZONE_INSTANCE_FLAGS:
-                instanceCheck = true;
-                break;
-            case objects::EventCondition::Type_t::ZONE_INSTANCE_CHARACTER_FLAGS:
-                if(client)
-                {
-                    instanceCheck = true;
-                    worldCID = client->GetClientState()->GetWorldCID();
-                }
-                else
-                {
-                    auto eventID = ctx.EventInstance->GetEvent()->GetID();
-                    LogEventManagerError([eventID]()
-                    {
-                        return libcomp::String("Attempted to check zone"
-                            " instance character flags with no associated"
-                            " client: %1\n").Arg(eventID);
-                    });
-
-                    return false;
-                }
-                break;
-            default:
-                break;
             }
 
             auto zone = ctx.CurrentZone;
-            auto flagCon = std::dynamic_pointer_cast<
-                objects::EventFlagCondition>(condition);
+            auto& flagCon = op.FlagCondition;
             if(zone && flagCon)
             {
                 std::unordered_map<int32_t, int32_t> flagStates;
-                if(instanceCheck)
+                if(op.InstanceFlags)
                 {
                     auto inst = zone->GetInstance();
                     if(inst)
@@ -1092,41 +1246,79 @@ bool EventManager::EvaluateEventCondition(EventContext& ctx, const std::shared_p
             }
         }
         break;
-    case objects::EventCondition::Type_t::PARTNER_ALIVE:
-    case objects::EventCondition::Type_t::PARTNER_FAMILIARITY:
-    case objects::EventCondition::Type_t::PARTNER_LEVEL:
-    case objects::EventCondition::Type_t::PARTNER_LOCKED:
-    case objects::EventCondition::Type_t::PARTNER_SKILL_LEARNED:
-    case objects::EventCondition::Type_t::PARTNER_STAT_VALUE:
-    case objects::EventCondition::Type_t::SOUL_POINTS:
+    case EventConditionOp::Kind_t::PARTNER:
         return negate != (client && EvaluatePartnerCondition(client, condition));
-    case objects::EventCondition::Type_t::QUEST_AVAILABLE:
-    case objects::EventCondition::Type_t::QUEST_PHASE:
-    case objects::EventCondition::Type_t::QUEST_PHASE_REQUIREMENTS:
-    case objects::EventCondition::Type_t::QUEST_FLAGS:
+    case EventConditionOp::Kind_t::QUEST:
         return negate != (client && EvaluateQuestCondition(ctx, condition));
-    default:
+    case EventConditionOp::Kind_t::STANDARD:
+        return negate != EvaluateCondition(ctx, eState, condition,
+            condition->GetCompareMode());
+    }
+
+    // Always return false when invalid
+    return false;
+}
+
+void EventManager::AddConditionProgram(const libcomp::Object* owner,
+    const std::list<std::shared_ptr<objects::EventCondition>>& conditions)
+{
+    if(conditions.size() > 0)
+    {
+        mConditionPrograms[owner] = EventConditionProgram::Compile(
+            conditions);
+    }
+}
+
+void EventManager::GatherConditionReferences(
+    const std::list<std::shared_ptr<objects::Action>>& actions,
+    std::set<libcomp::String>& eventIDs, std::set<uint32_t>& dropSetIDs)
+{
+    auto currentActions = actions;
+
+    std::list<std::shared_ptr<objects::Action>> newActions;
+    while(currentActions.size() > 0)
+    {
+        // Actions can't nest forever so loop until we're done
+        for(auto action : currentActions)
         {
-            std::shared_ptr<ActiveEntityState> eState;
-            if(client)
+            switch(action->GetActionType())
             {
-                // Entity is the character, never the demon
-                eState = client->GetClientState()->GetCharacterState();
-            }
-            else if(ctx.CurrentZone)
-            {
-                // Entity is the "event/action source"
-                eState = ctx.CurrentZone->GetActiveEntity(
-                    ctx.EventInstance->GetSourceEntityID());
+            case objects::Action::ActionType_t::CREATE_LOOT:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionCreateLoot>(action);
+                    for(uint32_t dropSetID : act->GetDropSetIDs())
+                    {
+                        dropSetIDs.insert(dropSetID);
+                    }
+                }
+                break;
+            case objects::Action::ActionType_t::DELAY:
+                for(auto act2 : std::dynamic_pointer_cast<
+                    objects::ActionDelay>(action)->GetActions())
+                {
+                    newActions.push_back(act2);
+                }
+                break;
+            case objects::Action::ActionType_t::SPAWN:
+                for(auto act2 : std::dynamic_pointer_cast<
+                    objects::ActionSpawn>(action)->GetDefeatActions())
+                {
+                    newActions.push_back(act2);
+                }
+                break;
+            case objects::Action::ActionType_t::START_EVENT:
+                eventIDs.insert(std::dynamic_pointer_cast<
+                    objects::ActionStartEvent>(action)->GetEventID());
+                break;
+            default:
+                break;
             }
-
-            return negate != EvaluateCondition(ctx, eState, condition,
-                condition->GetCompareMode());
         }
-    }
 
-    // Always return false when invalid
-    return false;
+        currentActions = newActions;
+        newActions.clear();
+    }
 }
 
 bool EventManager::EvaluatePartnerCondition(const std::shared_ptr<
@@ -1421,7 +1613,7 @@ bool EventManager::Compare(int32_t value1, int32_t value2, int32_t value3,
 }
 
 bool EventManager::EvaluateEventConditions(
-    const std::shared_ptr<Zone>& zone,
+    const std::shared_ptr<Zone>& zone, const libcomp::Object* owner,
     const std::list<std::shared_ptr<objects::EventCondition>>& conditions,
     const std::shared_ptr<ChannelClientConnection>& client)
 {
@@ -1431,21 +1623,57 @@ bool EventManager::EvaluateEventConditions(
     ctx.CurrentZone = zone;
     ctx.AutoOnly = true;
 
-    return EvaluateEventConditions(ctx, conditions);
+    return EvaluateEventConditions(ctx, owner, conditions);
 }
 
 bool EventManager::EvaluateEventConditions(EventContext& ctx,
+    const libcomp::Object* owner,
     const std::list<std::shared_ptr<objects::EventCondition>>& conditions)
 {
-    for(auto condition : conditions)
+    if(conditions.size() == 0)
     {
-        if(!EvaluateEventCondition(ctx, condition))
+        return true;
+    }
+
+    // Standard conditions are checked against the same entity for the
+    // whole list so only look it up once it is needed
+    std::shared_ptr<ActiveEntityState> eState;
+    bool eStateResolved = false;
+    auto leaf = [&](const EventConditionOp& op)
         {
-            return false;
-        }
+            if(op.Kind == EventConditionOp::Kind_t::STANDARD &&
+                !eStateResolved)
+            {
+                if(ctx.Client)
+                {
+                    // Entity is the character, never the demon
+                    eState = ctx.Client->GetClientState()
+                        ->GetCharacterState();
+                }
+                else if(ctx.CurrentZone)
+                {
+                    // Entity is the "event/action source"
+                    eState = ctx.CurrentZone->GetActiveEntity(
+                        ctx.EventInstance->GetSourceEntityID());
+                }
+
+                eStateResolved = true;
+            }
+
+            return EvaluateEventCondition(ctx, op, eState);
+        };
+
+    // The programs are only written before the server starts so no lock
+    // is needed to read them
+    auto it = mConditionPrograms.find(owner);
+    if(it != mConditionPrograms.end())
+    {
+        return it->second.Evaluate(leaf);
     }
 
-    return true;
+    // Not reachable from any zone when the data was loaded (ex: started
+    // from a script) so compile it for this check only
+    return EventConditionProgram::Compile(conditions).Evaluate(leaf);
 }
 
 bool EventManager::EvaluateCondition(EventContext& ctx,
@@ -3487,7 +3715,7 @@ void EventManager::AddDemonQuestRewards(
                 if(!dropSet) continue;
 
                 for(auto drop : characterManager->DetermineDrops(
-                    dropSet->GetDrops(), 0))
+                    dropSet, 0))
                 {
                     dQuest->SetRewardItems(drop->GetItemType(),
                         RNG(uint16_t, drop->GetMinStack(),
@@ -3527,7 +3755,7 @@ void EventManager::AddDemonQuestRewards(
                     if(!dropSet) continue;
 
                     for(auto drop : characterManager->DetermineDrops(
-                        dropSet->GetDrops(), 0))
+                        dropSet, 0))
                     {
                         drops.push_back(drop);
                     }
@@ -3663,7 +3891,7 @@ void EventManager::AddDemonQuestRewards(
             if(!dropSet) continue;
 
             for(auto drop : characterManager->DetermineDrops(
-                dropSet->GetDrops(), 0))
+                dropSet, 0))
             {
                 drops.push_back(drop);
             }
@@ -4105,7 +4333,8 @@ bool EventManager::HandleEvent(EventContext& ctx)
 
     // If the event is conditional, check it now and end if it fails
     auto conditions = event->GetConditions();
-    if(conditions.size() > 0 && !EvaluateEventConditions(ctx, conditions))
+    if(conditions.size() > 0 &&
+        !EvaluateEventConditions(ctx, event.get(), conditions))
     {
         handled = true;
         EndEvent(client);
@@ -4326,7 +4555,7 @@ void EventManager::HandleNext(EventContext& ctx)
             {
                 auto conditions = branch->GetConditions();
                 if(conditions.size() > 0 && EvaluateEventConditions(
-                    ctx, conditions))
+                    ctx, branch.get(), conditions))
                 {
                     // Use the branch instead (first to pass is used)
                     nextEventID = branch->GetNext();
@@ -4531,7 +4760,8 @@ bool EventManager::Prompt(EventContext& ctx)
 
         auto conditions = choice->GetConditions();
         if(!skip &&
-            (conditions.size() == 0 || EvaluateEventConditions(ctx, conditions)))
+            (conditions.size() == 0 ||
+            EvaluateEventConditions(ctx, choice.get(), conditions)))
         {
             choices.push_back(choice);
         }
@@ -4781,7 +5011,8 @@ bool EventManager::ITime(EventContext& ctx)
             {
                 auto conditions = choice->GetConditions();
                 if(choice->GetMessageID() == 0 ||
-                    (conditions.size() > 0 && !EvaluateEventConditions(ctx, conditions)))
+                    (conditions.size() > 0 && !EvaluateEventConditions(ctx,
+                    choice.get(), conditions)))
                 {
                     ctx.EventInstance->InsertDisabledChoices((uint8_t)i);
                     choice = nullptr;
@@ -40,14 +40,20 @@
 
 // channel Includes
 #include "ChannelClientConnection.h"
+#include "EventConditionProgram.h"
+
+// Standard C++11 Includes
+#include <set>
 
 namespace libcomp
 {
+class Object;
 class ScriptEngine;
 }
 
 namespace objects
 {
+class Action;
 class EventConditionData;
 class EventFlagCondition;
 class EventInstance;
@@ -103,6 +109,13 @@ public:
      */
     ~EventManager();
 
+    /**
+     * Initialize the manager by compiling the condition lists of every
+     * event and drop set the zones can reach.
+     * @return true on success, false on failure
+     */
+    bool Initialize();
+
     /**
      * Handle a new event based upon the supplied ID, relative to an
      * optional entity
@@ -332,12 +345,14 @@ public:
     /**
      * Evaluate a list of event conditions for a client
      * @param zone Zone to evaluate the conditions in
+     * @param owner Pointer to the drop set or other object the conditions
+     *  belong to, used to find the program compiled for them
      * @param conditions Event conditions to evaluate
      * @param client Optional pointer to the client connection
      * @return true if the event conditions evaluate to true, otherwise false
      */
     bool EvaluateEventConditions(
-        const std::shared_ptr<Zone>& zone,
+        const std::shared_ptr<Zone>& zone, const libcomp::Object* owner,
         const std::list<std::shared_ptr<objects::EventCondition>>& conditions,
         const std::shared_ptr<ChannelClientConnection>& client = nullptr);
 
@@ -376,21 +391,49 @@ private:
     bool EvaluateQuestConditions(EventContext& ctx, int16_t questID);
 
     /**
-     * Evaluate an event condition
+     * Evaluate a compiled event condition
      * @param ctx Execution context of the event
-     * @param condition Event condition to evaluate
+     * @param op Compiled event condition to evaluate
+     * @param eState Pointer to the evaluating entity state for the context
+     *  used by standard conditions. Can be null
      * @return true if the event condition evaluates to true, otherwise false
      */
     bool EvaluateEventCondition(EventContext& ctx,
-        const std::shared_ptr<objects::EventCondition>& condition);
+        const EventConditionOp& op,
+        const std::shared_ptr<ActiveEntityState>& eState);
+
+    /**
+     * Compile the condition list of an event, branch, choice or drop set
+     * and store the program for the object
+     * @param owner Pointer to the object the conditions belong to
+     * @param conditions Event conditions of the object
+     */
+    void AddConditionProgram(const libcomp::Object* owner,
+        const std::list<std::shared_ptr<objects::EventCondition>>& conditions);
+
+    /**
+     * Add the events and drop sets referenced by a list of actions to
+     * the sets gathered when compiling the condition programs. Actions
+     * nested in other actions are gathered too.
+     * @param actions Actions to gather the references from
+     * @param eventIDs Output set of referenced event IDs
+     * @param dropSetIDs Output set of referenced drop set IDs
+     */
+    static void GatherConditionReferences(
+        const std::list<std::shared_ptr<objects::Action>>& actions,
+        std::set<libcomp::String>& eventIDs,
+        std::set<uint32_t>& dropSetIDs);
 
     /**
      * Evaluate a list of event conditions
      * @param ctx Execution context of the event
+     * @param owner Pointer to the event, branch, choice or drop set the
+     *  conditions belong to, used to find the program compiled for them
      * @param conditions Event conditions to evaluate
      * @return true if the event conditions evaluate to true, otherwise false
      */
     bool EvaluateEventConditions(EventContext& ctx,
+        const libcomp::Object* owner,
         const std::list<std::shared_ptr<objects::EventCondition>>& conditions);
 
     /**
@@ -644,6 +687,13 @@ private:
 
     /// Pointer to the channel server.
     std::weak_ptr<ChannelServer> mServer;
+
+    /// Compiled event condition lists mapped by the event, branch, choice
+    /// or drop set they belong to. Only built by Initialize before the
+    /// server starts so it is read without a lock. The server data keeps
+    /// every owner loaded so a key is never reused by another object.
+    std::unordered_map<const libcomp::Object*,
+        EventConditionProgram> mConditionPrograms;
 };
 
 } // namespace channel
@@ -0,0 +1,101 @@
+/**
+ * @file server/channel/src/FusionLevelTable.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Result demon of a fusion race for every adjusted level sum.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FusionLevelTable.h"
+
+using namespace channel;
+
+FusionLevelTable::FusionLevelTable()
+{
+}
+
+FusionLevelTable::FusionLevelTable(const std::vector<
+    std::pair<uint8_t, uint32_t>>& ranges) : mRanges(ranges)
+{
+    if(mRanges.size() == 0)
+    {
+        return;
+    }
+
+    // Negative levels always result in the first range so only the
+    // non-negative levels need an entry
+    mResults.resize(128);
+
+    size_t rangeIdx = 0;
+    for(size_t level = 0; level < 128; level++)
+    {
+        while(rangeIdx + 1 < mRanges.size() &&
+            (size_t)mRanges[rangeIdx].first < level)
+        {
+            rangeIdx++;
+        }
+
+        mResults[level] = mRanges[rangeIdx].second;
+    }
+}
+
+bool FusionLevelTable::IsEmpty() const
+{
+    return mResults.size() == 0;
+}
+
+uint32_t FusionLevelTable::GetResult(int8_t adjustedLevelSum) const
+{
+    if(mResults.size() == 0)
+    {
+        return 0;
+    }
+
+    return mResults[adjustedLevelSum < 0 ? 0 : (size_t)adjustedLevelSum];
+}
+
+uint32_t FusionLevelTable::RankUpDown(uint32_t demonType, bool up) const
+{
+    // Default to the current demon for up/down fusion at limit already
+    for(auto it = mRanges.begin(); it != mRanges.end(); it++)
+    {
+        if(it->second == demonType)
+        {
+            if(up)
+            {
+                it++;
+                if(it != mRanges.end())
+                {
+                    return it->second;
+                }
+            }
+            else if(it != mRanges.begin())
+            {
+                it--;
+                return it->second;
+            }
+
+            break;
+        }
+    }
+
+    return demonType;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file server/channel/src/FusionLevelTable.h
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Result demon of a fusion race for every adjusted level sum.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_FUSIONLEVELTABLE_H
+#define SERVER_CHANNEL_SRC_FUSIONLEVELTABLE_H
+
+// Standard C++11 Includes
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace channel
+{
+
+/**
+ * Fusion ranges of one race expanded into the result demon for every
+ * adjusted level sum so a fusion result is a single lookup instead of a
+ * walk over the ranges.
+ */
+class FusionLevelTable
+{
+public:
+    /**
+     * Create an empty table for a race with no fusion ranges
+     */
+    FusionLevelTable();
+
+    /**
+     * Create the table for a race
+     * @param ranges Fusion ranges of the race sorted by level, each
+     *  paired with the demon type that results at or below that level
+     */
+    FusionLevelTable(const std::vector<std::pair<uint8_t, uint32_t>>& ranges);
+
+    /**
+     * Check if the race has no fusion ranges
+     * @return true if the table is empty
+     */
+    bool IsEmpty() const;
+
+    /**
+     * Get the demon type an adjusted level sum results in: the first
+     * range at or above the level or the last range if the level is
+     * above all of them
+     * @param adjustedLevelSum Level to use when checking level ranges
+     * @return Type ID of the result demon or 0 if the table is empty
+     */
+    uint32_t GetResult(int8_t adjustedLevelSum) const;
+
+    /**
+     * Get the demon type directly above or below the supplied type in the
+     * fusion ranges by one rank
+     * @param demonType Type of the demon to adjust
+     * @param up true if checking higher, false if checking lower
+     * @return Demon type directly above or below the supplied type or the
+     *  supplied type if it is already at the limit or not in the ranges
+     */
+    uint32_t RankUpDown(uint32_t demonType, bool up) const;
+
+private:
+    /// Sorted fusion ranges of the race
+    std::vector<std::pair<uint8_t, uint32_t>> mRanges;
+
+    /// Result demon type for every adjusted level sum from 0 to 127,
+    /// empty if the race has no fusion ranges
+    std::vector<uint32_t> mResults;
+};
+
+} // namespace channel
+
+#endif // SERVER_CHANNEL_SRC_FUSIONLEVELTABLE_H
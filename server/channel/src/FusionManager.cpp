@@ -70,12 +70,64 @@ using namespace channel;
 FusionManager::FusionManager(const std::weak_ptr<
     ChannelServer>& server) : mServer(server)
 {
+    // Map race IDs to their table positions so lookups do not have to
+    // scan the tables
+    mRaceIndexes.fill(-1);
+    mTriFusionPriorities.fill(34);
+
+    for(size_t i = 34; i > 0; i--)
+    {
+        mRaceIndexes[FUSION_RACE_MAP[0][i - 1]] = (int8_t)(i - 1);
+        mTriFusionPriorities[TRIFUSION_RACE_PRIORITY[i - 1]] =
+            (uint8_t)(i - 1);
+    }
 }
 
 FusionManager::~FusionManager()
 {
 }
 
+bool FusionManager::Initialize()
+{
+    auto definitionManager = mServer.lock()->GetDefinitionManager();
+
+    // Expand the fusion ranges of every race into the result for every
+    // level once so fusions do not have to copy and walk them
+    for(size_t race = 1; race < 256; race++)
+    {
+        auto fusionRanges = definitionManager->GetFusionRanges(
+            (uint8_t)race);
+        if(fusionRanges.size() > 0)
+        {
+            mFusionTables[race] = FusionLevelTable(std::vector<
+                std::pair<uint8_t, uint32_t>>(fusionRanges.begin(),
+                    fusionRanges.end()));
+        }
+    }
+
+    // Races that can result from a 2-way fusion need ranges
+    for(size_t i = 0; i < 34; i++)
+    {
+        for(size_t j = 0; j < 34; j++)
+        {
+            uint8_t resultRace = FUSION_RACE_MAP[i + 1][j];
+            if(i != j && resultRace != 0 &&
+                mFusionTables[resultRace].IsEmpty())
+            {
+                LogFusionManagerWarning([&]()
+                {
+                    return libcomp::String("No valid fusion range found"
+                        " for race ID %1 fused from race IDs %2 and %3\n")
+                        .Arg(resultRace).Arg(FUSION_RACE_MAP[0][i])
+                        .Arg(FUSION_RACE_MAP[0][j]);
+                });
+            }
+        }
+    }
+
+    return true;
+}
+
 bool FusionManager::HandleFusion(
     const std::shared_ptr<ChannelClientConnection>& client,
     int64_t demonID1, int64_t demonID2, uint32_t costItemType)
@@ -480,8 +532,9 @@ uint32_t FusionManager::GetResultDemon(const std::shared_ptr<
         sources[2] = std::pair<uint32_t, bool>(special->GetSourceID3(),
             special->GetVariant3Allowed() == 1);
 
-        // Store each demon number that matches the corresponding source
-        std::array<std::set<uint8_t>, 3> matches;
+        // Store a bit for each demon number that matches the
+        // corresponding source
+        std::array<uint8_t, 3> matches = { { 0, 0, 0 } };
 
         bool match = true;
         for(size_t i = 0; i < 3; i++)
@@ -499,17 +552,17 @@ uint32_t FusionManager::GetResultDemon(const std::shared_ptr<
                     ->GetBaseDemonID();
                 if(baseDemonType1 == sourceBaseDemonType)
                 {
-                    matches[i].insert(1);
+                    matches[i] |= 0x01;
                 }
 
                 if(baseDemonType2 == sourceBaseDemonType)
                 {
-                    matches[i].insert(2);
+                    matches[i] |= 0x02;
                 }
 
                 if(baseDemonType3 == sourceBaseDemonType)
                 {
-                    matches[i].insert(3);
+                    matches[i] |= 0x04;
                 }
             }
             else
@@ -517,21 +570,21 @@ uint32_t FusionManager::GetResultDemon(const std::shared_ptr<
                 // Match against exact demon
                 if(demonType1 == sourceID)
                 {
-                    matches[i].insert(1);
+                    matches[i] |= 0x01;
                 }
 
                 if(demonType2 == sourceID)
                 {
-                    matches[i].insert(2);
+                    matches[i] |= 0x02;
                 }
 
                 if(demonType3 == sourceID)
                 {
-                    matches[i].insert(3);
+                    matches[i] |= 0x04;
                 }
             }
 
-            if(matches[i].size() == 0)
+            if(matches[i] == 0)
             {
                 // No match found for the current source demon
                 match = false;
@@ -546,31 +599,26 @@ uint32_t FusionManager::GetResultDemon(const std::shared_ptr<
             // two of the same type or a variant and a specific demon with
             // the same base type)
             match = false;
-            for(uint8_t m1 : matches[0])
+            for(uint8_t m1 = 0x01; m1 <= 0x04 && !match;
+                m1 = (uint8_t)(m1 << 1))
             {
-                for(uint8_t m2 : matches[1])
+                if(!(matches[0] & m1)) continue;
+
+                for(uint8_t m2 = 0x01; m2 <= 0x04 && !match;
+                    m2 = (uint8_t)(m2 << 1))
                 {
+                    if(!(matches[1] & m2) || m1 == m2) continue;
+
                     if(triFusion)
                     {
-                        for(uint8_t m3 : matches[2])
-                        {
-                            if(m1 != m2 && m1 != m3 && m2 != m3)
-                            {
-                                match = true;
-                                break;
-                            }
-                        }
-
-                        if(match) break;
+                        // Any remaining demon matching the third source
+                        match = (matches[2] & ~(m1 | m2)) != 0;
                     }
-                    else if(m1 != m2)
+                    else
                     {
                         match = true;
-                        break;
                     }
                 }
-
-                if(match) break;
             }
         }
 
@@ -601,7 +649,7 @@ uint32_t FusionManager::GetResultDemon(const std::shared_ptr<
         // Sort by level and priority for logic purposes
         std::list<std::pair<uint8_t,
             std::shared_ptr<objects::MiDevilData>>> defs = { def1, def2, def3 };
-        defs.sort([](auto& a, auto& b)
+        defs.sort([this](auto& a, auto& b)
             {
                 if(a.second->GetGrowth()->GetBaseLevel() !=
                     b.second->GetGrowth()->GetBaseLevel())
@@ -616,30 +664,8 @@ uint32_t FusionManager::GetResultDemon(const std::shared_ptr<
                     uint8_t ra = (uint8_t)a.second->GetCategory()->GetRace();
                     uint8_t rb = (uint8_t)b.second->GetCategory()->GetRace();
 
-                    size_t pa = 0;
-                    size_t pb = 0;
-
-                    for(size_t i = 0; i < 34; i++)
-                    {
-                        if(TRIFUSION_RACE_PRIORITY[i] == ra)
-                        {
-                            break;
-                        }
-
-                        pa++;
-                    }
-
-                    for(size_t i = 0; i < 34; i++)
-                    {
-                        if(TRIFUSION_RACE_PRIORITY[i] == rb)
-                        {
-                            break;
-                        }
-
-                        pb++;
-                    }
-
-                    return pa < pb;
+                    return mTriFusionPriorities[ra] <
+                        mTriFusionPriorities[rb];
                 }
             });
 
@@ -1797,10 +1823,10 @@ std::shared_ptr<objects::MiDevilData> FusionManager::GetResultDemon(
         return nullptr;
     }
 
-    // Normal race selection adjusted for level range
-    auto definitionManager = mServer.lock()->GetDefinitionManager();
-    auto fusionRanges = definitionManager->GetFusionRanges(race);
-    if(fusionRanges.size() == 0)
+    // Normal race selection adjusted for level range, precalculated for
+    // every level when the manager was initialized
+    auto& table = mFusionTables[race];
+    if(table.IsEmpty())
     {
         LogFusionManagerError([&]()
         {
@@ -1811,19 +1837,10 @@ std::shared_ptr<objects::MiDevilData> FusionManager::GetResultDemon(
         return nullptr;
     }
 
-    // Traverse the pre-sorted list and take the highest range accessible
-    uint32_t resultID = fusionRanges.front().second;
-    for(auto pair : fusionRanges)
-    {
-        resultID = pair.second;
+    uint32_t resultID = table.GetResult(adjustedLevelSum);
 
-        if(pair.first >= adjustedLevelSum)
-        {
-            break;
-        }
-    }
-
-    return resultID ? definitionManager->GetDevilData(resultID) : nullptr;
+    return resultID ? mServer.lock()->GetDefinitionManager()
+        ->GetDevilData(resultID) : nullptr;
 }
 
 uint32_t FusionManager::GetElementalType(size_t elementalIndex) const
@@ -1872,18 +1889,11 @@ uint32_t FusionManager::GetElementalFuseResult(uint32_t elementalType,
 
 size_t FusionManager::GetRaceIndex(uint8_t raceID, bool& found)
 {
-    found = false;
+    int8_t raceIdx = mRaceIndexes[raceID];
 
-    for(size_t i = 0; i < 34; i++)
-    {
-        if(FUSION_RACE_MAP[0][i] == raceID)
-        {
-            found = true;
-            return i;
-        }
-    }
+    found = raceIdx >= 0;
 
-    return false;
+    return found ? (size_t)raceIdx : 0;
 }
 
 size_t FusionManager::GetElementalIndex(uint32_t elemType, bool& found)
@@ -1942,31 +1952,5 @@ bool FusionManager::IsTriFusionValid(const std::shared_ptr<
 uint32_t FusionManager::RankUpDown(uint8_t raceID, uint32_t demonType,
     bool up)
 {
-    auto fusionRanges = mServer.lock()->GetDefinitionManager()
-        ->GetFusionRanges(raceID);
-
-    // Default to the current demon for up/down fusion at limit already
-    for(auto it = fusionRanges.begin(); it != fusionRanges.end(); it++)
-    {
-        if(it->second == demonType)
-        {
-            if(up)
-            {
-                it++;
-                if(it != fusionRanges.end())
-                {
-                    return it->second;
-                }
-            }
-            else if(it != fusionRanges.begin())
-            {
-                it--;
-                return it->second;
-            }
-
-            break;
-        }
-    }
-
-    return demonType;
+    return mFusionTables[raceID].RankUpDown(demonType, up);
 }
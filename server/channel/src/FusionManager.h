@@ -29,6 +29,11 @@
 
 // channel Includes
 #include "ChannelClientConnection.h"
+#include "FusionLevelTable.h"
+
+// Standard C++11 Includes
+#include <array>
+#include <vector>
 
 namespace objects
 {
@@ -58,6 +63,13 @@ public:
      */
     virtual ~FusionManager();
 
+    /**
+     * Build the fusion lookup tables from the loaded definitions. Must be
+     * called once before any fusion is calculated.
+     * @return true on success
+     */
+    bool Initialize();
+
     /**
      * Perform a normal 2-way fusion and respond to the client with the
      * results
@@ -221,6 +233,18 @@ private:
 
     /// Pointer to the channel server.
     std::weak_ptr<ChannelServer> mServer;
+
+    /// Index of each race ID on the FUSION_RACE_MAP axes or -1 if the
+    /// race is not on the map
+    std::array<int8_t, 256> mRaceIndexes;
+
+    /// Position of each race ID in TRIFUSION_RACE_PRIORITY or 34 if the
+    /// race is not listed
+    std::array<uint8_t, 256> mTriFusionPriorities;
+
+    /// Result demon type of each race ID for every adjusted level sum,
+    /// empty if the race has no fusion ranges
+    std::array<FusionLevelTable, 256> mFusionTables;
 };
 
 } // namespace channel
@@ -0,0 +1,137 @@
+/**
+ * @file server/channel/src/ItemBoxIndex.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Index of the items in an item box by type and free slot.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ItemBoxIndex.h"
+
+// Standard C++11 Includes
+#include <algorithm>
+
+// object Includes
+#include <Item.h>
+#include <ItemBox.h>
+
+using namespace channel;
+
+ItemBoxIndex::ItemBoxIndex(const std::shared_ptr<objects::ItemBox>& box)
+{
+    for(size_t i = 0; i < ITEM_BOX_SLOT_COUNT; i++)
+    {
+        auto item = box->GetItems(i).Get();
+        if(!item)
+        {
+            mFreeSlots.set(i);
+            continue;
+        }
+
+        // Ensure nothing is somehow added twice
+        auto& items = mItems[item->GetType()];
+        if(std::find(items.begin(), items.end(), item) == items.end())
+        {
+            items.push_back(item);
+        }
+    }
+}
+
+std::list<std::shared_ptr<objects::Item>> ItemBoxIndex::GetItems(
+    uint32_t itemType) const
+{
+    auto it = mItems.find(itemType);
+    if(it != mItems.end())
+    {
+        return std::list<std::shared_ptr<objects::Item>>(it->second.begin(),
+            it->second.end());
+    }
+
+    return {};
+}
+
+uint32_t ItemBoxIndex::GetCount(uint32_t itemType) const
+{
+    uint32_t count = 0;
+
+    auto it = mItems.find(itemType);
+    if(it != mItems.end())
+    {
+        for(auto& item : it->second)
+        {
+            count = (uint32_t)(count + item->GetStackSize());
+        }
+    }
+
+    return count;
+}
+
+std::list<size_t> ItemBoxIndex::GetFreeSlots() const
+{
+    std::list<size_t> slots;
+    for(size_t i = 0; i < ITEM_BOX_SLOT_COUNT; i++)
+    {
+        if(mFreeSlots[i])
+        {
+            slots.push_back(i);
+        }
+    }
+
+    return slots;
+}
+
+void ItemBoxIndex::Add(const std::shared_ptr<objects::Item>& item)
+{
+    int8_t slot = item->GetBoxSlot();
+    if(slot < 0 || (size_t)slot >= ITEM_BOX_SLOT_COUNT)
+    {
+        return;
+    }
+
+    mFreeSlots.reset((size_t)slot);
+
+    // Keep the items in slot order
+    auto& items = mItems[item->GetType()];
+    auto it = items.begin();
+    while(it != items.end() && (*it)->GetBoxSlot() < slot)
+    {
+        it++;
+    }
+
+    items.insert(it, item);
+}
+
+void ItemBoxIndex::Remove(const std::shared_ptr<objects::Item>& item,
+    size_t slot)
+{
+    if(slot < ITEM_BOX_SLOT_COUNT)
+    {
+        mFreeSlots.set(slot);
+    }
+
+    auto it = mItems.find(item->GetType());
+    if(it != mItems.end())
+    {
+        auto& items = it->second;
+        items.erase(std::remove(items.begin(), items.end(), item),
+            items.end());
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ * @file server/channel/src/ItemBoxIndex.h
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Index of the items in an item box by type and free slot.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_ITEMBOXINDEX_H
+#define SERVER_CHANNEL_SRC_ITEMBOXINDEX_H
+
+// Standard C++11 Includes
+#include <bitset>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace objects
+{
+class Item;
+class ItemBox;
+}
+
+namespace channel
+{
+
+/// Number of slots in an item box
+const size_t ITEM_BOX_SLOT_COUNT = 50;
+
+/**
+ * Index of the items in an item box grouped by item type along with the
+ * set of free slots, built in a single pass over the box. Operations that
+ * query or modify several item types at once should build one index and
+ * keep it updated with Add and Remove as they change the box instead of
+ * scanning the box again for every type. The index does not observe the
+ * box so it must not be kept beyond the operation it was built for.
+ */
+class ItemBoxIndex
+{
+public:
+    /**
+     * Build a new index from the current contents of an item box
+     * @param box Pointer to the item box to index
+     */
+    ItemBoxIndex(const std::shared_ptr<objects::ItemBox>& box);
+
+    /**
+     * Get all indexed items of the specified type in slot order
+     * @param itemType Item type to retrieve
+     * @return List of pointers to the items of the matching type
+     */
+    std::list<std::shared_ptr<objects::Item>> GetItems(
+        uint32_t itemType) const;
+
+    /**
+     * Get the total stack size of all indexed items of the specified type
+     * @param itemType Item type to count
+     * @return Total stack size of all matching items
+     */
+    uint32_t GetCount(uint32_t itemType) const;
+
+    /**
+     * Get all free slots in ascending order
+     * @return List of free slots
+     */
+    std::list<size_t> GetFreeSlots() const;
+
+    /**
+     * Register an item that was placed in the box. The item's box slot
+     * must already be set.
+     * @param item Pointer to the item that was added
+     */
+    void Add(const std::shared_ptr<objects::Item>& item);
+
+    /**
+     * Unregister an item that was removed from the box, freeing its slot
+     * @param item Pointer to the item that was removed
+     * @param slot Slot the item was removed from
+     */
+    void Remove(const std::shared_ptr<objects::Item>& item, size_t slot);
+
+private:
+    /// Map of item types to the items of that type in slot order
+    std::unordered_map<uint32_t,
+        std::vector<std::shared_ptr<objects::Item>>> mItems;
+
+    /// Set of free slots in the box
+    std::bitset<ITEM_BOX_SLOT_COUNT> mFreeSlots;
+};
+
+} // namespace channel
+
+#endif // SERVER_CHANNEL_SRC_ITEMBOXINDEX_H
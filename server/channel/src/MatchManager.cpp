@@ -207,7 +207,7 @@ bool MatchManager::JoinQueue(const std::shared_ptr<
 
     if(queued)
     {
-        syncManager->SyncOutgoing();
+        syncManager->ScheduleSyncOutgoing();
     }
     else
     {
@@ -276,7 +276,7 @@ bool MatchManager::CancelQueue(const std::shared_ptr<
 
         if(queued)
         {
-            syncManager->SyncOutgoing();
+            syncManager->ScheduleSyncOutgoing();
         }
         else
         {
@@ -476,7 +476,7 @@ bool MatchManager::UpdateUBPoints(const std::shared_ptr<
 
         server->GetWorldDatabase()->ProcessChangeSet(dbChanges);
 
-        syncManager->SyncOutgoing();
+        syncManager->ScheduleSyncOutgoing();
 
         return true;
     }
@@ -4087,7 +4087,7 @@ bool MatchManager::CreatePvPInstance(const std::shared_ptr<
     instAccess->SetDefinitionID(instanceDefID);
     instAccess->SetVariantID(match->GetVariantID());
 
-    server->GetZoneManager()->CreateInstance(instAccess);
+    server->GetZoneManager()->CreateInstance(instAccess, true);
     auto instance = server->GetZoneManager()->GetInstance(instAccess
         ->GetInstanceID());
     if(!instance)
@@ -4880,7 +4880,7 @@ bool MatchManager::EndUltimateBattlePhase(const std::shared_ptr<Zone>& zone,
             syncManager->UpdateRecord(update, "UBResult");
         }
 
-        syncManager->SyncOutgoing();
+        syncManager->ScheduleSyncOutgoing();
     }
 
     ubMatch->SetPhaseBoss(0);
@@ -38,6 +38,7 @@
 #include <ServerDataManager.h>
 
 // Standard C++11 Includes
+#include <algorithm>
 #include <math.h>
 
 // object Includes
@@ -135,6 +136,7 @@
 #include "AIManager.h"
 #include "ChannelServer.h"
 #include "CharacterManager.h"
+#include "DropTable.h"
 #include "EventManager.h"
 #include "ManagerConnection.h"
 #include "MatchManager.h"
@@ -3103,6 +3105,14 @@ bool SkillManager::ProcessSkillResult(std::shared_ptr<objects::ActivatedAbility>
             srcPoint = *pSkill->RushStartPoint;
         }
 
+        // Gather targets where they are at the hit time so every skill
+        // hitting at the same time shares the zone spatial index
+        uint64_t hitTime = activated->GetHitTime();
+        if(!hitTime)
+        {
+            hitTime = ChannelServer::GetServerTime();
+        }
+
         switch(skillRange->GetAreaType())
         {
         case objects::MiEffectiveRangeData::AreaType_t::SOURCE:
@@ -3118,7 +3128,7 @@ bool SkillManager::ProcessSkillResult(std::shared_ptr<objects::ActivatedAbility>
                 ->GetHitboxSize() * 10.0);
 
             effectiveTargets = zone->GetActiveEntitiesInRadius(
-                srcPoint.x, srcPoint.y, aoeRange, true);
+                srcPoint.x, srcPoint.y, aoeRange, true, hitTime);
             break;
         case objects::MiEffectiveRangeData::AreaType_t::TARGET_RADIUS:
             // If the primary target is set and the hit was not absorbed,
@@ -3128,7 +3138,7 @@ bool SkillManager::ProcessSkillResult(std::shared_ptr<objects::ActivatedAbility>
                 // AoE range is not extended
                 effectiveTargets = zone->GetActiveEntitiesInRadius(
                     primaryTarget->GetCurrentX(), primaryTarget->GetCurrentY(),
-                    aoeRange, true);
+                    aoeRange, true, hitTime);
             }
             break;
         case objects::MiEffectiveRangeData::AreaType_t::FRONT_1:
@@ -3147,10 +3157,6 @@ bool SkillManager::ProcessSkillResult(std::shared_ptr<objects::ActivatedAbility>
                 maxTargetRange = maxTargetRange + (double)(effectiveSource
                     ->GetHitboxSize() * 10.0);
 
-                // Get entities in range using the target distance
-                auto potentialTargets = zone->GetActiveEntitiesInRadius(
-                    srcPoint.x, srcPoint.y, maxTargetRange, true);
-
                 // Center pointer of the arc
                 float sourceRot = ActiveEntityState::CorrectRotation(
                     effectiveSource->GetCurrentRotation());
@@ -3161,9 +3167,10 @@ bool SkillManager::ProcessSkillResult(std::shared_ptr<objects::ActivatedAbility>
                 // a source radius AoE)
                 float maxRotOffset = (float)(aoeRange * 0.001 * PI);
 
-                effectiveTargets = ZoneManager::GetEntitiesInFoV(
-                    potentialTargets, srcPoint.x, srcPoint.y, sourceRot,
-                    maxRotOffset, true);
+                // Get entities in the arc using the target distance
+                effectiveTargets = zone->GetActiveEntitiesInCone(
+                    srcPoint.x, srcPoint.y, maxTargetRange, sourceRot,
+                    maxRotOffset, true, hitTime);
             }
             break;
         case objects::MiEffectiveRangeData::AreaType_t::STRAIGHT_LINE:
@@ -3190,77 +3197,23 @@ bool SkillManager::ProcessSkillResult(std::shared_ptr<objects::ActivatedAbility>
                         srcPoint.y, dest.x, dest.y, (float)aoeRange, false);
                 }
 
-                std::list<Point> rect;
-                if(dest.y != srcPoint.y)
-                {
-                    // Set the line rectangle corner points from the source,
-                    // destination and perpendicular slope
-
-                    float pSlope = ((dest.x - srcPoint.x) /
-                        (dest.y - srcPoint.y)) * -1.f;
-                    float denom = (float)std::sqrt(1.0f + std::pow(pSlope, 2));
-
-                    float xOffset = (float)(lineWidth / denom);
-                    float yOffset = (float)fabs((pSlope * lineWidth) / denom);
-
-                    if(pSlope > 0)
-                    {
-                        rect.push_back(Point(srcPoint.x + xOffset,
-                            srcPoint.y + yOffset));
-                        rect.push_back(Point(srcPoint.x - xOffset,
-                            srcPoint.y - yOffset));
-                        rect.push_back(Point(dest.x - xOffset,
-                            dest.y - yOffset));
-                        rect.push_back(Point(dest.x + xOffset,
-                            dest.y + yOffset));
-                    }
-                    else
-                    {
-                        rect.push_back(Point(srcPoint.x - xOffset,
-                            srcPoint.y + yOffset));
-                        rect.push_back(Point(srcPoint.x + xOffset,
-                            srcPoint.y - yOffset));
-                        rect.push_back(Point(dest.x - xOffset,
-                            dest.y + yOffset));
-                        rect.push_back(Point(dest.x + xOffset,
-                            dest.y - yOffset));
-                    }
-                }
-                else if(dest.x != srcPoint.x)
-                {
-                    // Horizontal line, add points directly to +Y/-Y
-                    rect.push_back(Point(srcPoint.x, srcPoint.y + lineWidth));
-                    rect.push_back(Point(srcPoint.x, srcPoint.y - lineWidth));
-                    rect.push_back(Point(dest.x, dest.y - lineWidth));
-                    rect.push_back(Point(dest.x, dest.y + lineWidth));
-                }
-                else
+                if(dest == srcPoint)
                 {
                     // Same point, only add the target
                     effectiveTargets.push_back(primaryTarget);
                     break;
                 }
 
-                // Gather entities in the polygon as well as ones bisected
-                // by the boundaries on their hitbox
-                uint64_t now = ChannelServer::GetServerTime();
-                for(auto t : zone->GetActiveEntities())
-                {
-                    if(t == effectiveSource)
-                    {
-                        // Do not check, just add
-                        effectiveTargets.push_back(t);
-                        continue;
-                    }
-
-                    t->RefreshCurrentPosition(now);
+                // Gather entities in the rotated rectangle as well as ones
+                // bisected by the boundaries on their hitbox
+                effectiveTargets = zone->GetActiveEntitiesInRect(srcPoint,
+                    dest, lineWidth, true, hitTime);
 
-                    Point p(t->GetCurrentX(), t->GetCurrentY());
-                    if(ZoneManager::PointInPolygon(p, rect,
-                        (float)t->GetHitboxSize() * 10.f))
-                    {
-                        effectiveTargets.push_back(t);
-                    }
+                // Always include the source
+                if(std::find(effectiveTargets.begin(), effectiveTargets.end(),
+                    effectiveSource) == effectiveTargets.end())
+                {
+                    effectiveTargets.push_back(effectiveSource);
                 }
             }
             break;
@@ -6601,6 +6554,15 @@ void SkillManager::HandleKills(std::shared_ptr<ActiveEntityState> source,
 
         std::unordered_map<uint64_t, std::list<int32_t>> lootTimeEntityIDs;
         std::unordered_map<uint64_t, std::list<int32_t>> delayedLootEntityIDs;
+
+        // Every kill is rolled into the same buffers so the luck scaled
+        // rates are only calculated once per drop set. Destiny drops do
+        // not use luck.
+        DropRollBuffer normalDrops(luck);
+        DropRollBuffer destinyDrops;
+        std::vector<std::shared_ptr<DropTable>> dropTables;
+        bool rollDestiny = instance && sourceState;
+
         for(auto lPair : lStates)
         {
             auto lState = lPair.first;
@@ -6690,31 +6652,9 @@ void SkillManager::HandleKills(std::shared_ptr<ActiveEntityState> source,
                 }
             }
 
-            auto drops = GetItemDrops(source, eState, sourceClient, zone);
-
-            // Remove cooldown restricted drops
-            std::set<int32_t> invalid;
-            for(auto& pair : drops)
-            {
-                for(auto loot : pair.second)
-                {
-                    int32_t cd = loot->GetCooldownRestrict();
-                    if(cd)
-                    {
-                        if(sourceCooldowns.find(cd) == sourceCooldowns.end())
-                        {
-                            invalid.insert(cd);
-                        }
-                    }
-                }
-
-                pair.second.remove_if([invalid](
-                    const std::shared_ptr<objects::ItemDrop>& drop)
-                    {
-                        return invalid.find(drop->GetCooldownRestrict()) !=
-                            invalid.end();
-                    });
-            }
+            RollItemDrops(source, eState, sourceClient, zone,
+                sourceCooldowns, normalDrops, rollDestiny ? &destinyDrops
+                : nullptr, dropTables);
 
             if(validLooterIDs.size() > 0)
             {
@@ -6728,12 +6668,9 @@ void SkillManager::HandleKills(std::shared_ptr<ActiveEntityState> source,
                 }
             }
 
-            auto nDrops = drops[(uint8_t)objects::DropSet::Type_t::NORMAL];
-            auto dDrops = drops[(uint8_t)objects::DropSet::Type_t::DESTINY];
-
             uint64_t lootTime = 0;
-            if(characterManager->CreateLootFromDrops(lootBody, nDrops, luck,
-                false, maccaRate, magRate))
+            if(characterManager->CreateLootFromDrops(lootBody,
+                normalDrops.GetDrops(), maccaRate, magRate))
             {
                 // Bodies remain lootable for 120 seconds with loot
                 lootTime = (uint64_t)(now + 120000000);
@@ -6753,33 +6690,25 @@ void SkillManager::HandleKills(std::shared_ptr<ActiveEntityState> source,
                     true, true);
             }
 
-            if(dDrops.size() > 0 && instance && sourceState)
+            auto& filtered = destinyDrops.GetDrops();
+            if(rollDestiny && filtered.size() > 0)
             {
-                // Always add at least one item
-                auto filtered = characterManager->DetermineDrops(dDrops, 0, false);
-                if(filtered.size() == 0)
+                // Create loot one drop at a time so we don't combine
+                // two non-max stacks into one
+                std::list<std::shared_ptr<objects::Loot>> loot;
+                for(auto f : filtered)
                 {
-                    filtered = { libcomp::Randomizer::GetEntry(dDrops) };
-                }
-
-                if(filtered.size() > 0)
-                {
-                    // Create loot one drop at a time so we don't combine
-                    // two non-max stacks into one
-                    std::list<std::shared_ptr<objects::Loot>> loot;
-                    for(auto f : filtered)
+                    std::vector<std::shared_ptr<objects::ItemDrop>> dList =
+                        { f };
+                    for(auto l : characterManager->CreateLootFromDrops(
+                        dList))
                     {
-                        auto dList = { f };
-                        for(auto l : characterManager->CreateLootFromDrops(
-                            dList))
-                        {
-                            loot.push_back(l);
-                        }
+                        loot.push_back(l);
                     }
-
-                    zoneManager->UpdateDestinyBox(instance, sourceState
-                        ->GetWorldCID(), loot);
                 }
+
+                zoneManager->UpdateDestinyBox(instance, sourceState
+                    ->GetWorldCID(), loot);
             }
         }
 
@@ -9845,6 +9774,183 @@ std::unordered_map<uint8_t, std::list<
     return drops;
 }
 
+void SkillManager::RollItemDrops(
+    const std::shared_ptr<ActiveEntityState>& source,
+    const std::shared_ptr<ActiveEntityState>& eState,
+    const std::shared_ptr<ChannelClientConnection>& client,
+    const std::shared_ptr<Zone>& zone, const std::set<int32_t>& cooldowns,
+    DropRollBuffer& drops, DropRollBuffer* destinyDrops,
+    std::vector<std::shared_ptr<DropTable>>& tables)
+{
+    drops.Clear();
+    if(destinyDrops)
+    {
+        destinyDrops->Clear();
+    }
+
+    auto eBase = eState ? eState->GetEnemyBase() : nullptr;
+    auto spawn = eBase ? eBase->GetSpawnSource() : nullptr;
+    if(!spawn)
+    {
+        return;
+    }
+
+    auto server = mServer.lock();
+    auto characterManager = server->GetCharacterManager();
+    auto serverDataManager = server->GetServerDataManager();
+    auto sharedConfig = server->GetWorldSharedConfig();
+
+    // Roll specific spawn drops, then drop sets
+    DropTable::Roll(spawn->GetDrops(), sharedConfig->GetDropRateBonus(),
+        sharedConfig->GetDropLuckScalingCap(), drops);
+
+    std::list<uint32_t> dropSetIDs;
+    for(uint32_t dropSetID : spawn->GetDropSetIDs())
+    {
+        dropSetIDs.push_back(dropSetID);
+    }
+
+    if(spawn->GetInheritDrops())
+    {
+        // Add global drops
+        auto globalDef = serverDataManager->GetZonePartialData(0);
+        if(globalDef)
+        {
+            for(uint32_t dropSetID : globalDef->GetDropSetIDs())
+            {
+                dropSetIDs.push_back(dropSetID);
+            }
+        }
+
+        // Add zone drops
+        for(uint32_t dropSetID : zone->GetDefinition()->GetDropSetIDs())
+        {
+            dropSetIDs.push_back(dropSetID);
+        }
+    }
+
+    characterManager->GetDropTables(characterManager->DetermineDropSets(
+        dropSetIDs, zone, client), tables);
+
+    bool hasDestiny = false;
+    for(auto& table : tables)
+    {
+        switch(table->GetDropSet()->GetType())
+        {
+        case objects::DropSet::Type_t::NORMAL:
+            table->Roll(drops);
+            break;
+        case objects::DropSet::Type_t::DESTINY:
+            if(destinyDrops)
+            {
+                table->Roll(*destinyDrops);
+                if(table->GetDrops().size() > 0)
+                {
+                    hasDestiny = true;
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Special drop definitions and cooldown restrictions are applied after
+    // rolling so only the drops selected are copied or checked. Every drop
+    // is rolled independently so the result is the same as filtering first.
+    auto adjust = [&](const std::shared_ptr<objects::ItemDrop>& drop)
+        -> std::shared_ptr<objects::ItemDrop>
+        {
+            int32_t cd = drop->GetCooldownRestrict();
+            if(cd && cooldowns.find(cd) == cooldowns.end())
+            {
+                return nullptr;
+            }
+
+            switch(drop->GetType())
+            {
+            case objects::ItemDrop::Type_t::LEVEL_MULTIPLY:
+                {
+                    // Copy the drop and scale stacks
+                    auto copy = std::make_shared<objects::ItemDrop>(*drop);
+
+                    uint16_t min = copy->GetMinStack();
+                    uint16_t max = copy->GetMaxStack();
+                    float multiplier = (float)eState->GetLevel() *
+                        copy->GetModifier();
+
+                    copy->SetMinStack((uint16_t)((float)min * multiplier));
+                    copy->SetMaxStack((uint16_t)((float)max * multiplier));
+
+                    return copy;
+                }
+            case objects::ItemDrop::Type_t::RELATIVE_LEVEL_MIN:
+                // Only add if the (non-source) relative entity's level is
+                // at least the same as the source's level + the modifier
+                if(eState != source && (int32_t)eState->GetLevel() >=
+                    (int32_t)(source->GetLevel() + drop->GetModifier()))
+                {
+                    return drop;
+                }
+
+                return nullptr;
+            case objects::ItemDrop::Type_t::NORMAL:
+            default:
+                return drop;
+            }
+        };
+
+    auto adjustAll = [&](std::vector<std::shared_ptr<objects::ItemDrop>>& selected)
+        {
+            size_t count = 0;
+            for(auto& drop : selected)
+            {
+                auto adjusted = adjust(drop);
+                if(adjusted)
+                {
+                    selected[count++] = adjusted;
+                }
+            }
+
+            selected.resize(count);
+        };
+
+    adjustAll(drops.GetDrops());
+
+    if(hasDestiny)
+    {
+        auto& selected = destinyDrops->GetDrops();
+        adjustAll(selected);
+
+        if(selected.size() == 0)
+        {
+            // Always add at least one item
+            std::list<std::shared_ptr<objects::ItemDrop>> candidates;
+            for(auto& table : tables)
+            {
+                if(table->GetDropSet()->GetType() ==
+                    objects::DropSet::Type_t::DESTINY)
+                {
+                    for(auto& drop : table->GetDrops())
+                    {
+                        auto adjusted = adjust(drop);
+                        if(adjusted)
+                        {
+                            candidates.push_back(adjusted);
+                        }
+                    }
+                }
+            }
+
+            if(candidates.size() > 0)
+            {
+                selected.push_back(libcomp::Randomizer::GetEntry(
+                    candidates));
+            }
+        }
+    }
+}
+
 void SkillManager::ScheduleFreeLoot(uint64_t time, const std::shared_ptr<Zone>& zone,
     const std::list<int32_t>& lootEntityIDs, const std::set<int32_t>& worldCIDs)
 {
@@ -11773,8 +11879,8 @@ bool SkillManager::RandomItem(
     }
 
     // Get one drop from the set
-    auto drops = characterManager->DetermineDrops(dropSet->GetDrops(),
-        0, true);
+    auto drops = characterManager->DetermineDrops(dropSet, 0,
+        true);
     auto drop = libcomp::Randomizer::GetEntry(drops);
     if(!drop)
     {
@@ -57,6 +57,8 @@ class SkillTargetResult;
 class ActiveEntityState;
 class AIState;
 class ChannelServer;
+class DropRollBuffer;
+class DropTable;
 
 /**
  * Container for skill execution contextual parameters.
@@ -945,6 +947,30 @@ private:
             const std::shared_ptr<ChannelClientConnection>& client,
             const std::shared_ptr<Zone>& zone, bool giftMode = false);
 
+    /**
+     * Roll the drops of a killed enemy from its spawn drops and the compiled
+     * tables of its own, global and zone drop sets, then apply special drop
+     * definitions and cooldown restrictions to the drops selected.
+     * @param source Pointer to the entity that activated the skill
+     * @param eState Pointer to enemy which may or may not have spawn
+     *  information (ex: GM created enemy)
+     * @param client Pointer to the client connection related to the source,
+     *  can be null for non-player entity sources
+     * @param zone Pointer to the zone the entities belong to
+     * @param cooldowns Cooldown restrictions active on the source
+     * @param drops Buffer to roll normal drops into, cleared first
+     * @param destinyDrops Optional buffer to roll destiny drops into,
+     *  cleared first. At least one destiny drop is selected if the enemy
+     *  has any. Destiny drop sets are skipped if this is null.
+     * @param tables Reusable vector to hold the drop tables rolled
+     */
+    void RollItemDrops(const std::shared_ptr<ActiveEntityState>& source,
+        const std::shared_ptr<ActiveEntityState>& eState,
+        const std::shared_ptr<ChannelClientConnection>& client,
+        const std::shared_ptr<Zone>& zone, const std::set<int32_t>& cooldowns,
+        DropRollBuffer& drops, DropRollBuffer* destinyDrops,
+        std::vector<std::shared_ptr<DropTable>>& tables);
+
     /**
      * Schedule the adjustment of who is a valid looter for one or more loot
      * boxes.
@@ -0,0 +1,290 @@
+/**
+ * @file server/channel/src/StartupTaskGraph.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Runs startup tasks concurrently in dependency order.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StartupTaskGraph.h"
+
+// libcomp Includes
+#include <Log.h>
+
+// Standard C++11 Includes
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace channel;
+
+StartupTaskGraph::StartupTaskGraph(bool parallel) : mParallel(parallel)
+{
+}
+
+bool StartupTaskGraph::AddTask(const libcomp::String& name,
+    const std::function<bool()>& task,
+    const std::set<libcomp::String>& dependencies)
+{
+    std::list<size_t> dependencyIndexes;
+    for(auto& dependency : dependencies)
+    {
+        bool found = false;
+        for(size_t i = 0; i < mTasks.size(); i++)
+        {
+            if(mTasks[i].Name == dependency)
+            {
+                dependencyIndexes.push_back(i);
+                found = true;
+                break;
+            }
+        }
+
+        if(!found)
+        {
+            LogGeneralError([&]()
+            {
+                return libcomp::String("Startup task '%1' depends on unknown"
+                    " task '%2'\n").Arg(name).Arg(dependency);
+            });
+
+            return false;
+        }
+    }
+
+    for(auto& existing : mTasks)
+    {
+        if(existing.Name == name)
+        {
+            LogGeneralError([&]()
+            {
+                return libcomp::String("Duplicate startup task '%1'\n")
+                    .Arg(name);
+            });
+
+            return false;
+        }
+    }
+
+    for(size_t i : dependencyIndexes)
+    {
+        mTasks[i].Dependents.push_back(mTasks.size());
+    }
+
+    Task t;
+    t.Name = name;
+    t.Function = task;
+    t.DependencyCount = dependencyIndexes.size();
+
+    mTasks.push_back(t);
+
+    return true;
+}
+
+bool StartupTaskGraph::Run()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::list<size_t> ready;
+    for(size_t i = 0; i < mTasks.size(); i++)
+    {
+        auto& task = mTasks[i];
+        task.Pending = task.DependencyCount;
+        task.Ran = false;
+        task.Duration = 0;
+
+        if(!task.Pending)
+        {
+            ready.push_back(i);
+        }
+    }
+
+    bool failed = false;
+    if(!mParallel)
+    {
+        // Tasks can only depend on tasks added before them so the order
+        // they were added in is always valid
+        for(auto& task : mTasks)
+        {
+            if(!RunTask(task))
+            {
+                failed = true;
+                break;
+            }
+        }
+    }
+    else
+    {
+        std::mutex lock;
+        std::condition_variable readyCondition;
+        size_t running = 0;
+
+        auto worker = [&]()
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            while(true)
+            {
+                readyCondition.wait(guard, [&]()
+                {
+                    return failed || !ready.empty() || !running;
+                });
+
+                if(failed || ready.empty())
+                {
+                    // Either a task failed or everything that can run is
+                    // done
+                    break;
+                }
+
+                size_t idx = ready.front();
+                ready.pop_front();
+                running++;
+
+                guard.unlock();
+                bool success = RunTask(mTasks[idx]);
+                guard.lock();
+
+                running--;
+
+                if(!success)
+                {
+                    failed = true;
+                }
+                else
+                {
+                    for(size_t dependent : mTasks[idx].Dependents)
+                    {
+                        if(--mTasks[dependent].Pending == 0)
+                        {
+                            ready.push_back(dependent);
+                        }
+                    }
+                }
+
+                readyCondition.notify_all();
+            }
+        };
+
+        std::list<std::thread*> threads;
+
+        size_t threadCount = std::min(mTasks.size(), (size_t)std::max(1U,
+            std::thread::hardware_concurrency()));
+        for(size_t i = 0; i < threadCount; ++i)
+        {
+            threads.push_back(new std::thread(worker));
+        }
+
+        for(auto thread : threads)
+        {
+            thread->join();
+
+            delete thread;
+        }
+    }
+
+    uint64_t total = (uint64_t)std::chrono::duration_cast<
+        std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+            start).count();
+
+    uint64_t serialTotal = 0;
+    for(auto& timing : GetTimings())
+    {
+        serialTotal += timing.second;
+    }
+
+    LogGeneralInfo([&]()
+    {
+        return libcomp::String("Startup tasks %1 in %2 ms (%3 ms of task"
+            " time)\n").Arg(failed ? "failed" : "completed").Arg(total)
+            .Arg(serialTotal);
+    });
+
+    return !failed;
+}
+
+std::list<std::pair<libcomp::String, uint64_t>>
+    StartupTaskGraph::GetTimings() const
+{
+    std::list<std::pair<libcomp::String, uint64_t>> timings;
+    for(auto& task : mTasks)
+    {
+        if(task.Ran)
+        {
+            timings.push_back(std::make_pair(task.Name, task.Duration));
+        }
+    }
+
+    return timings;
+}
+
+bool StartupTaskGraph::RunTask(Task& task)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    bool success = task.Function();
+
+    task.Duration = (uint64_t)std::chrono::duration_cast<
+        std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+            start).count();
+    task.Ran = true;
+
+    if(success)
+    {
+        LogGeneralDebug([&]()
+        {
+            return libcomp::String("Startup task '%1' completed in %2 ms\n")
+                .Arg(task.Name).Arg(task.Duration);
+        });
+    }
+    else
+    {
+        LogGeneralError([&]()
+        {
+            return libcomp::String("Startup task '%1' failed after %2 ms\n")
+                .Arg(task.Name).Arg(task.Duration);
+        });
+    }
+
+    return success;
+}
+
+void StartupDigest::Add(const void *pData, size_t size)
+{
+    const uint8_t *pBytes = (const uint8_t*)pData;
+    for(size_t i = 0; i < size; i++)
+    {
+        mHash = (mHash ^ pBytes[i]) * 1099511628211ULL;
+    }
+}
+
+void StartupDigest::Add(const libcomp::String& value)
+{
+    // Include the length so adjacent strings cannot run together
+    Add((uint64_t)value.Size());
+    Add(value.C(), value.Size());
+}
+
+uint64_t StartupDigest::Get() const
+{
+    return mHash;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file server/channel/src/StartupTaskGraph.h
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Runs startup tasks concurrently in dependency order.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_STARTUPTASKGRAPH_H
+#define SERVER_CHANNEL_SRC_STARTUPTASKGRAPH_H
+
+// libcomp Includes
+#include <CString.h>
+
+// Standard C++11 Includes
+#include <functional>
+#include <list>
+#include <set>
+#include <type_traits>
+#include <vector>
+
+namespace channel
+{
+
+/**
+ * Set of named startup tasks that are run on a pool of threads. A task is
+ * started as soon as every task it depends on has finished successfully.
+ * If any task fails no further tasks are started and the graph fails once
+ * the running tasks finish.
+ */
+class StartupTaskGraph
+{
+public:
+    /**
+     * Create an empty task graph.
+     * @param parallel If false, run every task on the calling thread in the
+     *  order they were added instead.
+     */
+    StartupTaskGraph(bool parallel = true);
+
+    /**
+     * Add a task to the graph. Dependencies must be added first.
+     * @param name Unique name of the task, used for logging.
+     * @param task Function to run, returning false on failure.
+     * @param dependencies Names of the tasks that must finish first.
+     * @returns true if the task was added, false if the name is already in
+     *  use or a dependency does not exist.
+     */
+    bool AddTask(const libcomp::String& name,
+        const std::function<bool()>& task,
+        const std::set<libcomp::String>& dependencies = {});
+
+    /**
+     * Run every task and log the time each one took.
+     * @returns true if every task succeeded, false otherwise.
+     */
+    bool Run();
+
+    /**
+     * Get the time each task took to run during the last call to Run.
+     * Tasks that were not run are not included.
+     * @returns List of task names and run times in milliseconds, in the
+     *  order the tasks were added.
+     */
+    std::list<std::pair<libcomp::String, uint64_t>> GetTimings() const;
+
+private:
+    /**
+     * Task in the graph and its state for the current run.
+     */
+    struct Task
+    {
+        /// Name of the task
+        libcomp::String Name;
+
+        /// Function to run
+        std::function<bool()> Function;
+
+        /// Indexes of the tasks that depend on this one
+        std::list<size_t> Dependents;
+
+        /// Number of dependencies of the task
+        size_t DependencyCount = 0;
+
+        /// Number of dependencies that have not finished yet
+        size_t Pending = 0;
+
+        /// If the task was run during the current run
+        bool Ran = false;
+
+        /// Time the task took to run in milliseconds
+        uint64_t Duration = 0;
+    };
+
+    /**
+     * Run a task and time it.
+     * @param task Task to run.
+     * @returns true if the task succeeded, false otherwise.
+     */
+    static bool RunTask(Task& task);
+
+    /// If the tasks should be run concurrently
+    bool mParallel;
+
+    /// Tasks in the order they were added
+    std::vector<Task> mTasks;
+};
+
+/**
+ * Order dependent digest of the state built during startup. It is logged
+ * once startup completes so a parallel startup can be checked against a
+ * serial one with the same data.
+ */
+class StartupDigest
+{
+public:
+    /**
+     * Add raw bytes to the digest.
+     * @param pData Pointer to the bytes to add.
+     * @param size Number of bytes to add.
+     */
+    void Add(const void *pData, size_t size);
+
+    /**
+     * Add a string to the digest.
+     * @param value String to add.
+     */
+    void Add(const libcomp::String& value);
+
+    /**
+     * Add a number to the digest.
+     * @param value Number to add.
+     */
+    template<typename T>
+    void Add(T value)
+    {
+        static_assert(std::is_arithmetic<T>::value,
+            "Only numbers can be added to a digest by value");
+
+        Add(&value, sizeof(value));
+    }
+
+    /**
+     * Get the digest of everything added so far.
+     * @returns 64-bit FNV-1a hash of the added data.
+     */
+    uint64_t Get() const;
+
+private:
+    /// Current hash value
+    uint64_t mHash = 14695981039346656037ULL;
+};
+
+} // namespace channel
+
+#endif // SERVER_CHANNEL_SRC_STARTUPTASKGRAPH_H
@@ -0,0 +1,72 @@
+/**
+ * @file server/channel/src/TokuseiConditionProgram.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Compiled tokusei condition lists.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TokuseiConditionProgram.h"
+
+// object Includes
+#include <Tokusei.h>
+
+using namespace channel;
+
+TokuseiConditionProgram TokuseiConditionProgram::Compile(
+    const std::shared_ptr<objects::Tokusei>& tokusei)
+{
+    TokuseiConditionProgram program;
+    program.Ops.reserve(tokusei->ConditionsCount());
+
+    for(auto condition : tokusei->GetConditions())
+    {
+        TokuseiConditionOp op;
+        op.Type = condition->GetType();
+        op.Comparator = condition->GetComparator();
+        op.NumericCompare = op.Comparator !=
+            objects::TokuseiCondition::Comparator_t::EQUALS &&
+            op.Comparator != objects::TokuseiCondition::Comparator_t::NOT_EQUAL;
+        op.Equals = op.Comparator ==
+            objects::TokuseiCondition::Comparator_t::EQUALS;
+        op.Value = condition->GetValue();
+        op.ExpertiseID = 0;
+        op.OptionGroupID = condition->GetOptionGroupID();
+
+        if(op.Type == TokuseiConditionType::EXPERTISE)
+        {
+            // The 2 smallest digits are the expertise ID, the rest are the
+            // rank value
+            int32_t expertiseID = (int32_t)(op.Value % 100);
+            op.ExpertiseID = (uint32_t)expertiseID;
+            op.Value = (int32_t)((op.Value - expertiseID) / 100);
+        }
+
+        if(op.OptionGroupID != 0)
+        {
+            program.OptionGroups.set(op.OptionGroupID);
+        }
+
+        program.Ops.push_back(op);
+    }
+
+    return program;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file server/channel/src/TokuseiConditionProgram.h
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Compiled tokusei condition lists.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_TOKUSEICONDITIONPROGRAM_H
+#define SERVER_CHANNEL_SRC_TOKUSEICONDITIONPROGRAM_H
+
+// object Includes
+#include <TokuseiCondition.h>
+
+// Standard C++11 Includes
+#include <bitset>
+#include <memory>
+#include <vector>
+
+namespace objects
+{
+class Tokusei;
+}
+
+typedef objects::TokuseiCondition::Type_t TokuseiConditionType;
+
+namespace channel
+{
+
+/**
+ * Single tokusei condition lowered into the operands needed to evaluate
+ * it so the definition does not need to be read again for each check.
+ */
+struct TokuseiConditionOp
+{
+    /// Type of condition to evaluate
+    TokuseiConditionType Type;
+
+    /// Comparator to apply to the condition value
+    objects::TokuseiCondition::Comparator_t Comparator;
+
+    /// true if the comparator is not equals or not equal
+    bool NumericCompare;
+
+    /// true if the comparator is equals, used by conditions that only
+    /// check if something exists or not
+    bool Equals;
+
+    /// Right hand value to compare against. Expertise conditions store
+    /// the rank to compare here.
+    int32_t Value;
+
+    /// Expertise ID to read the rank from for expertise conditions
+    uint32_t ExpertiseID;
+
+    /// Option group the condition belongs to or 0 if it is required
+    uint8_t OptionGroupID;
+};
+
+/**
+ * Tokusei condition list compiled into a flat program when the definitions
+ * are loaded. Required conditions must all pass and each option group must
+ * have at least one passing condition.
+ */
+struct TokuseiConditionProgram
+{
+    /**
+     * Compile the conditions on a tokusei into a program that can be
+     * evaluated without reading the definition again.
+     * @param tokusei Pointer to the tokusei to compile the conditions of
+     * @return Compiled condition program
+     */
+    static TokuseiConditionProgram Compile(
+        const std::shared_ptr<objects::Tokusei>& tokusei);
+
+    /**
+     * Evaluate the program. Conditions are checked in definition order,
+     * stopping at the first required condition that fails and skipping
+     * conditions in option groups that already passed.
+     * @param leaf Function taking a TokuseiConditionOp and returning true
+     *  if the single condition passes
+     * @return true if the entire condition list passes
+     */
+    template<typename F>
+    bool Evaluate(const F& leaf) const
+    {
+        std::bitset<256> passedGroups;
+        for(auto& op : Ops)
+        {
+            if(op.OptionGroupID != 0)
+            {
+                // If the option group has already had a condition pass,
+                // skip it
+                if(!passedGroups[op.OptionGroupID] && leaf(op))
+                {
+                    passedGroups.set(op.OptionGroupID);
+                }
+            }
+            else if(!leaf(op))
+            {
+                return false;
+            }
+        }
+
+        return passedGroups == OptionGroups;
+    }
+
+    /// Conditions to evaluate, in definition order
+    std::vector<TokuseiConditionOp> Ops;
+
+    /// Set of every option group referenced by the conditions
+    std::bitset<256> OptionGroups;
+};
+
+} // namespace channel
+
+#endif // SERVER_CHANNEL_SRC_TOKUSEICONDITIONPROGRAM_H
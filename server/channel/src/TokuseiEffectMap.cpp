@@ -0,0 +1,156 @@
+/**
+ * @file server/channel/src/TokuseiEffectMap.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Routing of active tokusei to the entities they apply to.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TokuseiEffectMap.h"
+
+using namespace channel;
+
+TokuseiEffectMap::TokuseiEffectMap(const std::vector<TokuseiSource>& entities)
+    : mEntities(entities)
+{
+    for(auto& entity : mEntities)
+    {
+        auto& counts = mCounts[entity.EntityID];
+        counts[false];
+        counts[true];
+    }
+}
+
+void TokuseiEffectMap::SetCounts(int32_t entityID,
+    const TokuseiCounts& counts)
+{
+    auto it = mCounts.find(entityID);
+    if(it != mCounts.end())
+    {
+        it->second = counts;
+        it->second[false];
+        it->second[true];
+    }
+}
+
+TokuseiCounts& TokuseiEffectMap::GetCounts(int32_t entityID)
+{
+    return mCounts[entityID];
+}
+
+const std::vector<int32_t>& TokuseiEffectMap::Apply(
+    const TokuseiSource& source, Target_t target, bool skillTokusei,
+    int32_t tokuseiID, int32_t count)
+{
+    mChanged.clear();
+
+    switch(target)
+    {
+    case Target_t::PARTY:
+        // All party entities in the zone (including the source) gain the
+        // effect
+        if(source.HasClient && source.InParty)
+        {
+            for(auto& entity : mEntities)
+            {
+                if((entity.IsCharacter || entity.IsPartnerDemon) &&
+                    entity.Zone == source.Zone)
+                {
+                    Adjust(entity.EntityID, skillTokusei, tokuseiID, count);
+                }
+            }
+        }
+        break;
+    case Target_t::SUMMONER:
+        if(source.IsPartnerDemon)
+        {
+            if(source.HasClient && source.OtherEntityID)
+            {
+                Adjust(source.OtherEntityID, skillTokusei, tokuseiID,
+                    count);
+            }
+        }
+        else if(source.IsCharacter)
+        {
+            // Mostly affects digitalize skills
+            Adjust(source.EntityID, skillTokusei, tokuseiID, count);
+        }
+        break;
+    case Target_t::PARTNER:
+        if(source.IsCharacter)
+        {
+            if(source.HasClient && source.OtherEntityID)
+            {
+                Adjust(source.OtherEntityID, skillTokusei, tokuseiID,
+                    count);
+            }
+        }
+        else if(source.IsPartnerDemon)
+        {
+            // May never happen on actual skills but keep it consistent
+            // with digitalize behavior
+            Adjust(source.EntityID, skillTokusei, tokuseiID, count);
+        }
+        break;
+    case Target_t::SELF:
+    default:
+        Adjust(source.EntityID, skillTokusei, tokuseiID, count);
+        break;
+    }
+
+    return mChanged;
+}
+
+void TokuseiEffectMap::Adjust(int32_t entityID, bool skillTokusei,
+    int32_t tokuseiID, int32_t count)
+{
+    auto it = mCounts.find(entityID);
+    if(it == mCounts.end() || count == 0)
+    {
+        // Not in the group
+        return;
+    }
+
+    auto& map = it->second[skillTokusei];
+    auto cIter = map.find(tokuseiID);
+
+    int32_t current = cIter != map.end() ? (int32_t)cIter->second : 0;
+    int32_t next = current + count;
+    if(next == current)
+    {
+        return;
+    }
+
+    if(next > 0)
+    {
+        map[tokuseiID] = (uint16_t)next;
+    }
+    else if(cIter != map.end())
+    {
+        map.erase(cIter);
+    }
+    else
+    {
+        return;
+    }
+
+    mChanged.push_back(entityID);
+}
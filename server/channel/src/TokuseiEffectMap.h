@@ -0,0 +1,148 @@
+/**
+ * @file server/channel/src/TokuseiEffectMap.h
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Routing of active tokusei to the entities they apply to.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_TOKUSEIEFFECTMAP_H
+#define SERVER_CHANNEL_SRC_TOKUSEIEFFECTMAP_H
+
+// Standard C++11 Includes
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace channel
+{
+
+/// Count of each tokusei ID on an entity, keyed by true for pending skill
+/// tokusei and false for effective tokusei
+typedef std::unordered_map<bool, std::unordered_map<int32_t, uint16_t>>
+    TokuseiCounts;
+
+/**
+ * Entity a tokusei originates from, reduced to what decides which entities
+ * the tokusei applies to.
+ */
+struct TokuseiSource
+{
+    /// Entity ID of the source
+    int32_t EntityID = 0;
+
+    /// true if the source is a character
+    bool IsCharacter = false;
+
+    /// true if the source is a partner demon
+    bool IsPartnerDemon = false;
+
+    /// true if the source belongs to a client
+    bool HasClient = false;
+
+    /// true if the client the source belongs to is in a party
+    bool InParty = false;
+
+    /// Entity ID of the partner demon of a character or the character of a
+    /// partner demon on the same client or 0 if there is none
+    int32_t OtherEntityID = 0;
+
+    /// Zone the source is in, only compared against other sources
+    const void* Zone = nullptr;
+};
+
+/**
+ * Tracks the tokusei counts applied to a group of entities that can affect
+ * one another, routing each tokusei from its source to the entities its
+ * target type applies to.
+ */
+class TokuseiEffectMap
+{
+public:
+    /// Entities a tokusei applies to relative to its source
+    enum class Target_t : uint8_t
+    {
+        SELF = 0,
+        PARTY,
+        SUMMONER,
+        PARTNER,
+    };
+
+    /**
+     * Create a new map for a group of entities
+     * @param entities Every entity in the group, tokusei routed to an entity
+     *  outside of the group are ignored
+     */
+    TokuseiEffectMap(const std::vector<TokuseiSource>& entities);
+
+    /**
+     * Set the current counts on an entity in the group to adjust from
+     * @param entityID Entity ID in the group
+     * @param counts Counts to set
+     */
+    void SetCounts(int32_t entityID, const TokuseiCounts& counts);
+
+    /**
+     * Get the counts on an entity in the group
+     * @param entityID Entity ID in the group
+     * @return Counts on the entity
+     */
+    TokuseiCounts& GetCounts(int32_t entityID);
+
+    /**
+     * Add or remove a tokusei originating from a source in the group on
+     * every entity it applies to. Counts that reach zero are removed.
+     * @param source Source the tokusei originates from
+     * @param target Target type of the tokusei
+     * @param skillTokusei true if the tokusei has skill conditions
+     * @param tokuseiID ID of the tokusei
+     * @param count Number of times to add the tokusei or a negative number
+     *  to remove it that many times
+     * @return Entity IDs the counts changed on
+     */
+    const std::vector<int32_t>& Apply(const TokuseiSource& source,
+        Target_t target, bool skillTokusei, int32_t tokuseiID,
+        int32_t count);
+
+private:
+    /**
+     * Adjust the count of one tokusei on an entity in the group
+     * @param entityID Entity ID to adjust the count of
+     * @param skillTokusei true if the tokusei has skill conditions
+     * @param tokuseiID ID of the tokusei
+     * @param count Amount to adjust the count by
+     */
+    void Adjust(int32_t entityID, bool skillTokusei, int32_t tokuseiID,
+        int32_t count);
+
+    /// Every entity in the group
+    std::vector<TokuseiSource> mEntities;
+
+    /// Counts on each entity in the group
+    std::unordered_map<int32_t, TokuseiCounts> mCounts;
+
+    /// Entities changed by the last call to Apply
+    std::vector<int32_t> mChanged;
+};
+
+} // namespace channel
+
+#endif // SERVER_CHANNEL_SRC_TOKUSEIEFFECTMAP_H
@@ -146,6 +146,20 @@ bool TokuseiManager::Initialize()
             }
         }
 
+        if(tPair.second->ConditionsCount() > 0)
+        {
+            // Compile the conditions once instead of on every evaluation
+            mConditionPrograms[tPair.first] = TokuseiConditionProgram::Compile(
+                tPair.second);
+
+            // Register the state each condition reads
+            for(auto condition : tPair.second->GetConditions())
+            {
+                mConditionDependents[(int8_t)condition->GetType()].insert(
+                    tPair.first);
+            }
+        }
+
         for(uint32_t skillID : skillIDs)
         {
             auto skillData = definitionManager->GetSkillData(skillID);
@@ -583,7 +597,8 @@ bool TokuseiManager::GatherTimedTokusei(const std::shared_ptr<
 std::unordered_map<int32_t, bool> TokuseiManager::Recalculate(const std::shared_ptr<
     ActiveEntityState>& eState, std::set<TokuseiConditionType> changes)
 {
-    bool doRecalc = false;
+    // Entities with tokusei conditions that read the changed state
+    std::list<std::shared_ptr<ActiveEntityState>> affected;
 
     // Since anything pertaining to party members or summoning a new demon requires
     // a full recalculation check, only check another entity if a partner demon's
@@ -596,30 +611,195 @@ std::unordered_map<int32_t, bool> TokuseiManager::Recalculate(const std::shared_
         {
             auto cState = state->GetCharacterState();
             auto triggers = cState->GetCalculatedState()->GetActiveTokuseiTriggers();
-            doRecalc = triggers.find((int8_t)TokuseiConditionType::PARTNER_FAMILIARITY)
-                != triggers.end();
+            if(triggers.find((int8_t)TokuseiConditionType::PARTNER_FAMILIARITY)
+                != triggers.end())
+            {
+                affected.push_back(cState);
+            }
         }
     }
 
-    if(!doRecalc)
+    auto triggers = eState->GetCalculatedState()->GetActiveTokuseiTriggers();
+    for(auto change : changes)
+    {
+        if(triggers.find((int8_t)change) != triggers.end())
+        {
+            affected.push_back(eState);
+            break;
+        }
+    }
+
+    if(affected.size() == 0)
+    {
+        return std::unordered_map<int32_t, bool>();
+    }
+
+    // Only the tokusei depending on the changed state can evaluate
+    // differently than they did during the last recalculation so only the
+    // ones that flip need to be added to or removed from the entities they
+    // apply to
+    auto definitionManager = mServer.lock()->GetDefinitionManager();
+
+    std::list<std::pair<std::shared_ptr<ActiveEntityState>,
+        std::shared_ptr<objects::Tokusei>>> flipped;
+    for(auto entity : affected)
     {
-        auto triggers = eState->GetCalculatedState()->GetActiveTokuseiTriggers();
+        auto calcState = entity->GetCalculatedState();
+        auto results = calcState->GetConditionalTokuseiResults();
+
+        bool changed = false;
         for(auto change : changes)
         {
-            if(triggers.find((int8_t)change) != triggers.end())
+            auto it = mConditionDependents.find((int8_t)change);
+            if(it == mConditionDependents.end())
+            {
+                continue;
+            }
+
+            for(int32_t tokuseiID : it->second)
+            {
+                auto rIter = results.find(tokuseiID);
+                if(rIter == results.end())
+                {
+                    // Not active on the entity
+                    continue;
+                }
+
+                auto tokusei = definitionManager->GetTokuseiData(tokuseiID);
+                if(!tokusei)
+                {
+                    return Recalculate(eState, true);
+                }
+
+                bool add = EvaluateTokuseiConditions(entity, tokusei);
+                if(add != rIter->second)
+                {
+                    rIter->second = add;
+                    flipped.push_back(std::make_pair(entity, tokusei));
+                    changed = true;
+                }
+            }
+        }
+
+        if(changed)
+        {
+            calcState->SetConditionalTokuseiResults(results);
+        }
+    }
+
+    if(flipped.size() == 0)
+    {
+        return std::unordered_map<int32_t, bool>();
+    }
+
+    // Start from the tokusei currently on the group and move only the
+    // flipped ones
+    std::unordered_map<int32_t, bool> result;
+
+    auto entities = GetAllTokuseiEntities(eState);
+
+    std::vector<TokuseiSource> sources;
+    sources.reserve(entities.size());
+    for(auto entity : entities)
+    {
+        sources.push_back(GetTokuseiSource(entity));
+        result[entity->GetEntityID()] = false;
+    }
+
+    TokuseiEffectMap effectMap(sources);
+    for(auto entity : entities)
+    {
+        auto calcState = entity->GetCalculatedState();
+
+        TokuseiCounts counts;
+        counts[false] = calcState->GetEffectiveTokusei();
+        counts[true] = calcState->GetPendingSkillTokusei();
+        effectMap.SetCounts(entity->GetEntityID(), counts);
+    }
+
+    std::set<int32_t> changedIDs;
+    std::unordered_map<int32_t, std::list<std::shared_ptr<
+        objects::Tokusei>>> directTokusei;
+    for(auto& fPair : flipped)
+    {
+        auto entity = fPair.first;
+        auto tokusei = fPair.second;
+
+        const TokuseiSource* source = nullptr;
+        for(auto& s : sources)
+        {
+            if(s.EntityID == entity->GetEntityID())
             {
-                doRecalc = true;
+                source = &s;
                 break;
             }
         }
+
+        if(!source)
+        {
+            // Not part of the group anymore
+            continue;
+        }
+
+        // Duplicate tokusei on the entity are each applied
+        auto dIter = directTokusei.find(entity->GetEntityID());
+        if(dIter == directTokusei.end())
+        {
+            dIter = directTokusei.insert(std::make_pair(
+                entity->GetEntityID(), GetDirectTokusei(entity))).first;
+        }
+
+        int32_t count = 0;
+        for(auto t : dIter->second)
+        {
+            if(t->GetID() == tokusei->GetID())
+            {
+                count++;
+            }
+        }
+
+        if(count == 0)
+        {
+            // The tokusei is no longer on the entity so the counts on the
+            // group cannot be adjusted from the last calculation
+            return Recalculate(eState, true);
+        }
+
+        bool skillTokusei = tokusei->SkillConditionsCount() > 0 ||
+            tokusei->SkillTargetConditionsCount() > 0;
+        bool add = entity->GetCalculatedState()
+            ->GetConditionalTokuseiResults()[tokusei->GetID()];
+
+        for(int32_t entityID : effectMap.Apply(*source,
+            GetEffectTarget(tokusei), skillTokusei, tokusei->GetID(),
+            add ? count : -count))
+        {
+            changedIDs.insert(entityID);
+        }
     }
 
-    if(doRecalc)
+    std::list<std::shared_ptr<ActiveEntityState>> updatedEntities;
+    for(auto entity : entities)
     {
-        return Recalculate(eState, true);
+        if(changedIDs.find(entity->GetEntityID()) != changedIDs.end())
+        {
+            ApplyTokuseiCounts(entity,
+                effectMap.GetCounts(entity->GetEntityID()));
+            updatedEntities.push_back(entity);
+        }
+    }
+
+    auto characterManager = mServer.lock()->GetCharacterManager();
+    auto connectionManager = mServer.lock()->GetManagerConnection();
+    for(auto entity : updatedEntities)
+    {
+        auto client = connectionManager->GetEntityClient(entity->GetEntityID());
+        characterManager->RecalculateStats(entity, client);
+
+        result[entity->GetEntityID()] = true;
     }
 
-    return std::unordered_map<int32_t, bool>();
+    return result;
 }
 
 std::unordered_map<int32_t, bool> TokuseiManager::Recalculate(const std::shared_ptr<
@@ -634,41 +814,45 @@ std::unordered_map<int32_t, bool> TokuseiManager::Recalculate(const std::list<st
 {
     std::unordered_map<int32_t, bool> result;
 
-    // Effects directly on the entity
-    std::unordered_map<int32_t,
-        std::unordered_map<bool, std::unordered_map<int32_t, uint16_t>>> newMaps;
-
-    // Effects on the whole party
-    std::unordered_map<int32_t,
-        std::unordered_map<bool, std::unordered_map<int32_t, uint16_t>>> partyEffects;
+    // Effects on each entity, routed from the entity they originate from
+    std::vector<TokuseiSource> sources;
+    sources.reserve(entities.size());
+    for(auto eState : entities)
+    {
+        sources.push_back(GetTokuseiSource(eState));
+    }
 
-    // Effects on an entity's partner or summoner
-    std::unordered_map<int32_t,
-        std::unordered_map<bool, std::unordered_map<int32_t, uint16_t>>> otherEffects;
+    TokuseiEffectMap effectMap(sources);
 
     // Keep track of direct timed tokusei on all player entities
     std::unordered_map<int32_t, std::set<int32_t>> playerEntityTimedTokusei;
 
-    // Keep track of aspects encountered to avoid having to loop multiple times
-    std::unordered_map<int32_t, std::set<int8_t>> aspectMap;
-
+    auto sIter = sources.begin();
     for(auto eState : entities)
     {
+        auto& source = *sIter++;
+
         result[eState->GetEntityID()] = false;
 
         int32_t worldCID = 0;
-        auto state = ClientState::GetEntityClientState(eState->GetEntityID(),
-            false);
-        if(state)
+        if(source.HasClient)
         {
-            worldCID = state->GetWorldCID();
+            auto state = ClientState::GetEntityClientState(
+                eState->GetEntityID(), false);
+            if(state)
+            {
+                worldCID = state->GetWorldCID();
 
-            // Make sure there's always an entry per player
-            playerEntityTimedTokusei[worldCID];
+                // Make sure there's always an entry per player
+                playerEntityTimedTokusei[worldCID];
+            }
         }
 
         std::set<int8_t> triggers;
 
+        // Conditional tokusei results kept to check future changes against
+        std::unordered_map<int32_t, bool> conditionResults;
+
         std::unordered_map<int32_t, bool> evaluated;
         for(auto tokusei : GetDirectTokusei(eState))
         {
@@ -690,14 +874,14 @@ std::unordered_map<int32_t, bool> TokuseiManager::Recalculate(const std::list<st
                     playerEntityTimedTokusei[worldCID].insert(tokuseiID);
                 }
 
-                for(auto aspect : tokusei->GetAspects())
+                for(auto condition : tokusei->GetConditions())
                 {
-                    aspectMap[tokuseiID].insert((int8_t)aspect->GetType());
+                    triggers.insert((int8_t)condition->GetType());
                 }
 
-                for(auto condition : tokusei->GetConditions())
+                if(tokusei->ConditionsCount() > 0)
                 {
-                    triggers.insert((int8_t)condition->GetType());
+                    conditionResults[tokuseiID] = add;
                 }
             }
 
@@ -706,56 +890,14 @@ std::unordered_map<int32_t, bool> TokuseiManager::Recalculate(const std::list<st
                 bool skillTokusei = tokusei->SkillConditionsCount() > 0 ||
                     tokusei->SkillTargetConditionsCount() > 0;
 
-                std::unordered_map<int32_t, uint16_t>* map = 0;
-                switch(tokusei->GetTargetType())
-                {
-                case objects::Tokusei::TargetType_t::PARTY:
-                    map = &partyEffects[eState->GetEntityID()][skillTokusei];
-                    break;
-                case objects::Tokusei::TargetType_t::SUMMONER:
-                    if(eState->GetEntityType() == EntityType_t::PARTNER_DEMON)
-                    {
-                        map = &otherEffects[eState->GetEntityID()][skillTokusei];
-                    }
-                    else if(eState->GetEntityType() == EntityType_t::CHARACTER)
-                    {
-                        // Mostly affects digitalize skills
-                        map = &newMaps[eState->GetEntityID()][skillTokusei];
-                    }
-                    break;
-                case objects::Tokusei::TargetType_t::PARTNER:
-                    if(eState->GetEntityType() == EntityType_t::CHARACTER)
-                    {
-                        map = &otherEffects[eState->GetEntityID()][skillTokusei];
-                    }
-                    else if(eState->GetEntityType() == EntityType_t::PARTNER_DEMON)
-                    {
-                        // May never happen on actual skills but keep it
-                        // consistent with digitalize behavior
-                        map = &newMaps[eState->GetEntityID()][skillTokusei];
-                    }
-                    break;
-                case objects::Tokusei::TargetType_t::SELF:
-                default:
-                    map = &newMaps[eState->GetEntityID()][skillTokusei];
-                    break;
-                }
-
-                if(map)
-                {
-                    if(map->find(tokuseiID) == map->end())
-                    {
-                        (*map)[tokuseiID] = 1;
-                    }
-                    else
-                    {
-                        (*map)[tokuseiID]++;
-                    }
-                }
+                effectMap.Apply(source, GetEffectTarget(tokusei),
+                    skillTokusei, tokuseiID, 1);
             }
         }
 
         eState->GetCalculatedState()->SetActiveTokuseiTriggers(triggers);
+        eState->GetCalculatedState()->SetConditionalTokuseiResults(
+            conditionResults);
     }
 
     // Set or clear all timed tokusei for player entities
@@ -775,66 +917,6 @@ std::unordered_map<int32_t, bool> TokuseiManager::Recalculate(const std::list<st
         }
     }
 
-    // Loop back through and add all party/other effects
-    for(auto eState : entities)
-    {
-        auto state = ClientState::GetEntityClientState(eState->GetEntityID(), false);
-        if(!state) continue;
-
-        auto cState = state->GetCharacterState();
-        auto dState = state->GetDemonState();
-        auto otherEntityID = eState == cState ? dState->GetEntityID() : cState->GetEntityID();
-
-        if(otherEntityID)
-        {
-            auto& map = newMaps[otherEntityID];
-            for(auto pair : otherEffects[eState->GetEntityID()])
-            {
-                for(auto bPair : pair.second)
-                {
-                    if(map[pair.first].find(bPair.first) == map[pair.first].end())
-                    {
-                        map[pair.first][bPair.first] = bPair.second;
-                    }
-                    else
-                    {
-                        map[pair.first][bPair.first] = (uint16_t)(
-                            map[pair.first][bPair.first] + bPair.second);
-                    }
-                }
-            }
-        }
-
-        // All party entities in the zone (including the source) gain the effect
-        if(state->GetParty())
-        {
-            for(auto e : entities)
-            {
-                bool partyEntity = e->GetEntityType() == EntityType_t::CHARACTER ||
-                    e->GetEntityType() == EntityType_t::PARTNER_DEMON;
-                if(partyEntity && e->GetZone() == eState->GetZone())
-                {
-                    auto& map = newMaps[e->GetEntityID()];
-                    for(auto pair : partyEffects[eState->GetEntityID()])
-                    {
-                        for(auto bPair : pair.second)
-                        {
-                            if(map[pair.first].find(bPair.first) == map[pair.first].end())
-                            {
-                                map[pair.first][bPair.first] = bPair.second;
-                            }
-                            else
-                            {
-                                map[pair.first][bPair.first] = (uint16_t)(
-                                    map[pair.first][bPair.first] + bPair.second);
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
-
     // Now that all tokusei have been calculated, compare and add them to their
     // respective entities
     std::list<std::shared_ptr<ActiveEntityState>> updatedEntities;
@@ -842,10 +924,12 @@ std::unordered_map<int32_t, bool> TokuseiManager::Recalculate(const std::list<st
     {
         bool updated = false;
 
+        auto& counts = effectMap.GetCounts(eState->GetEntityID());
+
         auto calcState = eState->GetCalculatedState();
         for(bool skillMode : { false, true })
         {
-            auto& selfMap = newMaps[eState->GetEntityID()][skillMode];
+            auto& selfMap = counts[skillMode];
             auto currentTokusei = skillMode ? calcState->GetPendingSkillTokusei()
                 : calcState->GetEffectiveTokusei();
             if(currentTokusei.size() != selfMap.size())
@@ -873,70 +957,9 @@ std::unordered_map<int32_t, bool> TokuseiManager::Recalculate(const std::list<st
 
         if(updated)
         {
-            auto& effective = newMaps[eState->GetEntityID()][false];
-            auto& skillPending = newMaps[eState->GetEntityID()][true];
-            calcState->SetEffectiveTokusei(effective);
-            calcState->SetPendingSkillTokusei(skillPending);
-
-            // Gather all possible aspects on the entity for quick
-            // reference later
-            std::set<int8_t> aspects;
-            for(auto& aPair : aspectMap)
-            {
-                if(effective.find(aPair.first) != effective.end() ||
-                    skillPending.find(aPair.first) != skillPending.end())
-                {
-                    for(int8_t aspect : aPair.second)
-                    {
-                        aspects.insert(aspect);
-                    }
-                }
-            }
-
-            eState->GetCalculatedState()->SetExistingTokuseiAspects(aspects);
-
-            // Update constant status effects
-            StatusEffectChanges effects;
-
-            auto currentEffects = eState->GetStatusEffects();
-            for(auto statusPair : mStatusEffectTokusei)
-            {
-                bool exists = currentEffects.find(statusPair.first) !=
-                    currentEffects.end();
-
-                bool apply = false;
-                for(int32_t source : statusPair.second)
-                {
-                    if(effective.find(source) != effective.end())
-                    {
-                        apply = true;
-                        break;
-                    }
-                }
-
-                if(apply && !exists)
-                {
-                    StatusEffectChange change(statusPair.first, 1, true);
-                    change.IsConstant = true;
-
-                    effects[statusPair.first] = change;
-                }
-                else if(!apply && exists)
-                {
-                    effects[statusPair.first] = StatusEffectChange(
-                        statusPair.first, 0, true);
-                }
-            }
-
-            if(effects.size() > 0)
-            {
-                eState->AddStatusEffects(effects,
-                    mServer.lock()->GetDefinitionManager());
-            }
+            ApplyTokuseiCounts(eState, counts);
 
             updatedEntities.push_back(eState);
-
-            RecalcCostAdjustments(eState);
         }
     }
 
@@ -1323,59 +1346,45 @@ bool TokuseiManager::EvaluateTokuseiConditions(const std::shared_ptr<
 
     // Compare singular (and) and option group (or) conditions and
     // only return true if the entire clause evaluates to true
-    std::unordered_map<uint8_t, bool> optionGroups;
-    for(auto condition : tokusei->GetConditions())
-    {
-        bool result = false;
-
-        // If the option group has already had a condition pass, skip it
-        uint8_t optionGroupID = condition->GetOptionGroupID();
-        if(optionGroupID != 0)
+    return GetConditionProgram(tokusei).Evaluate(
+        [this, &eState, tokuseiID](const TokuseiConditionOp& op)
         {
-            if(optionGroups.find(optionGroupID) == optionGroups.end())
-            {
-                optionGroups[optionGroupID] = false;
-            }
-            else
-            {
-                result = optionGroups[optionGroupID];
-            }
-        }
+            return EvaluateTokuseiCondition(eState, tokuseiID, op);
+        });
+}
 
-        if(!result)
-        {
-            result = EvaluateTokuseiCondition(eState, tokuseiID, condition);
-            if(optionGroupID != 0)
-            {
-                optionGroups[optionGroupID] |= result;
-            }
-            else if(!result)
-            {
-                return false;
-            }
-        }
+const TokuseiConditionProgram& TokuseiManager::GetConditionProgram(
+    const std::shared_ptr<objects::Tokusei>& tokusei)
+{
+    int32_t tokuseiID = tokusei->GetID();
+
+    auto it = mConditionPrograms.find(tokuseiID);
+    if(it != mConditionPrograms.end())
+    {
+        return it->second;
     }
 
-    for(auto pair : optionGroups)
+    // Not a loaded definition, compile it the first time it is seen.
+    // Entries are never removed so the reference stays valid.
+    std::lock_guard<std::mutex> lock(mConditionProgramLock);
+
+    auto extraIter = mExtraConditionPrograms.find(tokuseiID);
+    if(extraIter == mExtraConditionPrograms.end())
     {
-        if(!pair.second)
-        {
-            return false;
-        }
+        extraIter = mExtraConditionPrograms.insert(std::make_pair(tokuseiID,
+            TokuseiConditionProgram::Compile(tokusei))).first;
     }
 
-    return true;
+    return extraIter->second;
 }
 
-
 bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntityState>& eState,
-    int32_t tokuseiID, const std::shared_ptr<objects::TokuseiCondition>& condition)
+    int32_t tokuseiID, const TokuseiConditionOp& op)
 {
-    bool numericCompare = condition->GetComparator() != objects::TokuseiCondition::Comparator_t::EQUALS &&
-        condition->GetComparator() != objects::TokuseiCondition::Comparator_t::NOT_EQUAL;
+    bool numericCompare = op.NumericCompare;
 
     bool isPartnerCondition = false;
-    switch(condition->GetType())
+    switch(op.Type)
     {
     case TokuseiConditionType::CURRENT_HP:
     case TokuseiConditionType::CURRENT_MP:
@@ -1388,7 +1397,7 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
             }
 
             int32_t currentValue = 0;
-            if(condition->GetType() == TokuseiConditionType::CURRENT_HP)
+            if(op.Type == TokuseiConditionType::CURRENT_HP)
             {
                 currentValue = (int32_t)floor((float)cs->GetHP() / (float)eState->GetMaxHP() * 100.f);
             }
@@ -1397,7 +1406,7 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
                 currentValue = (int32_t)floor((float)cs->GetMP() / (float)eState->GetMaxMP() * 100.f);
             }
 
-            return Compare(currentValue, condition, true);
+            return Compare(currentValue, op.Value, op.Comparator, true);
         }
         break;
     case TokuseiConditionType::DIGITALIZED:
@@ -1412,8 +1421,7 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
             auto cState = std::dynamic_pointer_cast<CharacterState>(eState);
 
             bool digitalized = cState->GetDigitalizeState() != nullptr;
-            return digitalized == (condition->GetComparator() ==
-                objects::TokuseiCondition::Comparator_t::EQUALS);
+            return digitalized == op.Equals;
         }
         break;
     case TokuseiConditionType::EQUIPPED_WEAPON_TYPE:
@@ -1435,11 +1443,10 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
                 auto itemData = mServer.lock()->GetDefinitionManager()->GetItemData(
                     equip->GetType());
                 equipped = itemData && (int32_t)itemData->GetCommon()
-                    ->GetCategory()->GetSubCategory() == condition->GetValue();
+                    ->GetCategory()->GetSubCategory() == op.Value;
             }
 
-            return equipped == (condition->GetComparator() ==
-                objects::TokuseiCondition::Comparator_t::EQUALS);
+            return equipped == op.Equals;
         }
         break;
     case TokuseiConditionType::EXPERTISE:
@@ -1452,13 +1459,11 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
         {
             auto cState = std::dynamic_pointer_cast<CharacterState>(eState);
 
-            // The 2 smallest digits are the expertise ID, the rest are the rank value
-            int32_t expertiseID = (int32_t)(condition->GetValue() % 100);
-            int32_t rankCompare = (int32_t)((condition->GetValue() - expertiseID) / 100);
-            uint8_t rank = cState->GetExpertiseRank(
-                (uint32_t)expertiseID, mServer.lock()->GetDefinitionManager());
+            // The expertise ID and rank value were split when compiled
+            uint8_t rank = cState->GetExpertiseRank(op.ExpertiseID,
+                mServer.lock()->GetDefinitionManager());
 
-            return Compare((int32_t)rank, rankCompare, condition, true);
+            return Compare((int32_t)rank, op.Value, op.Comparator, true);
         }
         break;
     case TokuseiConditionType::LNC:
@@ -1469,14 +1474,13 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
         }
         else
         {
-            bool containsLNC = eState->IsLNCType((uint8_t)condition->GetValue(), false);
-            return containsLNC == (condition->GetComparator() ==
-                objects::TokuseiCondition::Comparator_t::EQUALS);
+            bool containsLNC = eState->IsLNCType((uint8_t)op.Value, false);
+            return containsLNC == op.Equals;
         }
         break;
     case TokuseiConditionType::GENDER:
         // Entity is the specified gender
-        return Compare((int32_t)eState->GetGender(), condition, false);
+        return Compare((int32_t)eState->GetGender(), op.Value, op.Comparator, false);
         break;
     case TokuseiConditionType::STATUS_ACTIVE:
         // Entity currently has the specified status effect active
@@ -1487,9 +1491,8 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
         else
         {
             bool exists = eState->StatusEffectActive(
-                (uint32_t)condition->GetValue());
-            return exists == (condition->GetComparator() ==
-                objects::TokuseiCondition::Comparator_t::EQUALS);
+                (uint32_t)op.Value);
+            return exists == op.Equals;
         }
         break;
     case TokuseiConditionType::DIASPORA_MINIBOSS_COUNT:
@@ -1503,7 +1506,7 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
             }
 
             auto counts = zone->GetDiasporaMiniBossCount();
-            return Compare((int32_t)counts.first, condition, true);
+            return Compare((int32_t)counts.first, op.Value, op.Comparator, true);
         }
         break;
     case TokuseiConditionType::GAME_TIME:
@@ -1547,10 +1550,9 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
                 }
             }
 
-            bool exists = demonIDs.find((uint32_t)condition->GetValue())
+            bool exists = demonIDs.find((uint32_t)op.Value)
                 != demonIDs.end();
-            return exists == (condition->GetComparator() ==
-                objects::TokuseiCondition::Comparator_t::EQUALS);
+            return exists == op.Equals;
         }
         break;
     case TokuseiConditionType::SKILL_STATE:
@@ -1589,13 +1591,13 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
         return false;
     }
 
-    switch(condition->GetType())
+    switch(op.Type)
     {
     case TokuseiConditionType::PARTNER_FAMILIARITY:
-        return Compare((int32_t)partner->GetFamiliarity(), condition, true);
+        return Compare((int32_t)partner->GetFamiliarity(), op.Value, op.Comparator, true);
         break;
     case TokuseiConditionType::PARTNER_MITAMA:
-        return Compare((int32_t)partner->GetMitamaType(), condition, true);
+        return Compare((int32_t)partner->GetMitamaType(), op.Value, op.Comparator, true);
         break;
     default:
         break;
@@ -1607,7 +1609,7 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
     }
 
     int32_t partnerValue = 0;
-    switch(condition->GetType())
+    switch(op.Type)
     {
     case TokuseiConditionType::PARTNER_TYPE:
         // Partner matches the specified demon type
@@ -1623,7 +1625,7 @@ bool TokuseiManager::EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntity
         break;
     }
 
-    return Compare(partnerValue, condition, false);
+    return Compare(partnerValue, op.Value, op.Comparator, false);
 }
 
 double TokuseiManager::CalculateAttributeValue(ActiveEntityState* eState, int32_t value,
@@ -2142,7 +2144,8 @@ void TokuseiManager::UpdateDiasporaMinibossCount(
     const std::shared_ptr<Zone>& zone)
 {
     std::list<std::shared_ptr<ActiveEntityState>> entities;
-    for(auto eState : zone->GetActiveEntities())
+    auto eStates = zone->GetActiveEntitySnapshot();
+    for(auto& eState : *eStates)
     {
         auto calcState = eState->GetCalculatedState();
         if(calcState->ActiveTokuseiTriggersContains(
@@ -2165,6 +2168,121 @@ bool TokuseiManager::DeadTokuseiDisabled()
     return disabled;
 }
 
+TokuseiSource TokuseiManager::GetTokuseiSource(
+    const std::shared_ptr<ActiveEntityState>& eState)
+{
+    TokuseiSource source;
+    source.EntityID = eState->GetEntityID();
+    source.IsCharacter = eState->GetEntityType() == EntityType_t::CHARACTER;
+    source.IsPartnerDemon = eState->GetEntityType() ==
+        EntityType_t::PARTNER_DEMON;
+    source.Zone = eState->GetZone().get();
+
+    auto state = ClientState::GetEntityClientState(eState->GetEntityID(),
+        false);
+    if(state)
+    {
+        auto cState = state->GetCharacterState();
+        auto dState = state->GetDemonState();
+
+        source.HasClient = true;
+        source.InParty = state->GetParty() != nullptr;
+        source.OtherEntityID = eState == cState ? dState->GetEntityID()
+            : cState->GetEntityID();
+    }
+
+    return source;
+}
+
+TokuseiEffectMap::Target_t TokuseiManager::GetEffectTarget(
+    const std::shared_ptr<objects::Tokusei>& tokusei)
+{
+    switch(tokusei->GetTargetType())
+    {
+    case objects::Tokusei::TargetType_t::PARTY:
+        return TokuseiEffectMap::Target_t::PARTY;
+    case objects::Tokusei::TargetType_t::SUMMONER:
+        return TokuseiEffectMap::Target_t::SUMMONER;
+    case objects::Tokusei::TargetType_t::PARTNER:
+        return TokuseiEffectMap::Target_t::PARTNER;
+    case objects::Tokusei::TargetType_t::SELF:
+    default:
+        return TokuseiEffectMap::Target_t::SELF;
+    }
+}
+
+void TokuseiManager::ApplyTokuseiCounts(const std::shared_ptr<
+    ActiveEntityState>& eState, TokuseiCounts& counts)
+{
+    auto definitionManager = mServer.lock()->GetDefinitionManager();
+
+    auto& effective = counts[false];
+    auto& skillPending = counts[true];
+
+    auto calcState = eState->GetCalculatedState();
+    calcState->SetEffectiveTokusei(effective);
+    calcState->SetPendingSkillTokusei(skillPending);
+
+    // Gather all possible aspects on the entity for quick reference later
+    std::set<int8_t> aspects;
+    for(auto map : { &effective, &skillPending })
+    {
+        for(auto& pair : *map)
+        {
+            auto tokusei = definitionManager->GetTokuseiData(pair.first);
+            if(tokusei)
+            {
+                for(auto aspect : tokusei->GetAspects())
+                {
+                    aspects.insert((int8_t)aspect->GetType());
+                }
+            }
+        }
+    }
+
+    calcState->SetExistingTokuseiAspects(aspects);
+
+    // Update constant status effects
+    StatusEffectChanges effects;
+
+    auto currentEffects = eState->GetStatusEffects();
+    for(auto statusPair : mStatusEffectTokusei)
+    {
+        bool exists = currentEffects.find(statusPair.first) !=
+            currentEffects.end();
+
+        bool apply = false;
+        for(int32_t source : statusPair.second)
+        {
+            if(effective.find(source) != effective.end())
+            {
+                apply = true;
+                break;
+            }
+        }
+
+        if(apply && !exists)
+        {
+            StatusEffectChange change(statusPair.first, 1, true);
+            change.IsConstant = true;
+
+            effects[statusPair.first] = change;
+        }
+        else if(!apply && exists)
+        {
+            effects[statusPair.first] = StatusEffectChange(
+                statusPair.first, 0, true);
+        }
+    }
+
+    if(effects.size() > 0)
+    {
+        eState->AddStatusEffects(effects, definitionManager);
+    }
+
+    RecalcCostAdjustments(eState);
+}
+
 void TokuseiManager::RecalcCostAdjustments(const std::shared_ptr<
     ActiveEntityState>& eState)
 {
@@ -2416,7 +2534,14 @@ bool TokuseiManager::Compare(int32_t value, std::shared_ptr<
 bool TokuseiManager::Compare(int32_t value1, int32_t value2, std::shared_ptr<
     objects::TokuseiCondition> condition, bool numericCompare) const
 {
-    switch(condition->GetComparator())
+    return Compare(value1, value2, condition->GetComparator(), numericCompare);
+}
+
+bool TokuseiManager::Compare(int32_t value1, int32_t value2,
+    objects::TokuseiCondition::Comparator_t comparator,
+    bool numericCompare) const
+{
+    switch(comparator)
     {
     case objects::TokuseiCondition::Comparator_t::EQUALS:
         return value1 == value2;
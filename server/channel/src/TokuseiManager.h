@@ -35,6 +35,8 @@
 
 // channel Includes
 #include "ActiveEntityState.h"
+#include "TokuseiConditionProgram.h"
+#include "TokuseiEffectMap.h"
 
 namespace objects
 {
@@ -45,7 +47,6 @@ class TokuseiAttributes;
 }
 
 typedef objects::TokuseiAspect::Type_t TokuseiAspectType;
-typedef objects::TokuseiCondition::Type_t TokuseiConditionType;
 typedef objects::TokuseiSkillCondition
     ::SkillConditionType_t TokuseiSkillConditionType;
 
@@ -152,14 +153,14 @@ public:
         const std::shared_ptr<objects::Tokusei>& tokusei);
 
     /**
-     * Evaluate a condition from a tokusei.
+     * Evaluate a compiled condition from a tokusei.
      * @param eState Pointer to the tokusei source to evaluate the conditions for
      * @param tokuseiID ID of the source tokusei effect
-     * @param condition Pointer to the condition to evaluate
+     * @param op Compiled condition to evaluate
      * @return true if the condition evaluates to true
      */
     bool EvaluateTokuseiCondition(const std::shared_ptr<ActiveEntityState>& eState,
-        int32_t tokuseiID, const std::shared_ptr<objects::TokuseiCondition>& condition);
+        int32_t tokuseiID, const TokuseiConditionOp& op);
 
     /**
      * Calculate the value of an attribute driven tokusei value.
@@ -279,6 +280,34 @@ public:
     bool DeadTokuseiDisabled();
 
 private:
+    /**
+     * Get the entity information that decides which entities the tokusei
+     * originating from the supplied entity apply to.
+     * @param eState Pointer to the entity
+     * @return Tokusei source information of the entity
+     */
+    TokuseiSource GetTokuseiSource(
+        const std::shared_ptr<ActiveEntityState>& eState);
+
+    /**
+     * Get the target type of a tokusei for routing it to the entities it
+     * applies to.
+     * @param tokusei Pointer to the tokusei
+     * @return Target type used by TokuseiEffectMap
+     */
+    static TokuseiEffectMap::Target_t GetEffectTarget(
+        const std::shared_ptr<objects::Tokusei>& tokusei);
+
+    /**
+     * Set the effective and pending skill tokusei on an entity and update
+     * everything derived from them: aspects, constant status effects and
+     * skill cost adjustments.
+     * @param eState Pointer to the entity to update
+     * @param counts New tokusei counts on the entity
+     */
+    void ApplyTokuseiCounts(const std::shared_ptr<ActiveEntityState>& eState,
+        TokuseiCounts& counts);
+
     /**
      * Recalculate skill cost adjustments from tokusei for the specified
      * entity. If the entity's data has already been sent to the client,
@@ -341,6 +370,40 @@ private:
     bool Compare(int32_t value1, int32_t value2, std::shared_ptr<
         objects::TokuseiCondition> condition, bool numericCompare) const;
 
+    /**
+     * Compare the supplied two values.
+     * @param value1 LHS value to compare
+     * @param value2 RHS value to compare
+     * @param comparator Comparator to apply to the values
+     * @param numericCompare If false and a numeric comparator is supplied
+     *  this will always return false
+     * @return false if the comparison does not evaluate to true
+     */
+    bool Compare(int32_t value1, int32_t value2,
+        objects::TokuseiCondition::Comparator_t comparator,
+        bool numericCompare) const;
+
+    /**
+     * Get the compiled conditions of a tokusei, compiling and caching them
+     * if the tokusei was not loaded from the definitions.
+     * @param tokusei Pointer to the tokusei to get the conditions of
+     * @return Compiled condition program
+     */
+    const TokuseiConditionProgram& GetConditionProgram(
+        const std::shared_ptr<objects::Tokusei>& tokusei);
+
+    /// Map of tokusei IDs to their compiled conditions, built for every
+    /// conditional tokusei at initialization and not modified after
+    std::unordered_map<int32_t, TokuseiConditionProgram> mConditionPrograms;
+
+    /// Map of tokusei IDs to compiled conditions of tokusei that were not
+    /// loaded from the definitions, compiled the first time they are used
+    std::unordered_map<int32_t, TokuseiConditionProgram> mExtraConditionPrograms;
+
+    /// Dependency graph of tokusei condition types to the IDs of every
+    /// tokusei with a condition of that type
+    std::unordered_map<int8_t, std::set<int32_t>> mConditionDependents;
+
     /// Quick access mapping of constant status effect IDs to their source tokusei IDs
     std::unordered_map<uint32_t, std::set<int32_t>> mStatusEffectTokusei;
 
@@ -362,6 +425,9 @@ private:
     /// Server lock for time calculation
     std::mutex mTimeLock;
 
+    /// Server lock for the compiled conditions of non-definition tokusei
+    std::mutex mConditionProgramLock;
+
     /// Pointer to the channel server.
     std::weak_ptr<ChannelServer> mServer;
 };
@@ -33,6 +33,15 @@
 
 using namespace channel;
 
+/// Seconds in a system day
+static const uint32_t SYSTEM_DAY_SECONDS = 86400;
+
+/// Seconds in a game day (2 seconds per game minute)
+static const uint32_t GAME_DAY_SECONDS = 2880;
+
+/// Seconds in a moon phase (16 phases per full cycle)
+static const uint32_t MOON_PHASE_SECONDS = 1440;
+
 namespace libcomp
 {
     template<>
@@ -145,3 +154,45 @@ libcomp::String WorldClock::ToString() const
     return libcomp::String("%1:%2 %3/16 [%4:%5]")
         .Arg(time[0]).Arg(time[1]).Arg(time[2]).Arg(time[3]).Arg(time[4]);
 }
+
+uint32_t WorldClock::GetSecondsUntil(const WorldClockTime& time) const
+{
+    // If the time is not in the current phase, the next time it can be
+    // reached is the start of its phase
+    bool inPhase = time.MoonPhase == -1 || time.MoonPhase == MoonPhase;
+
+    if(inPhase && time.SystemHour != -1)
+    {
+        // Time to system time
+        uint32_t now = (uint32_t)(SystemHour * 3600 + SystemMin * 60 +
+            SystemSec);
+        uint32_t target = (uint32_t)(time.SystemHour * 3600 +
+            time.SystemMin * 60);
+
+        uint32_t delta = (target + SYSTEM_DAY_SECONDS - now) %
+            SYSTEM_DAY_SECONDS;
+        return delta ? delta : SYSTEM_DAY_SECONDS;
+    }
+    else if(inPhase && time.Hour != -1)
+    {
+        // Time to game time
+        uint32_t now = CycleOffset % GAME_DAY_SECONDS;
+        uint32_t target = (uint32_t)(time.Hour * 120 + time.Min * 2);
+
+        uint32_t delta = (target + GAME_DAY_SECONDS - now) %
+            GAME_DAY_SECONDS;
+        return delta ? delta : GAME_DAY_SECONDS;
+    }
+    else if(time.MoonPhase != -1)
+    {
+        // Time to phase (full cycle if in phase), reduced by the time
+        // already spent in the current phase
+        uint32_t phaseDelta = (uint32_t)((16 + time.MoonPhase - MoonPhase)
+            % 16);
+
+        return (phaseDelta ? phaseDelta : 16) * MOON_PHASE_SECONDS -
+            (CycleOffset % MOON_PHASE_SECONDS);
+    }
+
+    return SYSTEM_DAY_SECONDS;
+}
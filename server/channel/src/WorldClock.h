@@ -124,6 +124,16 @@ public:
      */
     libcomp::String ToString() const;
 
+    /**
+     * Get the number of seconds from the clock until the next time the
+     * supplied time is reached. Times with a moon phase that is not the
+     * current phase are reached at the start of that phase. A time that
+     * is reached right now returns the time until it is reached again.
+     * @param time Time to check
+     * @return Seconds until the time is reached, always at least 1
+     */
+    uint32_t GetSecondsUntil(const WorldClockTime& time) const;
+
     /// Week day numeric respresentation
     /// (1 = Sunday, 7 = Saturday, -1 = not set)
     int8_t WeekDay;
@@ -31,6 +31,7 @@
 #include <ScriptEngine.h>
 
 // C++ Standard Includes
+#include <algorithm>
 #include <cmath>
 
 // object Includes
@@ -58,9 +59,13 @@
 #include "ChannelServer.h"
 #include "WorldClock.h"
 #include "ZoneInstance.h"
+#include "ZoneManager.h"
 
 using namespace channel;
 
+/// Width and height of each spatial index grid cell in world units
+const float SPATIAL_CELL_SIZE = 1000.f;
+
 namespace libcomp
 {
     template<>
@@ -129,9 +134,34 @@ namespace libcomp
     }
 }
 
+template<typename T, typename U>
+static void RefreshSnapshot(std::shared_ptr<const ZoneEntitySnapshot<T>>& snapshot,
+    uint64_t generation, const std::list<std::shared_ptr<U>>& source)
+{
+    if(!snapshot || snapshot->GetGeneration() != generation)
+    {
+        std::vector<std::shared_ptr<T>> entities(source.begin(),
+            source.end());
+        snapshot = std::make_shared<ZoneEntitySnapshot<T>>(generation,
+            std::move(entities));
+    }
+}
+
+static int64_t GetSpatialCell(float coord)
+{
+    return (int64_t)std::floor(coord / SPATIAL_CELL_SIZE);
+}
+
+static uint64_t GetSpatialCellKey(int64_t cellX, int64_t cellY)
+{
+    return ((uint64_t)(uint32_t)cellX << 32) | (uint64_t)(uint32_t)cellY;
+}
+
 Zone::Zone(uint32_t id, const std::shared_ptr<objects::ServerZone>& definition)
     : mNextRentalExpiration(0), mNextEncounterID(1),
-    mDiasporaMiniBossUpdated(false)
+    mConnectionGeneration(0), mActiveEntityGeneration(0), mAllyGeneration(0),
+    mEnemyGeneration(0), mNPCGeneration(0), mDiasporaMiniBossUpdated(false),
+    mSpatialTime(0), mSpatialGeneration(0), mSpatialMaxExtent(0.f)
 {
     SetDefinition(definition);
     SetID(id);
@@ -252,6 +282,9 @@ bool Zone::AddConnection(const std::shared_ptr<ChannelClientConnection>& client)
         mActiveEntities.push_back(cState);
         mActiveEntities.push_back(dState);
 
+        mConnectionGeneration++;
+        mActiveEntityGeneration++;
+
         return true;
     }
     else
@@ -288,6 +321,9 @@ void Zone::RemoveConnection(const std::shared_ptr<ChannelClientConnection>& clie
     mActiveEntities.remove(cState);
     mActiveEntities.remove(dState);
 
+    mConnectionGeneration++;
+    mActiveEntityGeneration++;
+
     // If this zone is not part of an instance, clear the character
     // specific flags
     if(!mZoneInstance)
@@ -309,6 +345,7 @@ void Zone::RemoveEntity(int32_t entityID, uint32_t spawnDelay)
             {
                 return a->GetEntityID() == entityID;
             });
+        mActiveEntityGeneration++;
 
         std::shared_ptr<ActiveEntityState> removeSpawn;
         switch(state->GetEntityType())
@@ -320,6 +357,7 @@ void Zone::RemoveEntity(int32_t entityID, uint32_t spawnDelay)
                     {
                         return a->GetEntityID() == entityID;
                     });
+                mAllyGeneration++;
 
                 removeSpawn = std::dynamic_pointer_cast<
                     ActiveEntityState>(state);
@@ -332,6 +370,7 @@ void Zone::RemoveEntity(int32_t entityID, uint32_t spawnDelay)
                     {
                         return e->GetEntityID() == entityID;
                     });
+                mEnemyGeneration++;
 
                 removeSpawn = std::dynamic_pointer_cast<
                     ActiveEntityState>(state);
@@ -502,6 +541,7 @@ void Zone::AddAlly(const std::shared_ptr<AllyState>& ally,
         if(!staggerTime)
         {
             mAllies.push_back(ally);
+            mAllyGeneration++;
             ally->SetDisplayState(ActiveDisplayState_t::ACTIVE);
         }
         else
@@ -550,6 +590,7 @@ void Zone::AddEnemy(const std::shared_ptr<EnemyState>& enemy,
         if(!staggerTime)
         {
             mEnemies.push_back(enemy);
+            mEnemyGeneration++;
             enemy->SetDisplayState(ActiveDisplayState_t::ACTIVE);
         }
         else
@@ -598,7 +639,12 @@ void Zone::AddLootBox(const std::shared_ptr<LootBoxState>& box,
 
 void Zone::AddNPC(const std::shared_ptr<NPCState>& npc)
 {
-    mNPCs.push_back(npc);
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mNPCs.push_back(npc);
+        mNPCGeneration++;
+    }
+
     RegisterEntityState(npc);
 
     int32_t actorID = npc->GetEntity()->GetActorID();
@@ -643,6 +689,27 @@ std::list<std::shared_ptr<ChannelClientConnection>> Zone::GetConnectionList()
     return connections;
 }
 
+ConnectionSnapshot Zone::GetConnectionSnapshot()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    if(!mConnectionSnapshot ||
+        mConnectionSnapshot->GetGeneration() != mConnectionGeneration)
+    {
+        std::vector<std::shared_ptr<ChannelClientConnection>> connections;
+        connections.reserve(mConnections.size());
+        for(auto& cPair : mConnections)
+        {
+            connections.push_back(cPair.second);
+        }
+
+        mConnectionSnapshot = std::make_shared<ZoneEntitySnapshot<
+            ChannelClientConnection>>(mConnectionGeneration,
+                std::move(connections));
+    }
+
+    return mConnectionSnapshot;
+}
+
 const std::shared_ptr<ActiveEntityState> Zone::GetActiveEntity(int32_t entityID)
 {
     return std::dynamic_pointer_cast<ActiveEntityState>(GetEntity(entityID));
@@ -653,38 +720,144 @@ const std::list<std::shared_ptr<ActiveEntityState>> Zone::GetActiveEntities()
     return mActiveEntities;
 }
 
+ActiveEntitySnapshot Zone::GetActiveEntitySnapshot()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    RefreshSnapshot(mActiveEntitySnapshot, mActiveEntityGeneration,
+        mActiveEntities);
+    return mActiveEntitySnapshot;
+}
+
 const std::list<std::shared_ptr<ActiveEntityState>>
     Zone::GetActiveEntitiesInRadius(float x, float y, double radius,
-        bool useHitbox)
+        bool useHitbox, uint64_t now)
 {
     std::list<std::shared_ptr<ActiveEntityState>> results;
 
-    uint64_t now = ChannelServer::GetServerTime();
+    float r = (float)radius;
 
-    float rSquared = (float)std::pow(radius, 2);
+    QueryActiveEntities(x - r, y - r, x + r, y + r, useHitbox, now,
+        [x, y, r](float eX, float eY, float extent)
+        {
+            // The entity overlaps the radius if its hitbox (as a radius)
+            // reaches into it
+            float reach = r + extent;
+            return (float)(std::pow(eX - x, 2) + std::pow(eY - y, 2)) <=
+                reach * reach;
+        }, results);
 
-    for(auto active : GetActiveEntities())
-    {
-        active->RefreshCurrentPosition(now);
+    return results;
+}
+
+void Zone::GetActiveEntitiesInRadius(
+    std::vector<std::shared_ptr<ActiveEntityState>>& results,
+    float x, float y, double radius, bool useHitbox, uint64_t now)
+{
+    results.clear();
 
-        float sqDist = active->GetDistance(x, y, true);
-        if(rSquared >= sqDist)
+    float r = (float)radius;
+
+    QueryActiveEntities(x - r, y - r, x + r, y + r, useHitbox, now,
+        [x, y, r](float eX, float eY, float extent)
         {
-            results.push_back(active);
-        }
-        else if(useHitbox)
+            float reach = r + extent;
+            return (float)(std::pow(eX - x, 2) + std::pow(eY - y, 2)) <=
+                reach * reach;
+        }, results);
+}
+
+const std::list<std::shared_ptr<ActiveEntityState>>
+    Zone::GetActiveEntitiesInCone(float x, float y, double radius, float rot,
+        float maxAngle, bool useHitbox, uint64_t now)
+{
+    std::list<std::shared_ptr<ActiveEntityState>> results;
+
+    float r = (float)radius;
+
+    QueryActiveEntities(x - r, y - r, x + r, y + r, useHitbox, now,
+        [x, y, r, rot, maxAngle](float eX, float eY, float extent)
         {
-            // Use the entity's hitbox to determine if it overlaps into the
-            // radius. If the distance minus the hitbox as a radius (squared)
-            // is still too far out, there is no overlap
-            float extend = (float)active->GetHitboxSize() * 10.f;
-            if(sqDist - (float)std::pow(extend, 2) <= radius)
-            {
-                results.push_back(active);
-            }
-        }
+            float reach = r + extent;
+            return (float)(std::pow(eX - x, 2) + std::pow(eY - y, 2)) <=
+                reach * reach && ZoneManager::PointInFoV(Point(eX, eY),
+                    extent, x, y, rot, maxAngle);
+        }, results);
+
+    return results;
+}
+
+const std::list<std::shared_ptr<ActiveEntityState>>
+    Zone::GetActiveEntitiesInRect(const Point& start, const Point& end,
+        float halfWidth, bool useHitbox, uint64_t now)
+{
+    std::list<std::shared_ptr<ActiveEntityState>> results;
+
+    // Measure everything along the center line and perpendicular to it
+    // instead of building the rotated corners
+    float length = start.GetDistance(end);
+    float dirX = 1.f;
+    float dirY = 0.f;
+    if(length > 0.f)
+    {
+        dirX = (end.x - start.x) / length;
+        dirY = (end.y - start.y) / length;
     }
 
+    QueryActiveEntities(std::min(start.x, end.x) - halfWidth,
+        std::min(start.y, end.y) - halfWidth,
+        std::max(start.x, end.x) + halfWidth,
+        std::max(start.y, end.y) + halfWidth, useHitbox, now,
+        [start, length, dirX, dirY, halfWidth](float eX, float eY,
+            float extent)
+        {
+            float relX = eX - start.x;
+            float relY = eY - start.y;
+
+            float along = relX * dirX + relY * dirY;
+            float across = (float)fabs(relY * dirX - relX * dirY);
+
+            // Distance from the rectangle on each axis, zero if inside
+            float outAlong = along < 0.f ? -along
+                : (along > length ? along - length : 0.f);
+            float outAcross = across > halfWidth ? across - halfWidth : 0.f;
+
+            return outAlong * outAlong + outAcross * outAcross <=
+                extent * extent;
+        }, results);
+
+    return results;
+}
+
+const std::list<std::shared_ptr<ActiveEntityState>>
+    Zone::GetActiveEntitiesInPolygon(const std::list<Point>& vertices,
+        bool useHitbox, uint64_t now)
+{
+    std::list<std::shared_ptr<ActiveEntityState>> results;
+
+    if(vertices.size() < 3)
+    {
+        return results;
+    }
+
+    float minX = vertices.front().x;
+    float minY = vertices.front().y;
+    float maxX = minX;
+    float maxY = minY;
+    for(auto& vert : vertices)
+    {
+        minX = std::min(minX, vert.x);
+        minY = std::min(minY, vert.y);
+        maxX = std::max(maxX, vert.x);
+        maxY = std::max(maxY, vert.y);
+    }
+
+    QueryActiveEntities(minX, minY, maxX, maxY, useHitbox, now,
+        [&vertices](float eX, float eY, float extent)
+        {
+            return ZoneManager::PointInPolygon(Point(eX, eY), vertices,
+                extent);
+        }, results);
+
     return results;
 }
 
@@ -698,6 +871,13 @@ const std::list<std::shared_ptr<AllyState>> Zone::GetAllies() const
     return mAllies;
 }
 
+AllySnapshot Zone::GetAllySnapshot()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    RefreshSnapshot(mAllySnapshot, mAllyGeneration, mAllies);
+    return mAllySnapshot;
+}
+
 std::shared_ptr<BazaarState> Zone::GetBazaar(int32_t id)
 {
     return std::dynamic_pointer_cast<BazaarState>(GetEntity(id));
@@ -750,6 +930,13 @@ const std::list<std::shared_ptr<EnemyState>> Zone::GetEnemies() const
     return mEnemies;
 }
 
+EnemySnapshot Zone::GetEnemySnapshot()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    RefreshSnapshot(mEnemySnapshot, mEnemyGeneration, mEnemies);
+    return mEnemySnapshot;
+}
+
 const std::list<std::shared_ptr<EnemyState>> Zone::GetBosses()
 {
     std::list<std::shared_ptr<EnemyState>> result;
@@ -810,6 +997,28 @@ std::list<std::shared_ptr<ActiveEntityState>>
     return all;
 }
 
+ActiveEntitySnapshot Zone::GetEnemyAndAllySnapshot()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    // Both generations only ever increase so their sum changes whenever
+    // either collection does
+    uint64_t generation = mEnemyGeneration + mAllyGeneration;
+    if(!mEnemyAndAllySnapshot ||
+        mEnemyAndAllySnapshot->GetGeneration() != generation)
+    {
+        std::vector<std::shared_ptr<ActiveEntityState>> all;
+        all.reserve(mEnemies.size() + mAllies.size());
+        all.insert(all.end(), mEnemies.begin(), mEnemies.end());
+        all.insert(all.end(), mAllies.begin(), mAllies.end());
+
+        mEnemyAndAllySnapshot = std::make_shared<ZoneEntitySnapshot<
+            ActiveEntityState>>(generation, std::move(all));
+    }
+
+    return mEnemyAndAllySnapshot;
+}
+
 std::shared_ptr<LootBoxState> Zone::GetLootBox(int32_t id)
 {
     return std::dynamic_pointer_cast<LootBoxState>(GetEntity(id));
@@ -976,6 +1185,13 @@ const std::list<std::shared_ptr<NPCState>> Zone::GetNPCs() const
     return mNPCs;
 }
 
+NPCSnapshot Zone::GetNPCSnapshot()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    RefreshSnapshot(mNPCSnapshot, mNPCGeneration, mNPCs);
+    return mNPCSnapshot;
+}
+
 std::shared_ptr<PlasmaState> Zone::GetPlasma(uint32_t id)
 {
     auto it = mPlasma.find(id);
@@ -1058,49 +1274,29 @@ std::shared_ptr<ServerObjectState> Zone::GetServerObject(int32_t id)
 void Zone::SetNextStatusEffectTime(uint32_t time, int32_t entityID)
 {
     std::lock_guard<std::mutex> lock(mLock);
-    if(time)
-    {
-        mNextEntityStatusTimes[time].insert(entityID);
-    }
-    else
-    {
-        for(auto pair : mNextEntityStatusTimes)
-        {
-            pair.second.erase(entityID);
-        }
-    }
+    mNextEntityStatusTimes.Set(entityID, time);
 }
 
 std::list<std::shared_ptr<ActiveEntityState>>
     Zone::GetUpdatedStatusEffectEntities(uint32_t now)
 {
     std::list<std::shared_ptr<ActiveEntityState>> result;
-    std::set<uint32_t> passed;
+    std::vector<int32_t> entityIDs;
 
     std::lock_guard<std::mutex> lock(mLock);
-    for(auto pair : mNextEntityStatusTimes)
+    mNextEntityStatusTimes.PopDue(now, entityIDs);
+    for(int32_t entityID : entityIDs)
     {
-        if(pair.first > now) break;
-
-        passed.insert(pair.first);
-        for(auto entityID : pair.second)
+        auto it = mAllEntities.find(entityID);
+        auto active = it != mAllEntities.end()
+            ? std::dynamic_pointer_cast<ActiveEntityState>(it->second)
+            : nullptr;
+        if(active)
         {
-            auto it = mAllEntities.find(entityID);
-            auto active = it != mAllEntities.end()
-                ? std::dynamic_pointer_cast<ActiveEntityState>(it->second)
-                : nullptr;
-            if(active)
-            {
-                result.push_back(active);
-            }
+            result.push_back(active);
         }
     }
 
-    for(auto p : passed)
-    {
-        mNextEntityStatusTimes.erase(p);
-    }
-
     return result;
 }
 
@@ -1420,11 +1616,13 @@ std::list<std::shared_ptr<ActiveEntityState>>
                 {
                     mEnemies.push_back(
                         std::dynamic_pointer_cast<EnemyState>(eState));
+                    mEnemyGeneration++;
                 }
                 else
                 {
                     mAllies.push_back(
                         std::dynamic_pointer_cast<AllyState>(eState));
+                    mAllyGeneration++;
                 }
 
                 eState->SetDisplayState(ActiveDisplayState_t::ACTIVE);
@@ -1737,34 +1935,58 @@ bool Zone::Collides(const Line& path, Point& point) const
 
 void Zone::Cleanup()
 {
-    std::lock_guard<std::mutex> lock(mLock);
-    for(auto pair : mAllEntities)
     {
-        auto active = std::dynamic_pointer_cast<ActiveEntityState>(pair.second);
-        if(active)
+        std::lock_guard<std::mutex> lock(mLock);
+        for(auto pair : mAllEntities)
         {
-            active->SetZone(0, false);
+            auto active = std::dynamic_pointer_cast<ActiveEntityState>(
+                pair.second);
+            if(active)
+            {
+                active->SetZone(0, false);
+            }
         }
-    }
 
-    mAllies.clear();
-    mBases.clear();
-    mBazaars.clear();
-    mBossIDs.clear();
-    mCultureMachines.clear();
-    mEncounters.clear();
-    mEncounterDefeatActions.clear();
-    mEnemies.clear();
-    mNPCs.clear();
-    mObjects.clear();
-    mPlasma.clear();
-    mActors.clear();
-    mAllEntities.clear();
-    mSpawnGroups.clear();
-    mSpawnLocationGroups.clear();
-    mStaggeredSpawns.clear();
+        mAllies.clear();
+        mBases.clear();
+        mBazaars.clear();
+        mBossIDs.clear();
+        mCultureMachines.clear();
+        mEncounters.clear();
+        mEncounterDefeatActions.clear();
+        mEnemies.clear();
+        mNPCs.clear();
+        mObjects.clear();
+        mPlasma.clear();
+        mActors.clear();
+        mAllEntities.clear();
+        mSpawnGroups.clear();
+        mSpawnLocationGroups.clear();
+        mStaggeredSpawns.clear();
+
+        mAllyGeneration++;
+        mEnemyGeneration++;
+        mNPCGeneration++;
 
-    mZoneInstance = nullptr;
+        // Drop any snapshots still referencing the cleared entities
+        mAllySnapshot = nullptr;
+        mEnemySnapshot = nullptr;
+        mEnemyAndAllySnapshot = nullptr;
+        mNPCSnapshot = nullptr;
+
+        mZoneInstance = nullptr;
+    }
+
+    // Release the entities held by the spatial index too. The index lock
+    // is never acquired while the zone lock is held.
+    {
+        std::lock_guard<std::mutex> lock(mSpatialLock);
+        mSpatialEntries.clear();
+        mSpatialCells.clear();
+        mSpatialMatches.clear();
+        mSpatialTime = 0;
+        mSpatialMaxExtent = 0.f;
+    }
 
     // Zone is no longer valid for use
     SetInvalid(true);
@@ -1890,6 +2112,7 @@ void Zone::AddSpawnedEntity(const std::shared_ptr<ActiveEntityState>& state,
     uint32_t spotID, uint32_t sgID, uint32_t slgID)
 {
     mActiveEntities.push_back(state);
+    mActiveEntityGeneration++;
 
     if(spotID != 0)
     {
@@ -2108,3 +2331,133 @@ bool Zone::DisableSpawnGroups(const std::set<uint32_t>& spawnGroupIDs,
 
     return updated;
 }
+
+template<typename T, typename R>
+void Zone::QueryActiveEntities(float minX, float minY, float maxX,
+    float maxY, bool useHitbox, uint64_t now, const T& test, R& results)
+{
+    if(!now)
+    {
+        // Nothing to share the index with, check every entity at the
+        // current time
+        now = ChannelServer::GetServerTime();
+
+        auto entities = GetActiveEntitySnapshot();
+        for(auto& active : *entities)
+        {
+            active->RefreshCurrentPosition(now);
+
+            float extent = useHitbox
+                ? (float)active->GetHitboxSize() * 10.f : 0.f;
+            if(test(active->GetCurrentX(), active->GetCurrentY(), extent))
+            {
+                results.push_back(active);
+            }
+        }
+
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mSpatialLock);
+
+    RefreshSpatialIndex(now);
+
+    mSpatialMatches.clear();
+
+    // Entities centered outside of the bounding box can still reach into
+    // it with their hitbox
+    float pad = useHitbox ? mSpatialMaxExtent : 0.f;
+    int64_t minCellX = GetSpatialCell(minX - pad);
+    int64_t minCellY = GetSpatialCell(minY - pad);
+    int64_t maxCellX = GetSpatialCell(maxX + pad);
+    int64_t maxCellY = GetSpatialCell(maxY + pad);
+
+    int64_t cellCount = (maxCellX - minCellX + 1) *
+        (maxCellY - minCellY + 1);
+    if(cellCount >= (int64_t)mSpatialCells.size())
+    {
+        // Visiting every cell in the box costs more than checking every
+        // entity directly
+        for(size_t i = 0; i < mSpatialEntries.size(); i++)
+        {
+            auto& entry = mSpatialEntries[i];
+            if(test(entry.X, entry.Y, useHitbox ? entry.Extent : 0.f))
+            {
+                mSpatialMatches.push_back(i);
+            }
+        }
+    }
+    else
+    {
+        for(int64_t cellX = minCellX; cellX <= maxCellX; cellX++)
+        {
+            for(int64_t cellY = minCellY; cellY <= maxCellY; cellY++)
+            {
+                auto it = mSpatialCells.find(GetSpatialCellKey(cellX,
+                    cellY));
+                if(it == mSpatialCells.end())
+                {
+                    continue;
+                }
+
+                for(size_t idx : it->second)
+                {
+                    auto& entry = mSpatialEntries[idx];
+                    if(test(entry.X, entry.Y, useHitbox ? entry.Extent
+                        : 0.f))
+                    {
+                        mSpatialMatches.push_back(idx);
+                    }
+                }
+            }
+        }
+
+        // Return results in snapshot order regardless of cell order
+        std::sort(mSpatialMatches.begin(), mSpatialMatches.end());
+    }
+
+    for(size_t idx : mSpatialMatches)
+    {
+        results.push_back(mSpatialEntries[idx].Entity);
+    }
+}
+
+void Zone::RefreshSpatialIndex(uint64_t now)
+{
+    auto snapshot = GetActiveEntitySnapshot();
+    if(mSpatialTime == now &&
+        mSpatialGeneration == snapshot->GetGeneration())
+    {
+        // Already built for this time and membership
+        return;
+    }
+
+    for(auto& cPair : mSpatialCells)
+    {
+        cPair.second.clear();
+    }
+
+    mSpatialEntries.clear();
+    mSpatialEntries.reserve(snapshot->size());
+    mSpatialMaxExtent = 0.f;
+
+    for(auto& active : *snapshot)
+    {
+        active->RefreshCurrentPosition(now);
+
+        SpatialEntry entry;
+        entry.Entity = active;
+        entry.X = active->GetCurrentX();
+        entry.Y = active->GetCurrentY();
+        entry.Extent = (float)active->GetHitboxSize() * 10.f;
+
+        mSpatialMaxExtent = std::max(mSpatialMaxExtent, entry.Extent);
+
+        mSpatialCells[GetSpatialCellKey(GetSpatialCell(entry.X),
+            GetSpatialCell(entry.Y))].push_back(mSpatialEntries.size());
+        mSpatialEntries.push_back(entry);
+    }
+
+    mSpatialTime = now;
+    mSpatialGeneration = snapshot->GetGeneration();
+}
@@ -35,6 +35,7 @@
 #include "EnemyState.h"
 #include "EntityState.h"
 #include "ZoneGeometry.h"
+#include "ZoneStatusEffectTable.h"
 
 // object Includes
 #include <ServerZoneInstanceVariant.h>
@@ -42,6 +43,7 @@
 
 // Standard C++11 includes
 #include <map>
+#include <vector>
 
 namespace objects
 {
@@ -75,6 +77,81 @@ typedef EntityState<objects::ServerObject> ServerObjectState;
 
 typedef objects::ServerZoneInstanceVariant::InstanceType_t InstanceType_t;
 
+/**
+ * Immutable, contiguous copy of one of the zone's entity collections
+ * tagged with the membership generation it was built from. Snapshots are
+ * only rebuilt when the collection they represent changes so repeated
+ * requests between changes share the same vector.
+ */
+template<typename T>
+class ZoneEntitySnapshot
+{
+public:
+    /**
+     * Create a new snapshot.
+     * @param generation Membership generation the entities were copied at
+     * @param entities Entities contained in the snapshot
+     */
+    ZoneEntitySnapshot(uint64_t generation,
+        std::vector<std::shared_ptr<T>>&& entities)
+        : mGeneration(generation), mEntities(std::move(entities))
+    {
+    }
+
+    /**
+     * Get the membership generation the snapshot was built from
+     * @return Membership generation of the snapshot
+     */
+    uint64_t GetGeneration() const
+    {
+        return mGeneration;
+    }
+
+    /**
+     * Get the entities contained in the snapshot
+     * @return Entities contained in the snapshot
+     */
+    const std::vector<std::shared_ptr<T>>& GetEntities() const
+    {
+        return mEntities;
+    }
+
+    typename std::vector<std::shared_ptr<T>>::const_iterator begin() const
+    {
+        return mEntities.begin();
+    }
+
+    typename std::vector<std::shared_ptr<T>>::const_iterator end() const
+    {
+        return mEntities.end();
+    }
+
+    size_t size() const
+    {
+        return mEntities.size();
+    }
+
+    bool empty() const
+    {
+        return mEntities.empty();
+    }
+
+private:
+    /// Membership generation the entities were copied at
+    uint64_t mGeneration;
+
+    /// Entities contained in the snapshot
+    std::vector<std::shared_ptr<T>> mEntities;
+};
+
+typedef std::shared_ptr<const ZoneEntitySnapshot<ActiveEntityState>>
+    ActiveEntitySnapshot;
+typedef std::shared_ptr<const ZoneEntitySnapshot<AllyState>> AllySnapshot;
+typedef std::shared_ptr<const ZoneEntitySnapshot<ChannelClientConnection>>
+    ConnectionSnapshot;
+typedef std::shared_ptr<const ZoneEntitySnapshot<EnemyState>> EnemySnapshot;
+typedef std::shared_ptr<const ZoneEntitySnapshot<NPCState>> NPCSnapshot;
+
 /**
  * Represents a server zone containing client connections, objects,
  * enemies, etc.
@@ -268,6 +345,14 @@ public:
      */
     std::list<std::shared_ptr<ChannelClientConnection>> GetConnectionList();
 
+    /**
+     * Get an immutable snapshot of all client connections in the zone.
+     * The snapshot is shared between calls until a connection is added
+     * or removed so iterating it does not allocate.
+     * @return Snapshot of all client connections in the zone
+     */
+    ConnectionSnapshot GetConnectionSnapshot();
+
     /**
      * Get an active entity in the zone by ID
      * @param entityID ID of the active entity to retrieve
@@ -282,6 +367,14 @@ public:
      */
     const std::list<std::shared_ptr<ActiveEntityState>> GetActiveEntities();
 
+    /**
+     * Get an immutable snapshot of all active entities in the zone. The
+     * snapshot is shared between calls until the active entity membership
+     * of the zone changes.
+     * @return Snapshot of all active entities
+     */
+    ActiveEntitySnapshot GetActiveEntitySnapshot();
+
     /**
      * Get all active entities in the zone within a supplied radius
      * @param x X coordinate of the center of the radius
@@ -289,11 +382,81 @@ public:
      * @param radius Radius to check for entities
      * @param useHitbox If true, the entities' hitboxes will be used to
      *  determine if they are in the radius, even if the center point is not
+     * @param now Server time to check entity positions at. If specified,
+     *  the zone spatial index for that time is used and shared with every
+     *  other query at the same time. If zero, the current time is used and
+     *  every entity is checked directly.
      * @return List of pointers to active entities in the radius
      */
     const std::list<std::shared_ptr<ActiveEntityState>>
         GetActiveEntitiesInRadius(float x, float y, double radius,
-            bool useHitbox = false);
+            bool useHitbox = false, uint64_t now = 0);
+
+    /**
+     * Get all active entities in the zone within a supplied radius into
+     * a buffer the caller reuses between queries
+     * @param results Output buffer, cleared before the results are added
+     * @param x X coordinate of the center of the radius
+     * @param y Y coordinate of the center of the radius
+     * @param radius Radius to check for entities
+     * @param useHitbox If true, the entities' hitboxes will be used to
+     *  determine if they are in the radius, even if the center point is not
+     * @param now Server time to check entity positions at, see
+     *  GetActiveEntitiesInRadius for more details
+     */
+    void GetActiveEntitiesInRadius(
+        std::vector<std::shared_ptr<ActiveEntityState>>& results,
+        float x, float y, double radius, bool useHitbox = false,
+        uint64_t now = 0);
+
+    /**
+     * Get all active entities in the zone within a supplied radius and
+     * field of view, such as the area in front of an entity
+     * @param x X coordinate of the center of the cone
+     * @param y Y coordinate of the center of the cone
+     * @param radius Radius to check for entities
+     * @param rot Rotation in radians for the center of the cone
+     * @param maxAngle Maximum angle in radians for either side of the cone
+     * @param useHitbox If true, the entities' hitboxes will be used to
+     *  determine if they are in the cone, even if the center point is not
+     * @param now Server time to check entity positions at, see
+     *  GetActiveEntitiesInRadius for more details
+     * @return List of pointers to active entities in the cone
+     */
+    const std::list<std::shared_ptr<ActiveEntityState>>
+        GetActiveEntitiesInCone(float x, float y, double radius, float rot,
+            float maxAngle, bool useHitbox = false, uint64_t now = 0);
+
+    /**
+     * Get all active entities in the zone within a rectangle rotated to
+     * follow a line segment, such as a straight line AoE
+     * @param start Start point of the rectangle's center line
+     * @param end End point of the rectangle's center line
+     * @param halfWidth Distance the rectangle extends on either side of
+     *  the center line
+     * @param useHitbox If true, the entities' hitboxes will be used to
+     *  determine if they are in the rectangle, even if the center point
+     *  is not
+     * @param now Server time to check entity positions at, see
+     *  GetActiveEntitiesInRadius for more details
+     * @return List of pointers to active entities in the rectangle
+     */
+    const std::list<std::shared_ptr<ActiveEntityState>>
+        GetActiveEntitiesInRect(const Point& start, const Point& end,
+            float halfWidth, bool useHitbox = false, uint64_t now = 0);
+
+    /**
+     * Get all active entities in the zone within a polygon
+     * @param vertices List of points representing the polygon's vertices
+     * @param useHitbox If true, the entities' hitboxes will be used to
+     *  determine if they are in the polygon, even if the center point is not
+     * @param now Server time to check entity positions at, see
+     *  GetActiveEntitiesInRadius for more details
+     * @return List of pointers to active entities in the polygon
+     */
+    const std::list<std::shared_ptr<ActiveEntityState>>
+        GetActiveEntitiesInPolygon(const std::list<Point>& vertices,
+            bool useHitbox = false, uint64_t now = 0);
 
     /**
      * Get an entity instance by it's ID.
@@ -315,6 +478,12 @@ public:
      */
     const std::list<std::shared_ptr<AllyState>> GetAllies() const;
 
+    /**
+     * Get an immutable snapshot of all ally instances in the zone
+     * @return Snapshot of all ally instances in the zone
+     */
+    AllySnapshot GetAllySnapshot();
+
     /**
      * Get a bazaar instance by it's ID.
      * @param id Instance ID of the bazaar.
@@ -375,6 +544,12 @@ public:
      */
     const std::list<std::shared_ptr<EnemyState>> GetEnemies() const;
 
+    /**
+     * Get an immutable snapshot of all enemy instances in the zone
+     * @return Snapshot of all enemy instances in the zone
+     */
+    EnemySnapshot GetEnemySnapshot();
+
     /**
      * Get all boss enemy instances in the zone
      * @return List of all boss enemy instances in the zone
@@ -390,6 +565,13 @@ public:
     std::list<std::shared_ptr<ActiveEntityState>> GetEnemiesAndAllies(
         bool includeStaggered = false);
 
+    /**
+     * Get an immutable snapshot of all spawned enemy and ally instances in
+     * the zone. Staggered spawns are not included.
+     * @return Snapshot of all enemy and ally instances in the zone
+     */
+    ActiveEntitySnapshot GetEnemyAndAllySnapshot();
+
     /**
      * Get a loot box instance by it's ID.
      * @param id Instance ID of the loot box.
@@ -449,6 +631,12 @@ public:
      */
     const std::list<std::shared_ptr<NPCState>> GetNPCs() const;
 
+    /**
+     * Get an immutable snapshot of all NPC instances in the zone
+     * @return Snapshot of all NPC instances in the zone
+     */
+    NPCSnapshot GetNPCSnapshot();
+
     /**
      * Get a plasma instance by it's definition ID.
      * @param id Definition ID of the plasma.
@@ -491,8 +679,9 @@ public:
 
     /**
      * Set the next status effect event time associated to an entity
-     * in the zone
-     * @param time Time of the next status effect event time
+     * in the zone, replacing any time previously set for the entity
+     * @param time Time of the next status effect event time or 0 to
+     *  clear the entity's time
      * @param entityID ID of the entity with a status effect event
      *  at the specified time
      */
@@ -503,7 +692,8 @@ public:
      * event times that have passed since the specified time
      * @param now System time representing the current server time
      * @return List of entities that have had registered status effect
-     *  event times that have passed
+     *  event times that have passed, ordered by event time and containing
+     *  each entity only once
      */
     std::list<std::shared_ptr<ActiveEntityState>>
         GetUpdatedStatusEffectEntities(uint32_t now);
@@ -825,6 +1015,53 @@ private:
     bool DisableSpawnGroups(const std::set<uint32_t>& spawnGroupIDs,
         bool initializing, bool deactivate);
 
+    /**
+     * Gather active entities within the supplied bounding box that pass a
+     * shape test. If a time is specified the spatial index is used to
+     * limit the entities checked, otherwise every active entity is checked
+     * at the current time.
+     * @param minX Minimum X coordinate of the shape's bounding box
+     * @param minY Minimum Y coordinate of the shape's bounding box
+     * @param maxX Maximum X coordinate of the shape's bounding box
+     * @param maxY Maximum Y coordinate of the shape's bounding box
+     * @param useHitbox If true, the entities' hitboxes will be passed to
+     *  the shape test as the distance they extend from their center
+     * @param now Server time to check entity positions at or zero
+     * @param test Shape test taking an entity's center point and hitbox
+     *  extension, returning true if the entity is in the shape
+     * @param results Output container the active entities in the shape
+     *  are appended to, in the same order as the active entity snapshot
+     */
+    template<typename T, typename R>
+    void QueryActiveEntities(float minX, float minY, float maxX, float maxY,
+        bool useHitbox, uint64_t now, const T& test, R& results);
+
+    /**
+     * Rebuild the spatial index with the active entity positions at the
+     * supplied time if it was not already built for it. The spatial lock
+     * must be held when calling this.
+     * @param now Server time to index entity positions at
+     */
+    void RefreshSpatialIndex(uint64_t now);
+
+    /**
+     * Entity position stored in the zone spatial index
+     */
+    struct SpatialEntry
+    {
+        /// Pointer to the indexed entity
+        std::shared_ptr<ActiveEntityState> Entity;
+
+        /// X coordinate of the entity when it was indexed
+        float X;
+
+        /// Y coordinate of the entity when it was indexed
+        float Y;
+
+        /// Distance the entity's hitbox extends from its center
+        float Extent;
+    };
+
     /// Map of world CIDs to client connections
     std::unordered_map<int32_t, std::shared_ptr<ChannelClientConnection>> mConnections;
 
@@ -896,9 +1133,9 @@ private:
     /// when referencing in actions or events
     std::unordered_map<int32_t, std::shared_ptr<objects::EntityStateObject>> mActors;
 
-    /// Map of system times to active entities with status effects that need
-    /// handling at that time
-    std::map<uint32_t, std::set<int32_t>> mNextEntityStatusTimes;
+    /// Schedule of the next system time each active entity with status
+    /// effects needs handling at
+    ZoneStatusEffectTable mNextEntityStatusTimes;
 
     /// Map of server times to spawn location group IDs that need to be respawned
     /// at that time
@@ -942,6 +1179,39 @@ private:
     /// Next ID to use for encounters registered for the zone
     uint32_t mNextEncounterID;
 
+    /// Membership generation of mConnections, incremented on every change
+    uint64_t mConnectionGeneration;
+
+    /// Membership generation of mActiveEntities, incremented on every change
+    uint64_t mActiveEntityGeneration;
+
+    /// Membership generation of mAllies, incremented on every change
+    uint64_t mAllyGeneration;
+
+    /// Membership generation of mEnemies, incremented on every change
+    uint64_t mEnemyGeneration;
+
+    /// Membership generation of mNPCs, incremented on every change
+    uint64_t mNPCGeneration;
+
+    /// Last built snapshot of mConnections
+    ConnectionSnapshot mConnectionSnapshot;
+
+    /// Last built snapshot of mActiveEntities
+    ActiveEntitySnapshot mActiveEntitySnapshot;
+
+    /// Last built snapshot of mAllies
+    AllySnapshot mAllySnapshot;
+
+    /// Last built snapshot of mEnemies
+    EnemySnapshot mEnemySnapshot;
+
+    /// Last built snapshot of mEnemies and mAllies combined
+    ActiveEntitySnapshot mEnemyAndAllySnapshot;
+
+    /// Last built snapshot of mNPCs
+    NPCSnapshot mNPCSnapshot;
+
     /// Quick reference flag to determine if the zone has respwa
     bool mHasRespawns;
 
@@ -949,8 +1219,31 @@ private:
     /// updated since the last call to DiasporaMiniBossUpdated
     bool mDiasporaMiniBossUpdated;
 
+    /// Active entity positions in the spatial index, in the same order as
+    /// the active entity snapshot it was built from
+    std::vector<SpatialEntry> mSpatialEntries;
+
+    /// Spatial index grid cells mapped to indexes in mSpatialEntries. Cells
+    /// are cleared rather than removed on rebuild to keep their capacity.
+    std::unordered_map<uint64_t, std::vector<size_t>> mSpatialCells;
+
+    /// Reusable buffer of mSpatialEntries indexes matched by a query
+    std::vector<size_t> mSpatialMatches;
+
+    /// Server time the spatial index was built for
+    uint64_t mSpatialTime;
+
+    /// Active entity generation the spatial index was built from
+    uint64_t mSpatialGeneration;
+
+    /// Largest hitbox extension of any entity in the spatial index
+    float mSpatialMaxExtent;
+
     /// Server lock for shared resources
     std::mutex mLock;
+
+    /// Lock for the spatial index, never acquired while mLock is held
+    std::mutex mSpatialLock;
 };
 
 } // namespace channel
@@ -41,6 +41,7 @@
 #include <QmpNavPoint.h>
 
 // Standard C++11 Includes
+#include <algorithm>
 #include <thread>
 
 using namespace channel;
@@ -57,7 +58,9 @@ std::unordered_map<std::string,
 
     std::list<std::thread*> threads;
 
-    for(uint32_t i = 0; i < std::thread::hardware_concurrency(); ++i)
+    size_t threadCount = std::min(mZonePairs.size(), (size_t)std::max(1U,
+        std::thread::hardware_concurrency()));
+    for(size_t i = 0; i < threadCount; ++i)
     {
         threads.push_back(new std::thread(
             [&](const std::shared_ptr<ChannelServer>& _server) {
@@ -97,8 +100,17 @@ bool ZoneGeometryLoader::LoadZoneQMP(
     auto zoneData = definitionManager->GetZoneData(zoneID);
 
     libcomp::String filename = zoneData->GetFile()->GetQmpFile();
-    if(filename.IsEmpty() || mZoneGeometry.find(filename.C()) !=
-        mZoneGeometry.end())
+    if(filename.IsEmpty())
+    {
+        return true;
+    }
+
+    // Zones can share a file so only the first thread to claim it loads it
+    mDataLock.lock();
+    bool claimed = mClaimedFiles.insert(filename.C()).second;
+    mDataLock.unlock();
+
+    if(!claimed)
     {
         return true;
     }
@@ -43,7 +43,9 @@
 #include <ActionSpawn.h>
 #include <ActionStartEvent.h>
 #include <Ally.h>
+#include <ChannelConfig.h>
 #include <ChannelLogin.h>
+#include <ChannelTelemetry.h>
 #include <CharacterLogin.h>
 #include <CharacterProgress.h>
 #include <DestinyBox.h>
@@ -111,6 +113,7 @@
 #include "PerformanceTimer.h"
 #include "PlasmaState.h"
 #include "SkillManager.h"
+#include "StartupTaskGraph.h"
 #include "TokuseiManager.h"
 #include "Zone.h"
 #include "ZoneGeometryLoader.h"
@@ -118,6 +121,7 @@
 
 // C++ Standard Includes
 #include <cmath>
+#include <map>
 
 using namespace channel;
 
@@ -168,13 +172,12 @@ ZoneManager::~ZoneManager()
     }
 }
 
-void ZoneManager::LoadGeometry()
+bool ZoneManager::LoadGeometry()
 {
     auto server = mServer.lock();
     auto sharedConfig = server->GetWorldSharedConfig();
     uint8_t channelID = server->GetChannelID();
 
-    auto definitionManager = server->GetDefinitionManager();
     auto serverDataManager = server->GetServerDataManager();
 
     std::unordered_map<uint32_t, std::set<uint32_t>> localZoneIDs;
@@ -207,14 +210,42 @@ void ZoneManager::LoadGeometry()
         }
     }
 
-    // Build zone geometry from QMP files
-    ZoneGeometryLoader loader;
-    mZoneGeometry = loader.LoadQMP(localZoneIDs, server);
+    // Geometry is built from the QMP files and the spot definitions
+    // separately so both can be loaded at the same time
+    auto conf = std::dynamic_pointer_cast<objects::ChannelConfig>(
+        server->GetConfig());
+    StartupTaskGraph loader(conf->GetParallelStartup());
+
+    bool tasksAdded = loader.AddTask("geometry", [&]()
+    {
+        // Build zone geometry from QMP files
+        ZoneGeometryLoader qmpLoader;
+        mZoneGeometry = qmpLoader.LoadQMP(localZoneIDs, server);
+
+        return true;
+    });
+
+    tasksAdded = loader.AddTask("spots", [&]()
+    {
+        BuildDynamicMaps(localZoneIDs);
+
+        return true;
+    }) && tasksAdded;
+
+    return tasksAdded && loader.Run();
+}
+
+void ZoneManager::BuildDynamicMaps(const std::unordered_map<uint32_t,
+    std::set<uint32_t>>& zoneIDs)
+{
+    auto server = mServer.lock();
+    auto definitionManager = server->GetDefinitionManager();
+    auto serverDataManager = server->GetServerDataManager();
 
     // Build any existing zone spots as polygons
-    // Loop through a second time instead of handling in the first loop
-    // because dynamic map/QMP file combos are not the same on all zones
-    for(auto zonePair : localZoneIDs)
+    // These are handled separately from the QMP files because dynamic
+    // map/QMP file combos are not the same on all zones
+    for(auto zonePair : zoneIDs)
     {
         uint32_t zoneID = zonePair.first;
         auto zoneData = definitionManager->GetZoneData(zoneID);
@@ -301,6 +332,67 @@ void ZoneManager::LoadGeometry()
     }
 }
 
+void ZoneManager::DigestStartupState(StartupDigest& digest)
+{
+    std::lock_guard<libcomp::Mutex> lock(mLock);
+
+    std::map<std::string, std::shared_ptr<ZoneGeometry>> geometry(
+        mZoneGeometry.begin(), mZoneGeometry.end());
+    for(auto& geoPair : geometry)
+    {
+        digest.Add(libcomp::String(geoPair.first));
+        digest.Add((uint64_t)geoPair.second->Elements.size());
+        digest.Add((uint64_t)geoPair.second->Shapes.size());
+
+        for(auto& shape : geoPair.second->Shapes)
+        {
+            digest.Add(shape->ShapeID);
+            for(auto& p : shape->Vertices)
+            {
+                digest.Add(p.x);
+                digest.Add(p.y);
+            }
+        }
+    }
+
+    std::map<uint32_t, std::shared_ptr<DynamicMap>> dynamicMaps(
+        mDynamicMaps.begin(), mDynamicMaps.end());
+    for(auto& dPair : dynamicMaps)
+    {
+        digest.Add(dPair.first);
+
+        std::map<uint32_t, std::shared_ptr<ZoneSpotShape>> spots(
+            dPair.second->Spots.begin(), dPair.second->Spots.end());
+        for(auto& spotPair : spots)
+        {
+            digest.Add(spotPair.first);
+            for(auto& p : spotPair.second->Vertices)
+            {
+                digest.Add(p.x);
+                digest.Add(p.y);
+            }
+        }
+    }
+
+    std::map<uint32_t, std::set<uint32_t>> globalZones;
+    for(auto& zPair : mGlobalZoneMap)
+    {
+        for(auto& dPair : zPair.second)
+        {
+            globalZones[zPair.first].insert(dPair.first);
+        }
+    }
+
+    for(auto& zPair : globalZones)
+    {
+        digest.Add(zPair.first);
+        for(uint32_t dynamicMapID : zPair.second)
+        {
+            digest.Add(dynamicMapID);
+        }
+    }
+}
+
 void ZoneManager::InstanceGlobalZones()
 {
     auto server = mServer.lock();
@@ -656,7 +748,7 @@ bool ZoneManager::EnterZone(const std::shared_ptr<ChannelClientConnection>& clie
             syncManager->UpdateRecord(nextInstance->GetAccess(),
                 "InstanceAccess");
 
-            syncManager->SyncOutgoing();
+            syncManager->ScheduleSyncOutgoing();
         }
 
         // Reactive the zone if its not active already
@@ -1208,7 +1300,8 @@ void ZoneManager::LeaveZone(const std::shared_ptr<ChannelClientConnection>& clie
                 {
                     // Stop all AI in place
                     uint64_t now = ChannelServer::GetServerTime();
-                    for(auto eState : zone->GetEnemies())
+                    auto enemies = zone->GetEnemySnapshot();
+                    for(auto& eState : *enemies)
                     {
                         eState->Stop(now);
                     }
@@ -1341,7 +1434,7 @@ void ZoneManager::LeaveZone(const std::shared_ptr<ChannelClientConnection>& clie
 }
 
 uint8_t ZoneManager::CreateInstance(
-    const std::shared_ptr<objects::InstanceAccess>& access)
+    const std::shared_ptr<objects::InstanceAccess>& access, bool localOnly)
 {
     auto server = mServer.lock();
     auto serverDataManager = server->GetServerDataManager();
@@ -1424,6 +1517,26 @@ uint8_t ZoneManager::CreateInstance(
     uint8_t ownerChannelID = sharedConfig->ChannelDistributionCount() > 0
         ? sharedConfig->GetChannelDistribution(def->GetGroupID()) : channelID;
 
+    if(!localOnly && sharedConfig->ChannelDistributionCount() == 0 &&
+        access->GetRequestID().IsNull())
+    {
+        // Every channel can host the instance so place it on the least
+        // loaded channel if the world has selected a different one. Access
+        // requested by another channel has already been placed here.
+        int8_t placementID = syncManager->GetPlacementChannelID();
+        if(placementID >= 0 && (uint8_t)placementID != channelID)
+        {
+            for(auto channel : server->GetAllRegisteredChannels())
+            {
+                if(channel->GetID() == (uint8_t)placementID)
+                {
+                    ownerChannelID = (uint8_t)placementID;
+                    break;
+                }
+            }
+        }
+    }
+
     access->SetChannelID(ownerChannelID);
 
     // Notify players on this channel that it has been created (other channels
@@ -1464,7 +1577,7 @@ uint8_t ZoneManager::CreateInstance(
         access->SetRequestID(libobjgen::UUID::Random());
 
         // Sync the record
-        syncManager->SyncRecordUpdate(access, "InstanceAccess");
+        syncManager->QueueRecordUpdate(access, "InstanceAccess");
 
         return 2;   // Requested on another channel
     }
@@ -1538,7 +1651,7 @@ uint8_t ZoneManager::CreateInstance(
 
         // Sync the record to notify the rest
         syncManager->UpdateRecord(access, "InstanceAccess");
-        syncManager->SyncOutgoing();
+        syncManager->ScheduleSyncOutgoing();
 
         return 1;   // Created local
     }
@@ -1918,12 +2031,14 @@ bool ZoneManager::SendPopulateZoneData(const std::shared_ptr<
 
     // All zone information is queued and sent together to minimize excess
     // communication
-    for(auto enemyState : zone->GetEnemies())
+    auto enemies = zone->GetEnemySnapshot();
+    for(auto& enemyState : *enemies)
     {
         SendEnemyData(enemyState, client, zone, true);
     }
 
-    for(auto npcState : zone->GetNPCs())
+    auto npcs = zone->GetNPCSnapshot();
+    for(auto& npcState : *npcs)
     {
         if(npcState->GetEntity()->GetState() == HNPC_STATE_SHOW)
         {
@@ -2037,7 +2152,8 @@ bool ZoneManager::SendPopulateZoneData(const std::shared_ptr<
         SendLootBoxData(client, lState, nullptr, false, true);
     }
 
-    for(auto allyState : zone->GetAllies())
+    auto allies = zone->GetAllySnapshot();
+    for(auto& allyState : *allies)
     {
         SendAllyData(allyState, client, zone, true);
     }
@@ -3093,26 +3209,16 @@ void ZoneManager::HandleSpecialInstancePopulate(
 void ZoneManager::BroadcastPacket(const std::shared_ptr<ChannelClientConnection>& client,
     libcomp::Packet& p, bool includeSelf)
 {
-    std::list<std::shared_ptr<libcomp::TcpConnection>> connections;
-    for(auto connection : GetZoneConnections(client, includeSelf))
-    {
-        connections.push_back(connection);
-    }
-
-    libcomp::TcpConnection::BroadcastPacket(connections, p);
+    ChannelClientConnection::BroadcastPacket(GetZoneConnections(client,
+        includeSelf), p);
 }
 
 void ZoneManager::BroadcastPacket(const std::shared_ptr<Zone>& zone, libcomp::Packet& p)
 {
     if(nullptr != zone)
     {
-        std::list<std::shared_ptr<libcomp::TcpConnection>> connections;
-        for(auto connectionPair : zone->GetConnections())
-        {
-            connections.push_back(connectionPair.second);
-        }
-
-        libcomp::TcpConnection::BroadcastPacket(connections, p);
+        ChannelClientConnection::BroadcastPacket(zone->GetConnectionList(),
+            p);
     }
 }
 
@@ -3126,7 +3232,7 @@ void ZoneManager::SendToRange(const std::shared_ptr<ChannelClientConnection>& cl
 
     cState->RefreshCurrentPosition(now);
 
-    std::list<std::shared_ptr<libcomp::TcpConnection>> zConnections;
+    std::list<std::shared_ptr<ChannelClientConnection>> zConnections;
     if(includeSelf)
     {
         zConnections.push_back(client);
@@ -3143,7 +3249,7 @@ void ZoneManager::SendToRange(const std::shared_ptr<ChannelClientConnection>& cl
             zConnections.push_back(zConnection);
         }
     }
-    libcomp::TcpConnection::BroadcastPacket(zConnections, p);
+    ChannelClientConnection::BroadcastPacket(zConnections, p);
 }
 
 std::list<std::shared_ptr<ChannelClientConnection>> ZoneManager::GetZoneConnections(
@@ -4537,6 +4643,49 @@ std::shared_ptr<ActiveEntityState> ZoneManager::CreateEnemy(
     return state;
 }
 
+void ZoneManager::GetPopulationTelemetry(const std::shared_ptr<
+    objects::ChannelTelemetry>& telemetry)
+{
+    std::lock_guard<libcomp::Mutex> lock(mLock);
+
+    telemetry->SetZoneCount((uint16_t)mZones.size());
+    telemetry->SetActiveZoneCount((uint16_t)mActiveZones.size());
+    telemetry->SetInstanceCount((uint16_t)mZoneInstances.size());
+
+    // Only occupied zones are reported to keep the record compact. Global
+    // zones are reported by definition ID while instance players are
+    // summed together.
+    uint16_t instancePopulation = 0;
+    for(uint32_t uniqueID : mActiveZones)
+    {
+        auto it = mZones.find(uniqueID);
+        if(it == mZones.end())
+        {
+            continue;
+        }
+
+        auto zone = it->second;
+        uint16_t count = (uint16_t)zone->GetConnectionSnapshot()->size();
+        if(!count)
+        {
+            continue;
+        }
+
+        if(zone->GetInstanceID())
+        {
+            instancePopulation = (uint16_t)(instancePopulation + count);
+        }
+        else
+        {
+            uint32_t zoneID = zone->GetDefinitionID();
+            telemetry->SetZonePopulations(zoneID, (uint16_t)(
+                telemetry->GetZonePopulations(zoneID) + count));
+        }
+    }
+
+    telemetry->SetInstancePopulation(instancePopulation);
+}
+
 void ZoneManager::UpdateActiveZoneStates()
 {
     auto serverTime = ChannelServer::GetServerTime();
@@ -4619,6 +4768,13 @@ void ZoneManager::UpdateActiveZoneStates()
 
         mTimeRestrictUpdatedZones.erase(zone->GetID());
 
+        // Send anything the bounded queues kept back now that the zone has
+        // had its turn
+        for(auto client : zone->GetConnectionList())
+        {
+            client->ReleaseQueue();
+        }
+
         perf.Stop(libcomp::String("Zone %1").Arg(zone->GetDefinitionID()));
     }
 
@@ -7206,7 +7362,7 @@ float ZoneManager::GetPointToLineDistance(const Line& line, const Point& point)
 }
 
 bool ZoneManager::PointInPolygon(const Point& p, const std::list<
-    Point> vertices, float overlapRadius)
+    Point>& vertices, float overlapRadius)
 {
     auto p1 = vertices.begin();
     auto p2 = vertices.begin();
@@ -7217,7 +7373,7 @@ bool ZoneManager::PointInPolygon(const Point& p, const std::list<
     for(size_t i = 0; i < count; i++)
     {
         // Check if the point is on the vertex
-        if(p.x == p1->x && p.y == p2->y)
+        if(p.x == p1->x && p.y == p1->y)
         {
             return true;
         }
@@ -7268,42 +7424,50 @@ std::list<std::shared_ptr<ActiveEntityState>> ZoneManager::GetEntitiesInFoV(
 {
     std::list<std::shared_ptr<ActiveEntityState>> results;
 
-    // Max and min radians of the arc's circle
-    float maxRotL = rot + maxAngle;
-    float maxRotR = rot - maxAngle;
-
     for(auto e : entities)
     {
         Point ePoint(e->GetCurrentX(), e->GetCurrentY());
-        float eRot = (float)atan2((float)(y - ePoint.y),
-            (float)(x - ePoint.x));
-
-        if(maxRotL >= eRot && maxRotR <= eRot)
+        float extend = useHitbox ? (float)e->GetHitboxSize() * 10.f : 0.f;
+        if(PointInFoV(ePoint, extend, x, y, rot, maxAngle))
         {
             results.push_back(e);
         }
-        else if(useHitbox)
+    }
+
+    return results;
+}
+
+bool ZoneManager::PointInFoV(const Point& p, float extend, float x, float y,
+    float rot, float maxAngle)
+{
+    // Max and min radians of the arc's circle
+    float maxRotL = rot + maxAngle;
+    float maxRotR = rot - maxAngle;
+
+    float pRot = (float)atan2((float)(y - p.y), (float)(x - p.x));
+    if(maxRotL >= pRot && maxRotR <= pRot)
+    {
+        return true;
+    }
+    else if(extend > 0.f)
+    {
+        // "Shift" the center of the point based on the rotation and
+        // recalculate to see if the extended area is included for each side
+        for(float max : { maxRotL, maxRotR })
         {
-            // "Shift" the center of the entity based on the rotation and
-            // recalculate to see if the hitbox is included for each side
-            float extend = (float)e->GetHitboxSize() * 10.f;
-            for(float max : { maxRotL, maxRotR })
+            Point exPoint(p.x, p.y + extend);
+            exPoint = RotatePoint(exPoint, p,
+                ActiveEntityState::CorrectRotation(-max));
+            pRot = (float)atan2((float)(y - exPoint.y),
+                (float)(x - exPoint.x));
+            if(maxRotL >= pRot && maxRotR <= pRot)
             {
-                Point exPoint(ePoint.x, ePoint.y + extend);
-                exPoint = RotatePoint(exPoint, ePoint,
-                    ActiveEntityState::CorrectRotation(-max));
-                eRot = (float)atan2((float)(y - exPoint.y),
-                    (float)(x - exPoint.x));
-                if(maxRotL >= eRot && maxRotR <= eRot)
-                {
-                    results.push_back(e);
-                    break;
-                }
+                return true;
             }
         }
     }
 
-    return results;
+    return false;
 }
 
 void ZoneManager::ScheduleInstanceAccessTimeOut(
@@ -8544,11 +8708,11 @@ void ZoneManager::RemoveZone(const std::shared_ptr<Zone>& zone,
     else
     {
         // Remove any AI aggro in the zone
-        auto eBases = zone->GetEnemiesAndAllies();
-        if(eBases.size() > 0)
+        auto eBases = zone->GetEnemyAndAllySnapshot();
+        if(!eBases->empty())
         {
             auto aiManager = mServer.lock()->GetAIManager();
-            for(auto eBase : eBases)
+            for(auto& eBase : *eBases)
             {
                 aiManager->UpdateAggro(eBase, -1);
             }
@@ -8642,7 +8806,7 @@ bool ZoneManager::RemoveInstance(uint32_t instanceID)
     }
 
     mServer.lock()->GetChannelSyncManager()
-        ->SyncRecordRemoval(access, "InstanceAccess");
+        ->QueueRecordRemoval(access, "InstanceAccess");
 
     return true;
 }
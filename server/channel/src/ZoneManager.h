@@ -47,6 +47,7 @@ class Packet;
 namespace objects
 {
 class ActionSpawn;
+class ChannelTelemetry;
 class MiZoneData;
 class PvPInstanceVariant;
 class Spawn;
@@ -56,6 +57,7 @@ namespace channel
 {
 
 class ChannelServer;
+class StartupDigest;
 class WorldClock;
 class WorldClockTime;
 
@@ -84,8 +86,9 @@ public:
      * to zones as they are instantiated. If a specific file fails to
      * load, an error will be returned but the zone will still be
      * accessible without server side collision support.
+     * @return false if the loading tasks could not be run
      */
-    void LoadGeometry();
+    bool LoadGeometry();
 
     /**
      * Instantiate all global zones the server is responsible for
@@ -94,6 +97,14 @@ public:
      */
     void InstanceGlobalZones();
 
+    /**
+     * Add the geometry, spots and global zones built during startup to a
+     * digest. The digest does not depend on the order things were loaded
+     * in so it can be compared between serial and parallel startups.
+     * @param digest Digest to add the state to.
+     */
+    void DigestStartupState(StartupDigest& digest);
+
     /**
      * Get the zone associated to a client connection
      * @param client Client connection connected to a zone
@@ -175,13 +186,19 @@ public:
         bool logOut, uint32_t newZoneID = 0, uint32_t newDynamicMapID = 0);
 
     /**
-     * Create a zone instance with access granted for the supplied CIDs
+     * Create a zone instance with access granted for the supplied CIDs.
+     * If zones are not distributed between channels and the world has
+     * selected a less loaded placement channel, the instance will be
+     * requested on that channel instead.
      * @param access Pointer to the access definition
+     * @param localOnly If true, never request the instance on another
+     *  channel for load placement
      * @return 0 if it failed to create, 1 if it created local, 2 if a request
      *  was sent to the world to create the instance
      */
     uint8_t CreateInstance(
-        const std::shared_ptr<objects::InstanceAccess>& access);
+        const std::shared_ptr<objects::InstanceAccess>& access,
+        bool localOnly = false);
 
     /**
      * Expire and remove an instance matching the supplied values
@@ -670,6 +687,14 @@ public:
      */
     void UpdateActiveZoneStates();
 
+    /**
+     * Populate the zone, instance and per zone player counts of the supplied
+     * telemetry record from the zones currently hosted on the channel.
+     * @param telemetry Pointer to the telemetry record to populate
+     */
+    void GetPopulationTelemetry(const std::shared_ptr<
+        objects::ChannelTelemetry>& telemetry);
+
     /**
      * Update the state of status effects in the supplied zone, adding
      * and updating existing effects, expiring old effects and applying
@@ -1056,9 +1081,23 @@ public:
      *  using this value as the radius and checking if it overlaps anywhere
      * @return true if the point is within the polygon, false if it is not
      */
-    static bool PointInPolygon(const Point& p, const std::list<Point> vertices,
+    static bool PointInPolygon(const Point& p, const std::list<Point>& vertices,
         float overlapRadius = 0.f);
 
+    /**
+     * Determine if the specified point is within the field of view
+     * @param p Point to check
+     * @param extend Radius around the point to treat as part of it, such
+     *  as the hitbox of an entity standing at the point
+     * @param x X coordinate of the FoV origin
+     * @param y Y coordinate of the FoV origin
+     * @param rot Rotation in radians for the center of the FoV
+     * @param maxAngle Maximum angle in radians for either side of the FoV
+     * @return true if the point is within the FoV, false if it is not
+     */
+    static bool PointInFoV(const Point& p, float extend, float x, float y,
+        float rot, float maxAngle);
+
     /**
      * Filter the list of supplied entities to only those visible in the
      * specified field of view
@@ -1095,6 +1134,14 @@ public:
         std::list<std::shared_ptr<objects::InstanceAccess>> removes);
 
 private:
+    /**
+     * Build the spot shapes of the dynamic maps used by the supplied zones.
+     * @param zoneIDs Map of zone IDs to the dynamic map IDs used by them.
+     * @note This is called by @ref LoadGeometry.
+     */
+    void BuildDynamicMaps(const std::unordered_map<uint32_t,
+        std::set<uint32_t>>& zoneIDs);
+
     /**
      * Select a spot for a spawn group and get it's location.
      * @param useSpotID If the spot ID should be used.
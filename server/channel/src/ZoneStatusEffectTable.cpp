@@ -0,0 +1,158 @@
+/**
+ * @file server/channel/src/ZoneStatusEffectTable.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Zone level schedule of status effect ticks.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ZoneStatusEffectTable.h"
+
+using namespace channel;
+
+ZoneStatusEffectTable::ZoneStatusEffectTable()
+{
+}
+
+void ZoneStatusEffectTable::Set(int32_t entityID, uint32_t time)
+{
+    if(!time)
+    {
+        Remove(entityID);
+        return;
+    }
+
+    Entry entry;
+    entry.Time = time;
+    entry.EntityID = entityID;
+
+    auto it = mPositions.find(entityID);
+    if(it != mPositions.end())
+    {
+        size_t pos = it->second;
+        mHeap[pos] = entry;
+        Fix(pos);
+    }
+    else
+    {
+        mHeap.push_back(entry);
+        mPositions[entityID] = mHeap.size() - 1;
+        Fix(mHeap.size() - 1);
+    }
+}
+
+void ZoneStatusEffectTable::Remove(int32_t entityID)
+{
+    auto it = mPositions.find(entityID);
+    if(it != mPositions.end())
+    {
+        RemoveAt(it->second);
+    }
+}
+
+void ZoneStatusEffectTable::PopDue(uint32_t now,
+    std::vector<int32_t>& entityIDs)
+{
+    // The top of the heap is always the next entity due
+    while(mHeap.size() > 0 && mHeap[0].Time <= now)
+    {
+        entityIDs.push_back(mHeap[0].EntityID);
+        RemoveAt(0);
+    }
+}
+
+size_t ZoneStatusEffectTable::Size() const
+{
+    return mHeap.size();
+}
+
+bool ZoneStatusEffectTable::Before(const Entry& a, const Entry& b)
+{
+    return a.Time < b.Time || (a.Time == b.Time && a.EntityID < b.EntityID);
+}
+
+void ZoneStatusEffectTable::Fix(size_t pos)
+{
+    Entry entry = mHeap[pos];
+
+    // Move up past any parent due later
+    while(pos > 0)
+    {
+        size_t parent = (pos - 1) / 2;
+        if(!Before(entry, mHeap[parent]))
+        {
+            break;
+        }
+
+        Place(pos, mHeap[parent]);
+        pos = parent;
+    }
+
+    // Move down past any child due sooner
+    size_t count = mHeap.size();
+    while(true)
+    {
+        size_t child = pos * 2 + 1;
+        if(child >= count)
+        {
+            break;
+        }
+
+        if(child + 1 < count && Before(mHeap[child + 1], mHeap[child]))
+        {
+            child++;
+        }
+
+        if(!Before(mHeap[child], entry))
+        {
+            break;
+        }
+
+        Place(pos, mHeap[child]);
+        pos = child;
+    }
+
+    Place(pos, entry);
+}
+
+void ZoneStatusEffectTable::RemoveAt(size_t pos)
+{
+    mPositions.erase(mHeap[pos].EntityID);
+
+    // Move the last entry into the removed one
+    size_t last = mHeap.size() - 1;
+    if(pos != last)
+    {
+        mHeap[pos] = mHeap[last];
+        mHeap.pop_back();
+        Fix(pos);
+    }
+    else
+    {
+        mHeap.pop_back();
+    }
+}
+
+void ZoneStatusEffectTable::Place(size_t pos, const Entry& entry)
+{
+    mHeap[pos] = entry;
+    mPositions[entry.EntityID] = pos;
+}
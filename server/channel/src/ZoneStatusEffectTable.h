@@ -0,0 +1,134 @@
+/**
+ * @file server/channel/src/ZoneStatusEffectTable.h
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Zone level schedule of status effect ticks.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_CHANNEL_SRC_ZONESTATUSEFFECTTABLE_H
+#define SERVER_CHANNEL_SRC_ZONESTATUSEFFECTTABLE_H
+
+// Standard C++11 Includes
+#include <cstddef>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace channel
+{
+
+/**
+ * Schedule of the next status effect event time of each active entity in a
+ * zone. The entities are kept in a binary min-heap ordered by event time
+ * then entity ID with the heap position of each entity indexed so a time
+ * can be replaced or removed in place. The zone tick only touches the
+ * entities that are due, popping them in order off the top of the heap. An
+ * entity only ever registers its earliest pending event time so setting a
+ * new time replaces the old one. The table is not thread safe and must be
+ * guarded by the zone.
+ */
+class ZoneStatusEffectTable
+{
+public:
+    /**
+     * Create an empty table.
+     */
+    ZoneStatusEffectTable();
+
+    /**
+     * Set the next status effect event time of an entity.
+     * @param entityID ID of the entity
+     * @param time System time of the next event or 0 to remove the entity
+     */
+    void Set(int32_t entityID, uint32_t time);
+
+    /**
+     * Remove an entity from the table.
+     * @param entityID ID of the entity
+     */
+    void Remove(int32_t entityID);
+
+    /**
+     * Remove every entity with an event time that has passed from the table.
+     * @param now System time representing the current server time
+     * @param entityIDs Output list to append the IDs of the entities to,
+     *  ordered by event time then entity ID
+     */
+    void PopDue(uint32_t now, std::vector<int32_t>& entityIDs);
+
+    /**
+     * Get the number of entities in the table.
+     * @return Number of entities with a scheduled event time
+     */
+    size_t Size() const;
+
+private:
+    /**
+     * Scheduled event time of one entity.
+     */
+    struct Entry
+    {
+        /// Next event time
+        uint32_t Time;
+
+        /// ID of the entity
+        int32_t EntityID;
+    };
+
+    /**
+     * Check if one entry is due before another.
+     * @param a First entry
+     * @param b Second entry
+     * @return true if the first entry is due before the second
+     */
+    static bool Before(const Entry& a, const Entry& b);
+
+    /**
+     * Move an entry at a heap position up or down until the heap is
+     * ordered again.
+     * @param pos Heap position of the entry
+     */
+    void Fix(size_t pos);
+
+    /**
+     * Remove the entry at a heap position.
+     * @param pos Heap position of the entry
+     */
+    void RemoveAt(size_t pos);
+
+    /**
+     * Store an entry at a heap position and index it.
+     * @param pos Heap position to store the entry at
+     * @param entry Entry to store
+     */
+    void Place(size_t pos, const Entry& entry);
+
+    /// Binary min-heap of the scheduled entries
+    std::vector<Entry> mHeap;
+
+    /// Map of entity IDs to their heap position
+    std::unordered_map<int32_t, size_t> mPositions;
+};
+
+} // namespace channel
+
+#endif // SERVER_CHANNEL_SRC_ZONESTATUSEFFECTTABLE_H
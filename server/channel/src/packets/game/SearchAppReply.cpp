@@ -202,7 +202,7 @@ bool Parsers::SearchAppReply::Parse(libcomp::ManagerPacket *pPacketManager,
             auto entry = std::make_shared<objects::SearchEntry>(*replyEntry);
             entry->SetLastAction(objects::SearchEntry::LastAction_t::REMOVE_MANUAL);
 
-            success = syncManager->SyncRecordRemoval(entry, "SearchEntry");
+            success = syncManager->QueueRecordRemoval(entry, "SearchEntry");
         }
     }
 
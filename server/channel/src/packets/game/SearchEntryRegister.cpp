@@ -476,7 +476,7 @@ bool Parsers::SearchEntryRegister::Parse(libcomp::ManagerPacket *pPacketManager,
 
     if(success)
     {
-        success = syncManager->SyncRecordUpdate(entry, "SearchEntry");
+        success = syncManager->QueueRecordUpdate(entry, "SearchEntry");
     }
     else
     {
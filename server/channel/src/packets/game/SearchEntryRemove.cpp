@@ -125,7 +125,7 @@ bool Parsers::SearchEntryRemove::Parse(libcomp::ManagerPacket *pPacketManager,
 
         if(success)
         {
-            success = syncManager->SyncRecordRemoval(entry, "SearchEntry");
+            success = syncManager->QueueRecordRemoval(entry, "SearchEntry");
         }
         else
         {
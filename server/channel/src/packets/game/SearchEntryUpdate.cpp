@@ -280,7 +280,7 @@ bool Parsers::SearchEntryUpdate::Parse(libcomp::ManagerPacket *pPacketManager,
 
         if(success)
         {
-            success = syncManager->SyncRecordUpdate(entry, "SearchEntry");
+            success = syncManager->QueueRecordUpdate(entry, "SearchEntry");
         }
         else
         {
@@ -57,6 +57,7 @@
 #include "ChannelServer.h"
 #include "ChannelSyncManager.h"
 #include "CharacterManager.h"
+#include "ItemBoxIndex.h"
 
 using namespace channel;
 
@@ -275,8 +276,11 @@ void HandleShopPurchase(const std::shared_ptr<ChannelServer> server,
 
         price = price * quantity;
 
+        // Index the inventory once for the payment and the product stacks
+        ItemBoxIndex index(inventory);
+
         if(!characterManager->CalculateMaccaPayment(client, (uint64_t)price,
-            insertItems, stackAdjustItems))
+            insertItems, stackAdjustItems, &index))
         {
             auto accountUID = state->GetAccountUID();
             LogGeneralError([accountUID]()
@@ -296,8 +300,7 @@ void HandleShopPurchase(const std::shared_ptr<ChannelServer> server,
         // Update existing stacks first if we aren't adding a full stack
         if(qtyLeft < maxStack)
         {
-            for(auto item : characterManager->GetExistingItems(character,
-                product->GetItem(), inventory))
+            for(auto item : index.GetItems(product->GetItem()))
             {
                 if(qtyLeft == 0) break;
 
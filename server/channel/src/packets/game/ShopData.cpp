@@ -99,7 +99,8 @@ bool Parsers::ShopData::Parse(libcomp::ManagerPacket *pPacketManager,
         {
             auto tab = shopData->GetTabs(i);
             if(tab->ConditionsCount() > 0 && !eventManager
-                ->EvaluateEventConditions(zone, tab->GetConditions(), client))
+                ->EvaluateEventConditions(zone, tab.get(),
+                tab->GetConditions(), client))
             {
                 cEvent->InsertDisabledChoices(i);
                 disabledTabs.insert(i);
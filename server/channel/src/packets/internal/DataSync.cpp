@@ -50,8 +50,8 @@ bool Parsers::DataSync::Parse(libcomp::ManagerPacket *pPacketManager,
         return false;
     }
 
-    // Sync any records that need to relay back
-    syncManager->SyncOutgoing();
+    // Sync any records that need to relay back with the next tick
+    syncManager->ScheduleSyncOutgoing();
 
     return true;
 }
@@ -166,9 +166,22 @@ bool SetWorldInfoFromPacket(libcomp::ManagerPacket *pPacketManager,
 
     // Load local geometry and build global zone instances now that we've
     // connected properly
-    server->GetZoneManager()->LoadGeometry();
+    if(!server->GetZoneManager()->LoadGeometry())
+    {
+        LogGeneralCriticalMsg("Zone geometry failed to load.\n");
+
+        server->Shutdown();
+        return true;
+    }
+
     server->GetZoneManager()->InstanceGlobalZones();
 
+    LogGeneralInfo([&]()
+    {
+        return libcomp::String("Startup state digest: %1\n")
+            .Arg(server->GetStartupDigest());
+    });
+
     // Initialize the sync manager now that we have the DBs, shutdown if
     // it fails
     if(!server->GetChannelSyncManager()->Initialize())
@@ -0,0 +1,165 @@
+/**
+ * @file server/channel/tests/AILevelOfDetail.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Test the AI level-of-detail update throttling.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+#include <PopIgnore.h>
+
+// channel Includes
+#include <AILevelOfDetail.h>
+
+using namespace channel;
+
+// 1 second throttle interval in milliseconds and microseconds
+static const uint32_t INTERVAL_MS = 1000;
+static const uint64_t INTERVAL = 1000000ULL;
+
+static float Squared(float dist)
+{
+    return dist * dist;
+}
+
+TEST(AILevelOfDetail, DisabledNeverSkips)
+{
+    AILevelOfDetail lod(0.f, 10000.f, INTERVAL_MS);
+
+    EXPECT_FALSE(lod.IsEnabled());
+
+    uint64_t next = 0;
+    EXPECT_FALSE(lod.Skip(-1.f, false, next, 1));
+    EXPECT_FALSE(lod.Skip(Squared(50000.f), false, next, 2));
+    EXPECT_EQ(next, 0ULL);
+}
+
+TEST(AILevelOfDetail, NearPlayerUpdatesEveryTick)
+{
+    AILevelOfDetail lod(4000.f, 10000.f, INTERVAL_MS);
+
+    EXPECT_TRUE(lod.IsEnabled());
+
+    // A scheduled throttled update is cleared once a player is near
+    uint64_t next = 5 * INTERVAL;
+    for(uint64_t now = 1; now < 10; now++)
+    {
+        EXPECT_FALSE(lod.Skip(Squared(3999.f), false, next, now));
+        EXPECT_EQ(next, 0ULL);
+    }
+
+    // Exactly on the boundary still counts as near
+    EXPECT_FALSE(lod.Skip(Squared(4000.f), false, next, 10));
+}
+
+TEST(AILevelOfDetail, DistantUpdatesOnInterval)
+{
+    AILevelOfDetail lod(4000.f, 10000.f, INTERVAL_MS);
+
+    float dist = Squared(6000.f);
+
+    uint64_t start = 100 * INTERVAL;
+    uint64_t next = 0;
+
+    // First check updates and schedules the next one
+    EXPECT_FALSE(lod.Skip(dist, false, next, start));
+    EXPECT_EQ(next, start + INTERVAL);
+
+    // Every tick until the interval passes is skipped
+    int updates = 0;
+    for(uint64_t now = start + 50000ULL; now <= start + 10 * INTERVAL;
+        now += 50000ULL)
+    {
+        if(!lod.Skip(dist, false, next, now))
+        {
+            updates++;
+        }
+    }
+
+    // 10 intervals pass, one update each
+    EXPECT_EQ(updates, 10);
+}
+
+TEST(AILevelOfDetail, FrozenBeyondFreezeDistance)
+{
+    AILevelOfDetail lod(4000.f, 10000.f, INTERVAL_MS);
+
+    uint64_t next = 0;
+    for(uint64_t now = 1; now < 20 * INTERVAL; now += INTERVAL)
+    {
+        EXPECT_TRUE(lod.Skip(Squared(12000.f), false, next, now));
+        EXPECT_TRUE(lod.Skip(-1.f, false, next, now));
+    }
+
+    // Nothing is scheduled while frozen
+    EXPECT_EQ(next, 0ULL);
+
+    // Moving entities keep updating on the interval so they can finish
+    // their movement
+    EXPECT_FALSE(lod.Skip(Squared(12000.f), true, next, 30 * INTERVAL));
+    EXPECT_EQ(next, 31 * INTERVAL);
+    EXPECT_TRUE(lod.Skip(Squared(12000.f), true, next, 30 * INTERVAL + 1));
+}
+
+TEST(AILevelOfDetail, NoFreezeDistance)
+{
+    AILevelOfDetail lod(4000.f, 0.f, INTERVAL_MS);
+
+    // Without a freeze distance distant entities and empty zones are only
+    // throttled
+    uint64_t next = 0;
+    EXPECT_FALSE(lod.Skip(-1.f, false, next, INTERVAL));
+    EXPECT_TRUE(lod.Skip(-1.f, false, next, INTERVAL + 1));
+    EXPECT_FALSE(lod.Skip(Squared(50000.f), false, next, 2 * INTERVAL));
+}
+
+TEST(AILevelOfDetail, PlayerApproachResumes)
+{
+    AILevelOfDetail lod(4000.f, 10000.f, INTERVAL_MS);
+
+    uint64_t next = 0;
+    EXPECT_FALSE(lod.Skip(Squared(6000.f), false, next, INTERVAL));
+    EXPECT_TRUE(lod.Skip(Squared(6000.f), false, next, INTERVAL + 1));
+
+    // A player walks up mid interval
+    EXPECT_FALSE(lod.Skip(Squared(100.f), false, next, INTERVAL + 2));
+    EXPECT_EQ(next, 0ULL);
+
+    // And leaves again, throttling starts over from the current time
+    EXPECT_FALSE(lod.Skip(Squared(6000.f), false, next, INTERVAL + 3));
+    EXPECT_EQ(next, 2 * INTERVAL + 3);
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,355 @@
+/**
+ * @file server/channel/tests/DropTable.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Test the drop tables against the per drop rate calculation.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+#include <PopIgnore.h>
+
+// objects Includes
+#include <DropSet.h>
+#include <ItemDrop.h>
+
+// channel Includes
+#include <DropTable.h>
+
+// Standard C++11 Includes
+#include <cmath>
+#include <vector>
+
+using namespace channel;
+
+namespace
+{
+
+/// Number of times each table is rolled
+const int ROLL_COUNT = 200000;
+
+/// Base rates of the test drop set, including a guaranteed drop and one
+/// that can never drop
+const std::vector<float> BASE_RATES = { 0.f, 0.1f, 1.f, 5.f, 10.f, 25.f,
+    50.f, 75.f, 100.f, 3.5f };
+
+/**
+ * Drop rate out of 10000 calculated the way CharacterManager::DetermineDrops
+ * did for each drop before the drop tables.
+ */
+uint32_t ReferenceRate(float rate, int16_t luck, float globalDropBonus,
+    float scalingCap)
+{
+    double baseRate = (double)rate;
+    uint32_t dropRate = (uint32_t)(baseRate * 100.0);
+    if(luck > 0 && scalingCap != 0.f)
+    {
+        double deltaDiff = (double)(100.0 - baseRate);
+        dropRate = (uint32_t)(baseRate * (100.f +
+            100.f * (float)(((double)luck / 30.0) * 10.0 * (double)luck) /
+            (1000.0 + 7.0 * (double)luck + (deltaDiff * deltaDiff))));
+
+        if(scalingCap > 0.f &&
+            (float)((double)dropRate / (baseRate * 100.0)) > (1.f + scalingCap))
+        {
+            dropRate = (uint32_t)(baseRate * 100.0 * (1.0 + (double)scalingCap));
+        }
+    }
+
+    return (uint32_t)((double)dropRate * (double)(1.f + globalDropBonus));
+}
+
+/**
+ * Chance of a drop being selected at a rate out of 10000.
+ */
+double Chance(uint32_t dropRate)
+{
+    return dropRate >= 10000 ? 1.0 : (double)dropRate / 10000.0;
+}
+
+std::shared_ptr<objects::DropSet> MakeDropSet(uint32_t id,
+    const std::vector<float>& rates)
+{
+    auto dropSet = std::make_shared<objects::DropSet>();
+    dropSet->SetID(id);
+
+    uint32_t itemType = 1;
+    for(float rate : rates)
+    {
+        auto drop = std::make_shared<objects::ItemDrop>();
+        drop->SetItemType(itemType++);
+        drop->SetRate(rate);
+
+        dropSet->AppendDrops(drop);
+    }
+
+    return dropSet;
+}
+
+/**
+ * Upper critical value of the chi-squared distribution with the supplied
+ * degrees of freedom at a significance of 0.0001, using the Wilson-Hilferty
+ * approximation.
+ */
+double ChiSquaredLimit(size_t degrees)
+{
+    double k = (double)degrees;
+    double term = 1.0 - 2.0 / (9.0 * k) + 3.719 * sqrt(2.0 / (9.0 * k));
+
+    return k * term * term * term;
+}
+
+/**
+ * Check that the number of times each drop was selected matches the
+ * expected chances. Drops that are always or never selected must match
+ * exactly, every other drop adds one degree of freedom to a chi-squared
+ * test of the selection counts.
+ */
+void ExpectChances(const std::vector<double>& chances,
+    const std::vector<int>& counts, int rolls)
+{
+    ASSERT_EQ(chances.size(), counts.size());
+
+    double stat = 0.0;
+    size_t degrees = 0;
+    for(size_t i = 0; i < chances.size(); i++)
+    {
+        double p = chances[i];
+        if(p <= 0.0 || p >= 1.0)
+        {
+            EXPECT_EQ(p <= 0.0 ? 0 : rolls, counts[i]) << "drop " << i;
+            continue;
+        }
+
+        double expected = (double)rolls * p;
+        double delta = (double)counts[i] - expected;
+        stat += delta * delta / (expected * (1.0 - p));
+        degrees++;
+    }
+
+    if(degrees > 0)
+    {
+        EXPECT_LT(stat, ChiSquaredLimit(degrees)) << degrees
+            << " degree(s) of freedom";
+    }
+}
+
+/**
+ * Count the selections of each drop of a drop set in a buffer, by the
+ * item type the test drops were given.
+ */
+void CountDrops(DropRollBuffer& buffer, std::vector<int>& counts)
+{
+    for(auto& drop : buffer.GetDrops())
+    {
+        counts[drop->GetItemType() - 1]++;
+    }
+}
+
+void ExpectTableMatches(int16_t luck, float globalDropBonus,
+    float scalingCap)
+{
+    auto dropSet = MakeDropSet(1, BASE_RATES);
+    DropTable table(dropSet, globalDropBonus, scalingCap);
+
+    std::vector<double> chances;
+    for(float rate : BASE_RATES)
+    {
+        chances.push_back(Chance(ReferenceRate(rate, luck, globalDropBonus,
+            scalingCap)));
+    }
+
+    DropRollBuffer buffer(luck);
+    std::vector<int> counts(BASE_RATES.size(), 0);
+    for(int i = 0; i < ROLL_COUNT; i++)
+    {
+        buffer.Clear();
+        table.Roll(buffer);
+        CountDrops(buffer, counts);
+    }
+
+    ExpectChances(chances, counts, ROLL_COUNT);
+}
+
+} // namespace
+
+TEST(DropTable, RatesMatchReference)
+{
+    for(float rate : BASE_RATES)
+    {
+        for(int16_t luck = 0; luck < 1000; luck++)
+        {
+            for(float scalingCap : { 0.f, -1.f, 0.5f, 2.f })
+            {
+                for(float globalDropBonus : { 0.f, 0.25f })
+                {
+                    ASSERT_EQ(ReferenceRate(rate, luck, globalDropBonus,
+                        scalingCap), DropTable::GetDropRate((double)rate,
+                        luck, globalDropBonus, scalingCap)) << "rate " << rate
+                        << " luck " << luck << " cap " << scalingCap
+                        << " bonus " << globalDropBonus;
+                }
+            }
+        }
+    }
+}
+
+TEST(DropTable, RollWithoutLuck)
+{
+    ExpectTableMatches(0, 0.f, 0.f);
+    ExpectTableMatches(0, 0.5f, 1.f);
+}
+
+TEST(DropTable, RollWithLuck)
+{
+    ExpectTableMatches(30, 0.f, -1.f);
+    ExpectTableMatches(500, 0.f, 1.f);
+    ExpectTableMatches(500, 0.25f, 0.f);
+}
+
+TEST(DropTable, MinLastSelectsLastDrop)
+{
+    std::vector<float> rates = { 20.f, 10.f, 30.f };
+    DropTable table(MakeDropSet(1, rates), 0.f, 0.f);
+
+    // The last drop is selected if it rolls or if nothing else did
+    std::vector<double> chances;
+    double none = 1.0;
+    for(size_t i = 0; i < rates.size(); i++)
+    {
+        double p = Chance(ReferenceRate(rates[i], 0, 0.f, 0.f));
+        if(i + 1 < rates.size())
+        {
+            chances.push_back(p);
+            none *= 1.0 - p;
+        }
+        else
+        {
+            chances.push_back(p + (1.0 - p) * none);
+        }
+    }
+
+    DropRollBuffer buffer;
+    std::vector<int> counts(rates.size(), 0);
+    for(int i = 0; i < ROLL_COUNT; i++)
+    {
+        buffer.Clear();
+        table.Roll(buffer, true);
+        EXPECT_FALSE(buffer.GetDrops().empty());
+
+        CountDrops(buffer, counts);
+    }
+
+    ExpectChances(chances, counts, ROLL_COUNT);
+}
+
+TEST(DropTable, BufferKeepsRatesPerTable)
+{
+    // Both tables are rolled with the same buffer so each must keep its
+    // own scaled rates
+    std::vector<float> lowRates = { 1.f, 2.f, 3.f };
+    std::vector<float> highRates = { 60.f, 40.f, 20.f, 10.f };
+
+    DropTable low(MakeDropSet(1, lowRates), 0.f, 1.f);
+    DropTable high(MakeDropSet(2, highRates), 0.f, 1.f);
+
+    int16_t luck = 200;
+    DropRollBuffer buffer(luck);
+
+    std::vector<int> lowCounts(lowRates.size(), 0);
+    std::vector<int> highCounts(highRates.size(), 0);
+    for(int i = 0; i < ROLL_COUNT; i++)
+    {
+        buffer.Clear();
+        low.Roll(buffer);
+        CountDrops(buffer, lowCounts);
+
+        buffer.Clear();
+        high.Roll(buffer);
+        CountDrops(buffer, highCounts);
+    }
+
+    std::vector<double> lowChances, highChances;
+    for(float rate : lowRates)
+    {
+        lowChances.push_back(Chance(ReferenceRate(rate, luck, 0.f, 1.f)));
+    }
+
+    for(float rate : highRates)
+    {
+        highChances.push_back(Chance(ReferenceRate(rate, luck, 0.f, 1.f)));
+    }
+
+    ExpectChances(lowChances, lowCounts, ROLL_COUNT);
+    ExpectChances(highChances, highCounts, ROLL_COUNT);
+}
+
+TEST(DropTable, RollDropList)
+{
+    auto dropSet = MakeDropSet(1, BASE_RATES);
+    auto drops = dropSet->GetDrops();
+
+    int16_t luck = 100;
+
+    std::vector<double> chances;
+    for(float rate : BASE_RATES)
+    {
+        chances.push_back(Chance(ReferenceRate(rate, luck, 0.1f, 0.5f)));
+    }
+
+    DropRollBuffer buffer(luck);
+    std::vector<int> counts(BASE_RATES.size(), 0);
+    for(int i = 0; i < ROLL_COUNT; i++)
+    {
+        buffer.Clear();
+        DropTable::Roll(drops, 0.1f, 0.5f, buffer);
+        CountDrops(buffer, counts);
+    }
+
+    ExpectChances(chances, counts, ROLL_COUNT);
+}
+
+TEST(DropTable, MatchesDropSetAndConfig)
+{
+    auto dropSet = MakeDropSet(1, BASE_RATES);
+    DropTable table(dropSet, 0.f, 1.f);
+
+    EXPECT_TRUE(table.Matches(dropSet, 0.f, 1.f));
+    EXPECT_FALSE(table.Matches(dropSet, 0.5f, 1.f));
+    EXPECT_FALSE(table.Matches(dropSet, 0.f, 2.f));
+    EXPECT_FALSE(table.Matches(MakeDropSet(1, BASE_RATES), 0.f, 1.f));
+    EXPECT_EQ(BASE_RATES.size(), table.GetDrops().size());
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
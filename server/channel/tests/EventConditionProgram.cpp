@@ -0,0 +1,322 @@
+/**
+ * @file server/channel/tests/EventConditionProgram.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Test compiled event condition lists against the interpreter.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+#include <PopIgnore.h>
+
+// object Includes
+#include <EventCondition.h>
+#include <EventFlagCondition.h>
+#include <EventScriptCondition.h>
+
+// channel Includes
+#include <EventConditionProgram.h>
+
+// Standard C++11 Includes
+#include <random>
+#include <unordered_map>
+
+using namespace channel;
+
+typedef objects::EventCondition::Type_t ConditionType_t;
+typedef EventConditionOp::Kind_t Kind_t;
+
+static const ConditionType_t TYPES[] = {
+    ConditionType_t::SCRIPT,
+    ConditionType_t::ZONE_FLAGS,
+    ConditionType_t::ZONE_CHARACTER_FLAGS,
+    ConditionType_t::ZONE_INSTANCE_FLAGS,
+    ConditionType_t::ZONE_INSTANCE_CHARACTER_FLAGS,
+    ConditionType_t::PARTNER_ALIVE,
+    ConditionType_t::PARTNER_FAMILIARITY,
+    ConditionType_t::PARTNER_LEVEL,
+    ConditionType_t::PARTNER_LOCKED,
+    ConditionType_t::PARTNER_SKILL_LEARNED,
+    ConditionType_t::PARTNER_STAT_VALUE,
+    ConditionType_t::SOUL_POINTS,
+    ConditionType_t::QUEST_AVAILABLE,
+    ConditionType_t::QUEST_PHASE,
+    ConditionType_t::QUEST_PHASE_REQUIREMENTS,
+    ConditionType_t::QUEST_FLAGS,
+    ConditionType_t::CLAN_HOME,
+    ConditionType_t::COMP_DEMON,
+    ConditionType_t::DEMON_BOOK,
+    ConditionType_t::EQUIPPED,
+    ConditionType_t::ITEM,
+    ConditionType_t::SUMMONED,
+};
+
+namespace
+{
+
+/**
+ * Path the interpreter took to evaluate a single condition.
+ */
+struct InterpretedPath
+{
+    Kind_t Kind;
+    bool Negate;
+    bool CharacterFlags;
+    bool InstanceFlags;
+    std::shared_ptr<objects::EventScriptCondition> ScriptCondition;
+    std::shared_ptr<objects::EventFlagCondition> FlagCondition;
+};
+
+} // namespace
+
+/**
+ * Condition list interpreter the compiled programs replaced, kept here as
+ * the reference implementation. Each condition is switched on and cast
+ * again for every check.
+ */
+template<typename F>
+static bool Interpret(
+    const std::list<std::shared_ptr<objects::EventCondition>>& conditions,
+    const F& leaf)
+{
+    for(auto condition : conditions)
+    {
+        InterpretedPath path;
+        path.Negate = condition->GetNegate();
+        path.CharacterFlags = false;
+        path.InstanceFlags = false;
+
+        switch(condition->GetType())
+        {
+        case ConditionType_t::SCRIPT:
+            path.Kind = Kind_t::SCRIPT;
+            path.ScriptCondition = std::dynamic_pointer_cast<
+                objects::EventScriptCondition>(condition);
+            break;
+        case ConditionType_t::ZONE_FLAGS:
+        case ConditionType_t::ZONE_CHARACTER_FLAGS:
+        case ConditionType_t::ZONE_INSTANCE_FLAGS:
+        case ConditionType_t::ZONE_INSTANCE_CHARACTER_FLAGS:
+            path.Kind = Kind_t::FLAGS;
+            switch(condition->GetType())
+            {
+            case ConditionType_t::ZONE_FLAGS:
+                break;
+            case ConditionType_t::ZONE_CHARACTER_FLAGS:
+                path.CharacterFlags = true;
+                break;
+            case ConditionType_t::ZONE_INSTANCE_FLAGS:
+                path.InstanceFlags = true;
+                break;
+            case ConditionType_t::ZONE_INSTANCE_CHARACTER_FLAGS:
+                path.CharacterFlags = true;
+                path.InstanceFlags = true;
+                break;
+            default:
+                break;
+            }
+
+            path.FlagCondition = std::dynamic_pointer_cast<
+                objects::EventFlagCondition>(condition);
+            break;
+        case ConditionType_t::PARTNER_ALIVE:
+        case ConditionType_t::PARTNER_FAMILIARITY:
+        case ConditionType_t::PARTNER_LEVEL:
+        case ConditionType_t::PARTNER_LOCKED:
+        case ConditionType_t::PARTNER_SKILL_LEARNED:
+        case ConditionType_t::PARTNER_STAT_VALUE:
+        case ConditionType_t::SOUL_POINTS:
+            path.Kind = Kind_t::PARTNER;
+            break;
+        case ConditionType_t::QUEST_AVAILABLE:
+        case ConditionType_t::QUEST_PHASE:
+        case ConditionType_t::QUEST_PHASE_REQUIREMENTS:
+        case ConditionType_t::QUEST_FLAGS:
+            path.Kind = Kind_t::QUEST;
+            break;
+        default:
+            path.Kind = Kind_t::STANDARD;
+            break;
+        }
+
+        if(!leaf(condition, path))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static std::shared_ptr<objects::EventCondition> RandomCondition(
+    std::mt19937& rng)
+{
+    auto type = TYPES[rng() % (sizeof(TYPES) / sizeof(TYPES[0]))];
+
+    std::shared_ptr<objects::EventCondition> condition;
+    switch(type)
+    {
+    case ConditionType_t::SCRIPT:
+        condition = std::make_shared<objects::EventScriptCondition>();
+        break;
+    case ConditionType_t::ZONE_FLAGS:
+    case ConditionType_t::ZONE_CHARACTER_FLAGS:
+    case ConditionType_t::ZONE_INSTANCE_FLAGS:
+    case ConditionType_t::ZONE_INSTANCE_CHARACTER_FLAGS:
+        condition = std::make_shared<objects::EventFlagCondition>();
+        break;
+    default:
+        condition = std::make_shared<objects::EventCondition>();
+        break;
+    }
+
+    condition->SetType(type);
+    condition->SetNegate(rng() % 4 == 0);
+
+    return condition;
+}
+
+static std::list<std::shared_ptr<objects::EventCondition>> RandomConditions(
+    std::mt19937& rng)
+{
+    std::list<std::shared_ptr<objects::EventCondition>> conditions;
+
+    size_t count = (size_t)(rng() % 9);
+    for(size_t i = 0; i < count; i++)
+    {
+        conditions.push_back(RandomCondition(rng));
+    }
+
+    return conditions;
+}
+
+TEST(EventConditionProgram, MatchesInterpreter)
+{
+    std::mt19937 rng(0x0E7C04D);
+
+    for(int trial = 0; trial < 20000; trial++)
+    {
+        auto conditions = RandomConditions(rng);
+
+        // Fix the outcome of each condition for this trial
+        std::vector<bool> outcomes;
+        std::unordered_map<const objects::EventCondition*, size_t> indexes;
+        for(auto& condition : conditions)
+        {
+            indexes[condition.get()] = outcomes.size();
+            outcomes.push_back(rng() % 5 != 0);
+        }
+
+        std::vector<size_t> interpreted;
+        std::vector<InterpretedPath> paths;
+        bool expected = Interpret(conditions, [&](const std::shared_ptr<
+            objects::EventCondition>& condition, const InterpretedPath& path)
+            {
+                size_t idx = indexes[condition.get()];
+                interpreted.push_back(idx);
+                paths.push_back(path);
+                return (bool)outcomes[idx];
+            });
+
+        auto program = EventConditionProgram::Compile(conditions);
+        ASSERT_EQ(program.Ops.size(), conditions.size());
+
+        std::vector<size_t> compiled;
+        bool result = program.Evaluate([&](const EventConditionOp& op)
+            {
+                size_t idx = (size_t)(&op - &program.Ops[0]);
+
+                // The op must take the same path the interpreter did
+                auto& path = paths[compiled.size()];
+                EXPECT_EQ(op.Kind, path.Kind);
+                EXPECT_EQ(op.Negate, path.Negate);
+                EXPECT_EQ(op.CharacterFlags, path.CharacterFlags);
+                EXPECT_EQ(op.InstanceFlags, path.InstanceFlags);
+                EXPECT_EQ(op.ScriptCondition, path.ScriptCondition);
+                EXPECT_EQ(op.FlagCondition, path.FlagCondition);
+
+                compiled.push_back(idx);
+                return (bool)outcomes[idx];
+            });
+
+        // Same result and the same conditions checked in the same order
+        ASSERT_EQ(result, expected) << "Trial " << trial;
+        ASSERT_EQ(compiled, interpreted) << "Trial " << trial;
+    }
+}
+
+TEST(EventConditionProgram, Operands)
+{
+    std::mt19937 rng(0x0C0DE5E);
+
+    for(int trial = 0; trial < 2000; trial++)
+    {
+        auto conditions = RandomConditions(rng);
+        auto program = EventConditionProgram::Compile(conditions);
+
+        size_t idx = 0;
+        for(auto condition : conditions)
+        {
+            auto& op = program.Ops[idx++];
+
+            EXPECT_EQ(op.Condition, condition);
+            EXPECT_EQ(op.Negate, condition->GetNegate());
+
+            // Only the typed condition for the path is set
+            EXPECT_EQ(op.ScriptCondition != nullptr,
+                op.Kind == Kind_t::SCRIPT);
+            EXPECT_EQ(op.FlagCondition != nullptr,
+                op.Kind == Kind_t::FLAGS);
+            if(op.Kind != Kind_t::FLAGS)
+            {
+                EXPECT_FALSE(op.CharacterFlags);
+                EXPECT_FALSE(op.InstanceFlags);
+            }
+        }
+    }
+}
+
+TEST(EventConditionProgram, NoConditions)
+{
+    auto program = EventConditionProgram::Compile(
+        std::list<std::shared_ptr<objects::EventCondition>>());
+
+    EXPECT_TRUE(program.Ops.empty());
+    EXPECT_TRUE(program.Evaluate([](const EventConditionOp&)
+        {
+            return false;
+        }));
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,222 @@
+/**
+ * @file server/channel/tests/FusionLevelTable.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Test the fusion level tables against walking the fusion ranges.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+#include <PopIgnore.h>
+
+// channel Includes
+#include <FusionLevelTable.h>
+#include <FusionTables.h>
+
+// Standard C++11 Includes
+#include <algorithm>
+#include <array>
+#include <random>
+
+using namespace channel;
+
+typedef std::vector<std::pair<uint8_t, uint32_t>> FusionRanges;
+
+namespace
+{
+
+/**
+ * Result demon of a fusion found the way FusionManager::GetResultDemon
+ * did before the level tables by walking the ranges for every fusion.
+ */
+uint32_t WalkRanges(const FusionRanges& fusionRanges,
+    int8_t adjustedLevelSum)
+{
+    if(fusionRanges.size() == 0)
+    {
+        return 0;
+    }
+
+    // Traverse the pre-sorted list and take the highest range accessible
+    uint32_t resultID = fusionRanges.front().second;
+    for(auto pair : fusionRanges)
+    {
+        resultID = pair.second;
+
+        if(pair.first >= adjustedLevelSum)
+        {
+            break;
+        }
+    }
+
+    return resultID;
+}
+
+/**
+ * Rank up/down result found the way FusionManager::RankUpDown did before
+ * the level tables.
+ */
+uint32_t WalkRankUpDown(const FusionRanges& fusionRanges,
+    uint32_t demonType, bool up)
+{
+    for(auto it = fusionRanges.begin(); it != fusionRanges.end(); it++)
+    {
+        if(it->second == demonType)
+        {
+            if(up)
+            {
+                it++;
+                if(it != fusionRanges.end())
+                {
+                    return it->second;
+                }
+            }
+            else if(it != fusionRanges.begin())
+            {
+                it--;
+                return it->second;
+            }
+
+            break;
+        }
+    }
+
+    return demonType;
+}
+
+/**
+ * Generate sorted fusion ranges for a race the way the definitions load
+ * them, including repeated levels and levels above any level sum.
+ */
+FusionRanges GenerateRanges(std::mt19937& rng, uint8_t race)
+{
+    std::uniform_int_distribution<int> countDist(1, 16);
+    std::uniform_int_distribution<int> levelDist(0, 255);
+
+    FusionRanges ranges;
+
+    int count = countDist(rng);
+    for(int i = 0; i < count; i++)
+    {
+        ranges.push_back(std::make_pair((uint8_t)levelDist(rng),
+            (uint32_t)(race * 1000 + i + 1)));
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+
+    return ranges;
+}
+
+} // namespace
+
+TEST(FusionLevelTable, MatchesRangeWalkForEveryRacePair)
+{
+    for(uint32_t seed = 0; seed < 50; seed++)
+    {
+        std::mt19937 rng(seed);
+
+        // Every race gets its own ranges for this seed
+        std::array<FusionRanges, 256> ranges;
+        std::array<FusionLevelTable, 256> tables;
+        for(size_t race = 1; race < 256; race++)
+        {
+            ranges[race] = GenerateRanges(rng, (uint8_t)race);
+            tables[race] = FusionLevelTable(ranges[race]);
+        }
+
+        for(size_t i = 0; i < 34; i++)
+        {
+            for(size_t j = 0; j < 34; j++)
+            {
+                uint8_t resultRace = FUSION_RACE_MAP[i + 1][j];
+                if(i == j || resultRace == 0)
+                {
+                    // Elemental or invalid result
+                    continue;
+                }
+
+                auto& table = tables[resultRace];
+                ASSERT_FALSE(table.IsEmpty());
+
+                for(int16_t level = -128; level < 128; level++)
+                {
+                    ASSERT_EQ(WalkRanges(ranges[resultRace], (int8_t)level),
+                        table.GetResult((int8_t)level))
+                        << "seed " << seed << ", races "
+                        << (int)FUSION_RACE_MAP[0][i] << " and "
+                        << (int)FUSION_RACE_MAP[0][j] << ", level "
+                        << level;
+                }
+            }
+        }
+    }
+}
+
+TEST(FusionLevelTable, RankUpDownMatchesRangeWalk)
+{
+    std::mt19937 rng(1);
+
+    for(size_t race = 1; race < 256; race++)
+    {
+        auto ranges = GenerateRanges(rng, (uint8_t)race);
+        FusionLevelTable table(ranges);
+
+        for(auto& pair : ranges)
+        {
+            EXPECT_EQ(WalkRankUpDown(ranges, pair.second, true),
+                table.RankUpDown(pair.second, true));
+            EXPECT_EQ(WalkRankUpDown(ranges, pair.second, false),
+                table.RankUpDown(pair.second, false));
+        }
+
+        // Types not in the ranges stay the same
+        EXPECT_EQ(1u, table.RankUpDown(1, true));
+        EXPECT_EQ(1u, table.RankUpDown(1, false));
+    }
+}
+
+TEST(FusionLevelTable, EmptyRanges)
+{
+    FusionLevelTable table;
+    EXPECT_TRUE(table.IsEmpty());
+    EXPECT_EQ(0u, table.GetResult(0));
+    EXPECT_EQ(0u, table.GetResult(-1));
+    EXPECT_EQ(5u, table.RankUpDown(5, true));
+
+    table = FusionLevelTable(FusionRanges());
+    EXPECT_TRUE(table.IsEmpty());
+    EXPECT_EQ(0u, table.GetResult(127));
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,484 @@
+/**
+ * @file server/channel/tests/StartupTaskGraph.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Test serial and parallel startup loads against each other.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+#include <PopIgnore.h>
+
+// channel Includes
+#include <FusionLevelTable.h>
+#include <StartupTaskGraph.h>
+
+// Standard C++11 Includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+using namespace channel;
+
+namespace
+{
+
+/// Number of zones loaded by the test startup
+const uint32_t ZONE_COUNT = 400;
+
+/// Number of distinct geometry files shared by the zones
+const uint32_t GEOMETRY_FILE_COUNT = 150;
+
+/**
+ * Everything the test startup builds, loaded the same way as the channel
+ * with the same task names and dependencies.
+ */
+struct StartupState
+{
+    /// Sorted fusion ranges of each race from the "definitions"
+    std::map<uint8_t, std::vector<std::pair<uint8_t, uint32_t>>> Ranges;
+
+    /// Zone IDs to dynamic map IDs from the "serverdata"
+    std::unordered_map<uint32_t, std::set<uint32_t>> Zones;
+
+    /// Fusion level tables of each race from "fusion"
+    std::unordered_map<uint8_t, FusionLevelTable> Fusion;
+
+    /// Tokusei ID counts from "tokusei"
+    std::unordered_map<int32_t, uint32_t> Tokusei;
+
+    /// Geometry file name to the vertices built from it
+    std::unordered_map<std::string, std::vector<float>> Geometry;
+
+    /// Dynamic map ID to rotated spot vertices
+    std::unordered_map<uint32_t, std::vector<float>> Spots;
+
+    /// Number of times each geometry file was built
+    std::unordered_map<std::string, uint32_t> GeometryBuilds;
+};
+
+/**
+ * Sleep for a random short time so task and thread order changes from
+ * run to run.
+ */
+void Jitter(std::mt19937& rng, std::mutex& rngLock)
+{
+    int micros;
+    {
+        std::lock_guard<std::mutex> lock(rngLock);
+        micros = std::uniform_int_distribution<int>(0, 200)(rng);
+    }
+
+    std::this_thread::sleep_for(std::chrono::microseconds(micros));
+}
+
+/**
+ * Build geometry for every zone the way ZoneGeometryLoader does, with
+ * several threads claiming each file under a lock so a file shared by
+ * more than one zone is only built once.
+ */
+void LoadGeometry(StartupState& state, std::mt19937& rng,
+    std::mutex& rngLock)
+{
+    std::mutex dataLock;
+    std::list<uint32_t> zoneIDs;
+    for(auto& zPair : state.Zones)
+    {
+        zoneIDs.push_back(zPair.first);
+    }
+
+    std::set<std::string> claimed;
+
+    auto worker = [&]()
+    {
+        while(true)
+        {
+            std::string filename;
+            {
+                std::lock_guard<std::mutex> lock(dataLock);
+                if(zoneIDs.empty())
+                {
+                    return;
+                }
+
+                uint32_t zoneID = zoneIDs.front();
+                zoneIDs.pop_front();
+
+                filename = std::to_string(zoneID % GEOMETRY_FILE_COUNT) +
+                    ".qmp";
+                if(!claimed.insert(filename).second)
+                {
+                    continue;
+                }
+            }
+
+            Jitter(rng, rngLock);
+
+            std::vector<float> vertices;
+            uint32_t seed = (uint32_t)std::hash<std::string>()(filename);
+            std::mt19937 fileRng(seed);
+            std::uniform_real_distribution<float> coordDist(-5000.f,
+                5000.f);
+            for(int i = 0; i < 64; i++)
+            {
+                vertices.push_back(coordDist(fileRng));
+            }
+
+            std::lock_guard<std::mutex> lock(dataLock);
+            state.Geometry[filename] = vertices;
+            state.GeometryBuilds[filename]++;
+        }
+    };
+
+    std::list<std::thread> threads;
+    for(int i = 0; i < 4; i++)
+    {
+        threads.push_back(std::thread(worker));
+    }
+
+    for(auto& t : threads)
+    {
+        t.join();
+    }
+}
+
+/**
+ * Load the test startup with the channel's task graph shape.
+ * @param parallel If the graph should run tasks at the same time
+ * @param seed Seed for the scheduling jitter
+ * @param state Output parameter for the loaded state
+ * @return true if the load succeeded
+ */
+bool Load(bool parallel, uint32_t seed, StartupState& state)
+{
+    std::mt19937 rng(seed);
+    std::mutex rngLock;
+
+    StartupTaskGraph loader(parallel);
+
+    bool tasksAdded = loader.AddTask("newcharacter", [&]()
+    {
+        Jitter(rng, rngLock);
+        return true;
+    });
+
+    tasksAdded = loader.AddTask("definitions", [&]()
+    {
+        Jitter(rng, rngLock);
+
+        std::mt19937 defRng(1);
+        std::uniform_int_distribution<int> levelDist(1, 99);
+        for(uint32_t race = 1; race < 64; race++)
+        {
+            auto& ranges = state.Ranges[(uint8_t)race];
+            for(uint32_t i = 0; i < 8; i++)
+            {
+                ranges.push_back(std::make_pair((uint8_t)levelDist(defRng),
+                    race * 100 + i));
+            }
+
+            std::sort(ranges.begin(), ranges.end());
+        }
+
+        return true;
+    }) && tasksAdded;
+
+    tasksAdded = loader.AddTask("serverdata", [&]()
+    {
+        Jitter(rng, rngLock);
+
+        // Server data reads the definitions
+        for(uint32_t zoneID = 1; zoneID <= ZONE_COUNT; zoneID++)
+        {
+            auto& dynamicMaps = state.Zones[zoneID];
+            dynamicMaps.insert(zoneID);
+            dynamicMaps.insert((uint32_t)(zoneID + state.Ranges.size()));
+        }
+
+        return true;
+    }, { "definitions" }) && tasksAdded;
+
+    tasksAdded = loader.AddTask("verify", [&]()
+    {
+        Jitter(rng, rngLock);
+
+        for(auto& zPair : state.Zones)
+        {
+            if(zPair.second.empty())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }, { "serverdata" }) && tasksAdded;
+
+    tasksAdded = loader.AddTask("fusion", [&]()
+    {
+        Jitter(rng, rngLock);
+
+        for(auto& rPair : state.Ranges)
+        {
+            state.Fusion[rPair.first] = FusionLevelTable(rPair.second);
+        }
+
+        return true;
+    }, { "serverdata" }) && tasksAdded;
+
+    tasksAdded = loader.AddTask("tokusei", [&]()
+    {
+        Jitter(rng, rngLock);
+
+        for(auto& zPair : state.Zones)
+        {
+            state.Tokusei[(int32_t)(zPair.first % 37)]++;
+        }
+
+        return true;
+    }, { "serverdata" }) && tasksAdded;
+
+    // Zone geometry and spots load together once the data is loaded
+    tasksAdded = loader.AddTask("geometry", [&]()
+    {
+        LoadGeometry(state, rng, rngLock);
+
+        return true;
+    }, { "verify", "fusion", "tokusei" }) && tasksAdded;
+
+    tasksAdded = loader.AddTask("spots", [&]()
+    {
+        Jitter(rng, rngLock);
+
+        for(auto& zPair : state.Zones)
+        {
+            for(uint32_t dynamicMapID : zPair.second)
+            {
+                float rot = (float)dynamicMapID * 0.1f;
+                auto& vertices = state.Spots[dynamicMapID];
+                for(float x : { -10.f, 10.f })
+                {
+                    for(float y : { -20.f, 20.f })
+                    {
+                        vertices.push_back(x * std::cos(rot) -
+                            y * std::sin(rot));
+                        vertices.push_back(x * std::sin(rot) +
+                            y * std::cos(rot));
+                    }
+                }
+            }
+        }
+
+        return true;
+    }, { "verify", "fusion", "tokusei" }) && tasksAdded;
+
+    return tasksAdded && loader.Run();
+}
+
+/**
+ * Digest the loaded state in a fixed order the same way the channel
+ * digests its startup state.
+ */
+uint64_t Digest(const StartupState& state)
+{
+    StartupDigest digest;
+
+    std::map<uint32_t, std::set<uint32_t>> zones(state.Zones.begin(),
+        state.Zones.end());
+    for(auto& zPair : zones)
+    {
+        digest.Add(zPair.first);
+        for(uint32_t dynamicMapID : zPair.second)
+        {
+            digest.Add(dynamicMapID);
+        }
+    }
+
+    for(auto& rPair : state.Ranges)
+    {
+        auto it = state.Fusion.find(rPair.first);
+        digest.Add(it != state.Fusion.end());
+        if(it != state.Fusion.end())
+        {
+            for(int16_t level = -128; level < 128; level++)
+            {
+                digest.Add(it->second.GetResult((int8_t)level));
+            }
+        }
+    }
+
+    std::map<int32_t, uint32_t> tokusei(state.Tokusei.begin(),
+        state.Tokusei.end());
+    for(auto& tPair : tokusei)
+    {
+        digest.Add(tPair.first);
+        digest.Add(tPair.second);
+    }
+
+    std::map<std::string, std::vector<float>> geometry(
+        state.Geometry.begin(), state.Geometry.end());
+    for(auto& gPair : geometry)
+    {
+        digest.Add(libcomp::String(gPair.first));
+        for(float v : gPair.second)
+        {
+            digest.Add(v);
+        }
+    }
+
+    std::map<uint32_t, std::vector<float>> spots(state.Spots.begin(),
+        state.Spots.end());
+    for(auto& sPair : spots)
+    {
+        digest.Add(sPair.first);
+        for(float v : sPair.second)
+        {
+            digest.Add(v);
+        }
+    }
+
+    return digest.Get();
+}
+
+} // namespace
+
+TEST(StartupTaskGraph, SerialAndParallelDigestsMatch)
+{
+    StartupState serial;
+    ASSERT_TRUE(Load(false, 0, serial));
+
+    uint64_t expected = Digest(serial);
+    EXPECT_EQ(GEOMETRY_FILE_COUNT, (uint32_t)serial.Geometry.size());
+
+    for(uint32_t seed = 1; seed <= 25; seed++)
+    {
+        StartupState parallel;
+        ASSERT_TRUE(Load(true, seed, parallel));
+
+        EXPECT_EQ(expected, Digest(parallel)) << "seed " << seed;
+
+        // Shared geometry files are only built once
+        for(auto& bPair : parallel.GeometryBuilds)
+        {
+            EXPECT_EQ(1u, bPair.second) << bPair.first;
+        }
+    }
+}
+
+TEST(StartupTaskGraph, DependenciesFinishFirst)
+{
+    for(bool parallel : { false, true })
+    {
+        std::mutex lock;
+        std::list<std::string> finished;
+
+        auto task = [&](const std::string& name,
+            std::set<std::string> dependencies)
+        {
+            return [&finished, &lock, name, dependencies]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+                std::lock_guard<std::mutex> guard(lock);
+                for(auto& dependency : dependencies)
+                {
+                    if(std::find(finished.begin(), finished.end(),
+                        dependency) == finished.end())
+                    {
+                        return false;
+                    }
+                }
+
+                finished.push_back(name);
+
+                return true;
+            };
+        };
+
+        StartupTaskGraph loader(parallel);
+        EXPECT_TRUE(loader.AddTask("a", task("a", {})));
+        EXPECT_TRUE(loader.AddTask("b", task("b", { "a" }), { "a" }));
+        EXPECT_TRUE(loader.AddTask("c", task("c", {})));
+        EXPECT_TRUE(loader.AddTask("d", task("d", { "b", "c" }),
+            { "b", "c" }));
+
+        EXPECT_TRUE(loader.Run());
+        EXPECT_EQ(4u, finished.size());
+        EXPECT_EQ(4u, loader.GetTimings().size());
+    }
+}
+
+TEST(StartupTaskGraph, FailureStopsDependents)
+{
+    for(bool parallel : { false, true })
+    {
+        std::atomic<int> dependentRuns(0);
+
+        StartupTaskGraph loader(parallel);
+        EXPECT_TRUE(loader.AddTask("fails", []()
+        {
+            return false;
+        }));
+
+        EXPECT_TRUE(loader.AddTask("dependent", [&]()
+        {
+            dependentRuns++;
+            return true;
+        }, { "fails" }));
+
+        EXPECT_FALSE(loader.Run());
+        EXPECT_EQ(0, dependentRuns.load());
+    }
+}
+
+TEST(StartupTaskGraph, InvalidTasksAreRejected)
+{
+    StartupTaskGraph loader;
+    EXPECT_TRUE(loader.AddTask("a", []() { return true; }));
+
+    // Duplicate name
+    EXPECT_FALSE(loader.AddTask("a", []() { return true; }));
+
+    // Unknown or later dependency
+    EXPECT_FALSE(loader.AddTask("b", []() { return true; }, { "c" }));
+    EXPECT_TRUE(loader.Run());
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
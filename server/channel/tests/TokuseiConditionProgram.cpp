@@ -0,0 +1,253 @@
+/**
+ * @file server/channel/tests/TokuseiConditionProgram.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Test compiled tokusei condition lists against the interpreter.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+#include <PopIgnore.h>
+
+// object Includes
+#include <Tokusei.h>
+#include <TokuseiCondition.h>
+
+// channel Includes
+#include <TokuseiConditionProgram.h>
+
+// Standard C++11 Includes
+#include <random>
+#include <unordered_map>
+
+using namespace channel;
+
+typedef objects::TokuseiCondition::Comparator_t Comparator_t;
+
+static const TokuseiConditionType TYPES[] = {
+    TokuseiConditionType::CURRENT_HP,
+    TokuseiConditionType::DIGITALIZED,
+    TokuseiConditionType::EXPERTISE,
+    TokuseiConditionType::GENDER,
+    TokuseiConditionType::LNC,
+    TokuseiConditionType::PARTNER_FAMILIARITY,
+    TokuseiConditionType::STATUS_ACTIVE,
+};
+
+static const Comparator_t COMPARATORS[] = {
+    Comparator_t::EQUALS,
+    Comparator_t::NOT_EQUAL,
+    Comparator_t::GTE,
+    Comparator_t::LTE,
+};
+
+/**
+ * Condition list interpreter the compiled programs replaced, kept here as
+ * the reference implementation.
+ */
+template<typename F>
+static bool Interpret(const std::shared_ptr<objects::Tokusei>& tokusei,
+    const F& leaf)
+{
+    std::unordered_map<uint8_t, bool> optionGroups;
+    for(auto condition : tokusei->GetConditions())
+    {
+        bool result = false;
+
+        // If the option group has already had a condition pass, skip it
+        uint8_t optionGroupID = condition->GetOptionGroupID();
+        if(optionGroupID != 0)
+        {
+            if(optionGroups.find(optionGroupID) == optionGroups.end())
+            {
+                optionGroups[optionGroupID] = false;
+            }
+            else
+            {
+                result = optionGroups[optionGroupID];
+            }
+        }
+
+        if(!result)
+        {
+            result = leaf(condition);
+            if(optionGroupID != 0)
+            {
+                optionGroups[optionGroupID] |= result;
+            }
+            else if(!result)
+            {
+                return false;
+            }
+        }
+    }
+
+    for(auto pair : optionGroups)
+    {
+        if(!pair.second)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static std::shared_ptr<objects::Tokusei> RandomTokusei(std::mt19937& rng)
+{
+    auto tokusei = std::make_shared<objects::Tokusei>();
+
+    size_t count = (size_t)(rng() % 9);
+    for(size_t i = 0; i < count; i++)
+    {
+        auto condition = std::make_shared<objects::TokuseiCondition>();
+        condition->SetType(TYPES[rng() % (sizeof(TYPES) / sizeof(TYPES[0]))]);
+        condition->SetComparator(COMPARATORS[rng() %
+            (sizeof(COMPARATORS) / sizeof(COMPARATORS[0]))]);
+        condition->SetValue((int32_t)(rng() % 10000));
+
+        // Half required, the rest split between a few option groups
+        condition->SetOptionGroupID((uint8_t)(rng() % 2 ? 0
+            : (1 + rng() % 3)));
+
+        tokusei->AppendConditions(condition);
+    }
+
+    return tokusei;
+}
+
+TEST(TokuseiConditionProgram, MatchesInterpreter)
+{
+    std::mt19937 rng(0x70C05E1);
+
+    for(int trial = 0; trial < 20000; trial++)
+    {
+        auto tokusei = RandomTokusei(rng);
+        auto conditions = tokusei->GetConditions();
+
+        // Fix the outcome of each condition for this trial
+        std::vector<bool> outcomes;
+        std::unordered_map<const objects::TokuseiCondition*, size_t> indexes;
+        for(auto& condition : conditions)
+        {
+            indexes[condition.get()] = outcomes.size();
+            outcomes.push_back(rng() % 3 != 0);
+        }
+
+        std::vector<size_t> interpreted;
+        bool expected = Interpret(tokusei, [&](const std::shared_ptr<
+            objects::TokuseiCondition>& condition)
+            {
+                size_t idx = indexes[condition.get()];
+                interpreted.push_back(idx);
+                return (bool)outcomes[idx];
+            });
+
+        auto program = TokuseiConditionProgram::Compile(tokusei);
+        ASSERT_EQ(program.Ops.size(), conditions.size());
+
+        std::vector<size_t> compiled;
+        bool result = program.Evaluate([&](const TokuseiConditionOp& op)
+            {
+                size_t idx = (size_t)(&op - &program.Ops[0]);
+                compiled.push_back(idx);
+                return (bool)outcomes[idx];
+            });
+
+        // Same result and the same conditions checked in the same order
+        ASSERT_EQ(result, expected) << "Trial " << trial;
+        ASSERT_EQ(compiled, interpreted) << "Trial " << trial;
+    }
+}
+
+TEST(TokuseiConditionProgram, Operands)
+{
+    std::mt19937 rng(0x0BE4A5D);
+
+    for(int trial = 0; trial < 2000; trial++)
+    {
+        auto tokusei = RandomTokusei(rng);
+        auto program = TokuseiConditionProgram::Compile(tokusei);
+
+        size_t idx = 0;
+        std::bitset<256> groups;
+        for(auto condition : tokusei->GetConditions())
+        {
+            auto& op = program.Ops[idx++];
+
+            EXPECT_EQ(op.Type, condition->GetType());
+            EXPECT_EQ(op.Comparator, condition->GetComparator());
+            EXPECT_EQ(op.OptionGroupID, condition->GetOptionGroupID());
+            EXPECT_EQ(op.Equals,
+                condition->GetComparator() == Comparator_t::EQUALS);
+            EXPECT_EQ(op.NumericCompare,
+                condition->GetComparator() != Comparator_t::EQUALS &&
+                condition->GetComparator() != Comparator_t::NOT_EQUAL);
+
+            if(condition->GetType() == TokuseiConditionType::EXPERTISE)
+            {
+                // The 2 smallest digits are the expertise ID, the rest are
+                // the rank value
+                EXPECT_EQ(op.ExpertiseID,
+                    (uint32_t)(condition->GetValue() % 100));
+                EXPECT_EQ(op.Value, condition->GetValue() / 100);
+            }
+            else
+            {
+                EXPECT_EQ(op.Value, condition->GetValue());
+            }
+
+            if(condition->GetOptionGroupID())
+            {
+                groups.set(condition->GetOptionGroupID());
+            }
+        }
+
+        EXPECT_EQ(program.OptionGroups, groups);
+    }
+}
+
+TEST(TokuseiConditionProgram, NoConditions)
+{
+    auto tokusei = std::make_shared<objects::Tokusei>();
+    auto program = TokuseiConditionProgram::Compile(tokusei);
+
+    EXPECT_TRUE(program.Ops.empty());
+    EXPECT_TRUE(program.Evaluate([](const TokuseiConditionOp&)
+        {
+            return false;
+        }));
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,474 @@
+/**
+ * @file server/channel/tests/TokuseiEffectMap.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Test incremental tokusei routing against a full recalculation.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+#include <PopIgnore.h>
+
+// channel Includes
+#include <TokuseiEffectMap.h>
+
+// Standard C++11 Includes
+#include <random>
+
+using namespace channel;
+
+typedef TokuseiEffectMap::Target_t Target_t;
+
+namespace
+{
+
+/// Tokusei directly on a test entity
+struct DirectTokusei
+{
+    int32_t ID;
+    Target_t Target;
+    bool SkillTokusei;
+};
+
+/// Test entity with its direct tokusei and their current results
+struct TestEntity
+{
+    TokuseiSource Source;
+    std::vector<DirectTokusei> Tokusei;
+    std::unordered_map<int32_t, bool> Results;
+};
+
+typedef std::unordered_map<int32_t, TokuseiCounts> GroupCounts;
+
+/**
+ * Full recalculation as it was done before routing moved into
+ * TokuseiEffectMap: direct, party and partner/summoner effects gathered
+ * separately then merged.
+ */
+GroupCounts FullRecalculate(const std::vector<TestEntity>& entities)
+{
+    GroupCounts newMaps, partyEffects, otherEffects;
+
+    for(auto& entity : entities)
+    {
+        auto& source = entity.Source;
+        newMaps[source.EntityID][false];
+        newMaps[source.EntityID][true];
+
+        for(auto& tokusei : entity.Tokusei)
+        {
+            if(!entity.Results.at(tokusei.ID))
+            {
+                continue;
+            }
+
+            std::unordered_map<int32_t, uint16_t>* map = 0;
+            switch(tokusei.Target)
+            {
+            case Target_t::PARTY:
+                map = &partyEffects[source.EntityID][tokusei.SkillTokusei];
+                break;
+            case Target_t::SUMMONER:
+                if(source.IsPartnerDemon)
+                {
+                    map = &otherEffects[source.EntityID][tokusei.SkillTokusei];
+                }
+                else if(source.IsCharacter)
+                {
+                    map = &newMaps[source.EntityID][tokusei.SkillTokusei];
+                }
+                break;
+            case Target_t::PARTNER:
+                if(source.IsCharacter)
+                {
+                    map = &otherEffects[source.EntityID][tokusei.SkillTokusei];
+                }
+                else if(source.IsPartnerDemon)
+                {
+                    map = &newMaps[source.EntityID][tokusei.SkillTokusei];
+                }
+                break;
+            case Target_t::SELF:
+            default:
+                map = &newMaps[source.EntityID][tokusei.SkillTokusei];
+                break;
+            }
+
+            if(map)
+            {
+                (*map)[tokusei.ID]++;
+            }
+        }
+    }
+
+    GroupCounts result;
+    for(auto& entity : entities)
+    {
+        result[entity.Source.EntityID] = newMaps[entity.Source.EntityID];
+    }
+
+    for(auto& entity : entities)
+    {
+        auto& source = entity.Source;
+        if(!source.HasClient) continue;
+
+        auto other = result.find(source.OtherEntityID);
+        if(source.OtherEntityID && other != result.end())
+        {
+            for(auto& pair : otherEffects[source.EntityID])
+            {
+                for(auto& bPair : pair.second)
+                {
+                    other->second[pair.first][bPair.first] = (uint16_t)(
+                        other->second[pair.first][bPair.first] +
+                        bPair.second);
+                }
+            }
+        }
+
+        if(source.InParty)
+        {
+            for(auto& e : entities)
+            {
+                if((e.Source.IsCharacter || e.Source.IsPartnerDemon) &&
+                    e.Source.Zone == source.Zone)
+                {
+                    auto& map = result[e.Source.EntityID];
+                    for(auto& pair : partyEffects[source.EntityID])
+                    {
+                        for(auto& bPair : pair.second)
+                        {
+                            map[pair.first][bPair.first] = (uint16_t)(
+                                map[pair.first][bPair.first] + bPair.second);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Full recalculation through TokuseiEffectMap like
+ * TokuseiManager::Recalculate for a group of entities.
+ */
+GroupCounts MapRecalculate(const std::vector<TestEntity>& entities)
+{
+    std::vector<TokuseiSource> sources;
+    for(auto& entity : entities)
+    {
+        sources.push_back(entity.Source);
+    }
+
+    TokuseiEffectMap effectMap(sources);
+    for(auto& entity : entities)
+    {
+        for(auto& tokusei : entity.Tokusei)
+        {
+            if(entity.Results.at(tokusei.ID))
+            {
+                effectMap.Apply(entity.Source, tokusei.Target,
+                    tokusei.SkillTokusei, tokusei.ID, 1);
+            }
+        }
+    }
+
+    GroupCounts result;
+    for(auto& entity : entities)
+    {
+        result[entity.Source.EntityID] = effectMap.GetCounts(
+            entity.Source.EntityID);
+    }
+
+    return result;
+}
+
+/// Compare the counts on each entity ignoring empty entries
+void ExpectEqual(const GroupCounts& expected, const GroupCounts& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for(auto& pair : expected)
+    {
+        auto it = actual.find(pair.first);
+        ASSERT_NE(it, actual.end());
+
+        for(bool skillMode : { false, true })
+        {
+            std::unordered_map<int32_t, uint16_t> e, a;
+            auto eIter = pair.second.find(skillMode);
+            if(eIter != pair.second.end())
+            {
+                for(auto& c : eIter->second)
+                {
+                    if(c.second) e[c.first] = c.second;
+                }
+            }
+
+            auto aIter = it->second.find(skillMode);
+            if(aIter != it->second.end())
+            {
+                for(auto& c : aIter->second)
+                {
+                    EXPECT_NE(0, c.second);
+                    a[c.first] = c.second;
+                }
+            }
+
+            EXPECT_EQ(e, a) << "entity " << pair.first << " skill "
+                << skillMode;
+        }
+    }
+}
+
+/// Build a random party of clients with characters and partner demons
+/// split across two zones plus a few entities without a client
+std::vector<TestEntity> RandomGroup(std::mt19937& rng)
+{
+    static int zoneA = 0, zoneB = 0;
+    const void* zones[] = { &zoneA, &zoneB };
+
+    std::uniform_int_distribution<int> clientCount(1, 4);
+    std::uniform_int_distribution<int> tokuseiCount(0, 6);
+    std::uniform_int_distribution<int32_t> tokuseiID(1, 12);
+    std::bernoulli_distribution coin(0.5);
+
+    std::vector<TestEntity> entities;
+
+    int32_t nextID = 1;
+    bool party = coin(rng);
+    int clients = clientCount(rng);
+    for(int i = 0; i < clients + 2; i++)
+    {
+        bool hasClient = i < clients;
+        bool demon = hasClient && coin(rng);
+        const void* zone = zones[coin(rng) ? 1 : 0];
+
+        TestEntity character;
+        character.Source.EntityID = nextID++;
+        character.Source.IsCharacter = hasClient;
+        character.Source.HasClient = hasClient;
+        character.Source.InParty = hasClient && party;
+        character.Source.Zone = zone;
+        entities.push_back(character);
+
+        if(demon)
+        {
+            // Pair the character with a partner demon in the same zone
+            TestEntity partner;
+            partner.Source.EntityID = nextID++;
+            partner.Source.IsPartnerDemon = true;
+            partner.Source.HasClient = true;
+            partner.Source.InParty = party;
+            partner.Source.OtherEntityID = entities.back().Source.EntityID;
+            partner.Source.Zone = zone;
+
+            entities.back().Source.OtherEntityID = partner.Source.EntityID;
+            entities.push_back(partner);
+        }
+        else if(hasClient && coin(rng))
+        {
+            // Demon that is not summoned so it is outside of the group
+            entities.back().Source.OtherEntityID = 1000 + i;
+        }
+    }
+
+    for(auto& entity : entities)
+    {
+        int count = tokuseiCount(rng);
+        for(int i = 0; i < count; i++)
+        {
+            DirectTokusei tokusei;
+            tokusei.ID = tokuseiID(rng);
+
+            // The definition decides the target and skill conditions so
+            // duplicates must match
+            tokusei.Target = (Target_t)(tokusei.ID % 4);
+            tokusei.SkillTokusei = tokusei.ID % 3 == 0;
+            entity.Tokusei.push_back(tokusei);
+
+            entity.Results[tokusei.ID] = coin(rng);
+        }
+    }
+
+    return entities;
+}
+
+} // namespace
+
+TEST(TokuseiEffectMap, MatchesPreviousFullRecalculation)
+{
+    std::mt19937 rng(34);
+
+    for(int trial = 0; trial < 5000; trial++)
+    {
+        auto entities = RandomGroup(rng);
+
+        ExpectEqual(FullRecalculate(entities), MapRecalculate(entities));
+        if(::testing::Test::HasFailure())
+        {
+            FAIL() << "trial " << trial;
+        }
+    }
+}
+
+TEST(TokuseiEffectMap, IncrementalMatchesFullRecalculation)
+{
+    std::mt19937 rng(3434);
+
+    for(int trial = 0; trial < 5000; trial++)
+    {
+        auto entities = RandomGroup(rng);
+
+        std::vector<TokuseiSource> sources;
+        for(auto& entity : entities)
+        {
+            sources.push_back(entity.Source);
+        }
+
+        // Counts from the last full recalculation are the starting point
+        auto current = MapRecalculate(entities);
+
+        for(int step = 0; step < 8; step++)
+        {
+            TokuseiEffectMap effectMap(sources);
+            for(auto& pair : current)
+            {
+                effectMap.SetCounts(pair.first, pair.second);
+            }
+
+            // Flip a few conditional results like a state change would
+            std::uniform_int_distribution<size_t> entityIdx(0,
+                entities.size() - 1);
+            std::uniform_int_distribution<int> flips(1, 3);
+            int flipCount = flips(rng);
+            for(int f = 0; f < flipCount; f++)
+            {
+                auto& entity = entities[entityIdx(rng)];
+                if(entity.Results.empty())
+                {
+                    continue;
+                }
+
+                std::uniform_int_distribution<size_t> rIdx(0,
+                    entity.Results.size() - 1);
+                auto it = entity.Results.begin();
+                std::advance(it, rIdx(rng));
+                it->second = !it->second;
+
+                int32_t count = 0;
+                const DirectTokusei* tokusei = nullptr;
+                for(auto& t : entity.Tokusei)
+                {
+                    if(t.ID == it->first)
+                    {
+                        tokusei = &t;
+                        count++;
+                    }
+                }
+
+                effectMap.Apply(entity.Source, tokusei->Target,
+                    tokusei->SkillTokusei, tokusei->ID,
+                    it->second ? count : -count);
+            }
+
+            GroupCounts incremental;
+            for(auto& entity : entities)
+            {
+                incremental[entity.Source.EntityID] = effectMap.GetCounts(
+                    entity.Source.EntityID);
+            }
+
+            ExpectEqual(FullRecalculate(entities), incremental);
+            if(::testing::Test::HasFailure())
+            {
+                FAIL() << "trial " << trial << " step " << step;
+            }
+
+            current = incremental;
+        }
+    }
+}
+
+TEST(TokuseiEffectMap, ReportsChangedEntities)
+{
+    int zone = 0, otherZone = 0;
+
+    TokuseiSource character;
+    character.EntityID = 1;
+    character.IsCharacter = true;
+    character.HasClient = true;
+    character.InParty = true;
+    character.OtherEntityID = 2;
+    character.Zone = &zone;
+
+    TokuseiSource partner;
+    partner.EntityID = 2;
+    partner.IsPartnerDemon = true;
+    partner.HasClient = true;
+    partner.InParty = true;
+    partner.OtherEntityID = 1;
+    partner.Zone = &zone;
+
+    TokuseiSource member = character;
+    member.EntityID = 3;
+    member.OtherEntityID = 0;
+    member.Zone = &otherZone;
+
+    TokuseiEffectMap effectMap({ character, partner, member });
+
+    // Party effects skip members in other zones
+    auto changed = effectMap.Apply(character, Target_t::PARTY, false, 5, 2);
+    EXPECT_EQ((std::vector<int32_t>{ 1, 2 }), changed);
+    EXPECT_EQ(2, effectMap.GetCounts(1)[false][5]);
+    EXPECT_EQ(2, effectMap.GetCounts(2)[false][5]);
+    EXPECT_TRUE(effectMap.GetCounts(3)[false].empty());
+
+    // Partner effects move to the demon
+    changed = effectMap.Apply(character, Target_t::PARTNER, true, 6, 1);
+    EXPECT_EQ((std::vector<int32_t>{ 2 }), changed);
+    EXPECT_EQ(1, effectMap.GetCounts(2)[true][6]);
+
+    // Removing the last count erases the entry
+    changed = effectMap.Apply(character, Target_t::PARTNER, true, 6, -1);
+    EXPECT_EQ((std::vector<int32_t>{ 2 }), changed);
+    EXPECT_TRUE(effectMap.GetCounts(2)[true].empty());
+
+    // Removing what is not there changes nothing
+    changed = effectMap.Apply(character, Target_t::SELF, false, 7, -1);
+    EXPECT_TRUE(changed.empty());
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,276 @@
+/**
+ * @file server/channel/tests/WorldClock.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Test world clock event scheduling against a simulated clock.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+#include <PopIgnore.h>
+
+// channel Includes
+#include <WorldClock.h>
+
+// Standard C++11 Includes
+#include <random>
+#include <vector>
+
+using namespace channel;
+
+namespace
+{
+
+/// Seconds simulated by each run, a full cycle of game times and phases
+const uint32_t SIMULATED_SECONDS = 345600;
+
+/**
+ * Build the clock for a system time the same way ChannelServer::GetWorldClock
+ * does with no server time offset.
+ */
+WorldClock MakeClock(uint32_t systemTime, uint32_t gameOffset)
+{
+    WorldClock clock;
+    clock.SystemTime = systemTime;
+    clock.SystemHour = (int8_t)((systemTime / 3600) % 24);
+    clock.SystemMin = (int8_t)((systemTime / 60) % 60);
+    clock.SystemSec = (int8_t)(systemTime % 60);
+    clock.GameOffset = gameOffset;
+    clock.CycleOffset = (systemTime + gameOffset) % 345600;
+    clock.MoonPhase = (int8_t)((clock.CycleOffset / 1440) % 16);
+    clock.Hour = (int8_t)((clock.CycleOffset / 120) % 24);
+    clock.Min = (int8_t)((clock.CycleOffset / 2) % 60);
+
+    return clock;
+}
+
+/**
+ * Check if every part of a time that is set matches the clock.
+ */
+bool Matches(const WorldClock& clock, const WorldClockTime& time)
+{
+    return (time.MoonPhase == -1 || time.MoonPhase == clock.MoonPhase) &&
+        (time.Hour == -1 || (time.Hour == clock.Hour &&
+            time.Min == clock.Min)) &&
+        (time.SystemHour == -1 || (time.SystemHour == clock.SystemHour &&
+            time.SystemMin == clock.SystemMin));
+}
+
+/**
+ * Step a simulated clock one second at a time, waking up the way the
+ * channel's event calendar does, and check that every second a time is
+ * reached is a second the calendar woke up for it.
+ * @return Number of times the time was reached
+ */
+uint32_t Simulate(const WorldClockTime& time, uint32_t start,
+    uint32_t gameOffset)
+{
+    auto clock = MakeClock(start, gameOffset);
+    bool matched = Matches(clock, time);
+
+    uint32_t wake = start + clock.GetSecondsUntil(time);
+    uint32_t reached = 0;
+
+    for(uint32_t t = start + 1; t <= start + SIMULATED_SECONDS; t++)
+    {
+        clock = MakeClock(t, gameOffset);
+
+        bool nowMatched = Matches(clock, time);
+        if(nowMatched && !matched)
+        {
+            EXPECT_EQ(wake, t) << "time " << (int)time.MoonPhase << " "
+                << (int)time.Hour << ":" << (int)time.Min << " ["
+                << (int)time.SystemHour << ":" << (int)time.SystemMin
+                << "] reached at " << t << " from " << start;
+            if(wake != t)
+            {
+                return reached;
+            }
+
+            reached++;
+        }
+
+        matched = nowMatched;
+
+        if(t == wake)
+        {
+            uint32_t delta = clock.GetSecondsUntil(time);
+            EXPECT_GE(delta, 1u);
+
+            wake = t + delta;
+        }
+    }
+
+    return reached;
+}
+
+WorldClockTime GameTime(int8_t hour, int8_t min)
+{
+    WorldClockTime time;
+    time.Hour = hour;
+    time.Min = min;
+
+    return time;
+}
+
+} // namespace
+
+TEST(WorldClock, GameTimeWrapsOnGameDay)
+{
+    // Game 23:00 to game 01:00 is two game hours, not a wrap over the
+    // 1440 second moon phase
+    auto clock = MakeClock(2760, 0);
+    ASSERT_EQ(23, clock.Hour);
+    ASSERT_EQ(0, clock.Min);
+
+    EXPECT_EQ(240u, clock.GetSecondsUntil(GameTime(1, 0)));
+
+    // Earlier the same game day wraps on the 2880 second game day
+    EXPECT_EQ(2880u - 2760u + 1200u, clock.GetSecondsUntil(GameTime(10, 0)));
+
+    // The current game time is next reached a full game day later
+    EXPECT_EQ(2880u, clock.GetSecondsUntil(GameTime(23, 0)));
+
+    // Part way through a game minute
+    clock = MakeClock(2761, 0);
+    EXPECT_EQ(2879u, clock.GetSecondsUntil(GameTime(23, 0)));
+    EXPECT_EQ(1u, clock.GetSecondsUntil(GameTime(23, 1)));
+
+    // Game 00:00 from the last game minute of the day
+    clock = MakeClock(2878, 0);
+    EXPECT_EQ(2u, clock.GetSecondsUntil(GameTime(0, 0)));
+}
+
+TEST(WorldClock, PhaseAndSystemTimes)
+{
+    auto clock = MakeClock(1440 * 3 + 100, 0);
+    ASSERT_EQ(3, clock.MoonPhase);
+
+    WorldClockTime phase;
+    phase.MoonPhase = 4;
+    EXPECT_EQ(1340u, clock.GetSecondsUntil(phase));
+
+    // The current phase is next reached a full cycle later
+    phase.MoonPhase = 3;
+    EXPECT_EQ(16u * 1440u - 100u, clock.GetSecondsUntil(phase));
+
+    // Earlier phases wrap on the full cycle
+    phase.MoonPhase = 0;
+    EXPECT_EQ(13u * 1440u - 100u, clock.GetSecondsUntil(phase));
+
+    WorldClockTime system;
+    system.SystemHour = 0;
+    system.SystemMin = 0;
+
+    clock = MakeClock(86399, 0);
+    EXPECT_EQ(1u, clock.GetSecondsUntil(system));
+
+    clock = MakeClock(86400, 0);
+    EXPECT_EQ(86400u, clock.GetSecondsUntil(system));
+}
+
+TEST(WorldClock, SimulatedClockReachesEveryTime)
+{
+    std::vector<WorldClockTime> times;
+
+    // Midnight, phase 0 and game 00:00 plus the last of each
+    times.push_back(WorldClockTime());
+    times.back().SystemHour = 0;
+    times.back().SystemMin = 0;
+    times.push_back(WorldClockTime());
+    times.back().SystemHour = 23;
+    times.back().SystemMin = 59;
+    times.push_back(WorldClockTime());
+    times.back().MoonPhase = 0;
+    times.push_back(WorldClockTime());
+    times.back().MoonPhase = 15;
+    times.push_back(GameTime(0, 0));
+    times.push_back(GameTime(23, 59));
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> kindDist(0, 4);
+    std::uniform_int_distribution<int> phaseDist(0, 15);
+    std::uniform_int_distribution<int> hourDist(0, 23);
+    std::uniform_int_distribution<int> minDist(0, 59);
+
+    for(int i = 0; i < 60; i++)
+    {
+        WorldClockTime time;
+        switch(kindDist(rng))
+        {
+        case 0:
+            time.SystemHour = (int8_t)hourDist(rng);
+            time.SystemMin = (int8_t)minDist(rng);
+            break;
+        case 1:
+            time.Hour = (int8_t)hourDist(rng);
+            time.Min = (int8_t)minDist(rng);
+            break;
+        case 2:
+            time.MoonPhase = (int8_t)phaseDist(rng);
+            break;
+        case 3:
+            time.MoonPhase = (int8_t)phaseDist(rng);
+            time.Hour = (int8_t)hourDist(rng);
+            time.Min = (int8_t)minDist(rng);
+            break;
+        default:
+            time.MoonPhase = (int8_t)phaseDist(rng);
+            time.SystemHour = (int8_t)hourDist(rng);
+            time.SystemMin = (int8_t)minDist(rng);
+            break;
+        }
+
+        times.push_back(time);
+    }
+
+    std::uniform_int_distribution<uint32_t> startDist(0, 345599);
+    for(auto& time : times)
+    {
+        uint32_t reached = Simulate(time, startDist(rng), startDist(rng));
+
+        // Over four days every system and game time and every phase is
+        // reached, combined times can fall outside of their phase
+        if(time.MoonPhase == -1)
+        {
+            EXPECT_GE(reached, 4u);
+        }
+        else if(time.Hour == -1 && time.SystemHour == -1)
+        {
+            EXPECT_GE(reached, 1u);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,868 @@
+/**
+ * @file server/channel/tests/ZoneStatusEffectTable.cpp
+ * @ingroup channel
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Test the zone status effect schedule against replays.
+ *
+ * This file is part of the Channel Server (channel).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+#include <PopIgnore.h>
+
+// channel Includes
+#include <ZoneStatusEffectTable.h>
+
+// Standard C++11 Includes
+#include <list>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <unordered_map>
+
+using namespace channel;
+
+namespace
+{
+
+/**
+ * Map of event times to the entities registered at each one with the same
+ * replace semantics as the table. Setting a time replaces the time
+ * previously registered by the entity and setting 0 removes it.
+ */
+class ReferenceSchedule
+{
+public:
+    void Set(int32_t entityID, uint32_t time)
+    {
+        Remove(entityID);
+
+        if(time)
+        {
+            mTimes[time].insert(entityID);
+            mEntityTimes[entityID] = time;
+        }
+    }
+
+    void Remove(int32_t entityID)
+    {
+        auto it = mEntityTimes.find(entityID);
+        if(it != mEntityTimes.end())
+        {
+            auto tIter = mTimes.find(it->second);
+            tIter->second.erase(entityID);
+            if(tIter->second.empty())
+            {
+                mTimes.erase(tIter);
+            }
+
+            mEntityTimes.erase(it);
+        }
+    }
+
+    std::vector<int32_t> PopDue(uint32_t now)
+    {
+        std::vector<int32_t> entityIDs;
+        while(!mTimes.empty() && mTimes.begin()->first <= now)
+        {
+            for(int32_t entityID : mTimes.begin()->second)
+            {
+                entityIDs.push_back(entityID);
+                mEntityTimes.erase(entityID);
+            }
+
+            mTimes.erase(mTimes.begin());
+        }
+
+        return entityIDs;
+    }
+
+    size_t Size() const
+    {
+        return mEntityTimes.size();
+    }
+
+private:
+    std::map<uint32_t, std::set<int32_t>> mTimes;
+    std::unordered_map<int32_t, uint32_t> mEntityTimes;
+};
+
+/**
+ * Interface entities register their next status effect event time with,
+ * standing in for the zone they are in.
+ */
+class ScheduleZone
+{
+public:
+    virtual ~ScheduleZone() { }
+
+    virtual void SetNextStatusEffectTime(uint32_t time, int32_t entityID) = 0;
+    virtual std::vector<int32_t> GetUpdatedStatusEffectEntities(
+        uint32_t now) = 0;
+};
+
+/**
+ * Zone schedule as it was before the table. Registering a time adds the
+ * entity under it without removing the time it registered before, so an
+ * entity can come back more than once per tick. Clearing a time erased the
+ * entity from copies of the sets so it never removed anything.
+ */
+class BaselineZone : public ScheduleZone
+{
+public:
+    virtual void SetNextStatusEffectTime(uint32_t time, int32_t entityID)
+    {
+        if(time)
+        {
+            mNextEntityStatusTimes[time].insert(entityID);
+        }
+        else
+        {
+            for(auto pair : mNextEntityStatusTimes)
+            {
+                pair.second.erase(entityID);
+            }
+        }
+    }
+
+    virtual std::vector<int32_t> GetUpdatedStatusEffectEntities(uint32_t now)
+    {
+        std::vector<int32_t> result;
+        std::set<uint32_t> passed;
+
+        for(auto pair : mNextEntityStatusTimes)
+        {
+            if(pair.first > now) break;
+
+            passed.insert(pair.first);
+            for(auto entityID : pair.second)
+            {
+                result.push_back(entityID);
+            }
+        }
+
+        for(auto p : passed)
+        {
+            mNextEntityStatusTimes.erase(p);
+        }
+
+        return result;
+    }
+
+private:
+    std::map<uint32_t, std::set<int32_t>> mNextEntityStatusTimes;
+};
+
+/**
+ * Zone schedule backed by the table.
+ */
+class TableZone : public ScheduleZone
+{
+public:
+    virtual void SetNextStatusEffectTime(uint32_t time, int32_t entityID)
+    {
+        mNextEntityStatusTimes.Set(entityID, time);
+    }
+
+    virtual std::vector<int32_t> GetUpdatedStatusEffectEntities(uint32_t now)
+    {
+        std::vector<int32_t> result;
+        mNextEntityStatusTimes.PopDue(now, result);
+
+        return result;
+    }
+
+private:
+    ZoneStatusEffectTable mNextEntityStatusTimes;
+};
+
+/**
+ * Stub entity with the status effect timing and HP/MP handling of
+ * ActiveEntityState. System effect 0 drives regen, T-damage and upkeep and
+ * the times 1, 2 and 3 queue added, updated and removed effects. The
+ * quirks of the entity code are kept, such as regen only applying while
+ * no upkeep is scheduled and clearing one effect time erasing every effect
+ * at that time, since they decide when the zone must wake the entity.
+ */
+class StubEntity
+{
+public:
+    StubEntity(int32_t entityID, int32_t hpRegen, int32_t mpRegen)
+        : mEntityID(entityID), mHPRegen(hpRegen), mMPRegen(mpRegen),
+        mHP(500), mMP(200), mAlive(true), mEffectsActive(false),
+        mUpkeepCost(0), mNextRegenSync(0), mNextUpkeep(0), mZone(nullptr)
+    {
+    }
+
+    int32_t GetHP() const { return mHP; }
+    int32_t GetMP() const { return mMP; }
+    bool IsAlive() const { return mAlive; }
+    bool EffectsActive() const { return mEffectsActive; }
+    ScheduleZone* GetZone() const { return mZone; }
+
+    void SetZone(ScheduleZone* zone)
+    {
+        if(mZone)
+        {
+            mZone->SetNextStatusEffectTime(0, mEntityID);
+        }
+
+        mZone = zone;
+
+        RegisterNextEffectTime();
+    }
+
+    void SetStatusEffectsActive(bool activate, uint32_t now)
+    {
+        if(mEffectsActive == activate)
+        {
+            return;
+        }
+
+        mEffectsActive = activate;
+        if(activate)
+        {
+            mNextRegenSync = now + 10;
+            SetNextEffectTime(0, mNextRegenSync);
+
+            if(mUpkeepCost > 0)
+            {
+                mNextUpkeep = now + 3;
+                SetNextEffectTime(0, mNextUpkeep);
+            }
+
+            for(auto& pair : mExpirations)
+            {
+                mNextEffectTimes[now + pair.second].insert(pair.first);
+            }
+
+            RegisterNextEffectTime();
+        }
+        else
+        {
+            if(mZone)
+            {
+                mZone->SetNextStatusEffectTime(0, mEntityID);
+            }
+
+            // Keep the time left on each effect to restart it with
+            std::set<uint32_t> nonSystemTimes;
+            for(auto& pair : mNextEffectTimes)
+            {
+                if(pair.first <= 3) continue;
+
+                nonSystemTimes.insert(pair.first);
+                for(uint32_t effectType : pair.second)
+                {
+                    if(mTimeDamage.find(effectType) != mTimeDamage.end())
+                    {
+                        mExpirations[effectType] = pair.first > now
+                            ? pair.first - now : 1;
+                    }
+                }
+            }
+
+            for(uint32_t time : nonSystemTimes)
+            {
+                mNextEffectTimes.erase(time);
+            }
+        }
+    }
+
+    void AddStatusEffect(uint32_t effectType, uint32_t expiration,
+        int32_t hpDamage, int32_t mpDamage)
+    {
+        if(!mEffectsActive)
+        {
+            return;
+        }
+
+        bool add = mTimeDamage.find(effectType) == mTimeDamage.end();
+        if(!add)
+        {
+            // Only the time is replaced
+            for(auto& pair : mNextEffectTimes)
+            {
+                if(pair.first > 3)
+                {
+                    pair.second.erase(effectType);
+                }
+            }
+        }
+
+        mTimeDamage[effectType] = std::make_pair(hpDamage, mpDamage);
+        mExpirations.erase(effectType);
+        mNextEffectTimes[expiration].insert(effectType);
+        mNextEffectTimes[add ? 1 : 2].insert(effectType);
+
+        RegisterNextEffectTime();
+    }
+
+    void ExpireStatusEffect(uint32_t effectType)
+    {
+        if(mTimeDamage.erase(effectType) == 0)
+        {
+            return;
+        }
+
+        mExpirations.erase(effectType);
+
+        if(mEffectsActive)
+        {
+            SetNextEffectTime(effectType, 0);
+            mNextEffectTimes[3].insert(effectType);
+
+            RegisterNextEffectTime();
+        }
+    }
+
+    void ResetUpkeep(int32_t cost, uint32_t now)
+    {
+        mUpkeepCost = cost;
+        if(cost > 0)
+        {
+            mNextUpkeep = now + 3;
+            SetNextEffectTime(0, mNextUpkeep);
+
+            RegisterNextEffectTime();
+        }
+        else
+        {
+            mNextUpkeep = 0;
+        }
+    }
+
+    void Kill()
+    {
+        mHP = 0;
+        mAlive = false;
+    }
+
+    void Revive()
+    {
+        mHP = 250;
+        mAlive = true;
+    }
+
+    uint8_t PopEffectTicks(uint32_t time, int32_t& hpTDamage,
+        int32_t& mpTDamage, int32_t& tUpkeep)
+    {
+        hpTDamage = 0;
+        mpTDamage = 0;
+        tUpkeep = 0;
+
+        std::set<uint32_t> added, updated, removed;
+
+        if(!mEffectsActive)
+        {
+            return 0;
+        }
+
+        bool found = false;
+        bool reregister = false;
+        do
+        {
+            std::set<uint32_t> passed;
+            std::list<uint32_t> next;
+            for(auto& pair : mNextEffectTimes)
+            {
+                if(pair.first > time) break;
+
+                passed.insert(pair.first);
+
+                if(pair.first == 1)
+                {
+                    added = pair.second;
+                    continue;
+                }
+                else if(pair.first == 2)
+                {
+                    updated = pair.second;
+                    continue;
+                }
+                else if(pair.first == 3)
+                {
+                    removed = pair.second;
+                    continue;
+                }
+
+                bool systemEffect = pair.second.find(0) != pair.second.end();
+                bool doRegen = systemEffect && !mNextUpkeep;
+
+                if(systemEffect && mNextUpkeep && time >= mNextUpkeep)
+                {
+                    if(mUpkeepCost > 0 && mAlive)
+                    {
+                        tUpkeep = mUpkeepCost;
+
+                        mNextUpkeep = pair.first + 3;
+                        next.push_back(mNextUpkeep);
+                    }
+                    else
+                    {
+                        mNextUpkeep = 0;
+                    }
+                }
+
+                if(systemEffect && mNextRegenSync && time >= mNextRegenSync)
+                {
+                    if(mAlive)
+                    {
+                        if(doRegen)
+                        {
+                            hpTDamage = hpTDamage - mHPRegen;
+                            mpTDamage = mpTDamage - mMPRegen;
+                        }
+
+                        for(auto& dPair : mTimeDamage)
+                        {
+                            hpTDamage = hpTDamage + dPair.second.first;
+                            mpTDamage = mpTDamage + dPair.second.second;
+                        }
+                    }
+
+                    mNextRegenSync = pair.first + 10;
+                    next.push_back(mNextRegenSync);
+
+                    pair.second.erase(0);
+                }
+
+                // Remove effects that have ended
+                for(uint32_t effectType : pair.second)
+                {
+                    mTimeDamage.erase(effectType);
+                    removed.insert(effectType);
+                }
+            }
+
+            for(auto t : passed)
+            {
+                mNextEffectTimes.erase(t);
+            }
+
+            for(auto t : next)
+            {
+                SetNextEffectTime(0, t);
+            }
+
+            found = passed.size() > 0;
+            reregister |= found;
+        } while(found);
+
+        if(reregister)
+        {
+            RegisterNextEffectTime();
+        }
+
+        return (hpTDamage || mpTDamage || added.size() > 0 ||
+            updated.size() > 0 || removed.size() > 0) ? 1 : 0;
+    }
+
+    bool SetHPMP(int32_t hp, int32_t mp)
+    {
+        int32_t startingHP = mHP;
+        int32_t startingMP = mMP;
+
+        hp = startingHP + hp;
+        mp = startingMP + mp;
+
+        if(startingHP && hp <= 0)
+        {
+            hp = 1;
+        }
+        else if(!mAlive && hp > 0)
+        {
+            hp = 0;
+        }
+
+        if(hp < 0)
+        {
+            hp = 0;
+        }
+
+        if(mp < 0)
+        {
+            mp = 0;
+        }
+
+        bool result = false;
+
+        int32_t newHP = hp > MAX_HP ? MAX_HP : hp;
+        if(startingHP > 0 && newHP == 0)
+        {
+            mAlive = false;
+            result = true;
+        }
+        else if(startingHP == 0 && newHP > 0)
+        {
+            mAlive = true;
+            result = true;
+        }
+
+        result |= newHP != startingHP;
+        mHP = newHP;
+
+        int32_t newMP = mp > MAX_MP ? MAX_MP : mp;
+        result |= newMP != startingMP;
+        mMP = newMP;
+
+        return result;
+    }
+
+private:
+    void SetNextEffectTime(uint32_t effectType, uint32_t time)
+    {
+        if(effectType)
+        {
+            for(auto pair : mNextEffectTimes)
+            {
+                if(pair.first <= 3) continue;
+
+                if(pair.second.find(effectType) != pair.second.end())
+                {
+                    if(time == 0)
+                    {
+                        pair.second.erase(effectType);
+                        if(pair.second.size() == 0)
+                        {
+                            mNextEffectTimes.erase(pair.first);
+                        }
+                    }
+
+                    return;
+                }
+            }
+        }
+
+        if(time != 0)
+        {
+            mNextEffectTimes[time].insert(effectType);
+        }
+    }
+
+    void RegisterNextEffectTime()
+    {
+        if(mZone && mEffectsActive)
+        {
+            mZone->SetNextStatusEffectTime(mNextEffectTimes.size() > 0
+                ? mNextEffectTimes.begin()->first : 0, mEntityID);
+        }
+    }
+
+    static const int32_t MAX_HP = 1000;
+    static const int32_t MAX_MP = 400;
+
+    int32_t mEntityID;
+    int32_t mHPRegen;
+    int32_t mMPRegen;
+    int32_t mHP;
+    int32_t mMP;
+    bool mAlive;
+    bool mEffectsActive;
+    int32_t mUpkeepCost;
+    uint32_t mNextRegenSync;
+    uint32_t mNextUpkeep;
+    ScheduleZone* mZone;
+    std::map<uint32_t, std::set<uint32_t>> mNextEffectTimes;
+    std::map<uint32_t, std::pair<int32_t, int32_t>> mTimeDamage;
+    std::map<uint32_t, uint32_t> mExpirations;
+};
+
+/**
+ * Zone with stub entities ticked the way ZoneManager::UpdateStatusEffectStates
+ * applies T-damage, regen and upkeep to the entities the zone returns.
+ */
+template<typename ZoneType>
+class StubWorld
+{
+public:
+    StubWorld(size_t entityCount)
+    {
+        for(size_t i = 0; i < entityCount; i++)
+        {
+            int32_t entityID = (int32_t)(i + 1);
+            mEntities.push_back(std::make_shared<StubEntity>(entityID,
+                (int32_t)(i % 7) * 5, (int32_t)(i % 3) * 4));
+        }
+    }
+
+    std::shared_ptr<StubEntity> GetEntity(size_t idx)
+    {
+        return mEntities[idx];
+    }
+
+    ScheduleZone* GetZone()
+    {
+        return &mZone;
+    }
+
+    void UpdateStatusEffectStates(uint32_t now)
+    {
+        for(int32_t entityID : mZone.GetUpdatedStatusEffectEntities(now))
+        {
+            // Entities that left the zone are not found there
+            auto entity = mEntities[(size_t)(entityID - 1)];
+            if(entity->GetZone() != &mZone) continue;
+
+            int32_t hpTDamage, mpTDamage, upkeepCost;
+            uint8_t result = entity->PopEffectTicks(now, hpTDamage,
+                mpTDamage, upkeepCost);
+            if(!result) continue;
+
+            if(hpTDamage != 0 || mpTDamage != 0)
+            {
+                entity->SetHPMP(-hpTDamage, -(mpTDamage + upkeepCost));
+            }
+
+            if(upkeepCost != 0)
+            {
+                entity->SetHPMP(0, -upkeepCost);
+            }
+        }
+    }
+
+private:
+    ZoneType mZone;
+    std::vector<std::shared_ptr<StubEntity>> mEntities;
+};
+
+} // namespace
+
+TEST(ZoneStatusEffectTable, PopsInTimeThenEntityOrder)
+{
+    ZoneStatusEffectTable table;
+    table.Set(5, 30);
+    table.Set(2, 10);
+    table.Set(9, 10);
+    table.Set(1, 20);
+    table.Set(3, 40);
+
+    std::vector<int32_t> entityIDs;
+    table.PopDue(5, entityIDs);
+    EXPECT_TRUE(entityIDs.empty());
+
+    table.PopDue(30, entityIDs);
+    EXPECT_EQ(std::vector<int32_t>({ 2, 9, 1, 5 }), entityIDs);
+    EXPECT_EQ(1u, table.Size());
+
+    // Entities are appended to what is already in the output
+    table.PopDue(40, entityIDs);
+    EXPECT_EQ(std::vector<int32_t>({ 2, 9, 1, 5, 3 }), entityIDs);
+    EXPECT_EQ(0u, table.Size());
+}
+
+TEST(ZoneStatusEffectTable, SetReplacesAndZeroRemoves)
+{
+    ZoneStatusEffectTable table;
+    table.Set(1, 10);
+    table.Set(2, 20);
+    table.Set(1, 30);
+    table.Set(2, 0);
+    table.Remove(3);
+    EXPECT_EQ(1u, table.Size());
+
+    std::vector<int32_t> entityIDs;
+    table.PopDue(20, entityIDs);
+    EXPECT_TRUE(entityIDs.empty());
+
+    table.PopDue(30, entityIDs);
+    EXPECT_EQ(std::vector<int32_t>({ 1 }), entityIDs);
+
+    // A popped entity is only due again once it sets a new time
+    entityIDs.clear();
+    table.PopDue(100, entityIDs);
+    EXPECT_TRUE(entityIDs.empty());
+}
+
+TEST(ZoneStatusEffectTable, ReplayMatchesReference)
+{
+    std::mt19937 rng(4049);
+    std::uniform_int_distribution<int32_t> entityDist(1, 400);
+    std::uniform_int_distribution<uint32_t> delayDist(0, 30);
+    std::uniform_int_distribution<int> opDist(0, 99);
+
+    ZoneStatusEffectTable table;
+    ReferenceSchedule reference;
+
+    // Replay zone ticks where entities gain, refresh and lose effects and
+    // leave the zone between each tick
+    uint32_t now = 1000;
+    for(int tick = 0; tick < 5000; tick++)
+    {
+        int ops = opDist(rng) % 40;
+        for(int i = 0; i < ops; i++)
+        {
+            int32_t entityID = entityDist(rng);
+            int op = opDist(rng);
+            if(op < 70)
+            {
+                uint32_t time = now + delayDist(rng);
+                table.Set(entityID, time);
+                reference.Set(entityID, time);
+            }
+            else if(op < 85)
+            {
+                table.Set(entityID, 0);
+                reference.Set(entityID, 0);
+            }
+            else
+            {
+                table.Remove(entityID);
+                reference.Remove(entityID);
+            }
+        }
+
+        // Ticks are not always evenly spaced
+        now += (uint32_t)(1 + opDist(rng) % 3);
+
+        std::vector<int32_t> entityIDs;
+        table.PopDue(now, entityIDs);
+
+        ASSERT_EQ(reference.PopDue(now), entityIDs) << "tick " << tick;
+        ASSERT_EQ(reference.Size(), table.Size()) << "tick " << tick;
+    }
+}
+
+TEST(ZoneStatusEffectTable, ReplayMatchesBaselineHPMP)
+{
+    const size_t entityCount = 60;
+
+    StubWorld<BaselineZone> baseline(entityCount);
+    StubWorld<TableZone> table(entityCount);
+
+    std::mt19937 rng(4049);
+    std::uniform_int_distribution<size_t> entityDist(0, entityCount - 1);
+    std::uniform_int_distribution<int> opDist(0, 99);
+    std::uniform_int_distribution<uint32_t> effectDist(4, 24);
+    std::uniform_int_distribution<uint32_t> durationDist(1, 40);
+    std::uniform_int_distribution<int32_t> damageDist(-30, 50);
+
+    uint32_t now = 1000000;
+    for(size_t i = 0; i < entityCount; i++)
+    {
+        baseline.GetEntity(i)->SetZone(baseline.GetZone());
+        baseline.GetEntity(i)->SetStatusEffectsActive(true, now);
+        table.GetEntity(i)->SetZone(table.GetZone());
+        table.GetEntity(i)->SetStatusEffectsActive(true, now);
+    }
+
+    // Replay an hour of one second zone ticks where entities gain, refresh
+    // and lose effects, start and stop paying upkeep, die, come back and
+    // leave and enter the zone
+    std::vector<std::pair<int32_t, int32_t>> last(entityCount,
+        std::make_pair(500, 200));
+    size_t hpMpChanges = 0;
+    for(int tick = 0; tick < 3600; tick++)
+    {
+        int ops = opDist(rng) % 8;
+        for(int i = 0; i < ops; i++)
+        {
+            size_t idx = entityDist(rng);
+            int op = opDist(rng);
+            uint32_t effectType = effectDist(rng);
+            uint32_t duration = durationDist(rng);
+            int32_t hpDamage = damageDist(rng);
+            int32_t mpDamage = damageDist(rng) / 3;
+
+            for(int w = 0; w < 2; w++)
+            {
+                auto entity = w ? table.GetEntity(idx)
+                    : baseline.GetEntity(idx);
+                auto zone = w ? table.GetZone() : baseline.GetZone();
+
+                if(op < 50)
+                {
+                    entity->AddStatusEffect(effectType, now + duration,
+                        hpDamage, mpDamage);
+                }
+                else if(op < 62)
+                {
+                    entity->ExpireStatusEffect(effectType);
+                }
+                else if(op < 72)
+                {
+                    entity->ResetUpkeep(op % 2 ? (int32_t)duration % 6 : 0,
+                        now);
+                }
+                else if(op < 80)
+                {
+                    entity->SetStatusEffectsActive(
+                        !entity->EffectsActive(), now);
+                }
+                else if(op < 88)
+                {
+                    entity->SetZone(entity->GetZone() ? nullptr : zone);
+                }
+                else if(op < 94)
+                {
+                    entity->Kill();
+                }
+                else
+                {
+                    entity->Revive();
+                }
+            }
+        }
+
+        now++;
+
+        baseline.UpdateStatusEffectStates(now);
+        table.UpdateStatusEffectStates(now);
+
+        for(size_t i = 0; i < entityCount; i++)
+        {
+            auto b = baseline.GetEntity(i);
+            auto t = table.GetEntity(i);
+
+            ASSERT_EQ(b->GetHP(), t->GetHP()) << "tick " << tick
+                << " entity " << (i + 1);
+            ASSERT_EQ(b->GetMP(), t->GetMP()) << "tick " << tick
+                << " entity " << (i + 1);
+            ASSERT_EQ(b->IsAlive(), t->IsAlive()) << "tick " << tick
+                << " entity " << (i + 1);
+
+            auto current = std::make_pair(t->GetHP(), t->GetMP());
+            if(current != last[i])
+            {
+                hpMpChanges++;
+                last[i] = current;
+            }
+        }
+    }
+
+    // Make sure the replay actually moved HP and MP around
+    EXPECT_GT(hpMpChanges, (size_t)5000);
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
@@ -42,6 +42,7 @@
 #include <ServerConstants.h>
 
 // object Includes
+#include <ChannelTelemetry.h>
 #include <Character.h>
 #include <CharacterLogin.h>
 #include <CharacterProgress.h>
@@ -90,6 +91,7 @@ ApiHandler::ApiHandler(const std::shared_ptr<objects::LobbyConfig>& config,
     mParsers["/admin/message_world"] = &ApiHandler::Admin_MessageWorld;
     mParsers["/admin/online"] = &ApiHandler::Admin_Online;
     mParsers["/admin/post_items"] = &ApiHandler::Admin_PostItems;
+    mParsers["/admin/get_telemetry"] = &ApiHandler::Admin_GetTelemetry;
     mParsers["/admin/get_promos"] = &ApiHandler::Admin_GetPromos;
     mParsers["/admin/create_promo"] = &ApiHandler::Admin_CreatePromo;
     mParsers["/admin/delete_promo"] = &ApiHandler::Admin_DeletePromo;
@@ -1317,6 +1319,86 @@ bool ApiHandler::Admin_PostItems(const JsonBox::Object& request,
     return true;
 }
 
+bool ApiHandler::Admin_GetTelemetry(const JsonBox::Object& request,
+    JsonBox::Object& response, const std::shared_ptr<ApiSession>& session)
+{
+    (void)request;
+
+    if(!HaveUserLevel(response, session, SVR_CONST.API_ADMIN_LVL_ONLINE))
+    {
+        return true;
+    }
+
+    JsonBox::Array worldList;
+
+    for(auto world : mServer->GetManagerConnection()->GetWorlds())
+    {
+        auto rWorld = world->GetRegisteredWorld();
+
+        JsonBox::Object worldObj;
+        JsonBox::Array channelList;
+
+        int connections = 0;
+        int instances = 0;
+        int tickMax = 0;
+        for(auto& pair : world->GetChannelTelemetry())
+        {
+            auto telemetry = pair.second;
+
+            JsonBox::Object obj;
+            obj["channel_id"] = (int)telemetry->GetChannelID();
+            obj["timestamp"] = (int)telemetry->GetTimestamp();
+            obj["interval"] = (int)telemetry->GetInterval();
+            obj["connections"] = (int)telemetry->GetConnectionCount();
+            obj["zones"] = (int)telemetry->GetZoneCount();
+            obj["active_zones"] = (int)telemetry->GetActiveZoneCount();
+            obj["instances"] = (int)telemetry->GetInstanceCount();
+            obj["instance_population"] = (int)telemetry->
+                GetInstancePopulation();
+            obj["tick_count"] = (int)telemetry->GetTickCount();
+            obj["tick_average"] = (int)telemetry->GetTickAverage();
+            obj["tick_max"] = (int)telemetry->GetTickMax();
+            obj["tick_overruns"] = (int)telemetry->GetTickOverruns();
+            obj["ticks_missed"] = (int)telemetry->GetTicksMissed();
+            obj["db_time_max"] = (int)telemetry->GetDatabaseTimeMax();
+
+            JsonBox::Array zoneList;
+            for(auto& zPair : telemetry->GetZonePopulations())
+            {
+                JsonBox::Object zObj;
+                zObj["zone_id"] = (int)zPair.first;
+                zObj["population"] = (int)zPair.second;
+
+                zoneList.push_back(zObj);
+            }
+
+            obj["zone_populations"] = zoneList;
+
+            connections += (int)telemetry->GetConnectionCount();
+            instances += (int)telemetry->GetInstanceCount();
+            if((int)telemetry->GetTickMax() > tickMax)
+            {
+                tickMax = (int)telemetry->GetTickMax();
+            }
+
+            channelList.push_back(obj);
+        }
+
+        worldObj["world_id"] = (int)rWorld->GetID();
+        worldObj["connections"] = connections;
+        worldObj["instances"] = instances;
+        worldObj["tick_max"] = tickMax;
+        worldObj["channels"] = channelList;
+
+        worldList.push_back(worldObj);
+    }
+
+    response["error"] = "Success";
+    response["worlds"] = worldList;
+
+    return true;
+}
+
 bool ApiHandler::Admin_GetPromos(const JsonBox::Object& request,
     JsonBox::Object& response, const std::shared_ptr<ApiSession>& session)
 {
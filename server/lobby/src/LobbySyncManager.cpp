@@ -36,6 +36,7 @@
 
 // object Includes
 #include <Account.h>
+#include <ChannelTelemetry.h>
 #include <Character.h>
 #include <CharacterLogin.h>
 #include <CharacterProgress.h>
@@ -44,6 +45,7 @@
 #include "AccountManager.h"
 #include "LobbyServer.h"
 #include "ManagerConnection.h"
+#include "World.h"
 
 using namespace lobby;
 
@@ -77,6 +79,14 @@ bool LobbySyncManager::Initialize()
 
     mRegisteredTypes["Character"] = cfg;
 
+    cfg = std::make_shared<ObjectConfig>(
+        "ChannelTelemetry", false, nullptr);
+    cfg->UpdateHandler = &DataSyncManager::Update<LobbySyncManager,
+        objects::ChannelTelemetry>;
+    cfg->DynamicHandler = true;
+
+    mRegisteredTypes["ChannelTelemetry"] = cfg;
+
     cfg = std::make_shared<ObjectConfig>(
         "CharacterProgress", false, nullptr);
     cfg->UpdateHandler = &DataSyncManager::Update<LobbySyncManager,
@@ -121,6 +131,30 @@ int8_t LobbySyncManager::Update<objects::Character>(const libcomp::String& type,
     return SYNC_HANDLED;
 }
 
+template<>
+int8_t LobbySyncManager::Update<objects::ChannelTelemetry>(
+    const libcomp::String& type, const std::shared_ptr<libcomp::Object>& obj,
+    bool isRemove, const libcomp::String& source)
+{
+    (void)type;
+    (void)source;
+
+    // Channel removal clears telemetry with the channel itself
+    if(!isRemove)
+    {
+        auto entry = std::dynamic_pointer_cast<objects::ChannelTelemetry>(obj);
+
+        auto world = mServer.lock()->GetManagerConnection()->GetWorldByID(
+            entry->GetWorldID());
+        if(world)
+        {
+            world->SetChannelTelemetry(entry);
+        }
+    }
+
+    return SYNC_HANDLED;
+}
+
 template<>
 int8_t LobbySyncManager::Update<objects::CharacterProgress>(
     const libcomp::String& type, const std::shared_ptr<libcomp::Object>& obj,
@@ -39,6 +39,7 @@ namespace objects
 {
 class Account;
 class Character;
+class ChannelTelemetry;
 class CharacterProgress;
 }
 
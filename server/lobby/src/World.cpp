@@ -30,6 +30,9 @@
 #include <Packet.h>
 #include <PacketCodes.h>
 
+// object Includes
+#include <ChannelTelemetry.h>
+
 using namespace lobby;
 
 World::World()
@@ -75,6 +78,10 @@ bool World::RemoveChannelByID(uint8_t id)
         if((*iter)->GetID() == id)
         {
             mRegisteredChannels.erase(iter);
+
+            std::lock_guard<std::mutex> lock(mTelemetryLock);
+            mChannelTelemetry.erase(id);
+
             return true;
         }
     }
@@ -111,3 +118,17 @@ void World::RegisterWorld(const std::shared_ptr<objects::RegisteredWorld>& regis
 {
     mRegisteredWorld = registeredWorld;
 }
+
+std::unordered_map<uint8_t, std::shared_ptr<objects::ChannelTelemetry>>
+    World::GetChannelTelemetry()
+{
+    std::lock_guard<std::mutex> lock(mTelemetryLock);
+    return mChannelTelemetry;
+}
+
+void World::SetChannelTelemetry(const std::shared_ptr<
+    objects::ChannelTelemetry>& telemetry)
+{
+    std::lock_guard<std::mutex> lock(mTelemetryLock);
+    mChannelTelemetry[telemetry->GetChannelID()] = telemetry;
+}
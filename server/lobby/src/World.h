@@ -35,6 +35,15 @@
 #include <RegisteredChannel.h>
 #include <RegisteredWorld.h>
 
+// Standard C++11 Includes
+#include <mutex>
+#include <unordered_map>
+
+namespace objects
+{
+class ChannelTelemetry;
+}
+
 namespace lobby
 {
 
@@ -117,6 +126,22 @@ public:
      */
     void RegisterWorld(const std::shared_ptr<objects::RegisteredWorld>& registeredWorld);
 
+    /**
+     * Get the most recent telemetry reported by each of the world's
+     * channels.
+     * @return Map of channel IDs to their last reported telemetry
+     */
+    std::unordered_map<uint8_t, std::shared_ptr<
+        objects::ChannelTelemetry>> GetChannelTelemetry();
+
+    /**
+     * Store the telemetry reported by one of the world's channels,
+     * replacing any previous report from the same channel.
+     * @param telemetry Pointer to the channel telemetry
+     */
+    void SetChannelTelemetry(const std::shared_ptr<
+        objects::ChannelTelemetry>& telemetry);
+
 private:
     /// Pointer to the world's connection
     std::shared_ptr<libcomp::InternalConnection> mConnection;
@@ -129,6 +154,13 @@ private:
 
     /// List of pointers to the RegisteredChannels
     std::list<std::shared_ptr<objects::RegisteredChannel>> mRegisteredChannels;
+
+    /// Last telemetry reported by each channel by channel ID
+    std::unordered_map<uint8_t, std::shared_ptr<
+        objects::ChannelTelemetry>> mChannelTelemetry;
+
+    /// Server lock for channel telemetry
+    std::mutex mTelemetryLock;
 };
 
 } // namespace lobby
@@ -284,6 +284,9 @@ bool AccountManager::ChannelLogin(std::shared_ptr<objects::AccountLogin> login)
                 // the clan level and sending of the character updates
                 if(cLogin->GetClanID())
                 {
+                    server->GetCharacterManager()->UpdateClanMemberPoints(
+                        cLogin->GetClanID(), character->GetUUID(), points);
+
                     server->QueueWork([](std::shared_ptr<WorldServer> pServer,
                         std::shared_ptr<objects::CharacterLogin> pLogin,
                         int32_t pClanID)
@@ -658,8 +661,20 @@ void AccountManager::CompleteLobbyLogin(
     else
     {
         // Always start in channel 0 for redundant channel mode or
-        // only one channel
+        // only one channel unless login placement is enabled
         channelID = 0;
+
+        if(config->GetChannelPlacementLogin() &&
+            config->GetWorldSharedConfig()->ChannelDistributionCount() == 0)
+        {
+            int8_t placementID = server->GetWorldSyncManager()
+                ->GetPlacementChannel();
+            if(placementID >= 0 &&
+                server->GetChannelConnectionByID(placementID) != nullptr)
+            {
+                channelID = placementID;
+            }
+        }
     }
 
     ok &= channelID >= 0 &&
@@ -1119,6 +1134,8 @@ bool AccountManager::DeleteCharacter(const std::shared_ptr<
                 otherFriendSettings->SetFriends(friends);
 
                 changes->Update(otherFriendSettings);
+
+                characterManager->UpdateFriends(otherChar, friends);
             }
         }
 
@@ -1126,6 +1143,8 @@ bool AccountManager::DeleteCharacter(const std::shared_ptr<
         changes->Update(friendSettings);
     }
 
+    characterManager->InvalidateFriends(characterUUID);
+
     // If the character is somehow connected, send a disconnect request
     // and mark the character for deletion later
     if(cLogin && cLogin->GetChannelID() >= 0)
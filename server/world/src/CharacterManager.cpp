@@ -32,6 +32,9 @@
 #include <Log.h>
 #include <PacketCodes.h>
 
+// Standard C++11 Includes
+#include <ctime>
+
 // object Includes
 #include <Character.h>
 #include <ClanMember.h>
@@ -45,6 +48,10 @@
 
 using namespace world;
 
+/// Number of seconds a clan's running point total is trusted before it is
+/// reconciled against the member characters in the database
+static const uint32_t CLAN_POINT_RECONCILE_TIME = 3600;
+
 CharacterManager::CharacterManager(const std::weak_ptr<WorldServer>& server)
     : mServer(server)
 {
@@ -274,8 +281,6 @@ bool CharacterManager::SendToRelatedCharacters(libcomp::Packet& p,
         cLogins.push_back(cLogin);
     }
 
-    cLogins.unique();
-
     return cLogins.size() == 0 || SendToCharacters(p, cLogins, cidOffset);
 }
 
@@ -283,42 +288,13 @@ std::list<std::shared_ptr<objects::CharacterLogin>>
     CharacterManager::GetRelatedCharacterLogins(
     std::shared_ptr<objects::CharacterLogin> cLogin, uint8_t relatedTypes)
 {
-    auto server = mServer.lock();
-    auto worldDB = server->GetWorldDatabase();
-
     std::list<int32_t> targetCIDs;
     std::list<libobjgen::UUID> targetUUIDs;
     if(relatedTypes & RELATED_FRIENDS)
     {
-        std::shared_ptr<objects::FriendSettings> fSettings;
-
-        // If the character is currently loaded on the server, pull the friend
-        // settings directly from it so we don't need to load every time
-        auto character = cLogin->GetCharacter().Get();
-        if(character && cLogin->GetStatus() !=
-            objects::CharacterLogin::Status_t::OFFLINE)
-        {
-            fSettings = character->GetFriendSettings().Get(worldDB);
-            if(!fSettings && !character->GetFriendSettings().IsNull())
-            {
-                LogCharacterManagerError([&]()
-                {
-                    return libcomp::String(
-                        "Failed to get friend settings. Character UUID: %1\n")
-                        .Arg(cLogin->GetCharacter().GetUUID().ToString());
-                });
-            }
-        }
-        else
-        {
-            fSettings = objects::FriendSettings::LoadFriendSettingsByCharacter(
-                worldDB, cLogin->GetCharacter().GetUUID());
-        }
-
-        if(fSettings)
-        {
-            targetUUIDs = fSettings->GetFriends();
-        }
+        // Friends lists are cached so they do not need to be loaded for
+        // every status update
+        targetUUIDs = GetFriends(cLogin->GetCharacter().GetUUID());
     }
 
     if(relatedTypes & RELATED_CLAN)
@@ -359,26 +335,155 @@ std::list<std::shared_ptr<objects::CharacterLogin>>
         }
     }
 
+    // Characters can be related in more than one way so only return
+    // each one once
+    std::set<int32_t> seen = { cLogin->GetWorldCID() };
+
     std::list<std::shared_ptr<objects::CharacterLogin>> cLogins;
     for(auto targetUUID : targetUUIDs)
     {
         if(targetUUID != cLogin->GetCharacter().GetUUID())
         {
-            cLogins.push_back(GetCharacterLogin(targetUUID));
+            auto login = GetCharacterLogin(targetUUID);
+            if(seen.insert(login->GetWorldCID()).second)
+            {
+                cLogins.push_back(login);
+            }
         }
     }
 
     for(auto cid : targetCIDs)
     {
-        if(cid != cLogin->GetWorldCID())
+        if(seen.insert(cid).second)
         {
-            cLogins.push_back(GetCharacterLogin(cid));
+            auto login = GetCharacterLogin(cid);
+            if(login)
+            {
+                cLogins.push_back(login);
+            }
         }
     }
 
     return cLogins;
 }
 
+std::list<libobjgen::UUID> CharacterManager::GetFriends(
+    const libobjgen::UUID& uuid)
+{
+    libcomp::String lookup = uuid.ToString();
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = mFriendLists.find(lookup);
+        if(it != mFriendLists.end())
+        {
+            return it->second;
+        }
+    }
+
+    auto worldDB = mServer.lock()->GetWorldDatabase();
+    auto fSettings = objects::FriendSettings::LoadFriendSettingsByCharacter(
+        worldDB, uuid);
+
+    // A character without friend settings has no friends, cache that too
+    // so it is not loaded again for every status update
+    std::list<libobjgen::UUID> friends;
+    if(fSettings)
+    {
+        friends = fSettings->GetFriends();
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+
+    // If another thread loaded or updated the list first, keep theirs
+    auto it = mFriendLists.find(lookup);
+    if(it != mFriendLists.end())
+    {
+        return it->second;
+    }
+
+    mFriendLists[lookup] = friends;
+    for(auto& f : friends)
+    {
+        mFriendOf[f.ToString()].insert(lookup);
+    }
+
+    return friends;
+}
+
+void CharacterManager::UpdateFriends(const libobjgen::UUID& uuid,
+    const std::list<libobjgen::UUID>& friends)
+{
+    libcomp::String lookup = uuid.ToString();
+
+    std::lock_guard<std::mutex> lock(mLock);
+
+    auto it = mFriendLists.find(lookup);
+    if(it != mFriendLists.end())
+    {
+        for(auto& f : it->second)
+        {
+            auto rIter = mFriendOf.find(f.ToString());
+            if(rIter != mFriendOf.end())
+            {
+                rIter->second.erase(lookup);
+                if(rIter->second.size() == 0)
+                {
+                    mFriendOf.erase(rIter);
+                }
+            }
+        }
+    }
+
+    mFriendLists[lookup] = friends;
+    for(auto& f : friends)
+    {
+        mFriendOf[f.ToString()].insert(lookup);
+    }
+}
+
+void CharacterManager::InvalidateFriends(const libobjgen::UUID& uuid)
+{
+    libcomp::String lookup = uuid.ToString();
+
+    std::lock_guard<std::mutex> lock(mLock);
+
+    // Drop every cached list that contains the character, along with the
+    // character's own list
+    std::set<libcomp::String> dropLists;
+
+    auto rIter = mFriendOf.find(lookup);
+    if(rIter != mFriendOf.end())
+    {
+        dropLists = rIter->second;
+    }
+
+    dropLists.insert(lookup);
+
+    for(auto& owner : dropLists)
+    {
+        auto it = mFriendLists.find(owner);
+        if(it == mFriendLists.end())
+        {
+            continue;
+        }
+
+        for(auto& f : it->second)
+        {
+            auto fIter = mFriendOf.find(f.ToString());
+            if(fIter != mFriendOf.end())
+            {
+                fIter->second.erase(owner);
+                if(fIter->second.size() == 0)
+                {
+                    mFriendOf.erase(fIter);
+                }
+            }
+        }
+
+        mFriendLists.erase(it);
+    }
+}
+
 void CharacterManager::SendStatusToRelatedCharacters(
     const std::list<std::shared_ptr<objects::CharacterLogin>>& cLogins, uint8_t updateFlags, bool zoneRestrict)
 {
@@ -1075,6 +1180,9 @@ bool CharacterManager::ClanJoin(std::shared_ptr<objects::CharacterLogin> cLogin,
 
     SendToRelatedCharacters(relay, cLogin->GetWorldCID(), cidOffset, RELATED_CLAN, true);
 
+    UpdateClanMemberPoints(clanID, character->GetUUID(),
+        character->GetLoginPoints());
+
     SendClanMemberInfo(cLogin, 0x30);
     RecalculateClanLevel(clanID);
     SendClanMemberInfo(cLogin, (uint8_t)CharacterLoginStateFlag_t::CHARLOGIN_BASIC);
@@ -1217,6 +1325,7 @@ void CharacterManager::ClanDisband(int32_t clanID, int32_t sourceCID,
             std::lock_guard<std::mutex> lock(mLock);
             mClans.erase(clanID);
             mClanMap.erase(clanInfo->GetClan().GetUUID().ToString());
+            mClanPoints.RemoveClan(clanID);
         }
 
         // Reload and update all member characters, then delete all
@@ -1332,28 +1441,64 @@ void CharacterManager::RecalculateClanLevel(int32_t clanID, bool sendUpdate)
 
         int8_t currentLevel = clan->GetLevel();
 
+        uint32_t now = (uint32_t)std::time(0);
         uint64_t totalPoints = 0;
-        for(auto memberRef : clan->GetMembers())
+
+        // Member changes made while the members load are recorded and
+        // applied again when the load finishes so none are lost
+        size_t loadToken = 0;
+        bool reconcile = false;
         {
-            auto member = memberRef.Get(db);
-            auto character = member
-                ? libcomp::PersistentObject::LoadObjectByUUID<
-                objects::Character>(db, member->GetCharacter()) : nullptr;
+            std::lock_guard<std::mutex> lock(mLock);
+            if(!mClanPoints.GetTotal(clanID, now, CLAN_POINT_RECONCILE_TIME,
+                totalPoints))
+            {
+                loadToken = mClanPoints.BeginLoad(clanID);
+                reconcile = true;
+            }
+        }
 
-            if(!character)
+        if(reconcile)
+        {
+            // Load every member character to rebuild the running total
+            ClanPointTotals::MemberPoints memberPoints;
+            for(auto memberRef : clan->GetMembers())
             {
-                LogCharacterManagerWarning([&]()
+                auto member = memberRef.Get(db);
+                auto character = member
+                    ? libcomp::PersistentObject::LoadObjectByUUID<
+                    objects::Character>(db, member->GetCharacter()) : nullptr;
+
+                if(!character)
                 {
-                    return libcomp::String("Invalid clan member encountered"
-                        " on clan '%1' with UID: %2\n").Arg(clan->GetName())
-                        .Arg(memberRef.GetUUID().ToString());
-                });
+                    LogCharacterManagerWarning([&]()
+                    {
+                        return libcomp::String("Invalid clan member encountered"
+                            " on clan '%1' with UID: %2\n").Arg(clan->GetName())
+                            .Arg(memberRef.GetUUID().ToString());
+                    });
+
+                    continue;
+                }
 
-                continue;
+                memberPoints[character->GetUUID().ToString()] =
+                    character->GetLoginPoints();
             }
 
-            totalPoints = (uint64_t)(totalPoints + (uint64_t)
-                character->GetLoginPoints());
+            std::lock_guard<std::mutex> lock(mLock);
+
+            uint64_t runningTotal = 0;
+            totalPoints = mClanPoints.FinishLoad(clanID, loadToken,
+                memberPoints, now, runningTotal);
+            if(runningTotal != totalPoints)
+            {
+                LogClanDebug([clan, runningTotal, totalPoints]()
+                {
+                    return libcomp::String("Corrected running point total"
+                        " for clan '%1' from %2 to %3\n").Arg(clan->GetName())
+                        .Arg(runningTotal).Arg(totalPoints);
+                });
+            }
         }
 
         uint32_t newLevel = 0;
@@ -1384,6 +1529,13 @@ void CharacterManager::RecalculateClanLevel(int32_t clanID, bool sendUpdate)
     }
 }
 
+void CharacterManager::UpdateClanMemberPoints(int32_t clanID,
+    const libobjgen::UUID& characterUUID, int32_t points)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    mClanPoints.SetMemberPoints(clanID, characterUUID.ToString(), points);
+}
+
 void CharacterManager::SendClanDetails(std::shared_ptr<objects::CharacterLogin> cLogin,
     std::shared_ptr<libcomp::TcpConnection> requestConnection, std::list<int32_t> memberIDs)
 {
@@ -2365,6 +2517,9 @@ bool CharacterManager::RemoveFromClan(std::shared_ptr<objects::CharacterLogin> c
 
         if(worldDB->ProcessChangeSet(dbChanges))
         {
+            mClanPoints.RemoveMember(clanID, cLogin->GetCharacter()
+                .GetUUID().ToString());
+
             LogClanDebug([clan, character]()
             {
                 return libcomp::String("Successfully removed member from"
@@ -27,7 +27,11 @@
 #ifndef SERVER_WORLD_SRC_CHARACTERMANAGER_H
 #define SERVER_WORLD_SRC_CHARACTERMANAGER_H
 
+// world Includes
+#include "ClanPointTotals.h"
+
 // Standard C++11 Includes
+#include <set>
 #include <unordered_map>
 
 // object Includes
@@ -187,6 +191,33 @@ public:
         GetRelatedCharacterLogins(std::shared_ptr<objects::CharacterLogin> cLogin,
             uint8_t relatedTypes);
 
+    /**
+     * Get the friends list of a character from the cached friend graph.
+     * The list is loaded from the world database the first time it is
+     * requested and kept until the character is removed from the graph.
+     * @param uuid UUID of the character to get the friends of
+     * @return List of the UUIDs of the character's friends, empty if the
+     *  character has no friend settings
+     */
+    std::list<libobjgen::UUID> GetFriends(const libobjgen::UUID& uuid);
+
+    /**
+     * Replace the cached friends list of a character after it has been
+     * changed and saved to the world database.
+     * @param uuid UUID of the character whose friends list changed
+     * @param friends New list of the UUIDs of the character's friends
+     */
+    void UpdateFriends(const libobjgen::UUID& uuid,
+        const std::list<libobjgen::UUID>& friends);
+
+    /**
+     * Remove a character from the cached friend graph along with the
+     * cached friends list of every character that has them as a friend
+     * so they are loaded again the next time they are needed.
+     * @param uuid UUID of the character to remove
+     */
+    void InvalidateFriends(const libobjgen::UUID& uuid);
+
     /**
      * Send packets containing CharacterLogin information about the supplied logins
      * contextual to other related characters
@@ -419,13 +450,25 @@ public:
     /**
      * Recalculate a clan's level based on a summation of each member's
      * login points. Every 10,000 points grants a new level starting at 20,000
-     * and ending at 100,000.
+     * and ending at 100,000. The summation is kept as a running total that
+     * is loaded from every member character the first time and reconciled
+     * with the database periodically.
      * @param clanID Clan instance ID
      * @param sendUpdate If true and the level is changed by the calculation, it
      *  is broadcast to each logged in clan member.
      */
     void RecalculateClanLevel(int32_t clanID, bool sendUpdate = true);
 
+    /**
+     * Update the login points of a clan member in the running point total
+     * of their clan. This does not recalculate the clan level.
+     * @param clanID Clan instance ID
+     * @param characterUUID UUID of the member character
+     * @param points Current login points of the member character
+     */
+    void UpdateClanMemberPoints(int32_t clanID,
+        const libobjgen::UUID& characterUUID, int32_t points);
+
     /**
      * Get an active team by ID
      * @param teamID ID of the team to retrieve
@@ -598,6 +641,19 @@ private:
 
     std::unordered_map<int32_t, std::shared_ptr<objects::Team>> mTeams;
 
+    /// Running login point totals of each clan
+    ClanPointTotals mClanPoints;
+
+    /// Map of character UUIDs to the UUIDs on their friends list, only
+    /// containing characters whose friends list has been requested
+    std::unordered_map<libcomp::String,
+        std::list<libobjgen::UUID>> mFriendLists;
+
+    /// Reverse of mFriendLists, mapping character UUIDs to the UUIDs of
+    /// each cached character that has them on their friends list
+    std::unordered_map<libcomp::String,
+        std::set<libcomp::String>> mFriendOf;
+
     /// Highest CID registered for a logged in character
     int32_t mMaxCID;
 
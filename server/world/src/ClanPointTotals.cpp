@@ -0,0 +1,204 @@
+/**
+ * @file server/world/src/ClanPointTotals.cpp
+ * @ingroup world
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Running login point totals of each clan.
+ *
+ * This file is part of the World Server (world).
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ClanPointTotals.h"
+
+using namespace world;
+
+bool ClanPointTotals::GetTotal(int32_t clanID, uint32_t now,
+    uint32_t maxAge, uint64_t& total) const
+{
+    auto it = mClans.find(clanID);
+    if(it == mClans.end() || !it->second.IsLoaded ||
+        (now - it->second.Loaded) >= maxAge)
+    {
+        return false;
+    }
+
+    total = it->second.Total;
+
+    return true;
+}
+
+size_t ClanPointTotals::BeginLoad(int32_t clanID)
+{
+    auto& clan = mClans[clanID];
+    clan.ActiveLoads++;
+
+    return clan.Changes.size();
+}
+
+uint64_t ClanPointTotals::FinishLoad(int32_t clanID, size_t token,
+    const MemberPoints& loaded, uint32_t now, uint64_t& previous)
+{
+    auto& clan = mClans[clanID];
+    if(clan.ActiveLoads > 0)
+    {
+        clan.ActiveLoads--;
+    }
+
+    if(clan.Removed)
+    {
+        // The clan was removed while loading, drop it once the last load
+        // finishes
+        if(clan.ActiveLoads == 0)
+        {
+            mClans.erase(clanID);
+        }
+
+        previous = 0;
+
+        return 0;
+    }
+
+    MemberPoints members = loaded;
+
+    uint64_t total = 0;
+    for(auto& pair : members)
+    {
+        total = (uint64_t)(total + (uint64_t)pair.second);
+    }
+
+    // The load may or may not have seen each change made while it was
+    // running, each one sets the final state of a member so applying it
+    // again is correct either way
+    for(size_t i = token; i < clan.Changes.size(); i++)
+    {
+        ApplyTo(members, total, clan.Changes[i]);
+    }
+
+    previous = clan.IsLoaded ? clan.Total : total;
+
+    clan.Members = members;
+    clan.Total = total;
+    clan.Loaded = now;
+    clan.IsLoaded = true;
+
+    if(clan.ActiveLoads == 0)
+    {
+        clan.Changes.clear();
+    }
+
+    return total;
+}
+
+void ClanPointTotals::SetMemberPoints(int32_t clanID,
+    const libcomp::String& characterUUID, int32_t points)
+{
+    MemberChange change;
+    change.CharacterUUID = characterUUID;
+    change.Points = points;
+    change.Remove = false;
+
+    Apply(clanID, change);
+}
+
+void ClanPointTotals::RemoveMember(int32_t clanID,
+    const libcomp::String& characterUUID)
+{
+    MemberChange change;
+    change.CharacterUUID = characterUUID;
+    change.Points = 0;
+    change.Remove = true;
+
+    Apply(clanID, change);
+}
+
+void ClanPointTotals::RemoveClan(int32_t clanID)
+{
+    auto it = mClans.find(clanID);
+    if(it == mClans.end())
+    {
+        return;
+    }
+
+    if(it->second.ActiveLoads > 0)
+    {
+        // Keep the clan until the loads still running finish so they do
+        // not add it back
+        it->second.Members.clear();
+        it->second.Changes.clear();
+        it->second.Total = 0;
+        it->second.IsLoaded = false;
+        it->second.Removed = true;
+        return;
+    }
+
+    mClans.erase(it);
+}
+
+void ClanPointTotals::Apply(int32_t clanID, const MemberChange& change)
+{
+    auto it = mClans.find(clanID);
+    if(it == mClans.end())
+    {
+        // Not loaded yet, the first load will include the change
+        return;
+    }
+
+    auto& clan = it->second;
+    if(clan.Removed)
+    {
+        return;
+    }
+
+    if(clan.IsLoaded)
+    {
+        ApplyTo(clan.Members, clan.Total, change);
+    }
+
+    if(clan.ActiveLoads > 0)
+    {
+        clan.Changes.push_back(change);
+    }
+}
+
+void ClanPointTotals::ApplyTo(MemberPoints& members, uint64_t& total,
+    const MemberChange& change)
+{
+    auto it = members.find(change.CharacterUUID);
+    if(it != members.end())
+    {
+        total = (uint64_t)(total - (uint64_t)it->second);
+
+        if(change.Remove)
+        {
+            members.erase(it);
+            return;
+        }
+
+        it->second = change.Points;
+    }
+    else if(change.Remove)
+    {
+        return;
+    }
+    else
+    {
+        members[change.CharacterUUID] = change.Points;
+    }
+
+    total = (uint64_t)(total + (uint64_t)change.Points);
+}
@@ -0,0 +1,174 @@
+/**
+ * @file server/world/src/ClanPointTotals.h
+ * @ingroup world
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Running login point totals of each clan.
+ *
+ * This file is part of the World Server (world).
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_WORLD_SRC_CLANPOINTTOTALS_H
+#define SERVER_WORLD_SRC_CLANPOINTTOTALS_H
+
+// libcomp Includes
+#include <CString.h>
+
+// Standard C++11 Includes
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace world
+{
+
+/**
+ * Running totals of the login points of every member of each clan, kept
+ * up to date by applying member changes as deltas once a clan has been
+ * loaded. Loads run without the owner's lock held so any member change
+ * made while a load is running is recorded and applied again on top of
+ * the loaded points when the load finishes. This class is not thread
+ * safe.
+ */
+class ClanPointTotals
+{
+public:
+    /// Login points of each member character by character UUID
+    typedef std::unordered_map<libcomp::String, int32_t> MemberPoints;
+
+    /**
+     * Get the running total of a clan if it is loaded and was loaded
+     * recently enough to be trusted
+     * @param clanID Clan instance ID
+     * @param now Current system time
+     * @param maxAge Seconds a loaded total is trusted for
+     * @param total Output parameter set to the total if it is trusted
+     * @return true if the total is trusted, false if the clan needs to be
+     *  loaded
+     */
+    bool GetTotal(int32_t clanID, uint32_t now, uint32_t maxAge,
+        uint64_t& total) const;
+
+    /**
+     * Start loading the points of every member of a clan. Every member
+     * change made until the matching call to FinishLoad is recorded.
+     * @param clanID Clan instance ID
+     * @return Token to pass to FinishLoad
+     */
+    size_t BeginLoad(int32_t clanID);
+
+    /**
+     * Finish loading a clan, replacing its member points with the loaded
+     * points plus every member change made since BeginLoad
+     * @param clanID Clan instance ID
+     * @param token Token returned by BeginLoad
+     * @param loaded Points of every member read while loading
+     * @param now Current system time
+     * @param previous Output parameter set to the running total before the
+     *  load or the new total if the clan was not loaded before
+     * @return New running total of the clan or 0 if it was removed
+     *  while loading
+     */
+    uint64_t FinishLoad(int32_t clanID, size_t token,
+        const MemberPoints& loaded, uint32_t now, uint64_t& previous);
+
+    /**
+     * Set the login points of a clan member, adding them to the clan if
+     * they are not a member already
+     * @param clanID Clan instance ID
+     * @param characterUUID UUID of the member character as a string
+     * @param points Current login points of the member character
+     */
+    void SetMemberPoints(int32_t clanID,
+        const libcomp::String& characterUUID, int32_t points);
+
+    /**
+     * Remove a member from a clan
+     * @param clanID Clan instance ID
+     * @param characterUUID UUID of the member character as a string
+     */
+    void RemoveMember(int32_t clanID, const libcomp::String& characterUUID);
+
+    /**
+     * Drop everything known about a clan
+     * @param clanID Clan instance ID
+     */
+    void RemoveClan(int32_t clanID);
+
+private:
+    /// Change made to a single member
+    struct MemberChange
+    {
+        /// UUID of the member character as a string
+        libcomp::String CharacterUUID;
+
+        /// New points of the member
+        int32_t Points;
+
+        /// true if the member was removed
+        bool Remove;
+    };
+
+    /// State of a single clan
+    struct Clan
+    {
+        /// Points of each member, only valid once loaded
+        MemberPoints Members;
+
+        /// Sum of Members
+        uint64_t Total = 0;
+
+        /// System time the clan was last loaded
+        uint32_t Loaded = 0;
+
+        /// true once the clan has been loaded
+        bool IsLoaded = false;
+
+        /// true if the clan was removed while a load was running
+        bool Removed = false;
+
+        /// Number of loads currently running
+        uint32_t ActiveLoads = 0;
+
+        /// Member changes made while a load is running in order
+        std::vector<MemberChange> Changes;
+    };
+
+    /**
+     * Apply a member change to a clan, recording it for running loads
+     * @param clanID Clan instance ID
+     * @param change Change to apply
+     */
+    void Apply(int32_t clanID, const MemberChange& change);
+
+    /**
+     * Apply a member change to a set of member points and their total
+     * @param members Member points to change
+     * @param total Total of the member points to keep in sync
+     * @param change Change to apply
+     */
+    static void ApplyTo(MemberPoints& members, uint64_t& total,
+        const MemberChange& change);
+
+    /// Map of clan IDs to their state
+    std::unordered_map<int32_t, Clan> mClans;
+};
+
+} // namespace world
+
+#endif // SERVER_WORLD_SRC_CLANPOINTTOTALS_H
@@ -139,6 +139,7 @@ void ManagerConnection::RemoveConnection(std::shared_ptr<libcomp::InternalConnec
     if(nullptr != svr)
     {
         server->RemoveChannel(connection);
+        server->GetWorldSyncManager()->RemoveChannelTelemetry(svr->GetID());
 
         auto db = server->GetWorldDatabase();
         svr->Delete(db);
@@ -177,7 +178,7 @@ void ManagerConnection::RemoveConnection(std::shared_ptr<libcomp::InternalConnec
 
                     if(flushSyncData)
                     {
-                        syncManager->SyncOutgoing();
+                        syncManager->ScheduleSyncOutgoing();
                     }
 
                     characterManager->SendStatusToRelatedCharacters(cLogOuts,
@@ -0,0 +1,175 @@
+/**
+ * @file server/world/src/UBLeaderboard.cpp
+ * @ingroup world
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Incrementally maintained Ultimate Battle ranking board.
+ *
+ * This file is part of the World Server (world).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UBLeaderboard.h"
+
+// object Includes
+#include <UBResult.h>
+
+using namespace world;
+
+UBLeaderboard::UBLeaderboard(uint8_t rankCount,
+    const PointsGetter_t& getPoints, const RankGetter_t& getRank,
+    const RankSetter_t& setRank) : mRankCount(rankCount),
+    mGetPoints(getPoints), mGetRank(getRank), mSetRank(setRank),
+    mLoaded(false)
+{
+}
+
+void UBLeaderboard::Clear()
+{
+    mPointGroups.clear();
+    mEntries.clear();
+    mRanked.clear();
+    mLoaded = false;
+}
+
+bool UBLeaderboard::IsLoaded() const
+{
+    return mLoaded;
+}
+
+void UBLeaderboard::Load(
+    const std::list<std::shared_ptr<objects::UBResult>>& results)
+{
+    Clear();
+
+    for(auto result : results)
+    {
+        Set(result);
+    }
+
+    mLoaded = true;
+}
+
+void UBLeaderboard::Set(const std::shared_ptr<objects::UBResult>& result)
+{
+    auto uuid = result->GetUUID().ToString();
+    uint32_t points = mGetPoints(result);
+
+    auto it = mEntries.find(uuid);
+    if(it != mEntries.end())
+    {
+        if(it->second.first == points && it->second.second == result)
+        {
+            // Nothing changed
+            return;
+        }
+
+        // Pull it from the previous point group
+        auto gIter = mPointGroups.find(it->second.first);
+        if(gIter != mPointGroups.end())
+        {
+            gIter->second.erase(it->second.second);
+            if(gIter->second.size() == 0)
+            {
+                mPointGroups.erase(gIter);
+            }
+        }
+    }
+
+    mEntries[uuid] = std::make_pair(points, result);
+    mPointGroups[points].insert(result);
+
+    // Track anything that already has a rank so it is cleared if it no
+    // longer qualifies
+    if(mGetRank(result) || mRanked.find(uuid) != mRanked.end())
+    {
+        mRanked[uuid] = result;
+    }
+}
+
+void UBLeaderboard::Remove(const std::shared_ptr<objects::UBResult>& result)
+{
+    auto uuid = result->GetUUID().ToString();
+
+    auto it = mEntries.find(uuid);
+    if(it != mEntries.end())
+    {
+        auto gIter = mPointGroups.find(it->second.first);
+        if(gIter != mPointGroups.end())
+        {
+            gIter->second.erase(it->second.second);
+            if(gIter->second.size() == 0)
+            {
+                mPointGroups.erase(gIter);
+            }
+        }
+
+        mEntries.erase(it);
+    }
+
+    mRanked.erase(uuid);
+}
+
+size_t UBLeaderboard::Size() const
+{
+    return mEntries.size();
+}
+
+std::set<std::shared_ptr<objects::UBResult>> UBLeaderboard::UpdateRanks()
+{
+    std::set<std::shared_ptr<objects::UBResult>> updated;
+    std::unordered_map<libcomp::String,
+        std::shared_ptr<objects::UBResult>> ranked;
+
+    uint8_t rank = 0;
+    for(auto& pair : mPointGroups)
+    {
+        if(rank >= mRankCount)
+        {
+            break;
+        }
+
+        rank = (uint8_t)(rank + 1);
+
+        for(auto result : pair.second)
+        {
+            if(mGetRank(result) != rank)
+            {
+                mSetRank(result, rank);
+                updated.insert(result);
+            }
+
+            ranked[result->GetUUID().ToString()] = result;
+        }
+    }
+
+    // Clear the rank on anything that dropped out
+    for(auto& pair : mRanked)
+    {
+        if(ranked.find(pair.first) == ranked.end() &&
+            mGetRank(pair.second))
+        {
+            mSetRank(pair.second, 0);
+            updated.insert(pair.second);
+        }
+    }
+
+    mRanked = ranked;
+
+    return updated;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file server/world/src/UBLeaderboard.h
+ * @ingroup world
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Incrementally maintained Ultimate Battle ranking board.
+ *
+ * This file is part of the World Server (world).
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SERVER_WORLD_SRC_UBLEADERBOARD_H
+#define SERVER_WORLD_SRC_UBLEADERBOARD_H
+
+// libcomp Includes
+#include <CString.h>
+
+// Standard C++11 Includes
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+
+namespace objects
+{
+class UBResult;
+}
+
+namespace world
+{
+
+/**
+ * Ranking of UBResult records by a single point value. Records are kept
+ * grouped by points in descending order so the top ranks can be read
+ * without sorting every record. Ranks are dense so records with the same
+ * points share a rank and only the configured number of distinct ranks
+ * are assigned, all others being rank 0. This class is not thread safe.
+ */
+class UBLeaderboard
+{
+public:
+    /// Function used to read the points a record is ranked by
+    typedef std::function<uint32_t(
+        const std::shared_ptr<objects::UBResult>&)> PointsGetter_t;
+
+    /// Function used to read the rank currently stored on a record
+    typedef std::function<uint8_t(
+        const std::shared_ptr<objects::UBResult>&)> RankGetter_t;
+
+    /// Function used to store a new rank on a record
+    typedef std::function<void(
+        const std::shared_ptr<objects::UBResult>&, uint8_t)> RankSetter_t;
+
+    /**
+     * Create a new leaderboard
+     * @param rankCount Number of distinct ranks to assign
+     * @param getPoints Function to read the points of a record
+     * @param getRank Function to read the stored rank of a record
+     * @param setRank Function to store the rank of a record
+     */
+    UBLeaderboard(uint8_t rankCount, const PointsGetter_t& getPoints,
+        const RankGetter_t& getRank, const RankSetter_t& setRank);
+
+    /**
+     * Remove all records from the leaderboard.
+     */
+    void Clear();
+
+    /**
+     * Check if the leaderboard has been seeded with records since it was
+     * created or last cleared.
+     * @return true if the leaderboard has been seeded
+     */
+    bool IsLoaded() const;
+
+    /**
+     * Replace the leaderboard contents with the supplied records, such as
+     * the full set loaded from the database.
+     * @param results List of records to rank
+     */
+    void Load(const std::list<std::shared_ptr<objects::UBResult>>& results);
+
+    /**
+     * Add a record to the leaderboard or move it if its points changed.
+     * @param result Pointer to the record
+     */
+    void Set(const std::shared_ptr<objects::UBResult>& result);
+
+    /**
+     * Remove a record from the leaderboard.
+     * @param result Pointer to the record
+     */
+    void Remove(const std::shared_ptr<objects::UBResult>& result);
+
+    /**
+     * Get the number of records on the leaderboard.
+     * @return Number of records on the leaderboard
+     */
+    size_t Size() const;
+
+    /**
+     * Assign the current ranks to all records that are ranked or were
+     * ranked the last time this was called. Only records in the ranked
+     * point groups are visited.
+     * @return Set of records whose stored rank changed
+     */
+    std::set<std::shared_ptr<objects::UBResult>> UpdateRanks();
+
+private:
+    /// Number of distinct ranks to assign
+    uint8_t mRankCount;
+
+    /// Function to read the points of a record
+    PointsGetter_t mGetPoints;
+
+    /// Function to read the stored rank of a record
+    RankGetter_t mGetRank;
+
+    /// Function to store the rank of a record
+    RankSetter_t mSetRank;
+
+    /// Indicates that the leaderboard has been seeded
+    bool mLoaded;
+
+    /// Records grouped by the points they were ranked with, highest first
+    std::map<uint32_t, std::set<std::shared_ptr<objects::UBResult>>,
+        std::greater<uint32_t>> mPointGroups;
+
+    /// Map of record UUID strings to the record and the points it is
+    /// currently grouped under
+    std::unordered_map<libcomp::String, std::pair<uint32_t,
+        std::shared_ptr<objects::UBResult>>> mEntries;
+
+    /// Map of record UUID strings to records with a non-zero stored rank
+    std::unordered_map<libcomp::String,
+        std::shared_ptr<objects::UBResult>> mRanked;
+};
+
+} // namespace world
+
+#endif // SERVER_WORLD_SRC_UBLEADERBOARD_H
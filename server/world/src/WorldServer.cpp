@@ -283,6 +283,7 @@ void WorldServer::RegisterChannel(
     // Register the channel connection with the sync manager and sync
     // existing records
     const std::set<std::string> channelSyncTypes = {
+            "ChannelPlacement",
             "CharacterLogin",
             "EventCounter",
             "InstanceAccess",
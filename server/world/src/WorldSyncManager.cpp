@@ -38,6 +38,8 @@
 // object Includes
 #include <Account.h>
 #include <ChannelLogin.h>
+#include <ChannelPlacement.h>
+#include <ChannelTelemetry.h>
 #include <Character.h>
 #include <CharacterLogin.h>
 #include <CharacterProgress.h>
@@ -62,11 +64,49 @@
 using namespace world;
 
 WorldSyncManager::WorldSyncManager(const std::weak_ptr<
-    WorldServer>& server) : mNextMatchID(0), mServer(server)
+    WorldServer>& server) : mUBTournamentRanking(10,
+        [](const std::shared_ptr<objects::UBResult>& r)
+        {
+            return r->GetPoints();
+        },
+        [](const std::shared_ptr<objects::UBResult>& r)
+        {
+            return r->GetTournamentRank();
+        },
+        [](const std::shared_ptr<objects::UBResult>& r, uint8_t rank)
+        {
+            r->SetTournamentRank(rank);
+        }),
+    mUBAllTimeRanking(10,
+        [](const std::shared_ptr<objects::UBResult>& r)
+        {
+            return r->GetPoints();
+        },
+        [](const std::shared_ptr<objects::UBResult>& r)
+        {
+            return r->GetAllTimeRank();
+        },
+        [](const std::shared_ptr<objects::UBResult>& r, uint8_t rank)
+        {
+            r->SetAllTimeRank(rank);
+        }),
+    mUBTopPointRanking(10,
+        [](const std::shared_ptr<objects::UBResult>& r)
+        {
+            return r->GetTopPoints();
+        },
+        [](const std::shared_ptr<objects::UBResult>& r)
+        {
+            return r->GetTopPointRank();
+        },
+        [](const std::shared_ptr<objects::UBResult>& r, uint8_t rank)
+        {
+            r->SetTopPointRank(rank);
+        }),
+    mNextMatchID(0), mSyncScheduled(false), mServer(server)
 {
     mPvPReadyTimes[0] = { { 0, 0 } };
     mPvPReadyTimes[1] = { { 0, 0 } };
-    mUBRecalcMin = { { 0, 0, 0 } };
 }
 
 WorldSyncManager::~WorldSyncManager()
@@ -93,6 +133,18 @@ bool WorldSyncManager::Initialize()
 
     mRegisteredTypes["Account"] = cfg;
 
+    cfg = std::make_shared<ObjectConfig>("ChannelPlacement", true);
+    cfg->BuildHandler = &DataSyncManager::New<objects::ChannelPlacement>;
+
+    mRegisteredTypes["ChannelPlacement"] = cfg;
+
+    cfg = std::make_shared<ObjectConfig>("ChannelTelemetry", false);
+    cfg->BuildHandler = &DataSyncManager::New<objects::ChannelTelemetry>;
+    cfg->UpdateHandler = &DataSyncManager::Update<WorldSyncManager,
+        objects::ChannelTelemetry>;
+
+    mRegisteredTypes["ChannelTelemetry"] = cfg;
+
     cfg = std::make_shared<ObjectConfig>("Character", true, worldDB);
     cfg->UpdateHandler = &DataSyncManager::Update<WorldSyncManager,
         objects::Character>;
@@ -335,6 +387,45 @@ int8_t WorldSyncManager::Update<objects::Account>(const libcomp::String& type,
     return SYNC_HANDLED;
 }
 
+template<>
+int8_t WorldSyncManager::Update<objects::ChannelTelemetry>(
+    const libcomp::String& type, const std::shared_ptr<libcomp::Object>& obj,
+    bool isRemove, const libcomp::String& source)
+{
+    (void)type;
+    (void)source;
+
+    auto entry = std::dynamic_pointer_cast<objects::ChannelTelemetry>(obj);
+    if(isRemove || !entry)
+    {
+        // Telemetry is only ever replaced, never removed by the channel
+        return SYNC_HANDLED;
+    }
+
+    mChannelTelemetry[entry->GetChannelID()] = entry;
+
+    auto server = mServer.lock();
+    if(UpdateChannelPlacement())
+    {
+        // Cannot sync while handling incoming records, queue it instead
+        server->QueueWork([](std::shared_ptr<WorldServer> pServer)
+        {
+            pServer->GetWorldSyncManager()->SyncChannelPlacement();
+        }, server);
+    }
+
+    // Relay to the lobby so it can be exposed through the API
+    auto lobbyConnection = server->GetLobbyConnection();
+    if(lobbyConnection)
+    {
+        libcomp::Packet p;
+        WriteOutgoingRecord(p, true, "ChannelTelemetry", entry);
+        lobbyConnection->SendPacket(p);
+    }
+
+    return SYNC_HANDLED;
+}
+
 template<>
 int8_t WorldSyncManager::Update<objects::Character>(const libcomp::String& type,
     const std::shared_ptr<libcomp::Object>& obj, bool isRemove,
@@ -906,16 +997,37 @@ void WorldSyncManager::SyncComplete<objects::UBResult>(
                 objPair.first);
             if(result->GetTournament().IsNull())
             {
-                if(result->GetPoints() >= mUBRecalcMin[1] ||
-                    result->GetTopPoints() >= mUBRecalcMin[2] ||
-                    result->GetRanked())
+                // Move the result within the all time rankings
+                if(objPair.second)
+                {
+                    mUBAllTimeRanking.Remove(result);
+                    mUBTopPointRanking.Remove(result);
+                }
+                else
                 {
-                    recalcRank = true;
+                    mUBAllTimeRanking.Set(result);
+                    mUBTopPointRanking.Set(result);
                 }
+
+                recalcRank = true;
             }
-            else if(result->GetPoints() >= mUBRecalcMin[0] ||
-                result->GetTournamentRank())
+            else
             {
+                // If the ranking is not loaded for the tournament yet, it
+                // will be when recalculated
+                if(mUBTournamentRanking.IsLoaded() && result->GetTournament()
+                    .GetUUID() == mUBTournamentRankingUID)
+                {
+                    if(objPair.second)
+                    {
+                        mUBTournamentRanking.Remove(result);
+                    }
+                    else
+                    {
+                        mUBTournamentRanking.Set(result);
+                    }
+                }
+
                 recalcTournament = true;
             }
         }
@@ -963,7 +1075,6 @@ void WorldSyncManager::SyncComplete<objects::UBTournament>(
         if(mUBTournament && mUBTournament->GetEndTime())
         {
             mUBTournament = nullptr;
-            mUBRecalcMin = { { 0, 0, 0 } };
         }
     }
 
@@ -1387,12 +1498,75 @@ bool WorldSyncManager::CleanUpCharacterLogin(int32_t worldCID, bool flushOutgoin
 
     if(result && flushOutgoing)
     {
-        SyncOutgoing();
+        ScheduleSyncOutgoing();
     }
 
     return result;
 }
 
+void WorldSyncManager::ScheduleSyncOutgoing()
+{
+    if(!mSyncScheduled.exchange(true))
+    {
+        auto server = mServer.lock();
+        server->QueueWork([](std::shared_ptr<WorldServer> pServer)
+        {
+            pServer->GetWorldSyncManager()->FlushScheduledSync();
+        }, server);
+    }
+}
+
+void WorldSyncManager::FlushScheduledSync()
+{
+    if(mSyncScheduled.exchange(false))
+    {
+        SyncOutgoing();
+    }
+}
+
+std::unordered_map<uint8_t, std::shared_ptr<objects::ChannelTelemetry>>
+    WorldSyncManager::GetChannelTelemetry()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    return mChannelTelemetry;
+}
+
+void WorldSyncManager::RemoveChannelTelemetry(uint8_t channelID)
+{
+    bool sync = false;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mChannelTelemetry.erase(channelID);
+
+        sync = UpdateChannelPlacement();
+    }
+
+    if(sync)
+    {
+        SyncChannelPlacement();
+    }
+}
+
+int8_t WorldSyncManager::GetPlacementChannel()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    return mChannelPlacement ? (int8_t)mChannelPlacement->GetChannelID() : -1;
+}
+
+void WorldSyncManager::SyncChannelPlacement()
+{
+    std::shared_ptr<objects::ChannelPlacement> placement;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        placement = mChannelPlacement;
+    }
+
+    if(placement && UpdateRecord(placement, "ChannelPlacement"))
+    {
+        SyncOutgoing();
+    }
+}
+
 void WorldSyncManager::SyncExistingChannelRecords(const std::shared_ptr<
     libcomp::InternalConnection>& connection)
 {
@@ -1457,6 +1631,14 @@ void WorldSyncManager::SyncExistingChannelRecords(const std::shared_ptr<
         QueueOutgoing("UBTournament", connection, records, blank);
     }
 
+    if(mChannelPlacement)
+    {
+        records.clear();
+        records.insert(mChannelPlacement);
+
+        QueueOutgoing("ChannelPlacement", connection, records, blank);
+    }
+
     connection->FlushOutgoing();
 }
 
@@ -2163,6 +2345,92 @@ bool WorldSyncManager::EndMatch(const std::shared_ptr<
     return true;
 }
 
+/**
+ * Calculate the relative load of a channel from its last telemetry report.
+ * Average tick time (in microseconds) is the base load with a penalty
+ * added for the ratio of ticks that overran the tick delta as well as for
+ * each connection and zone instance on the channel.
+ * @param telemetry Pointer to the channel telemetry
+ * @return Relative load of the channel
+ */
+static uint32_t CalculateChannelLoad(const std::shared_ptr<
+    objects::ChannelTelemetry>& telemetry)
+{
+    uint64_t load = (uint64_t)telemetry->GetTickAverage();
+
+    if(telemetry->GetTickCount())
+    {
+        // A channel overrunning every tick counts for a full tick delta
+        load = (uint64_t)(load + (uint64_t)telemetry->GetTickOverruns() *
+            100000ULL / (uint64_t)telemetry->GetTickCount());
+    }
+
+    load = (uint64_t)(load + (uint64_t)telemetry->GetConnectionCount() * 200 +
+        (uint64_t)telemetry->GetInstanceCount() * 1000);
+
+    return (uint32_t)std::min(load, (uint64_t)0xFFFFFFFF);
+}
+
+bool WorldSyncManager::UpdateChannelPlacement()
+{
+    auto config = std::dynamic_pointer_cast<objects::WorldConfig>(
+        mServer.lock()->GetConfig());
+    if(!config->GetChannelPlacement() || mChannelTelemetry.size() == 0)
+    {
+        return false;
+    }
+
+    auto placement = std::make_shared<objects::ChannelPlacement>();
+    placement->SetTimestamp((uint32_t)std::time(0));
+
+    int16_t bestID = -1;
+    uint32_t bestLoad = 0;
+    for(auto& pair : mChannelTelemetry)
+    {
+        uint32_t load = CalculateChannelLoad(pair.second);
+        placement->SetChannelLoads((uint32_t)pair.first, load);
+
+        if(bestID == -1 || load < bestLoad)
+        {
+            bestID = (int16_t)pair.first;
+            bestLoad = load;
+        }
+    }
+
+    int16_t currentID = mChannelPlacement
+        ? (int16_t)mChannelPlacement->GetChannelID() : -1;
+    if(currentID != -1 && currentID != bestID &&
+        placement->ChannelLoadsKeyExists((uint32_t)currentID))
+    {
+        // Stay on the current channel unless the least loaded one is
+        // sufficiently less loaded than it
+        uint64_t hysteresis = (uint64_t)std::min(
+            config->GetChannelPlacementHysteresis(), (uint8_t)100);
+        uint64_t currentLoad = (uint64_t)placement->GetChannelLoads(
+            (uint32_t)currentID);
+        if((uint64_t)bestLoad * 100 > currentLoad * (100 - hysteresis))
+        {
+            bestID = currentID;
+        }
+    }
+
+    placement->SetChannelID((uint8_t)bestID);
+    mChannelPlacement = placement;
+
+    if(currentID != bestID)
+    {
+        LogDataSyncManagerDebug([bestID, bestLoad]()
+        {
+            return libcomp::String("Channel placement moved to channel %1"
+                " with load %2\n").Arg(bestID).Arg(bestLoad);
+        });
+
+        return true;
+    }
+
+    return false;
+}
+
 bool WorldSyncManager::RecalculateTournamentRankings(
     const libobjgen::UUID& tournamentUID)
 {
@@ -2174,52 +2442,35 @@ bool WorldSyncManager::RecalculateTournamentRankings(
 
     auto server = mServer.lock();
 
-    auto results = objects::UBResult::LoadUBResultListByTournament(
-        server->GetWorldDatabase(), tournamentUID);
+    bool load = false;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        load = !mUBTournamentRanking.IsLoaded() ||
+            mUBTournamentRankingUID != tournamentUID;
+    }
 
-    results.sort([](
-        const std::shared_ptr<objects::UBResult>& a,
-        const std::shared_ptr<objects::UBResult>& b)
-        {
-            return a->GetPoints() > b->GetPoints();
-        });
+    // Only load the full result set once per tournament, after that the
+    // ranking is updated as results are synced
+    std::list<std::shared_ptr<objects::UBResult>> results;
+    if(load)
+    {
+        results = objects::UBResult::LoadUBResultListByTournament(
+            server->GetWorldDatabase(), tournamentUID);
+    }
 
-    std::list<std::shared_ptr<objects::UBResult>> updated;
+    bool exists = false;
+    std::set<std::shared_ptr<objects::UBResult>> updated;
     {
         std::lock_guard<std::mutex> lock(mLock);
 
-        mUBRecalcMin[0] = 0;
-
-        size_t idx = 0;
-        uint8_t rank = 0;
-        int32_t points = -1;
-        for(auto result : results)
+        if(load)
         {
-            if(rank <= 10 && points != (int32_t)result->GetPoints())
-            {
-                rank = (uint8_t)(rank + 1);
-                points = (int32_t)result->GetPoints();
-            }
-
-            if(rank <= 10)
-            {
-                if(result->GetTournamentRank() != rank)
-                {
-                    result->SetTournamentRank(rank);
-                    updated.push_back(result);
-                }
-            }
-            else if(result->GetTournamentRank())
-            {
-                result->SetTournamentRank(0);
-                updated.push_back(result);
-            }
-
-            if(idx++ == 10)
-            {
-                mUBRecalcMin[0] = (uint32_t)points;
-            }
+            mUBTournamentRanking.Load(results);
+            mUBTournamentRankingUID = tournamentUID;
         }
+
+        updated = mUBTournamentRanking.UpdateRanks();
+        exists = mUBTournamentRanking.Size() > 0;
     }
 
     if(updated.size() > 0)
@@ -2236,99 +2487,43 @@ bool WorldSyncManager::RecalculateTournamentRankings(
         server->GetWorldDatabase()->ProcessChangeSet(dbChanges);
     }
 
-    return results.size() > 0;
+    return exists;
 }
 
 bool WorldSyncManager::RecalculateUBRankings()
 {
     auto server = mServer.lock();
 
-    auto results = objects::UBResult::LoadUBResultListByTournament(
-        server->GetWorldDatabase(), NULLUUID);
-
-    std::set<std::shared_ptr<objects::UBResult>> updated;
+    bool load = false;
     {
         std::lock_guard<std::mutex> lock(mLock);
+        load = !mUBAllTimeRanking.IsLoaded();
+    }
 
-        mUBRecalcMin[1] = 0;
-        mUBRecalcMin[2] = 0;
+    // Only load the full result set once, after that the rankings are
+    // updated as results are synced
+    std::list<std::shared_ptr<objects::UBResult>> results;
+    if(load)
+    {
+        results = objects::UBResult::LoadUBResultListByTournament(
+            server->GetWorldDatabase(), NULLUUID);
+    }
 
-        // Calculate all time ranks
-        results.sort([](
-            const std::shared_ptr<objects::UBResult>& a,
-            const std::shared_ptr<objects::UBResult>& b)
-            {
-                return a->GetPoints() > b->GetPoints();
-            });
+    std::set<std::shared_ptr<objects::UBResult>> updated;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
 
-        size_t idx = 0;
-        uint8_t rank = 0;
-        int32_t points = -1;
-        for(auto result : results)
+        if(load)
         {
-            if(rank <= 10 && points != (int32_t)result->GetPoints())
-            {
-                rank = (uint8_t)(rank + 1);
-                points = (int32_t)result->GetPoints();
-            }
-
-            if(rank <= 10)
-            {
-                if(result->GetAllTimeRank() != rank)
-                {
-                    result->SetAllTimeRank(rank);
-                    updated.insert(result);
-                }
-            }
-            else if(result->GetAllTimeRank())
-            {
-                result->SetAllTimeRank(0);
-                updated.insert(result);
-            }
-
-            if(idx++ == 10)
-            {
-                mUBRecalcMin[1] = (uint32_t)points;
-            }
+            mUBAllTimeRanking.Load(results);
+            mUBTopPointRanking.Load(results);
         }
 
-        // Calculate top point ranks
-        results.sort([](
-            const std::shared_ptr<objects::UBResult>& a,
-            const std::shared_ptr<objects::UBResult>& b)
-            {
-                return a->GetTopPoints() > b->GetTopPoints();
-            });
-
-        idx = 0;
-        rank = 0;
-        points = -1;
-        for(auto result : results)
+        // Calculate all time ranks then top point ranks
+        updated = mUBAllTimeRanking.UpdateRanks();
+        for(auto update : mUBTopPointRanking.UpdateRanks())
         {
-            if(rank <= 10 && points != (int32_t)result->GetTopPoints())
-            {
-                rank = (uint8_t)(rank + 1);
-                points = (int32_t)result->GetPoints();
-            }
-
-            if(rank <= 10)
-            {
-                if(result->GetTopPointRank() != rank)
-                {
-                    result->SetTopPointRank(rank);
-                    updated.insert(result);
-                }
-            }
-            else if(result->GetTopPointRank())
-            {
-                result->SetTopPointRank(0);
-                updated.insert(result);
-            }
-
-            if(idx++ == 10)
-            {
-                mUBRecalcMin[2] = (uint32_t)points;
-            }
+            updated.insert(update);
         }
     }
 
@@ -35,9 +35,17 @@
 // object Includes
 #include <SearchEntry.h>
 
+// Standard C++11 Includes
+#include <atomic>
+
+// world Includes
+#include "UBLeaderboard.h"
+
 namespace objects
 {
 class ChannelLogin;
+class ChannelPlacement;
+class ChannelTelemetry;
 class Character;
 class InstanceAccess;
 class MatchEntry;
@@ -139,17 +147,59 @@ public:
      */
     std::shared_ptr<objects::MatchEntry> GetMatchEntry(int32_t worldCID);
 
+    /**
+     * Mark the queued outgoing records to be sent by a single queued work
+     * item instead of immediately. All records queued before that work
+     * runs are sent together and records updated more than once are only
+     * sent once.
+     */
+    void ScheduleSyncOutgoing();
+
+    /**
+     * Send all queued outgoing records if a sync was scheduled since the
+     * last call. This is queued as work by ScheduleSyncOutgoing.
+     */
+    void FlushScheduledSync();
+
     /**
      * Perform cleanup operations based upon a character logging off (or
      * logging on) based upon world level data being synchronized.
      * @param worldCID CID of the character logging off
-     * @param flushOutgoing Optional parameter to send any updates done
-     *  immediately
+     * @param flushOutgoing Optional parameter to schedule any updates done
+     *  to be sent
      * @return true if updates were performed during this operation
      */
     bool CleanUpCharacterLogin(int32_t worldCID,
         bool flushOutgoing = false);
 
+    /**
+     * Get the most recent telemetry record reported by each connected
+     * channel.
+     * @return Map of channel IDs to the last telemetry record received
+     */
+    std::unordered_map<uint8_t, std::shared_ptr<
+        objects::ChannelTelemetry>> GetChannelTelemetry();
+
+    /**
+     * Remove the telemetry record of a channel that has disconnected and
+     * recalculate the channel placement without it.
+     * @param channelID ID of the channel that disconnected
+     */
+    void RemoveChannelTelemetry(uint8_t channelID);
+
+    /**
+     * Get the channel currently selected for new placements based upon the
+     * load reported by each channel.
+     * @return ID of the least loaded channel or -1 if channel placement is
+     *  disabled or no channel has reported its load yet
+     */
+    int8_t GetPlacementChannel();
+
+    /**
+     * Send the current channel placement to all connected channels.
+     */
+    void SyncChannelPlacement();
+
     /**
      * Send all existing sync records to the specified connection.
      * @param connection Pointer to the connection
@@ -237,17 +287,30 @@ private:
     bool EndMatch(const std::shared_ptr<objects::PentalphaMatch>& match);
 
     /**
-     * Recalculate all rankings for a spectific UBTournament. This function is
-     * thread safe.
+     * Recalculate the channel placement from the current channel telemetry.
+     * The current placement channel is kept unless another channel is less
+     * loaded by more than the configured hysteresis percentage. The sync
+     * manager lock must already be held when calling this.
+     * @return true if the placement channel changed
+     */
+    bool UpdateChannelPlacement();
+
+    /**
+     * Recalculate all rankings for a spectific UBTournament. The tournament
+     * results are loaded from the database the first time this is called
+     * for a tournament and kept up to date as results are synced after
+     * that. This function is thread safe.
      * @param tournamentUID UID of the tournament to recalculate
-     * @return true if the rankings were updated, false if an error occurred
+     * @return true if any results exist for the tournament
      */
     bool RecalculateTournamentRankings(const libobjgen::UUID& tournamentUID);
 
     /**
-     * Recalculate all tournament independent UBResult rankings. This function
-     * is thread safe.
-     * @return true if the rankings were updated, false if an error occurred
+     * Recalculate all tournament independent UBResult rankings. The results
+     * are loaded from the database the first time this is called and kept
+     * up to date as results are synced after that. This function is thread
+     * safe.
+     * @return true if the rankings were updated
      */
     bool RecalculateUBRankings();
 
@@ -280,6 +343,13 @@ private:
     std::unordered_map<int32_t,
         std::pair<uint32_t, std::shared_ptr<objects::ChannelLogin>>> mRelogins;
 
+    /// Map of channel IDs to the last telemetry record they reported
+    std::unordered_map<uint8_t,
+        std::shared_ptr<objects::ChannelTelemetry>> mChannelTelemetry;
+
+    /// Current channel placement calculated from the channel telemetry
+    std::shared_ptr<objects::ChannelPlacement> mChannelPlacement;
+
     /// Map of character CIDs to queued match entries
     std::unordered_map<int32_t,
         std::shared_ptr<objects::MatchEntry>> mMatchEntries;
@@ -300,14 +370,25 @@ private:
     std::array<std::array<
         std::shared_ptr<objects::PvPMatch>, 2>, 2> mPvPPendingMatches;
 
-    /// Lowest points required to cause a recalculation of the current top
-    /// 10 UB total score, top total points and top all time points (in that
-    /// index order)
-    std::array<uint32_t, 3> mUBRecalcMin;
+    /// Top 10 ranking of the current UB tournament by points
+    UBLeaderboard mUBTournamentRanking;
+
+    /// UID of the tournament the tournament ranking was loaded for
+    libobjgen::UUID mUBTournamentRankingUID;
+
+    /// Top 10 all time UB ranking by total points
+    UBLeaderboard mUBAllTimeRanking;
+
+    /// Top 10 all time UB ranking by top points
+    UBLeaderboard mUBTopPointRanking;
 
     /// Next match ID to use for any matches prepared by the server
     uint32_t mNextMatchID;
 
+    /// Indicates that a work item to send the queued outgoing records has
+    /// been queued but has not run yet
+    std::atomic<bool> mSyncScheduled;
+
     /// Pointer to the channel server.
     std::weak_ptr<WorldServer> mServer;
 };
@@ -57,8 +57,9 @@ bool Parsers::DataSync::Parse(libcomp::ManagerPacket *pPacketManager,
         return false;
     }
 
-    // Sync any records that need to relay back
-    syncManager->SyncOutgoing();
+    // Relay any records that need to go back along with any others
+    // synced before the queued flush runs
+    syncManager->ScheduleSyncOutgoing();
 
     return true;
 }
@@ -99,10 +99,8 @@ void FriendRequest(std::shared_ptr<WorldServer> server,
     bool failed = !targetLogin || targetLogin->GetChannelID() < 0;
     if(!failed)
     {
-        auto worldDB = server->GetWorldDatabase();
-        auto sourceFSettings = objects::FriendSettings::LoadFriendSettingsByCharacter(
-            worldDB, cLogin->GetCharacter().GetUUID());
-        for(auto f : sourceFSettings->GetFriends())
+        for(auto f : characterManager->GetFriends(
+            cLogin->GetCharacter().GetUUID()))
         {
             if(f == targetLogin->GetCharacter().GetUUID())
             {
@@ -166,6 +164,22 @@ void FriendRequestAccepted(std::shared_ptr<WorldServer> server,
                 targetFSettings->AppendFriends(cLogin->GetCharacter().GetUUID());
                 failed = !sourceFSettings->Update(worldDB) ||
                     !targetFSettings->Update(worldDB);
+
+                // Keep the cached friend graph in sync with the database
+                if(!failed)
+                {
+                    characterManager->UpdateFriends(cLogin->GetCharacter()
+                        .GetUUID(), sourceFSettings->GetFriends());
+                    characterManager->UpdateFriends(targetLogin->GetCharacter()
+                        .GetUUID(), targetFSettings->GetFriends());
+                }
+                else
+                {
+                    characterManager->InvalidateFriends(cLogin->GetCharacter()
+                        .GetUUID());
+                    characterManager->InvalidateFriends(targetLogin
+                        ->GetCharacter().GetUUID());
+                }
             }
         }
         else
@@ -298,6 +312,21 @@ void FriendRemoved(std::shared_ptr<WorldServer> server,
 
             failed = !sourceFSettings->Update(worldDB) ||
                 !targetFSettings->Update(worldDB);
+
+            // Keep the cached friend graph in sync with the database
+            auto characterManager = server->GetCharacterManager();
+            if(!failed)
+            {
+                characterManager->UpdateFriends(sourceUUID,
+                    sourceFSettings->GetFriends());
+                characterManager->UpdateFriends(targetUUID,
+                    targetFSettings->GetFriends());
+            }
+            else
+            {
+                characterManager->InvalidateFriends(sourceUUID);
+                characterManager->InvalidateFriends(targetUUID);
+            }
         }
         else
         {
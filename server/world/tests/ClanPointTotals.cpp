@@ -0,0 +1,352 @@
+/**
+ * @file server/world/tests/ClanPointTotals.cpp
+ * @ingroup world
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Test running clan point totals against a full reload.
+ *
+ * This file is part of the World Server (world).
+ *
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+#include <PopIgnore.h>
+
+// world Includes
+#include <ClanPointTotals.h>
+
+// Standard C++11 Includes
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace world;
+
+typedef ClanPointTotals::MemberPoints MemberPoints;
+
+namespace
+{
+
+/// Seconds a running total is trusted for in the tests
+const uint32_t MAX_AGE = 3600;
+
+/**
+ * Sum of the points of every member, what a full reload with nothing
+ * changing at the same time would find.
+ */
+uint64_t FullReload(const MemberPoints& members)
+{
+    uint64_t total = 0;
+    for(auto& pair : members)
+    {
+        total = (uint64_t)(total + (uint64_t)pair.second);
+    }
+
+    return total;
+}
+
+/**
+ * Clan members as stored in the database along with a random member
+ * change generator.
+ */
+class Clan
+{
+public:
+    Clan(int32_t clanID, uint32_t seed) : mClanID(clanID), mRng(seed),
+        mNextMember(0)
+    {
+    }
+
+    /**
+     * Make a random join, leave or point change, applying it to both the
+     * stored members and the running totals.
+     * @return UUID of the member changed
+     */
+    libcomp::String Change(ClanPointTotals& totals)
+    {
+        std::uniform_int_distribution<int> kindDist(0, 9);
+        std::uniform_int_distribution<int32_t> pointDist(0, 5000);
+
+        int kind = kindDist(mRng);
+        if(Members.size() == 0 || kind < 3)
+        {
+            // Join
+            libcomp::String uuid = libcomp::String("member-%1-%2")
+                .Arg(mClanID).Arg(mNextMember++);
+            Members[uuid] = pointDist(mRng);
+            totals.SetMemberPoints(mClanID, uuid, Members[uuid]);
+
+            return uuid;
+        }
+
+        std::uniform_int_distribution<size_t> memberDist(0,
+            Members.size() - 1);
+        auto it = Members.begin();
+        std::advance(it, (long)memberDist(mRng));
+        libcomp::String uuid = it->first;
+
+        if(kind < 5)
+        {
+            // Leave
+            Members.erase(it);
+            totals.RemoveMember(mClanID, uuid);
+        }
+        else
+        {
+            // Daily login points
+            it->second = (int32_t)(it->second + pointDist(mRng) / 50);
+            totals.SetMemberPoints(mClanID, uuid, it->second);
+        }
+
+        return uuid;
+    }
+
+    int32_t mClanID;
+    std::mt19937 mRng;
+    uint32_t mNextMember;
+    MemberPoints Members;
+};
+
+/**
+ * Load running concurrently with member changes. Each member is read at
+ * some point while the load runs so it can see any state the member was
+ * in between the start and end of the load.
+ */
+class Load
+{
+public:
+    Load(ClanPointTotals& totals, const Clan& clan) :
+        Token(totals.BeginLoad(clan.mClanID))
+    {
+        for(auto& pair : clan.Members)
+        {
+            States[pair.first].push_back(std::make_pair(true, pair.second));
+        }
+    }
+
+    void Changed(const Clan& clan, const libcomp::String& uuid)
+    {
+        auto& states = States[uuid];
+        if(states.size() == 0)
+        {
+            // Joined after the load started so it may not be seen at all
+            states.push_back(std::make_pair(false, 0));
+        }
+
+        auto it = clan.Members.find(uuid);
+        states.push_back(it != clan.Members.end()
+            ? std::make_pair(true, it->second) : std::make_pair(false, 0));
+    }
+
+    MemberPoints Read(std::mt19937& rng) const
+    {
+        MemberPoints loaded;
+        for(auto& pair : States)
+        {
+            std::uniform_int_distribution<size_t> dist(0,
+                pair.second.size() - 1);
+            auto& state = pair.second[dist(rng)];
+            if(state.first)
+            {
+                loaded[pair.first] = state.second;
+            }
+        }
+
+        return loaded;
+    }
+
+    size_t Token;
+    std::map<libcomp::String, std::vector<std::pair<bool, int32_t>>> States;
+};
+
+} // namespace
+
+TEST(ClanPointTotals, DeltasMatchFullReload)
+{
+    ClanPointTotals totals;
+
+    std::vector<Clan> clans;
+    for(int32_t clanID = 1; clanID <= 8; clanID++)
+    {
+        clans.push_back(Clan(clanID, (uint32_t)clanID));
+    }
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> clanDist(0, clans.size() - 1);
+
+    uint32_t now = 0;
+    for(int step = 0; step < 20000; step++)
+    {
+        auto& clan = clans[clanDist(rng)];
+
+        uint64_t total = 0;
+        if(!totals.GetTotal(clan.mClanID, now, MAX_AGE, total))
+        {
+            // Load without anything changing
+            size_t token = totals.BeginLoad(clan.mClanID);
+
+            uint64_t previous = 0;
+            total = totals.FinishLoad(clan.mClanID, token, clan.Members,
+                now, previous);
+        }
+
+        ASSERT_EQ(FullReload(clan.Members), total) << "step " << step;
+
+        clan.Change(totals);
+
+        ASSERT_TRUE(totals.GetTotal(clan.mClanID, now, MAX_AGE, total));
+        ASSERT_EQ(FullReload(clan.Members), total) << "step " << step;
+
+        now += 1;
+    }
+}
+
+TEST(ClanPointTotals, ChangesDuringLoadAreKept)
+{
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> changeDist(0, 6);
+    std::uniform_int_distribution<int> coinDist(0, 1);
+
+    for(int run = 0; run < 2000; run++)
+    {
+        ClanPointTotals totals;
+        Clan clan(1, (uint32_t)run);
+
+        // Some members exist before anything is loaded
+        int initial = changeDist(rng);
+        for(int i = 0; i < initial; i++)
+        {
+            clan.Change(totals);
+        }
+
+        bool loadedFirst = coinDist(rng) == 1;
+        if(loadedFirst)
+        {
+            uint64_t previous = 0;
+            totals.FinishLoad(1, totals.BeginLoad(1), clan.Members, 0,
+                previous);
+        }
+
+        // Two overlapping loads with changes before, between and after
+        Load first(totals, clan);
+
+        int changes = changeDist(rng);
+        for(int i = 0; i < changes; i++)
+        {
+            first.Changed(clan, clan.Change(totals));
+        }
+
+        Load second(totals, clan);
+
+        changes = changeDist(rng);
+        for(int i = 0; i < changes; i++)
+        {
+            auto uuid = clan.Change(totals);
+            first.Changed(clan, uuid);
+            second.Changed(clan, uuid);
+        }
+
+        uint64_t previous = 0;
+        uint64_t total = totals.FinishLoad(1, first.Token, first.Read(rng),
+            MAX_AGE, previous);
+        ASSERT_EQ(FullReload(clan.Members), total) << "run " << run;
+
+        changes = changeDist(rng);
+        for(int i = 0; i < changes; i++)
+        {
+            second.Changed(clan, clan.Change(totals));
+        }
+
+        total = totals.FinishLoad(1, second.Token, second.Read(rng),
+            MAX_AGE, previous);
+        ASSERT_EQ(FullReload(clan.Members), total) << "run " << run;
+
+        // Deltas after the loads finish keep matching
+        changes = changeDist(rng);
+        for(int i = 0; i < changes; i++)
+        {
+            clan.Change(totals);
+        }
+
+        ASSERT_TRUE(totals.GetTotal(1, MAX_AGE, MAX_AGE, total));
+        ASSERT_EQ(FullReload(clan.Members), total) << "run " << run;
+    }
+}
+
+TEST(ClanPointTotals, ReloadAfterMaxAge)
+{
+    ClanPointTotals totals;
+    MemberPoints members;
+    members["a"] = 100;
+    members["b"] = 200;
+
+    uint64_t total = 0;
+    EXPECT_FALSE(totals.GetTotal(1, 0, MAX_AGE, total));
+
+    // Changes before the first load are left to the load
+    totals.SetMemberPoints(1, "c", 50);
+
+    uint64_t previous = 0;
+    EXPECT_EQ(300u, totals.FinishLoad(1, totals.BeginLoad(1), members, 10,
+        previous));
+    EXPECT_EQ(300u, previous);
+
+    EXPECT_TRUE(totals.GetTotal(1, 10 + MAX_AGE - 1, MAX_AGE, total));
+    EXPECT_EQ(300u, total);
+    EXPECT_FALSE(totals.GetTotal(1, 10 + MAX_AGE, MAX_AGE, total));
+
+    // A change made outside of the tracked paths is corrected
+    members["a"] = 150;
+    EXPECT_EQ(350u, totals.FinishLoad(1, totals.BeginLoad(1), members,
+        10 + MAX_AGE, previous));
+    EXPECT_EQ(300u, previous);
+}
+
+TEST(ClanPointTotals, RemovedWhileLoading)
+{
+    ClanPointTotals totals;
+    MemberPoints members;
+    members["a"] = 100;
+
+    uint64_t previous = 0;
+    totals.FinishLoad(1, totals.BeginLoad(1), members, 0, previous);
+
+    size_t token = totals.BeginLoad(1);
+    totals.RemoveClan(1);
+    totals.SetMemberPoints(1, "a", 200);
+
+    EXPECT_EQ(0u, totals.FinishLoad(1, token, members, 0, previous));
+
+    // The load did not add the removed clan back
+    uint64_t total = 0;
+    EXPECT_FALSE(totals.GetTotal(1, 0, MAX_AGE, total));
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
@@ -25,12 +25,21 @@
  */
 
 // Standard C++11 Includes
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 // libcomp Includes
 #include <BinaryDataSet.h>
+#include <Crypto.h>
+#include <DataStore.h>
 #include <Log.h>
 #include <Object.h>
 
@@ -164,12 +173,47 @@
 #include <tinyxml2.h>
 #include <PopIgnore.h>
 
-int Usage(const char *szAppName, const std::map<std::string,
-    std::pair<std::string, std::function<libcomp::BinaryDataSet*(void)>>>& binaryTypes)
+// Qt Includes
+#include <QDir>
+#include <QFileInfo>
+
+typedef std::map<std::string, std::pair<std::string,
+    std::function<libcomp::BinaryDataSet*(void)>>> BinaryTypeMap_t;
+
+/**
+ * File converted as part of a bulk run.
+ */
+class BulkFile
+{
+public:
+    /// Path of the file relative to the input directory
+    libcomp::String relPath;
+
+    /// Absolute path of the input file
+    libcomp::String inPath;
+
+    /// Absolute path of the output file
+    libcomp::String outPath;
+
+    /// Format of the BinaryData file
+    std::string bdType;
+
+    /// MD5 hash of the input file contents
+    libcomp::String hash;
+
+    /// Indicates the file was converted or skipped without errors
+    bool success = false;
+};
+
+int Usage(const char *szAppName, const BinaryTypeMap_t& binaryTypes)
 {
     std::cerr << "USAGE: " << szAppName << " load TYPE IN OUT" << std::endl;
     std::cerr << "USAGE: " << szAppName << " save TYPE IN OUT" << std::endl;
     std::cerr << "USAGE: " << szAppName << " flatten TYPE IN OUT" << std::endl;
+    std::cerr << "USAGE: " << szAppName << " bulkload IN_DIR OUT_DIR "
+        "[MANIFEST]" << std::endl;
+    std::cerr << "USAGE: " << szAppName << " bulksave IN_DIR OUT_DIR "
+        "[MANIFEST]" << std::endl;
     std::cerr << std::endl;
     std::cerr << "TYPE indicates the format of the BinaryData and can "
         << "be one of:" << std::endl;
@@ -185,10 +229,304 @@ int Usage(const char *szAppName, const std::map<std::string,
     std::cerr << std::endl;
     std::cerr << "Mode 'save' will take the input XML file and "
         << "write the output BinaryData file." << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "Modes 'bulkload' and 'bulksave' convert every file in "
+        << "the input directory with a known BinaryData file name (plus "
+        << "'.xml' for 'bulksave') in parallel, detecting the TYPE from "
+        << "the file name. If a MANIFEST is specified, files whose content "
+        << "hash matches the previous run are skipped and the manifest is "
+        << "rewritten when done." << std::endl;
 
     return EXIT_FAILURE;
 }
 
+bool ConvertFile(const libcomp::String& mode, libcomp::BinaryDataSet *pSet,
+    const char *szInPath, const char *szOutPath, libcomp::String& error)
+{
+    if("load" == mode || "flatten" == mode)
+    {
+        std::ifstream file;
+        file.open(szInPath, std::ifstream::binary);
+
+        if(!pSet->Load(file))
+        {
+            error = libcomp::String("Failed to load file: %1").Arg(szInPath);
+
+            return false;
+        }
+
+        std::ofstream out;
+        out.open(szOutPath);
+
+        if("load" == mode)
+        {
+            out << pSet->GetXml().c_str();
+        }
+        else
+        {
+            out << pSet->GetTabular().c_str();
+        }
+
+        if(!out.good())
+        {
+            error = libcomp::String("Failed to save file: %1").Arg(szOutPath);
+
+            return false;
+        }
+    }
+    else if("save" == mode)
+    {
+        tinyxml2::XMLDocument doc;
+
+        if(tinyxml2::XML_SUCCESS != doc.LoadFile(szInPath))
+        {
+            error = libcomp::String("Failed to parse file: %1").Arg(szInPath);
+
+            return false;
+        }
+
+        if(!pSet->LoadXml(doc))
+        {
+            error = libcomp::String("Failed to load file: %1").Arg(szInPath);
+
+            return false;
+        }
+
+        std::ofstream out;
+        out.open(szOutPath, std::ofstream::binary);
+
+        if(!pSet->Save(out))
+        {
+            error = libcomp::String("Failed to save file: %1").Arg(szOutPath);
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string LowerCase(std::string s)
+{
+    std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+
+    return s;
+}
+
+std::unordered_map<std::string, libcomp::String> LoadManifest(
+    const libcomp::String& path)
+{
+    std::unordered_map<std::string, libcomp::String> manifest;
+
+    auto data = libcomp::Crypto::LoadFile(path.ToUtf8());
+    if(data.empty())
+    {
+        return manifest;
+    }
+
+    // Each line is the MD5 hash of the input file and its relative path
+    for(auto line : libcomp::String(&data[0], data.size()).Split("\n"))
+    {
+        line = line.Trimmed();
+
+        if(line.Length() > 33)
+        {
+            manifest[line.Mid(33).ToUtf8()] = line.Left(32).ToUpper();
+        }
+    }
+
+    return manifest;
+}
+
+int BulkConvert(const libcomp::String& mode, const libcomp::String& inDir,
+    const libcomp::String& outDir, const libcomp::String& manifestPath,
+    const BinaryTypeMap_t& binaryTypes)
+{
+    bool toXml = "load" == mode;
+
+    // Map the file name from each type description to the type
+    std::unordered_map<std::string, std::string> fileTypes;
+    for(auto& typ : binaryTypes)
+    {
+        static const std::string prefix = "Format for ";
+
+        auto pos = typ.second.first.find(prefix);
+        if(std::string::npos != pos)
+        {
+            auto fileName = LowerCase(typ.second.first.substr(
+                pos + prefix.size()));
+            if(toXml)
+            {
+                fileTypes[fileName] = typ.first;
+            }
+            else
+            {
+                fileTypes[fileName + ".xml"] = typ.first;
+            }
+        }
+    }
+
+    std::list<libcomp::String> files;
+    std::list<libcomp::String> dirs;
+    std::list<libcomp::String> symLinks;
+
+    libcomp::DataStore store(NULL);
+
+    if(!store.AddSearchPath(inDir) ||
+        !store.GetListing("/", files, dirs, symLinks, true, true))
+    {
+        std::cerr << "Failed to read directory: " << inDir.C() << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    std::vector<BulkFile> work;
+    for(auto file : files)
+    {
+        libcomp::String relPath = file.Mid(1);
+        auto fileName = LowerCase(QFileInfo(QString::fromUtf8(
+            relPath.C())).fileName().toStdString());
+
+        auto it = fileTypes.find(fileName);
+        if(fileTypes.end() == it)
+        {
+            continue;
+        }
+
+        BulkFile bulkFile;
+        bulkFile.relPath = relPath;
+        bulkFile.inPath = inDir + file;
+        bulkFile.bdType = it->second;
+
+        if(toXml)
+        {
+            bulkFile.outPath = libcomp::String("%1/%2.xml").Arg(outDir).Arg(
+                relPath);
+        }
+        else
+        {
+            bulkFile.outPath = libcomp::String("%1/%2").Arg(outDir).Arg(
+                relPath.Left(relPath.Length() - 4));
+        }
+
+        work.push_back(bulkFile);
+    }
+
+    auto manifest = manifestPath.IsEmpty()
+        ? std::unordered_map<std::string, libcomp::String>()
+        : LoadManifest(manifestPath);
+
+    std::atomic<size_t> nextFile(0);
+    std::atomic<size_t> converted(0);
+    std::atomic<size_t> skipped(0);
+    std::mutex outputLock;
+
+    auto worker = [&]()
+    {
+        for(size_t i = nextFile++; i < work.size(); i = nextFile++)
+        {
+            auto& bulkFile = work[i];
+
+            // Only one file's contents and objects are held per worker
+            {
+                auto data = libcomp::Crypto::LoadFile(
+                    bulkFile.inPath.ToUtf8());
+                if(!data.empty())
+                {
+                    bulkFile.hash = libcomp::Crypto::MD5(data).ToUpper();
+                }
+            }
+
+            auto it = manifest.find(bulkFile.relPath.ToUtf8());
+            if(!bulkFile.hash.IsEmpty() && manifest.end() != it &&
+                it->second == bulkFile.hash &&
+                QFileInfo(QString::fromUtf8(bulkFile.outPath.C())).exists())
+            {
+                // Unchanged since the last run
+                bulkFile.success = true;
+                skipped++;
+
+                continue;
+            }
+
+            QDir().mkpath(QFileInfo(QString::fromUtf8(
+                bulkFile.outPath.C())).absolutePath());
+
+            std::unique_ptr<libcomp::BinaryDataSet> pSet(
+                (binaryTypes.at(bulkFile.bdType).second)());
+
+            libcomp::String error;
+            bulkFile.success = ConvertFile(mode, pSet.get(),
+                bulkFile.inPath.C(), bulkFile.outPath.C(), error);
+
+            std::lock_guard<std::mutex> lock(outputLock);
+            if(bulkFile.success)
+            {
+                converted++;
+
+                std::cout << bulkFile.relPath.C() << std::endl;
+            }
+            else
+            {
+                std::cerr << error.C() << std::endl;
+            }
+        }
+    };
+
+    std::list<std::thread*> threads;
+
+    uint32_t threadCount = std::max(1U, std::thread::hardware_concurrency());
+    for(uint32_t i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(new std::thread(worker));
+    }
+
+    for(auto thread : threads)
+    {
+        thread->join();
+
+        delete thread;
+    }
+
+    bool failed = false;
+    for(auto& bulkFile : work)
+    {
+        if(!bulkFile.success)
+        {
+            failed = true;
+        }
+    }
+
+    if(!manifestPath.IsEmpty())
+    {
+        // Only record files that are known to be up to date
+        std::ofstream out;
+        out.open(manifestPath.C(), std::ofstream::binary);
+
+        for(auto& bulkFile : work)
+        {
+            if(bulkFile.success && !bulkFile.hash.IsEmpty())
+            {
+                out << bulkFile.hash.C() << " " << bulkFile.relPath.C()
+                    << std::endl;
+            }
+        }
+
+        if(!out.good())
+        {
+            std::cerr << "Failed to save manifest: " << manifestPath.C()
+                << std::endl;
+
+            failed = true;
+        }
+    }
+
+    std::cout << "Converted " << converted << " and skipped " << skipped
+        << " of " << work.size() << " files." << std::endl;
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
 #define ADD_TYPE(desc, key, objname) \
     binaryTypes[key] = std::make_pair(desc, []() \
     { \
@@ -246,8 +584,7 @@ int Usage(const char *szAppName, const std::map<std::string,
 
 int main(int argc, char *argv[])
 {
-    std::map<std::string, std::pair<std::string,
-        std::function<libcomp::BinaryDataSet*(void)>>> binaryTypes;
+    BinaryTypeMap_t binaryTypes;
 
     ADD_TYPE    ("  ai                    Format for AIData.sbin", "ai", MiAIData);
     ADD_TYPE    ("  bazaarclerknpc        Format for BazaarClerkNPCData.sbin", "bazaarclerknpc", MiBazaarClerkNPCData);
@@ -350,6 +687,27 @@ int main(int argc, char *argv[])
     ADD_TYPE_SEQ("  modexteffect          Format for ModificationExtEffectData.sbin", "modexteffect", MiModificationExtEffectData);
     ADD_TYPE_SEQ("  urafieldtower         Format for UraFieldTowerData.sbin", "urafieldtower", MiUraFieldTowerData);
 
+    if(2 < argc && ("bulkload" == libcomp::String(argv[1]) ||
+        "bulksave" == libcomp::String(argv[1])))
+    {
+        if(4 != argc && 5 != argc)
+        {
+            return Usage(argv[0], binaryTypes);
+        }
+
+        libcomp::Log::GetSingletonPtr()->AddStandardOutputHook();
+
+        int result = BulkConvert(libcomp::String(argv[1]).Mid(4), argv[2],
+            argv[3], 5 == argc ? argv[4] : "", binaryTypes);
+
+#ifndef EXOTIC_PLATFORM
+        // Stop the logger
+        delete libcomp::Log::GetSingletonPtr();
+#endif // !EXOTIC_PLATFORM
+
+        return result;
+    }
+
     if(5 != argc)
     {
         return Usage(argv[0], binaryTypes);
@@ -381,81 +739,13 @@ int main(int argc, char *argv[])
         return Usage(argv[0], binaryTypes);
     }
 
-    if("load" == mode)
-    {
-        std::ifstream file;
-        file.open(szInPath, std::ifstream::binary);
-
-        if(!pSet->Load(file))
-        {
-            std::cerr << "Failed to load file: " << szInPath << std::endl;
-
-            return EXIT_FAILURE;
-        }
-
-        std::ofstream out;
-        out.open(szOutPath);
-
-        out << pSet->GetXml().c_str();
-
-        if(!out.good())
-        {
-            std::cerr << "Failed to save file: " << szOutPath << std::endl;
-
-            return EXIT_FAILURE;
-        }
-    }
-    else if("flatten" == mode)
-    {
-        std::ifstream file;
-        file.open(szInPath, std::ifstream::binary);
-
-        if(!pSet->Load(file))
-        {
-            std::cerr << "Failed to load file: " << szInPath << std::endl;
-
-            return EXIT_FAILURE;
-        }
-
-        std::ofstream out;
-        out.open(szOutPath);
+    libcomp::String error;
 
-        out << pSet->GetTabular().c_str();
-
-        if(!out.good())
-        {
-            std::cerr << "Failed to save file: " << szOutPath << std::endl;
-
-            return EXIT_FAILURE;
-        }
-    }
-    else if("save" == mode)
+    if(!ConvertFile(mode, pSet, szInPath, szOutPath, error))
     {
-        tinyxml2::XMLDocument doc;
-
-        if(tinyxml2::XML_SUCCESS != doc.LoadFile(szInPath))
-        {
-            std::cerr << "Failed to parse file: " << szInPath << std::endl;
-
-            return EXIT_FAILURE;
-        }
+        std::cerr << error.C() << std::endl;
 
-        if(!pSet->LoadXml(doc))
-        {
-            std::cerr << "Failed to load file: " << szInPath << std::endl;
-
-            return EXIT_FAILURE;
-        }
-
-        std::ofstream out;
-        out.open(szOutPath, std::ofstream::binary);
-
-        if(!pSet->Save(out))
-        {
-            std::cerr << "Failed to save file: " << szOutPath << std::endl;
-
-            return EXIT_FAILURE;
-        }
+        return EXIT_FAILURE;
     }
 
 #ifndef EXOTIC_PLATFORM
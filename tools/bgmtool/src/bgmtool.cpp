@@ -22,7 +22,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <algorithm>
+// cryptstream Includes
+#include <BatchTransform.h>
+#include <CryptStream.h>
+
+// Standard C++11 Includes
 #include <cstdio>
 #include <cstdlib>
 #include <stdint.h>
@@ -68,8 +72,7 @@
  */
 int EncryptFile(const char *szIn, const char *szOut)
 {
-    FILE *pIn = fopen(szIn, "rb");
-    FILE *pOut = fopen(szOut, "wb");
+    auto pIn = cryptstream::OpenFile(szIn, "rb");
 
     if(!pIn)
     {
@@ -78,28 +81,23 @@ int EncryptFile(const char *szIn, const char *szOut)
         return EXIT_FAILURE;
     }
 
-    if(!pOut)
-    {
-        fprintf(stderr, "Failed to open input file.\n");
-
-        return EXIT_FAILURE;
-    }
+    // Get the size of the file and calculate the XOR key.
+    uint64_t sz = 0;
 
-    if(0 != fseek(pIn, 0, SEEK_END))
+    if(!cryptstream::RemainingSize(pIn.get(), sz))
     {
         fprintf(stderr, "Seek error in input file.\n");
 
         return EXIT_FAILURE;
     }
 
-    // Get the size of the file and calculate the XOR key.
-    uint32_t sz = (uint32_t)ftell(pIn);
-    uint32_t key = sz ^ BGM_XOR_KEY;
+    uint32_t key = (uint32_t)sz ^ BGM_XOR_KEY;
+
+    auto pOut = cryptstream::OpenFile(szOut, "wb");
 
-    // Start over now that we have the key
-    if(0 != fseek(pIn, 0, SEEK_SET))
+    if(!pOut)
     {
-        fprintf(stderr, "Seek error in input file.\n");
+        fprintf(stderr, "Failed to open output file.\n");
 
         return EXIT_FAILURE;
     }
@@ -107,7 +105,7 @@ int EncryptFile(const char *szIn, const char *szOut)
     // Write the magic.
     uint32_t magic = BGM_MAGIC;
 
-    if(1 != fwrite(&magic, 4, 1, pOut))
+    if(1 != fwrite(&magic, 4, 1, pOut.get()))
     {
         fprintf(stderr, "Failed to write output file.\n");
 
@@ -115,35 +113,15 @@ int EncryptFile(const char *szIn, const char *szOut)
     }
 
     // Write the output file contents.
-    while(sz)
-    {
-        uint32_t buffer = 0;
-        uint32_t chunk = std::min((uint32_t)4, sz);
-
-        if(1 != fread(&buffer, chunk, 1, pIn))
-        {
-            fprintf(stderr, "Failed to read input file.\n");
-
-            return EXIT_FAILURE;
-        }
-
-        // Encrypt the dword.
-        buffer ^= key;
-
-        if(1 != fwrite(&buffer, chunk, 1, pOut))
+    if(!cryptstream::TransformStream(pIn.get(), pOut.get(), sz,
+        [key](uint8_t *pData, size_t size, uint64_t offset)
         {
-            fprintf(stderr, "Failed to write output file.\n");
-
-            return EXIT_FAILURE;
-        }
-
-        sz -= chunk;
+            cryptstream::XorKey32(pData, size, key, offset);
+        }))
+    {
+        return EXIT_FAILURE;
     }
 
-    // Close the files and cleanup.
-    fclose(pIn);
-    fclose(pOut);
-
     return EXIT_SUCCESS;
 }
 
@@ -155,8 +133,7 @@ int EncryptFile(const char *szIn, const char *szOut)
  */
 int DecryptFile(const char *szIn, const char *szOut)
 {
-    FILE *pIn = fopen(szIn, "rb");
-    FILE *pOut = fopen(szOut, "wb");
+    auto pIn = cryptstream::OpenFile(szIn, "rb");
 
     if(!pIn)
     {
@@ -165,19 +142,14 @@ int DecryptFile(const char *szIn, const char *szOut)
         return EXIT_FAILURE;
     }
 
-    if(!pOut)
-    {
-        fprintf(stderr, "Failed to open input file.\n");
-
-        return EXIT_FAILURE;
-    }
-
     // Read and check the magic is correct.
     uint32_t magic = 0;
 
-    if(1 != fread(&magic, 4, 1, pIn))
+    if(1 != fread(&magic, 4, 1, pIn.get()))
     {
         fprintf(stderr, "Failed to read input file.\n");
+
+        return EXIT_FAILURE;
     }
 
     if(BGM_MAGIC != magic)
@@ -187,69 +159,63 @@ int DecryptFile(const char *szIn, const char *szOut)
         return EXIT_FAILURE;
     }
 
-    if(0 != fseek(pIn, 0, SEEK_END))
+    // Get the size of the file (without the magic) and calculate the key.
+    uint64_t sz = 0;
+
+    if(!cryptstream::RemainingSize(pIn.get(), sz))
     {
         fprintf(stderr, "Seek error in input file.\n");
 
         return EXIT_FAILURE;
     }
 
-    // Get the size of the file and calculate the XOR key.
-    uint32_t sz = (uint32_t)ftell(pIn);
-    uint32_t key = (sz - 4) ^ BGM_XOR_KEY;
+    uint32_t key = (uint32_t)sz ^ BGM_XOR_KEY;
 
-    // Start over now that we have the key
-    if(0 != fseek(pIn, 4, SEEK_SET))
+    auto pOut = cryptstream::OpenFile(szOut, "wb");
+
+    if(!pOut)
     {
-        fprintf(stderr, "Seek error in input file.\n");
+        fprintf(stderr, "Failed to open output file.\n");
 
         return EXIT_FAILURE;
     }
 
-    // We don't read the magic as part of the file.
-    sz -= 4;
-
     // Write the output file contents.
-    while(sz)
-    {
-        uint32_t buffer = 0;
-        uint32_t chunk = std::min((uint32_t)4, sz);
-
-        if(1 != fread(&buffer, chunk, 1, pIn))
-        {
-            fprintf(stderr, "Failed to read input file.\n");
-
-            return EXIT_FAILURE;
-        }
-
-        // Encrypt the dword.
-        buffer ^= key;
-
-        if(1 != fwrite(&buffer, chunk, 1, pOut))
+    if(!cryptstream::TransformStream(pIn.get(), pOut.get(), sz,
+        [key](uint8_t *pData, size_t size, uint64_t offset)
         {
-            fprintf(stderr, "Failed to write output file.\n");
-
-            return EXIT_FAILURE;
-        }
-
-        sz -= chunk;
+            cryptstream::XorKey32(pData, size, key, offset);
+        }))
+    {
+        return EXIT_FAILURE;
     }
 
-    // Close the files and cleanup.
-    fclose(pIn);
-    fclose(pOut);
-
     return EXIT_SUCCESS;
 }
 
 /**
- * Encrypt or decrypt a background music file.
+ * Encrypt or decrypt a background music file or every file in a directory.
  * @param argc Number of command line arguments.
  * @param argv Array of command line arguments.
  * @returns Standard exit code.
  */
 int main(int argc, char *argv[])
 {
+    // Detect directory mode.
+    if(argc >= 4 && std::string("-r") == argv[1])
+    {
+        if(argc == 5 && std::string("-d") == argv[2])
+        {
+            return cryptstream::TransformDirectory(argv[3], argv[4],
+                DecryptFile);
+        }
+        else if(argc == 4)
+        {
+            return cryptstream::TransformDirectory(argv[2], argv[3],
+                EncryptFile);
+        }
+    }
+
     // Detect encrypt or decrypt mode or print usage.
     if(argc == 4 && std::string("-d") == argv[1])
     {
@@ -262,6 +228,7 @@ int main(int argc, char *argv[])
     else
     {
         fprintf(stderr, "USAGE: %s [-d] IN OUT\n", argv[0]);
+        fprintf(stderr, "       %s -r [-d] IN_DIR OUT_DIR\n", argv[0]);
     }
 
     return EXIT_FAILURE;
@@ -55,11 +55,6 @@
 
 #include <zlib.h>
 
-static const uint32_t FORMAT_MAGIC  = 0x4B434148; // HACK
-static const uint32_t FORMAT_MAGIC2 = 0x504D4F43; // COMP
-static const uint32_t FORMAT_VER1   = 0x00010000; // Major, Minor, Patch (1.0.0)
-static const uint32_t FORMAT_VER2   = 0x00010100; // Major, Minor, Patch (1.1.0)
-
 static int uncompressChunk(const void *src, void *dest,
     int in_size, int chunk_size)
 {
@@ -568,65 +563,24 @@ void MainWindow::loadCaptures(const QStringList& inPaths)
         state->packetSeqB = 0;
         state->client = i;
 
-        QFile *file = new QFile(path);
-        if( !file->open(QIODevice::ReadOnly) )
-        {
-            foreach(CaptureLoadData *cap, capData)
-            {
-                delete cap->file;
-                cap->file = nullptr;
-
-                delete cap->state;
-                cap->state = nullptr;
-
-                delete cap;
-                cap = nullptr;
-            }
-
-            QMessageBox::critical(this, tr("Capture File Error"),
-                tr("Failed to open the capture file."));
-
-            return;
-        }
-
-        uint32_t magic = 0, ver = 0;
-
-        file->read((char*)&magic, 4);
-        file->read((char*)&ver, 4);
+        CaptureLoadData *cap = new CaptureLoadData;
+        cap->path = path;
+        cap->state = state;
 
-        if((magic != FORMAT_MAGIC && magic != FORMAT_MAGIC2) ||
-            (ver != FORMAT_VER1 && ver != FORMAT_VER2))
+        if( !cap->capture.open(path) )
         {
-            foreach(CaptureLoadData *cap, capData)
-            {
-                delete cap;
-            }
+            delete cap;
+
+            foreach(CaptureLoadData *other, capData)
+                delete other;
 
             QMessageBox::critical(this, tr("Capture File Error"),
-                tr("Invalid or corrupt capture file."));
+                tr("Failed to open the capture file or it is invalid."));
 
             return;
         }
 
-        uint64_t stamp = 0;
-        uint32_t addrlen = 0;
-        char address[1024];
-
-        memset(address, 0, 1024);
-
-        if(ver == FORMAT_VER1)
-            file->read((char*)&stamp, 4);
-        else
-            file->read((char*)&stamp, 8);
-
-        file->read((char*)&addrlen, 4);
-        file->read(address, addrlen);
-
-        CaptureLoadData *cap = new CaptureLoadData;
-        cap->path = path;
-        cap->file = file;
-        cap->state = state;
-        cap->ver = ver;
+        cap->nextOffset = cap->capture.firstRecord();
 
         if( !loadCapturePacket(cap) )
             delete cap;
@@ -637,14 +591,14 @@ void MainWindow::loadCaptures(const QStringList& inPaths)
     while( !capData.isEmpty() )
     {
         int index = 0;
-        uint64_t stamp = capData.first()->stamp;
+        uint64_t stamp = capData.first()->record.stamp;
 
         for(int i = 1; i < capData.count(); i++)
         {
-            if(capData.at(i)->stamp >= stamp)
+            if(capData.at(i)->record.stamp >= stamp)
                 continue;
 
-            stamp = capData.at(i)->stamp;
+            stamp = capData.at(i)->record.stamp;
             index = i;
         }
 
@@ -659,10 +613,11 @@ void MainWindow::loadCaptures(const QStringList& inPaths)
         libcomp::Packet p;
 
         p.Clear();
-        p.WriteArray(cap->buffer, cap->sz);
+        p.WriteArray(cap->record.data, cap->record.size);
 
-        createPacketData(packetData, cap->source,
-            cap->stamp, cap->micro, p, cap->state);
+        createPacketData(packetData, cap->record.source,
+            cap->record.stamp, cap->record.micro, p,
+            cap->capture.isLobby(), cap->state);
 
         // Read in the next packet
         if( !loadCapturePacket(cap) )
@@ -688,34 +643,10 @@ bool MainWindow::loadCapturePacket(CaptureLoadData *d)
     if(!d)
         return false;
 
-    d->stamp = 0;
-    d->micro = 0;
-
-    if( d->file->atEnd() )
-        return false;
-
-    if(d->file->read((char*)&d->source, sizeof(d->source)) != (qint64) sizeof(d->source))
-        return false;
-
-    if(d->ver == FORMAT_VER1)
-    {
-        if(d->file->read((char*)&d->stamp, 4) != 4)
-            return false;
-    }
-    else
-    {
-        if(d->file->read((char*)&d->stamp, 8) != 8)
-            return false;
-
-        if(d->file->read((char*)&d->micro, 8) != 8)
-            return false;
-    }
-
-    if(d->file->read((char*)&d->sz, sizeof(d->sz)) != (qint64) sizeof(d->sz))
+    if( !d->capture.readRecord(d->nextOffset, d->record) )
         return false;
 
-    if(d->file->read((char*)d->buffer, d->sz) != d->sz)
-        return false;
+    d->nextOffset = d->record.nextOffset;
 
     return true;
 }
@@ -756,84 +687,37 @@ void MainWindow::loadCapture(const QString& path)
 
     updateValues();
 
-    QFile log(path);
+    CaptureFile capture;
 
-    // Open the log
-    if( !log.open(QIODevice::ReadOnly) )
+    // Open and map the log
+    if( !capture.open(path) )
     {
         QMessageBox::critical(this, tr("Capture File Error"),
-            tr("Failed to open the capture file."));
+            tr("Failed to open the capture file or it is invalid."));
 
         return;
     }
 
-    uint32_t magic = 0, ver = 0;
-
-    log.read((char*)&magic, 4);
-    log.read((char*)&ver, 4);
-
-    if((magic != FORMAT_MAGIC && magic != FORMAT_MAGIC2) ||
-        (ver != FORMAT_VER1 && ver != FORMAT_VER2))
-    {
-        QMessageBox::critical(this, tr("Capture File Error"),
-            tr("Invalid or corrupt capture file."));
-
-        return;
-    }
-
-    bool isLobby = (FORMAT_MAGIC2 == magic);
-
-    uint64_t stamp = 0;
-    uint64_t micro = 0;
-    uint32_t addrlen = 0;
-    char address[1024];
-
-    memset(address, 0, 1024);
-
-    if(ver == FORMAT_VER1)
-        log.read((char*)&stamp, 4);
-    else
-        log.read((char*)&stamp, 8);
-
-    log.read((char*)&addrlen, 4);
-    log.read(address, addrlen);
-
-    uint8_t *pBuffer = new uint8_t[1048576];
-    uint8_t source;
-    uint32_t sz;
+    CaptureRecord record;
+    uint64_t offset = capture.firstRecord();
 
     libcomp::Packet p;
 
     // Variable to store list of loaded PacketData objects
     QList<PacketData*> packetData;
 
-    while( !log.atEnd() )
+    while( capture.readRecord(offset, record) )
     {
-        stamp = 0;
-        micro = 0;
-
-        log.read((char*)&source, sizeof(source));
-
-        if(ver == FORMAT_VER1)
-        {
-            log.read((char*)&stamp, 4);
-        }
-        else
-        {
-            log.read((char*)&stamp, 8);
-            log.read((char*)&micro, 8);
-        }
-
-        log.read((char*)&sz, sizeof(sz));
-        log.read((char*)pBuffer, sz);
-
         p.Clear();
-        p.WriteArray(pBuffer, sz);
+        p.WriteArray(record.data, record.size);
 
-        createPacketData(packetData, source, stamp, micro, p, isLobby);
+        createPacketData(packetData, record.source, record.stamp,
+            record.micro, p, capture.isLobby());
+
+        offset = record.nextOffset;
     }
 
-    log.close();
+    capture.close();
 
     // Add the final list of PacketData objects to the model in one shot
     mModel->addPacketData(packetData);
@@ -841,8 +725,6 @@ void MainWindow::loadCapture(const QString& path)
     setWindowTitle( tr("Capture Grep - %1").arg(QFileInfo(path).fileName()) );
 
     mStatusBar->setText(QDir::toNativeSeparators(path));
-
-    delete[] pBuffer;
 }
 
 void MainWindow::addPacket(uint8_t source, uint64_t stamp, uint64_t micro,
@@ -35,6 +35,8 @@
 #include "Packet.h"
 #include "Find.h"
 
+#include <CaptureFile.h>
+
 #include <PushIgnore.h>
 #include <QFile>
 #include <QHash>
@@ -65,23 +67,18 @@ public:
 class CaptureLoadData
 {
 public:
-    QFile *file;
+    CaptureFile capture;
     QString path;
-    uint32_t ver;
-    uint64_t stamp;
-    uint64_t micro;
     CaptureLoadState *state;
-    uint8_t buffer[1048576];
-    uint8_t source;
-    uint32_t sz;
+    CaptureRecord record;
+    uint64_t nextOffset;
 
-    CaptureLoadData() : file(0), state(0)
+    CaptureLoadData() : state(0), nextOffset(0)
     {
     }
 
     ~CaptureLoadData()
     {
-        delete file;
         delete state;
     }
 };
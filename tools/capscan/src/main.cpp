@@ -0,0 +1,248 @@
+/**
+ * @file tools/capscan/src/main.cpp
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Command line tool to search packet captures.
+ *
+ * This tool will index capture files and print the commands that match a
+ * filter as text or JSON lines.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// capture Includes
+#include <CaptureIndex.h>
+
+#include <PushIgnore.h>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <PopIgnore.h>
+
+// Standard C++11 Includes
+#include <cstdlib>
+#include <iostream>
+
+static void usage(const char *szAppName)
+{
+    std::cerr << "USAGE: " << szAppName << " [--code CODE[,CODE...]] "
+        "[--client ADDRESS] [--from TIME] [--to TIME] "
+        "[--source client|server] [--json] [--no-data] CAPTURE|DIR..."
+        << std::endl << std::endl;
+    std::cerr << "Codes are hex (0x00F3 or 00F3). Times are unix seconds "
+        "or ISO 8601 (2020-01-31T12:00:00)." << std::endl;
+    std::cerr << "Directories are searched recursively for *.hack files. "
+        "Each capture CAPTURE.hack gets a CAPTURE.hack.idx index next to "
+        "it." << std::endl;
+}
+
+static bool parseTime(const QString& text, int64_t& time)
+{
+    bool ok = false;
+    time = text.toLongLong(&ok);
+
+    if(ok)
+        return true;
+
+    QDateTime dateTime = QDateTime::fromString(text, Qt::ISODate);
+
+    if(!dateTime.isValid())
+        return false;
+
+    time = dateTime.toMSecsSinceEpoch() / 1000;
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList args = app.arguments();
+    QString appName = args.takeFirst();
+
+    CaptureFilter filter;
+    QStringList paths;
+    bool json = false;
+    bool showData = true;
+
+    while(!args.isEmpty())
+    {
+        QString arg = args.takeFirst();
+
+        if("--json" == arg)
+        {
+            json = true;
+        }
+        else if("--no-data" == arg)
+        {
+            showData = false;
+        }
+        else if(arg.startsWith("--") && args.isEmpty())
+        {
+            usage(appName.toLocal8Bit().constData());
+
+            return EXIT_FAILURE;
+        }
+        else if("--code" == arg)
+        {
+            foreach(QString code, args.takeFirst().split(","))
+            {
+                bool ok = false;
+                uint16_t value = code.trimmed().toUShort(&ok, 16);
+
+                if(!ok)
+                {
+                    std::cerr << "Invalid command code: "
+                        << code.toLocal8Bit().constData() << std::endl;
+
+                    return EXIT_FAILURE;
+                }
+
+                filter.codes.insert(value);
+            }
+        }
+        else if("--client" == arg)
+        {
+            filter.client = args.takeFirst();
+        }
+        else if("--from" == arg || "--to" == arg)
+        {
+            QString text = args.takeFirst();
+
+            if(!parseTime(text, "--from" == arg ? filter.startTime :
+                filter.endTime))
+            {
+                std::cerr << "Invalid time: "
+                    << text.toLocal8Bit().constData() << std::endl;
+
+                return EXIT_FAILURE;
+            }
+        }
+        else if("--source" == arg)
+        {
+            QString source = args.takeFirst();
+
+            if("client" == source)
+            {
+                filter.source = 0;
+            }
+            else if("server" == source)
+            {
+                filter.source = 1;
+            }
+            else
+            {
+                usage(appName.toLocal8Bit().constData());
+
+                return EXIT_FAILURE;
+            }
+        }
+        else if(arg.startsWith("--"))
+        {
+            usage(appName.toLocal8Bit().constData());
+
+            return EXIT_FAILURE;
+        }
+        else if(QFileInfo(arg).isDir())
+        {
+            QDirIterator it(arg, QStringList() << "*.hack", QDir::Files,
+                QDirIterator::Subdirectories);
+
+            QStringList found;
+
+            while(it.hasNext())
+                found.append(it.next());
+
+            found.sort();
+            paths.append(found);
+        }
+        else
+        {
+            paths.append(arg);
+        }
+    }
+
+    if(paths.isEmpty())
+    {
+        usage(appName.toLocal8Bit().constData());
+
+        return EXIT_FAILURE;
+    }
+
+    QStringList errors;
+
+    uint64_t count = ScanCaptures(paths, filter, [&](
+        const CaptureMatch& match)
+    {
+        const CaptureIndexEntry& entry = match.entry;
+
+        QString time = QDateTime::fromMSecsSinceEpoch(
+            (qint64)entry.stamp * 1000).toString(Qt::ISODate);
+        QString code = QString("%1").arg(entry.code, 4, 16,
+            QLatin1Char('0')).toUpper();
+
+        QByteArray line;
+
+        if(json)
+        {
+            QJsonObject obj;
+            obj["file"] = match.file->path();
+            obj["client"] = match.file->address();
+            obj["time"] = time;
+            obj["stamp"] = (qint64)entry.stamp;
+            obj["micro"] = (qint64)entry.micro;
+            obj["source"] = entry.source ? "server" : "client";
+            obj["code"] = QString("0x%1").arg(code);
+            obj["size"] = match.data.size();
+
+            if(showData)
+                obj["data"] = QString::fromLatin1(match.data.toHex());
+
+            line = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+        }
+        else
+        {
+            line = QString("%1\t%2\t%3\t%4\t0x%5\t%6").arg(
+                match.file->path()).arg(time).arg(entry.micro).arg(
+                entry.source ? "S>C" : "C>S").arg(code).arg(
+                match.data.size()).toUtf8();
+
+            if(showData)
+                line += "\t" + match.data.toHex();
+        }
+
+        std::cout << line.constData() << "\n";
+    }, errors);
+
+    std::cout.flush();
+
+    foreach(QString path, errors)
+    {
+        std::cerr << "Failed to read capture: "
+            << path.toLocal8Bit().constData() << std::endl;
+    }
+
+    std::cerr << count << " matching command(s) in " << paths.size()
+        << " capture(s)." << std::endl;
+
+    return errors.isEmpty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,308 @@
+/**
+ * @file tools/capture/src/CaptureFile.cpp
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Memory mapped reader for packet capture files.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CaptureFile.h"
+
+#include <PushIgnore.h>
+#include <QtEndian>
+#include <PopIgnore.h>
+
+#include <zlib.h>
+
+#include <cstring>
+
+template<typename T>
+static T readValue(const uchar *pData)
+{
+    T value;
+    memcpy(&value, pData, sizeof(value));
+
+    return value;
+}
+
+static int uncompressChunk(const void *src, void *dest,
+    int in_size, int chunk_size)
+{
+    z_stream strm;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+
+    strm.avail_in = static_cast<uInt>(in_size);
+    strm.next_in = (Bytef*)src;
+
+    if(inflateInit(&strm) != Z_OK)
+        return 0;
+
+    strm.avail_out = static_cast<uInt>(chunk_size);
+    strm.next_out = (Bytef*)dest;
+
+    if(inflate(&strm, Z_FINISH) != Z_STREAM_END)
+    {
+        inflateEnd(&strm);
+
+        return 0;
+    }
+
+    int written = chunk_size - static_cast<int>(strm.avail_out);
+
+    if(inflateEnd(&strm) != Z_OK)
+        return 0;
+
+    return written;
+}
+
+CaptureFile::CaptureFile() : mData(0), mSize(0), mVersion(0), mStamp(0),
+    mIsLobby(false), mFirstRecord(0)
+{
+}
+
+CaptureFile::~CaptureFile()
+{
+    close();
+}
+
+bool CaptureFile::open(const QString& path)
+{
+    close();
+
+    mFile.setFileName(path);
+
+    if(!mFile.open(QIODevice::ReadOnly))
+        return false;
+
+    mSize = (uint64_t)mFile.size();
+
+    // Magic, version, stamp and address length of the smallest header.
+    if(16 > mSize)
+    {
+        close();
+
+        return false;
+    }
+
+    mData = mFile.map(0, mFile.size());
+
+    if(!mData)
+    {
+        close();
+
+        return false;
+    }
+
+    uint32_t magic = readValue<uint32_t>(mData);
+    mVersion = readValue<uint32_t>(mData + 4);
+
+    if((magic != CAPTURE_FORMAT_MAGIC && magic != CAPTURE_FORMAT_MAGIC2) ||
+        (mVersion != CAPTURE_FORMAT_VER1 && mVersion != CAPTURE_FORMAT_VER2))
+    {
+        close();
+
+        return false;
+    }
+
+    mIsLobby = (CAPTURE_FORMAT_MAGIC2 == magic);
+
+    uint64_t offset = 8;
+
+    if(mVersion == CAPTURE_FORMAT_VER1)
+    {
+        mStamp = readValue<uint32_t>(mData + offset);
+        offset += 4;
+    }
+    else
+    {
+        mStamp = readValue<uint64_t>(mData + offset);
+        offset += 8;
+    }
+
+    if(offset + 4 > mSize)
+    {
+        close();
+
+        return false;
+    }
+
+    uint32_t addrlen = readValue<uint32_t>(mData + offset);
+    offset += 4;
+
+    if(offset + addrlen > mSize)
+    {
+        close();
+
+        return false;
+    }
+
+    mAddress = QString::fromUtf8((const char*)mData + offset,
+        (int)addrlen).trimmed();
+    mAddress.remove(QChar(0));
+    mFirstRecord = offset + addrlen;
+
+    return true;
+}
+
+void CaptureFile::close()
+{
+    if(mData)
+        mFile.unmap(const_cast<uchar*>(mData));
+
+    mFile.close();
+
+    mData = 0;
+    mSize = 0;
+    mAddress.clear();
+    mVersion = 0;
+    mStamp = 0;
+    mIsLobby = false;
+    mFirstRecord = 0;
+}
+
+QString CaptureFile::path() const
+{
+    return mFile.fileName();
+}
+
+QString CaptureFile::address() const
+{
+    return mAddress;
+}
+
+uint32_t CaptureFile::version() const
+{
+    return mVersion;
+}
+
+uint64_t CaptureFile::stamp() const
+{
+    return mStamp;
+}
+
+bool CaptureFile::isLobby() const
+{
+    return mIsLobby;
+}
+
+uint64_t CaptureFile::size() const
+{
+    return mSize;
+}
+
+uint64_t CaptureFile::firstRecord() const
+{
+    return mFirstRecord;
+}
+
+bool CaptureFile::readRecord(uint64_t offset, CaptureRecord& record) const
+{
+    uint64_t headerSize = (mVersion == CAPTURE_FORMAT_VER1) ? 9 : 21;
+
+    if(!mData || offset < mFirstRecord || offset + headerSize > mSize)
+        return false;
+
+    const uchar *pRecord = mData + offset;
+
+    record.offset = offset;
+    record.source = pRecord[0];
+
+    if(mVersion == CAPTURE_FORMAT_VER1)
+    {
+        record.stamp = readValue<uint32_t>(pRecord + 1);
+        record.micro = 0;
+    }
+    else
+    {
+        record.stamp = readValue<uint64_t>(pRecord + 1);
+        record.micro = readValue<uint64_t>(pRecord + 9);
+    }
+
+    record.size = readValue<uint32_t>(pRecord + headerSize - 4);
+    record.data = pRecord + headerSize;
+    record.nextOffset = offset + headerSize + record.size;
+
+    // The last record may be partially written if the logger is running.
+    return record.nextOffset <= mSize;
+}
+
+QList<CaptureCommand> CaptureFile::commands(
+    const CaptureRecord& record) const
+{
+    QList<CaptureCommand> commands;
+
+    QByteArray packet = QByteArray::fromRawData((const char*)record.data,
+        (int)record.size);
+
+    // Check for compression
+    if(!mIsLobby && 24 <= packet.size() && qFromBigEndian<quint32>(
+        (const uchar*)packet.constData() + 8) == 0x677A6970)
+    {
+        int32_t uncompressed_size = qFromLittleEndian<qint32>(
+            (const uchar*)packet.constData() + 12);
+        int32_t compressed_size = qFromLittleEndian<qint32>(
+            (const uchar*)packet.constData() + 16);
+
+        if(compressed_size != uncompressed_size && 0 < uncompressed_size &&
+            0 < compressed_size && 24 + compressed_size <= packet.size())
+        {
+            QByteArray decomp(24 + uncompressed_size, 0);
+            memcpy(decomp.data(), packet.constData(), 24);
+
+            int written = uncompressChunk(packet.constData() + 24,
+                decomp.data() + 24, compressed_size, uncompressed_size);
+
+            decomp.resize(24 + written);
+            packet = decomp;
+        }
+    }
+
+    const uchar *pData = (const uchar*)packet.constData();
+    int size = packet.size();
+    int pos = mIsLobby ? 8 : 24;
+
+    while(size - pos >= 6)
+    {
+        pos += 2; // Big endian size
+
+        int cmd_start = pos;
+        uint16_t cmd_size = qFromLittleEndian<quint16>(pData + pos);
+        pos += 2;
+
+        if(cmd_size < 4)
+            continue;
+
+        if(cmd_start + cmd_size > size)
+            break;
+
+        CaptureCommand cmd;
+        cmd.code = qFromLittleEndian<quint16>(pData + pos);
+        cmd.data = QByteArray((const char*)pData + cmd_start + 4,
+            cmd_size - 4);
+
+        commands.append(cmd);
+
+        pos = cmd_start + cmd_size;
+    }
+
+    return commands;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file tools/capture/src/CaptureFile.h
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Memory mapped reader for packet capture files.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOOLS_CAPTURE_SRC_CAPTUREFILE_H
+#define TOOLS_CAPTURE_SRC_CAPTUREFILE_H
+
+#include <PushIgnore.h>
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <PopIgnore.h>
+
+#include <stdint.h>
+
+/// Magic of a channel capture file ("HACK")
+static const uint32_t CAPTURE_FORMAT_MAGIC  = 0x4B434148;
+/// Magic of a lobby capture file ("COMP")
+static const uint32_t CAPTURE_FORMAT_MAGIC2 = 0x504D4F43;
+/// Capture version with 32-bit time stamps (1.0.0)
+static const uint32_t CAPTURE_FORMAT_VER1   = 0x00010000;
+/// Capture version with 64-bit time stamps and microseconds (1.1.0)
+static const uint32_t CAPTURE_FORMAT_VER2   = 0x00010100;
+
+/**
+ * A single packet as it was written to the capture.
+ */
+class CaptureRecord
+{
+public:
+    /// Offset of the record in the capture file
+    uint64_t offset;
+
+    /// Offset of the record following this one
+    uint64_t nextOffset;
+
+    /// Time the packet was captured in seconds since the epoch
+    uint64_t stamp;
+
+    /// Time the packet was captured in microseconds (version 2 only)
+    uint64_t micro;
+
+    /// 0 if the packet came from the client, 1 if it came from the server
+    uint8_t source;
+
+    /// Packet data inside the mapped capture file
+    const uchar *data;
+
+    /// Size of the packet data
+    uint32_t size;
+};
+
+/**
+ * A single command inside a captured packet.
+ */
+class CaptureCommand
+{
+public:
+    /// Command code
+    uint16_t code;
+
+    /// Command data following the code
+    QByteArray data;
+};
+
+/**
+ * Read only view of a capture file written by the logger. The file is
+ * memory mapped so records can be read at any offset without copying the
+ * capture into memory or issuing a read call for every field.
+ */
+class CaptureFile
+{
+public:
+    CaptureFile();
+    ~CaptureFile();
+
+    /**
+     * Open and map a capture file and read its header.
+     * @param path Path to the capture file.
+     * @returns true if the file is a valid capture, false otherwise.
+     */
+    bool open(const QString& path);
+
+    /**
+     * Unmap and close the capture file.
+     */
+    void close();
+
+    QString path() const;
+    QString address() const;
+    uint32_t version() const;
+    uint64_t stamp() const;
+    bool isLobby() const;
+    uint64_t size() const;
+
+    /**
+     * Get the offset of the first record after the header.
+     * @returns Offset of the first record.
+     */
+    uint64_t firstRecord() const;
+
+    /**
+     * Read the record at an offset.
+     * @param offset Offset of the record to read.
+     * @param record Output parameter for the record.
+     * @returns true if a complete record was read, false otherwise.
+     */
+    bool readRecord(uint64_t offset, CaptureRecord& record) const;
+
+    /**
+     * Split a record into its commands, decompressing it first if needed.
+     * @param record Record to split.
+     * @returns List of commands in the order they appear in the packet.
+     */
+    QList<CaptureCommand> commands(const CaptureRecord& record) const;
+
+private:
+    QFile mFile;
+    const uchar *mData;
+    uint64_t mSize;
+
+    QString mAddress;
+    uint32_t mVersion;
+    uint64_t mStamp;
+    bool mIsLobby;
+    uint64_t mFirstRecord;
+};
+
+#endif // TOOLS_CAPTURE_SRC_CAPTUREFILE_H
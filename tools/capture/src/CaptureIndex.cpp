@@ -0,0 +1,315 @@
+/**
+ * @file tools/capture/src/CaptureIndex.cpp
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Sidecar index of the commands in a packet capture file.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CaptureIndex.h"
+
+#include <PushIgnore.h>
+#include <QFile>
+#include <PopIgnore.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <thread>
+
+/// Magic of a capture index file ("CIDX")
+static const uint32_t INDEX_MAGIC = 0x58444943;
+
+/// Version of the capture index format
+static const uint32_t INDEX_VERSION = 1;
+
+/// Size of the index header: magic, version, capture stamp, indexed size
+/// and entry count
+static const int INDEX_HEADER_SIZE = 4 + 4 + 8 + 8 + 8;
+
+/// Size of each serialized entry
+static const int INDEX_ENTRY_SIZE = 8 + 8 + 8 + 2 + 2 + 1;
+
+bool CaptureFilter::matches(const CaptureIndexEntry& entry) const
+{
+    if(!codes.isEmpty() && !codes.contains(entry.code))
+        return false;
+
+    if(0 <= source && entry.source != source)
+        return false;
+
+    if(0 <= startTime && (int64_t)entry.stamp < startTime)
+        return false;
+
+    if(0 <= endTime && (int64_t)entry.stamp > endTime)
+        return false;
+
+    return true;
+}
+
+QString CaptureIndex::indexPath(const QString& capturePath)
+{
+    return capturePath + ".idx";
+}
+
+bool CaptureIndex::load(const CaptureFile& file, bool save)
+{
+    mEntries.clear();
+    mIndexedSize = 0;
+
+    QString path = indexPath(file.path());
+
+    if(!read(path, file))
+    {
+        mEntries.clear();
+        mIndexedSize = 0;
+    }
+
+    if(mIndexedSize == file.size())
+        return true;
+
+    extend(file);
+
+    if(save && !write(path, file))
+    {
+        // The index is still usable, it just has to be built next time.
+        QFile::remove(path);
+    }
+
+    return true;
+}
+
+const std::vector<CaptureIndexEntry>& CaptureIndex::entries() const
+{
+    return mEntries;
+}
+
+bool CaptureIndex::read(const QString& path, const CaptureFile& file)
+{
+    QFile in(path);
+
+    if(!in.open(QIODevice::ReadOnly))
+        return false;
+
+    QByteArray data = in.readAll();
+    const char *pData = data.constData();
+
+    if(INDEX_HEADER_SIZE > data.size())
+        return false;
+
+    uint32_t magic, version;
+    uint64_t stamp, indexedSize, count;
+
+    memcpy(&magic, pData, 4);
+    memcpy(&version, pData + 4, 4);
+    memcpy(&stamp, pData + 8, 8);
+    memcpy(&indexedSize, pData + 16, 8);
+    memcpy(&count, pData + 24, 8);
+
+    // Make sure this is the index of this capture and the capture has not
+    // been truncated or replaced since.
+    if(INDEX_MAGIC != magic || INDEX_VERSION != version ||
+        file.stamp() != stamp || file.size() < indexedSize ||
+        (uint64_t)(data.size() - INDEX_HEADER_SIZE) !=
+            count * INDEX_ENTRY_SIZE)
+    {
+        return false;
+    }
+
+    mEntries.resize((size_t)count);
+
+    pData += INDEX_HEADER_SIZE;
+
+    for(auto& entry : mEntries)
+    {
+        memcpy(&entry.offset, pData, 8);
+        memcpy(&entry.stamp, pData + 8, 8);
+        memcpy(&entry.micro, pData + 16, 8);
+        memcpy(&entry.code, pData + 24, 2);
+        memcpy(&entry.command, pData + 26, 2);
+        memcpy(&entry.source, pData + 28, 1);
+
+        pData += INDEX_ENTRY_SIZE;
+    }
+
+    mIndexedSize = indexedSize;
+
+    return true;
+}
+
+bool CaptureIndex::write(const QString& path, const CaptureFile& file) const
+{
+    QByteArray data(INDEX_HEADER_SIZE + (int)mEntries.size() *
+        INDEX_ENTRY_SIZE, 0);
+    char *pData = data.data();
+
+    uint64_t stamp = file.stamp();
+    uint64_t count = mEntries.size();
+
+    memcpy(pData, &INDEX_MAGIC, 4);
+    memcpy(pData + 4, &INDEX_VERSION, 4);
+    memcpy(pData + 8, &stamp, 8);
+    memcpy(pData + 16, &mIndexedSize, 8);
+    memcpy(pData + 24, &count, 8);
+
+    pData += INDEX_HEADER_SIZE;
+
+    for(auto& entry : mEntries)
+    {
+        memcpy(pData, &entry.offset, 8);
+        memcpy(pData + 8, &entry.stamp, 8);
+        memcpy(pData + 16, &entry.micro, 8);
+        memcpy(pData + 24, &entry.code, 2);
+        memcpy(pData + 26, &entry.command, 2);
+        memcpy(pData + 28, &entry.source, 1);
+
+        pData += INDEX_ENTRY_SIZE;
+    }
+
+    QFile out(path);
+
+    return out.open(QIODevice::WriteOnly) && data.size() == out.write(data);
+}
+
+void CaptureIndex::extend(const CaptureFile& file)
+{
+    uint64_t offset = std::max(mIndexedSize, file.firstRecord());
+
+    CaptureRecord record;
+
+    while(file.readRecord(offset, record))
+    {
+        uint16_t command = 0;
+
+        for(auto& cmd : file.commands(record))
+        {
+            CaptureIndexEntry entry;
+            entry.offset = record.offset;
+            entry.stamp = record.stamp;
+            entry.micro = record.micro;
+            entry.code = cmd.code;
+            entry.command = command++;
+            entry.source = record.source;
+
+            mEntries.push_back(entry);
+        }
+
+        offset = record.nextOffset;
+    }
+
+    mIndexedSize = offset;
+}
+
+uint64_t ScanCaptures(const QStringList& paths, const CaptureFilter& filter,
+    const CaptureMatchHandler_t& handler, QStringList& errors)
+{
+    std::atomic<int> nextFile(0);
+    std::atomic<uint64_t> matchCount(0);
+    std::mutex handlerLock;
+
+    auto worker = [&]()
+    {
+        for(int i = nextFile++; i < paths.size(); i = nextFile++)
+        {
+            CaptureFile file;
+
+            if(!file.open(paths.at(i)))
+            {
+                std::lock_guard<std::mutex> lock(handlerLock);
+                errors.append(paths.at(i));
+
+                continue;
+            }
+
+            // The client address is in the capture header so skip other
+            // clients before building or loading their index.
+            if(!filter.client.isEmpty() && !file.address().contains(
+                filter.client, Qt::CaseInsensitive))
+            {
+                continue;
+            }
+
+            CaptureIndex index;
+
+            if(!index.load(file))
+            {
+                std::lock_guard<std::mutex> lock(handlerLock);
+                errors.append(paths.at(i));
+
+                continue;
+            }
+
+            // Commands of a record are next to each other in the index so
+            // each matching record is only split once.
+            uint64_t lastOffset = 0;
+            QList<CaptureCommand> commands;
+
+            for(auto& entry : index.entries())
+            {
+                if(!filter.matches(entry))
+                    continue;
+
+                if(commands.isEmpty() || lastOffset != entry.offset)
+                {
+                    CaptureRecord record;
+
+                    if(!file.readRecord(entry.offset, record))
+                        continue;
+
+                    commands = file.commands(record);
+                    lastOffset = entry.offset;
+                }
+
+                if(entry.command >= commands.size())
+                    continue;
+
+                CaptureMatch match;
+                match.file = &file;
+                match.fileIndex = i;
+                match.entry = entry;
+                match.data = commands.at(entry.command).data;
+
+                matchCount++;
+
+                std::lock_guard<std::mutex> lock(handlerLock);
+                handler(match);
+            }
+        }
+    };
+
+    std::list<std::thread*> threads;
+
+    unsigned int threadCount = std::min((unsigned int)paths.size(),
+        std::max(1U, std::thread::hardware_concurrency()));
+    for(unsigned int i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(new std::thread(worker));
+    }
+
+    for(auto thread : threads)
+    {
+        thread->join();
+
+        delete thread;
+    }
+
+    return matchCount;
+}
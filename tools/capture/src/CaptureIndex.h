@@ -0,0 +1,172 @@
+/**
+ * @file tools/capture/src/CaptureIndex.h
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Sidecar index of the commands in a packet capture file.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOOLS_CAPTURE_SRC_CAPTUREINDEX_H
+#define TOOLS_CAPTURE_SRC_CAPTUREINDEX_H
+
+#include "CaptureFile.h"
+
+#include <PushIgnore.h>
+#include <QSet>
+#include <QStringList>
+#include <PopIgnore.h>
+
+#include <functional>
+#include <vector>
+
+/**
+ * Index entry for a single command in a capture.
+ */
+class CaptureIndexEntry
+{
+public:
+    /// Offset of the record containing the command
+    uint64_t offset;
+
+    /// Time the packet was captured in seconds since the epoch
+    uint64_t stamp;
+
+    /// Time the packet was captured in microseconds
+    uint64_t micro;
+
+    /// Command code
+    uint16_t code;
+
+    /// Position of the command in the record
+    uint16_t command;
+
+    /// 0 if the packet came from the client, 1 if it came from the server
+    uint8_t source;
+};
+
+/**
+ * Criteria a command must match to be returned by a scan. Empty or
+ * negative criteria match everything.
+ */
+class CaptureFilter
+{
+public:
+    /// Command codes to match
+    QSet<uint16_t> codes;
+
+    /// Text that must be part of the client address in the capture header
+    QString client;
+
+    /// Earliest capture time in seconds since the epoch
+    int64_t startTime = -1;
+
+    /// Latest capture time in seconds since the epoch
+    int64_t endTime = -1;
+
+    /// Packet source to match (0 = client, 1 = server)
+    int source = -1;
+
+    /**
+     * Check if an index entry matches the filter. The client is checked
+     * separately since it applies to the whole capture.
+     * @param entry Entry to check.
+     * @returns true if the entry matches, false otherwise.
+     */
+    bool matches(const CaptureIndexEntry& entry) const;
+};
+
+/**
+ * Command matched by a scan.
+ */
+class CaptureMatch
+{
+public:
+    /// Capture the command came from
+    const CaptureFile *file;
+
+    /// Index of the capture in the list of scanned paths
+    int fileIndex;
+
+    /// Index entry of the command
+    CaptureIndexEntry entry;
+
+    /// Command data following the code
+    QByteArray data;
+};
+
+/**
+ * Index of every command in a capture file, saved next to the capture as
+ * "<capture>.hack.idx" so later scans can filter without parsing or
+ * decompressing the packets. Captures are only appended to, so an index
+ * for a capture that has grown since it was saved is extended from the
+ * last indexed record instead of being rebuilt.
+ */
+class CaptureIndex
+{
+public:
+    /**
+     * Load the index for a capture, building or extending it as needed.
+     * @param file Open capture to index.
+     * @param save Save the index if it had to be built or extended.
+     * @returns true if the index is valid, false otherwise.
+     */
+    bool load(const CaptureFile& file, bool save = true);
+
+    /**
+     * Get all entries in capture order.
+     * @returns Reference to the entries.
+     */
+    const std::vector<CaptureIndexEntry>& entries() const;
+
+    /**
+     * Get the path of the sidecar index for a capture.
+     * @param capturePath Path to the capture file.
+     * @returns Path to the index file.
+     */
+    static QString indexPath(const QString& capturePath);
+
+private:
+    bool read(const QString& path, const CaptureFile& file);
+    bool write(const QString& path, const CaptureFile& file) const;
+    void extend(const CaptureFile& file);
+
+    /// Offset just past the last indexed record
+    uint64_t mIndexedSize = 0;
+
+    std::vector<CaptureIndexEntry> mEntries;
+};
+
+/// Function called with each match of a scan
+typedef std::function<void(const CaptureMatch&)> CaptureMatchHandler_t;
+
+/**
+ * Scan captures for commands matching a filter. Each capture is indexed
+ * and filtered by a separate worker. Matches of a capture are passed to
+ * the handler in capture order and the handler is never called by two
+ * workers at once, but the matches of different captures may interleave.
+ * @param paths Paths to the capture files.
+ * @param filter Filter the commands must match.
+ * @param handler Function to call with each match.
+ * @param errors Output parameter for any capture that failed to load.
+ * @returns Number of matches.
+ */
+uint64_t ScanCaptures(const QStringList& paths, const CaptureFilter& filter,
+    const CaptureMatchHandler_t& handler, QStringList& errors);
+
+#endif // TOOLS_CAPTURE_SRC_CAPTUREINDEX_H
@@ -35,42 +35,22 @@
 #include <QCloseEvent>
 #include <QDirIterator>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <PopIgnore.h>
 
+// refindex Includes
+#include <ReferenceIndex.h>
+
 // objects Includes
-#include <ActionAddRemoveItems.h>
-#include <ActionAddRemoveStatus.h>
-#include <ActionCreateLoot.h>
-#include <ActionDelay.h>
-#include <ActionDisplayMessage.h>
-#include <ActionPlayBGM.h>
-#include <ActionPlaySoundEffect.h>
-#include <ActionSetHomepoint.h>
-#include <ActionSpawn.h>
-#include <ActionStageEffect.h>
-#include <ActionUpdateCOMP.h>
-#include <ActionUpdateFlag.h>
-#include <ActionUpdatePoints.h>
-#include <ActionUpdateQuest.h>
-#include <ActionZoneChange.h>
 #include <DropSet.h>
-#include <EventChoice.h>
-#include <EventExNPCMessage.h>
-#include <EventITime.h>
-#include <EventNPCMessage.h>
-#include <EventPerformActions.h>
-#include <EventPrompt.h>
-#include <ItemDrop.h>
-#include <PlasmaSpawn.h>
-#include <ServerNPC.h>
-#include <ServerObject.h>
+#include <Event.h>
 #include <ServerZone.h>
 #include <ServerZonePartial.h>
-#include <ServerZoneSpot.h>
-#include <ServerZoneTrigger.h>
-#include <Spawn.h>
-#include <SpawnGroup.h>
+
+// libcomp Includes
+#include <Crypto.h>
+#include <Log.h>
 
 // Standard C++11 Includes
 #include <chrono>
@@ -114,80 +94,7 @@ bool FindRefWindow::Open(const libcomp::String& objType, uint32_t val)
     ui->lblRefs->setText("");
     ui->progressBar->hide();
 
-    // Build the filters for the object type
-    mActionFilters.clear();
-    mEventFilters.clear();
-    mEventConditionFilters.clear();
-    mDropSetFilter = nullptr;
-    mSpawnFilter = nullptr;
-    mZoneFilter = nullptr;
-    mZonePartialFilter = nullptr;
-
-    if(mObjType == "DropSet")
-    {
-        BuildDropSetFilters();
-    }
-    else if(mObjType == "CEventMessageData")
-    {
-        BuildCEventMessageDataFilters();
-    }
-    else if(mObjType == "CHouraiData")
-    {
-        BuildCHouraiDataFilters();
-    }
-    else if(mObjType == "CHouraiMessageData")
-    {
-        BuildCHouraiMessageDataFilters();
-    }
-    else if(mObjType == "CItemData")
-    {
-        BuildCItemDataFilters();
-    }
-    else if(mObjType == "CKeyItemData")
-    {
-        BuildCKeyItemDataFilters();
-    }
-    else if(mObjType == "CQuestData")
-    {
-        BuildCQuestDataFilters();
-    }
-    else if(mObjType == "CSoundData")
-    {
-        BuildCSoundDataFilters();
-    }
-    else if(mObjType == "CTitleData")
-    {
-        BuildCTitleDataFilters();
-    }
-    else if(mObjType == "CValuablesData")
-    {
-        BuildCValuablesDataFilters();
-    }
-    else if(mObjType == "DevilData")
-    {
-        BuildDevilDataFilters();
-    }
-    else if(mObjType == "hNPCData")
-    {
-        BuildHNPCDataFilters();
-    }
-    else if(mObjType == "oNPCData")
-    {
-        BuildONPCDataFilters();
-    }
-    else if(mObjType == "ShopProductData")
-    {
-        BuildShopProductDataFilters();
-    }
-    else if(mObjType == "StatusData")
-    {
-        BuildStatusDataFilters();
-    }
-    else if(mObjType == "ZoneData")
-    {
-        BuildZoneDataFilters();
-    }
-    else
+    if(!ReferenceIndex::IsSupportedType(mObjType))
     {
         // Invalid object type
         return false;
@@ -222,490 +129,6 @@ void FindRefWindow::closeEvent(QCloseEvent* event)
     }
 }
 
-void FindRefWindow::BuildDropSetFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::ADD_REMOVE_ITEMS] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<
-                objects::ActionAddRemoveItems>(action);
-            if(act->GetFromDropSet())
-            {
-                for(auto& pair : act->GetItems())
-                {
-                    ids.insert(pair.first);
-                }
-            }
-        });
-
-    mActionFilters[objects::Action::ActionType_t::CREATE_LOOT] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionCreateLoot>(
-                action);
-            for(uint32_t dropSetID : act->GetDropSetIDs())
-            {
-                ids.insert(dropSetID);
-            }
-        });
-
-    mSpawnFilter = ([](const std::shared_ptr<objects::Spawn>& spawn,
-        std::set<uint32_t>& ids)
-        {
-            for(uint32_t dropSetID : spawn->GetDropSetIDs())
-            {
-                ids.insert(dropSetID);
-            }
-
-            for(uint32_t dropSetID : spawn->GetGiftSetIDs())
-            {
-                ids.insert(dropSetID);
-            }
-        });
-
-    mZoneFilter = ([](const std::shared_ptr<objects::ServerZone>& zone,
-        std::set<uint32_t>& ids)
-        {
-            for(uint32_t dropSetID : zone->GetDropSetIDs())
-            {
-                ids.insert(dropSetID);
-            }
-
-            for(auto pair : zone->GetPlasmaSpawns())
-            {
-                ids.insert(pair.second->GetDropSetID());
-            }
-        });
-
-    mZonePartialFilter = ([](const std::shared_ptr<
-        objects::ServerZonePartial>& p, std::set<uint32_t>& ids)
-        {
-            for(uint32_t dropSetID : p->GetDropSetIDs())
-            {
-                ids.insert(dropSetID);
-            }
-        });
-}
-
-void FindRefWindow::BuildCEventMessageDataFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::DISPLAY_MESSAGE] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<
-                objects::ActionDisplayMessage>(action);
-            for(int32_t messageID : act->GetMessageIDs())
-            {
-                ids.insert((uint32_t)messageID);
-            }
-        });
-
-    mActionFilters[objects::Action::ActionType_t::STAGE_EFFECT] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionStageEffect>(
-                action);
-            ids.insert((uint32_t)act->GetMessageID());
-        });
-
-    mEventFilters[objects::Event::EventType_t::EX_NPC_MESSAGE] =
-        ([](const std::shared_ptr<objects::Event>& event,
-        std::set<uint32_t>& ids)
-        {
-            auto e = std::dynamic_pointer_cast<objects::EventExNPCMessage>(
-                event);
-
-            ids.insert((uint32_t)e->GetMessageID());
-        });
-
-    mEventFilters[objects::Event::EventType_t::NPC_MESSAGE] =
-        ([](const std::shared_ptr<objects::Event>& event,
-        std::set<uint32_t>& ids)
-        {
-            auto e = std::dynamic_pointer_cast<objects::EventNPCMessage>(
-                event);
-            for(int32_t messageID : e->GetMessageIDs())
-            {
-                ids.insert((uint32_t)messageID);
-            }
-        });
-
-    mEventFilters[objects::Event::EventType_t::PROMPT] =
-        ([](const std::shared_ptr<objects::Event>& event,
-        std::set<uint32_t>& ids)
-        {
-            auto e = std::dynamic_pointer_cast<objects::EventPrompt>(
-                event);
-
-            ids.insert((uint32_t)e->GetMessageID());
-
-            for(auto choice : e->GetChoices())
-            {
-                ids.insert((uint32_t)choice->GetMessageID());
-            }
-        });
-}
-
-void FindRefWindow::BuildCHouraiDataFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::UPDATE_POINTS] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionUpdatePoints>(
-                action);
-            if(act->GetPointType() ==
-                objects::ActionUpdatePoints::PointType_t::ITIME)
-            {
-                ids.insert((uint32_t)act->GetModifier());
-            }
-        });
-
-    mEventFilters[objects::Event::EventType_t::ITIME] =
-        ([](const std::shared_ptr<objects::Event>& event,
-        std::set<uint32_t>& ids)
-        {
-            auto e = std::dynamic_pointer_cast<objects::EventITime>(
-                event);
-
-            ids.insert((uint32_t)e->GetITimeID());
-        });
-}
-
-void FindRefWindow::BuildCHouraiMessageDataFilters()
-{
-    mEventFilters[objects::Event::EventType_t::ITIME] =
-        ([](const std::shared_ptr<objects::Event>& event,
-        std::set<uint32_t>& ids)
-        {
-            auto e = std::dynamic_pointer_cast<objects::EventITime>(
-                event);
-
-            ids.insert((uint32_t)e->GetMessageID());
-
-            for(auto choice : e->GetChoices())
-            {
-                ids.insert((uint32_t)choice->GetMessageID());
-            }
-        });
-}
-
-void FindRefWindow::BuildCItemDataFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::ADD_REMOVE_ITEMS] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<
-                objects::ActionAddRemoveItems>(action);
-            if(act->GetMode() != objects::ActionAddRemoveItems::Mode_t::POST)
-            {
-                for(auto& pair : act->GetItems())
-                {
-                    ids.insert(pair.first);
-                }
-            }
-        });
-
-    mActionFilters[objects::Action::ActionType_t::CREATE_LOOT] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionCreateLoot>(
-                action);
-            for(auto drop : act->GetDrops())
-            {
-                ids.insert(drop->GetItemType());
-            }
-        });
-
-    mDropSetFilter = ([](const std::shared_ptr<objects::DropSet>& dropset,
-        std::set<uint32_t>& ids)
-        {
-            for(auto drop : dropset->GetDrops())
-            {
-                ids.insert(drop->GetItemType());
-            }
-        });
-
-    mSpawnFilter = ([](const std::shared_ptr<objects::Spawn>& spawn,
-        std::set<uint32_t>& ids)
-        {
-            for(auto drop : spawn->GetDrops())
-            {
-                ids.insert(drop->GetItemType());
-            }
-
-            for(auto drop : spawn->GetGifts())
-            {
-                ids.insert(drop->GetItemType());
-            }
-        });
-
-    mEventConditionFilters[
-        objects::EventCondition::Type_t::EQUIPPED] = &FindRefWindow::GetValue1;
-    mEventConditionFilters[
-        objects::EventCondition::Type_t::ITEM] = &FindRefWindow::GetValue1;
-    mEventConditionFilters[
-        objects::EventCondition::Type_t::MATERIAL] = &FindRefWindow::GetValue1;
-}
-
-void FindRefWindow::BuildCKeyItemDataFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::UPDATE_FLAG] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionUpdateFlag>(
-                action);
-            if(act->GetFlagType() ==
-                objects::ActionUpdateFlag::FlagType_t::PLUGIN)
-            {
-                ids.insert((uint32_t)act->GetID());
-            }
-        });
-
-    mEventConditionFilters[
-        objects::EventCondition::Type_t::PLUGIN] = &FindRefWindow::GetValue1;
-}
-
-void FindRefWindow::BuildCQuestDataFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::UPDATE_QUEST] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionUpdateQuest>(
-                action);
-            ids.insert((uint32_t)act->GetQuestID());
-        });
-
-    mEventConditionFilters[objects::EventCondition::Type_t::QUEST_ACTIVE] =
-        &FindRefWindow::GetValue1;
-    mEventConditionFilters[objects::EventCondition::Type_t::QUEST_AVAILABLE] =
-        &FindRefWindow::GetValue1;
-    mEventConditionFilters[objects::EventCondition::Type_t::QUEST_COMPLETE] =
-        &FindRefWindow::GetValue1;
-    mEventConditionFilters[objects::EventCondition::Type_t::QUEST_FLAGS] =
-        &FindRefWindow::GetValue1;
-    mEventConditionFilters[objects::EventCondition::Type_t::QUEST_PHASE] =
-        &FindRefWindow::GetValue1;
-    mEventConditionFilters[objects::EventCondition::Type_t::
-        QUEST_PHASE_REQUIREMENTS] = &FindRefWindow::GetValue1;
-    mEventConditionFilters[objects::EventCondition::Type_t::QUEST_SEQUENCE] =
-        &FindRefWindow::GetValue1;
-}
-
-void FindRefWindow::BuildCSoundDataFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::PLAY_BGM] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionPlayBGM>(
-                action);
-            ids.insert((uint32_t)act->GetMusicID());
-        });
-
-    mActionFilters[objects::Action::ActionType_t::PLAY_SOUND_EFFECT] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<
-                objects::ActionPlaySoundEffect>(action);
-            ids.insert((uint32_t)act->GetSoundID());
-        });
-}
-
-void FindRefWindow::BuildCTitleDataFilters()
-{
-    mSpawnFilter = ([](const std::shared_ptr<objects::Spawn>& spawn,
-        std::set<uint32_t>& ids)
-        {
-            ids.insert(spawn->GetVariantType());
-        });
-}
-
-void FindRefWindow::BuildCValuablesDataFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::UPDATE_FLAG] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionUpdateFlag>(
-                action);
-            if(act->GetFlagType() ==
-                objects::ActionUpdateFlag::FlagType_t::VALUABLE)
-            {
-                ids.insert((uint32_t)act->GetID());
-            }
-        });
-
-    mEventConditionFilters[
-        objects::EventCondition::Type_t::VALUABLE] = &FindRefWindow::GetValue1;
-}
-
-void FindRefWindow::BuildDevilDataFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::UPDATE_COMP] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionUpdateCOMP>(
-                action);
-            for(auto& pair : act->GetAddDemons())
-            {
-                ids.insert(pair.first);
-            }
-
-            for(auto& pair : act->GetRemoveDemons())
-            {
-                ids.insert(pair.first);
-            }
-        });
-
-    mSpawnFilter = ([](const std::shared_ptr<objects::Spawn>& spawn,
-        std::set<uint32_t>& ids)
-        {
-            ids.insert(spawn->GetEnemyType());
-        });
-
-    mEventConditionFilters[objects::EventCondition::Type_t::COMP_DEMON] =
-        &FindRefWindow::GetValue1;
-    mEventConditionFilters[
-        objects::EventCondition::Type_t::SUMMONED] = &FindRefWindow::GetValue1;
-
-    mEventConditionFilters[objects::EventCondition::Type_t::DEMON_BOOK] =
-        ([](FindRefWindow& self, const std::shared_ptr<
-            objects::EventCondition>& c, std::set<uint32_t>& ids)
-        {
-            (void)self;
-
-            if(c->GetCompareMode() ==
-                objects::EventCondition::CompareMode_t::EXISTS)
-            {
-                ids.insert((uint32_t)c->GetValue1());
-            }
-        });
-}
-
-void FindRefWindow::BuildHNPCDataFilters()
-{
-    mZoneFilter = ([](const std::shared_ptr<objects::ServerZone>& zone,
-        std::set<uint32_t>& ids)
-        {
-            for(auto npc : zone->GetNPCs())
-            {
-                ids.insert(npc->GetID());
-            }
-        });
-
-    mZonePartialFilter = ([](const std::shared_ptr<
-        objects::ServerZonePartial>& p, std::set<uint32_t>& ids)
-        {
-            for(auto npc : p->GetNPCs())
-            {
-                ids.insert(npc->GetID());
-            }
-        });
-}
-
-void FindRefWindow::BuildONPCDataFilters()
-{
-    mZoneFilter = ([](const std::shared_ptr<objects::ServerZone>& zone,
-        std::set<uint32_t>& ids)
-        {
-            for(auto obj : zone->GetObjects())
-            {
-                ids.insert(obj->GetID());
-            }
-        });
-
-    mZonePartialFilter = ([](const std::shared_ptr<
-        objects::ServerZonePartial>& p, std::set<uint32_t>& ids)
-        {
-            for(auto obj : p->GetObjects())
-            {
-                ids.insert(obj->GetID());
-            }
-        });
-}
-
-void FindRefWindow::BuildShopProductDataFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::ADD_REMOVE_ITEMS] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionAddRemoveItems>(
-                action);
-            if(act->GetMode() == objects::ActionAddRemoveItems::Mode_t::POST)
-            {
-                for(auto& pair : act->GetItems())
-                {
-                    ids.insert(pair.first);
-                }
-            }
-        });
-}
-
-void FindRefWindow::BuildStatusDataFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::ADD_REMOVE_STATUS] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<
-                objects::ActionAddRemoveStatus>(action);
-            for(auto& pair : act->GetStatusStacks())
-            {
-                ids.insert(pair.first);
-            }
-
-            for(auto& pair : act->GetStatusTimes())
-            {
-                ids.insert(pair.first);
-            }
-        });
-
-    mEventConditionFilters[objects::EventCondition::Type_t::STATUS_ACTIVE] =
-        &FindRefWindow::GetValue1;
-}
-
-void FindRefWindow::BuildZoneDataFilters()
-{
-    mActionFilters[objects::Action::ActionType_t::SET_HOMEPOINT] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionSetHomepoint>(
-                action);
-            ids.insert(act->GetZoneID());
-        });
-
-    mActionFilters[objects::Action::ActionType_t::ZONE_CHANGE] =
-        ([](const std::shared_ptr<objects::Action>& action,
-        std::set<uint32_t>& ids)
-        {
-            auto act = std::dynamic_pointer_cast<objects::ActionZoneChange>(
-                action);
-            ids.insert(act->GetZoneID());
-        });
-
-    mEventConditionFilters[
-        objects::EventCondition::Type_t::CLAN_HOME] = &FindRefWindow::GetValue1;
-}
-
-void FindRefWindow::GetValue1(const std::shared_ptr<
-    objects::EventCondition>& c, std::set<uint32_t>& ids)
-{
-    ids.insert((uint32_t)c->GetValue1());
-}
-
 void FindRefWindow::Export()
 {
     QString qPath = QFileDialog::getSaveFileName(this,
@@ -844,351 +267,16 @@ void FindRefWindow::FindAsync()
     ui->results->setHorizontalHeaderItem(1, new QTableWidgetItem("Location"));
     ui->results->setHorizontalHeaderItem(2, new QTableWidgetItem("Section"));
 
-    auto eventWindow = mMainWindow->GetEvents();
-    auto zoneWindow = mMainWindow->GetZones();
-
-    size_t eventFileCount = 0;
-    size_t zoneFileCount = 0;
-    size_t partialFileCount = 0;
+    auto scope = RefreshIndex(ui->radModeEventCurrentOnly->isChecked());
 
-    int row = 0;
-    if(mEventFilters.size() > 0 || mEventConditionFilters.size() > 0 ||
-        mActionFilters.size() > 0)
+    std::set<libcomp::String> sources;
+    for(auto& ref : mMainWindow->GetReferenceIndex()->Find(mObjType, val,
+        maxVal))
     {
-        // Search events (and event actions)
-        std::list<libcomp::String> eventFiles;
-        if(ui->radModeEventCurrentOnly->isChecked())
-        {
-            auto current = eventWindow->GetCurrentFile();
-            if(!current.IsEmpty())
-            {
-                eventFiles.push_back(current);
-            }
-        }
-        else
-        {
-            eventFiles = eventWindow->GetCurrentFiles();
-        }
-
-        for(auto path : eventFiles)
+        if(scope.find(ref.Source) != scope.end())
         {
-            auto events = eventWindow->GetFileEvents(path);
-            for(auto e : events)
-            {
-                std::set<uint32_t> ids;
-
-                auto eIter = mEventFilters.find(e->GetEventType());
-                if(eIter != mEventFilters.end())
-                {
-                    eIter->second(e, ids);
-                }
-
-                // Gather all conditions and actions
-                auto conditions = e->GetConditions();
-                for(auto b : e->GetBranches())
-                {
-                    for(auto c : b->GetConditions())
-                    {
-                        conditions.push_back(c);
-                    }
-                }
-
-                std::list<std::shared_ptr<objects::Action>> actions;
-                switch(e->GetEventType())
-                {
-                case objects::Event::EventType_t::PERFORM_ACTIONS:
-                    actions = std::dynamic_pointer_cast<
-                        objects::EventPerformActions>(e)->GetActions();
-                    break;
-                case objects::Event::EventType_t::PROMPT:
-                    for(auto choice : std::dynamic_pointer_cast<
-                        objects::EventPrompt>(e)->GetChoices())
-                    {
-                        for(auto c : choice->GetConditions())
-                        {
-                            conditions.push_back(c);
-                        }
-                    }
-                    break;
-                default:
-                    break;
-                }
-
-                for(auto c : conditions)
-                {
-                    auto cIter = mEventConditionFilters.find(c->GetType());
-                    if(cIter != mEventConditionFilters.end())
-                    {
-                        cIter->second(*this, c, ids);
-                    }
-                }
-
-                FilterActionIDs(actions, ids);
-
-                bool refFound = false;
-                for(uint32_t id : GetFilteredIDs(ids, val, maxVal))
-                {
-                    AddResult(id, path, libcomp::String("Event %1")
-                        .Arg(e->GetID()));
-                    refFound = true;
-                }
-
-                if(refFound)
-                {
-                    eventFileCount++;
-                }
-            }
-        }
-    }
-
-    if(!ui->radModeEventCurrentOnly->isChecked())
-    {
-        if(mZoneFilter || mSpawnFilter || mActionFilters.size() > 0)
-        {
-            // Search zones
-            std::unordered_map<libcomp::String,
-                std::shared_ptr<objects::ServerZone>> zoneFiles;
-            auto merged = zoneWindow->GetMergedZone();
-            if(merged && merged->CurrentZone)
-            {
-                zoneFiles[merged->Path] = merged->CurrentZone;
-            }
-
-            if(ui->useZoneDirectory->isChecked() &&
-                !ui->zoneDirectory->text().isEmpty())
-            {
-                QDirIterator it(ui->zoneDirectory->text(),
-                    QStringList() << "*.xml", QDir::Files);
-                while(it.hasNext())
-                {
-                    libcomp::String path = cs(it.next());
-                    if(zoneFiles.find(path) == zoneFiles.end())
-                    {
-                        auto zone = zoneWindow->LoadZoneFromFile(path);
-                        if(zone)
-                        {
-                            zoneFiles[path] = zone;
-                        }
-                    }
-                }
-            }
-
-            for(auto& zonePair : zoneFiles)
-            {
-                auto zone = zonePair.second;
-
-                std::unordered_map<libcomp::String, std::set<uint32_t>> ids;
-                if(mZoneFilter)
-                {
-                    mZoneFilter(zone, ids[""]);
-                }
-
-                if(mSpawnFilter)
-                {
-                    for(auto& spawnPair : zone->GetSpawns())
-                    {
-                        auto spawnID = libcomp::String("Spawn %1")
-                            .Arg(spawnPair.first);
-                        mSpawnFilter(spawnPair.second, ids[spawnID]);
-                    }
-                }
-
-                if(mActionFilters.size() > 0)
-                {
-                    for(auto npc : zone->GetNPCs())
-                    {
-                        auto npcID = libcomp::String("NPC %1")
-                            .Arg(npc->GetID());
-
-                        auto actions = npc->GetActions();
-                        FilterActionIDs(actions, ids[npcID]);
-                    }
-
-                    for(auto obj : zone->GetObjects())
-                    {
-                        auto objID = libcomp::String("Object %1")
-                            .Arg(obj->GetID());
-
-                        auto actions = obj->GetActions();
-                        FilterActionIDs(actions, ids[objID]);
-                    }
-
-                    for(auto& sgPair : zone->GetSpawnGroups())
-                    {
-                        auto sgID = libcomp::String("Spawn Group %1")
-                            .Arg(sgPair.first);
-
-                        auto actions = sgPair.second->GetSpawnActions();
-                        FilterActionIDs(actions, ids[sgID]);
-
-                        actions = sgPair.second->GetDefeatActions();
-                        FilterActionIDs(actions, ids[sgID]);
-                    }
-
-                    for(auto& pPair : zone->GetPlasmaSpawns())
-                    {
-                        auto plasmaID = libcomp::String("Plasma %1")
-                            .Arg(pPair.first);
-
-                        auto actions = pPair.second->GetSuccessActions();
-                        FilterActionIDs(actions, ids[plasmaID]);
-
-                        actions = pPair.second->GetFailActions();
-                        FilterActionIDs(actions, ids[plasmaID]);
-                    }
-
-                    for(auto& spotPair : zone->GetSpots())
-                    {
-                        auto spotID = libcomp::String("Spot %1")
-                            .Arg(spotPair.first);
-
-                        auto actions = spotPair.second->GetActions();
-                        FilterActionIDs(actions, ids[spotID]);
-
-                        actions = spotPair.second->GetLeaveActions();
-                        FilterActionIDs(actions, ids[spotID]);
-                    }
-
-                    for(auto trigger : zone->GetTriggers())
-                    {
-                        auto actions = trigger->GetActions();
-                        FilterActionIDs(actions, ids["Trigger"]);
-                    }
-                }
-
-                bool refFound = false;
-                for(auto& idPair : ids)
-                {
-                    for(uint32_t id : GetFilteredIDs(idPair.second, val,
-                        maxVal))
-                    {
-                        AddResult(id, libcomp::String("Zone %1 (%2)")
-                            .Arg(zone->GetID()).Arg(zone->GetDynamicMapID()),
-                            idPair.first);
-                        refFound = true;
-                    }
-                }
-
-                if(refFound)
-                {
-                    zoneFileCount++;
-                }
-            }
-        }
-
-        if(mZonePartialFilter || mSpawnFilter || mActionFilters.size() > 0)
-        {
-            // Search zone partials
-            for(auto& partialPair : zoneWindow->GetLoadedPartials())
-            {
-                auto partial = partialPair.second;
-                
-                std::unordered_map<libcomp::String, std::set<uint32_t>> ids;
-                if(mZonePartialFilter)
-                {
-                    mZonePartialFilter(partial, ids[""]);
-                }
-
-                if(mSpawnFilter)
-                {
-                    for(auto& spawnPair : partial->GetSpawns())
-                    {
-                        auto spawnID = libcomp::String("Spawn %1")
-                            .Arg(spawnPair.first);
-                        mSpawnFilter(spawnPair.second, ids[spawnID]);
-                    }
-                }
-
-                if(mActionFilters.size() > 0)
-                {
-                    for(auto npc : partial->GetNPCs())
-                    {
-                        auto npcID = libcomp::String("NPC %1")
-                            .Arg(npc->GetID());
-
-                        auto actions = npc->GetActions();
-                        FilterActionIDs(actions, ids[npcID]);
-                    }
-
-                    for(auto obj : partial->GetObjects())
-                    {
-                        auto objID = libcomp::String("Object %1")
-                            .Arg(obj->GetID());
-
-                        auto actions = obj->GetActions();
-                        FilterActionIDs(actions, ids[objID]);
-                    }
-
-                    for(auto& sgPair : partial->GetSpawnGroups())
-                    {
-                        auto sgID = libcomp::String("Spawn Group %1")
-                            .Arg(sgPair.first);
-
-                        auto actions = sgPair.second->GetSpawnActions();
-                        FilterActionIDs(actions, ids[sgID]);
-
-                        actions = sgPair.second->GetDefeatActions();
-                        FilterActionIDs(actions, ids[sgID]);
-                    }
-
-                    for(auto& spotPair : partial->GetSpots())
-                    {
-                        auto spotID = libcomp::String("Spot %1")
-                            .Arg(spotPair.first);
-
-                        auto actions = spotPair.second->GetActions();
-                        FilterActionIDs(actions, ids[spotID]);
-
-                        actions = spotPair.second->GetLeaveActions();
-                        FilterActionIDs(actions, ids[spotID]);
-                    }
-
-                    for(auto trigger : partial->GetTriggers())
-                    {
-                        auto actions = trigger->GetActions();
-                        FilterActionIDs(actions, ids["Trigger"]);
-                    }
-                }
-
-                bool refFound = false;
-                for(auto& idPair : ids)
-                {
-                    for(uint32_t id : GetFilteredIDs(idPair.second, val,
-                        maxVal))
-                    {
-                        AddResult(id, libcomp::String("Zone Partial %1")
-                            .Arg(partial->GetID()), idPair.first);
-                        refFound = true;
-                    }
-                }
-
-                if(refFound)
-                {
-                    partialFileCount++;
-                }
-            }
-        }
-
-        if(mDropSetFilter)
-        {
-            // Search drop sets
-            auto dataset = mMainWindow->GetBinaryDataSet("DropSet");
-            if(dataset)
-            {
-                for(auto obj : dataset->GetObjects())
-                {
-                    auto ds = std::dynamic_pointer_cast<objects::DropSet>(obj);
-
-                    std::set<uint32_t> ids;
-                    mDropSetFilter(ds, ids);
-
-                    for(uint32_t id : GetFilteredIDs(ids, val, maxVal))
-                    {
-                        AddResult(id, libcomp::String("Drop Set %1")
-                            .Arg(ds->GetID()), "");
-                    }
-                }
-            }
+            AddResult(ref.ID, ref.Location, ref.Section);
+            sources.insert(ref.Source);
         }
     }
 
@@ -1225,7 +313,7 @@ void FindRefWindow::FindAsync()
     if(ui->results->rowCount())
     {
         ui->lblRefs->setText(QString("%1 reference(s) found in %2 file(s)")
-            .arg(row).arg(eventFileCount + zoneFileCount + partialFileCount));
+            .arg(ui->results->rowCount()).arg(sources.size()));
     }
     else
     {
@@ -1233,100 +321,176 @@ void FindRefWindow::FindAsync()
     }
 }
 
-void FindRefWindow::AddResult(uint32_t id, const libcomp::String& location,
-    const libcomp::String& section)
+std::set<libcomp::String> FindRefWindow::RefreshIndex(bool eventsOnly)
 {
-    int row = ui->results->rowCount();
+    auto index = mMainWindow->GetReferenceIndex();
+    auto eventWindow = mMainWindow->GetEvents();
+    auto zoneWindow = mMainWindow->GetZones();
 
-    ui->results->setRowCount(++row);
-    ui->results->setItem(row - 1, 0, new QTableWidgetItem(
-        QString::number(id)));
+    std::list<std::shared_ptr<ReferenceSource>> sources;
+    std::set<libcomp::String> scope;
 
-    if(!location.IsEmpty())
+    // Search events (and event actions)
+    std::list<libcomp::String> eventFiles;
+    if(eventsOnly)
     {
-        ui->results->setItem(row - 1, 1, new QTableWidgetItem(qs(location)));
+        auto current = eventWindow->GetCurrentFile();
+        if(!current.IsEmpty())
+        {
+            eventFiles.push_back(current);
+        }
     }
-
-    if(!section.IsEmpty())
+    else
     {
-        ui->results->setItem(row - 1, 2, new QTableWidgetItem(qs(section)));
+        eventFiles = eventWindow->GetCurrentFiles();
     }
-}
 
-void FindRefWindow::FilterActionIDs(
-    const std::list<std::shared_ptr<objects::Action>>& actions,
-    std::set<uint32_t>& ids)
-{
-    auto currentActions = actions;
+    for(auto path : eventFiles)
+    {
+        auto source = std::make_shared<ReferenceSource>();
+        source->Key = libcomp::String("Event:%1").Arg(path);
+        source->Path = path;
+        source->Events = eventWindow->GetFileEvents(path);
+
+        sources.push_back(source);
+        scope.insert(source->Key);
+    }
 
-    std::list<std::shared_ptr<objects::Action>> newActions;
-    while(currentActions.size() > 0)
+    if(!eventsOnly)
     {
-        // Actions can't nest forever so loop until we're done
-        for(auto action : currentActions)
+        // Search zones, preferring the open zone to its file on disk
+        libcomp::String mergedPath;
+
+        auto merged = zoneWindow->GetMergedZone();
+        if(merged && merged->CurrentZone)
         {
-            auto aIter = mActionFilters.find(action->GetActionType());
-            if(aIter != mActionFilters.end())
-            {
-                aIter->second(action, ids);
-            }
+            mergedPath = merged->Path;
+
+            auto source = std::make_shared<ReferenceSource>();
+            source->Key = libcomp::String("Zone:%1").Arg(merged->Path);
+            source->Path = merged->Path;
+            source->Zones.push_back(merged->CurrentZone);
+
+            sources.push_back(source);
+            scope.insert(source->Key);
+
+            // Load the file again once the zone is no longer open
+            mZoneFileTimes.erase(merged->Path);
+        }
+
+        if(ui->useZoneDirectory->isChecked() &&
+            !ui->zoneDirectory->text().isEmpty())
+        {
+            auto indexed = index->GetSources();
 
-            switch(action->GetActionType())
+            std::list<libcomp::String> changed;
+
+            QDirIterator it(ui->zoneDirectory->text(),
+                QStringList() << "*.xml", QDir::Files);
+            while(it.hasNext())
             {
-            case objects::Action::ActionType_t::DELAY:
+                QString qPath = it.next();
+                libcomp::String path = cs(qPath);
+                if(path == mergedPath)
                 {
-                    auto act = std::dynamic_pointer_cast<
-                        objects::ActionDelay>(action);
-                    for(auto act2 : act->GetActions())
-                    {
-                        newActions.push_back(act2);
-                    }
+                    continue;
                 }
-                break;
-            case objects::Action::ActionType_t::SPAWN:
+
+                auto key = libcomp::String("Zone:%1").Arg(path);
+                scope.insert(key);
+
+                int64_t modified = (int64_t)QFileInfo(qPath).lastModified()
+                    .toMSecsSinceEpoch();
+
+                auto timeIter = mZoneFileTimes.find(path);
+                if(timeIter == mZoneFileTimes.end() ||
+                    timeIter->second != modified ||
+                    indexed.find(key) == indexed.end())
                 {
-                    auto act = std::dynamic_pointer_cast<
-                        objects::ActionSpawn>(action);
-                    for(auto act2 : act->GetDefeatActions())
-                    {
-                        newActions.push_back(act2);
-                    }
+                    mZoneFileTimes[path] = modified;
+                    changed.push_back(path);
                 }
-                break;
-            default:
-                break;
+            }
+
+            std::list<libcomp::String> errors;
+            index->LoadFiles(changed, [](const libcomp::String& path)
+                {
+                    return libcomp::Crypto::LoadFile(path.ToUtf8());
+                }, errors, "Zone:");
+
+            for(auto& path : errors)
+            {
+                LogGeneralError([&]()
+                {
+                    return libcomp::String("Failed to load file: %1\n")
+                        .Arg(path);
+                });
+
+                mZoneFileTimes.erase(path);
             }
         }
 
-        currentActions = newActions;
-        newActions.clear();
-    }
-}
+        // Search zone partials
+        for(auto& partialPair : zoneWindow->GetLoadedPartials())
+        {
+            auto source = std::make_shared<ReferenceSource>();
+            source->Key = libcomp::String("Partial:%1")
+                .Arg(partialPair.first);
+            source->Partials.push_back(partialPair.second);
 
-std::set<uint32_t> FindRefWindow::GetFilteredIDs(const std::set<uint32_t>& ids,
-    uint32_t value, uint32_t maxValue)
-{
-    std::set<uint32_t> result;
+            sources.push_back(source);
+            scope.insert(source->Key);
+        }
 
-    if(!maxValue)
-    {
-        // Check if the (only) value is in the set
-        if(ids.find(value) != ids.end())
+        // Search drop sets
+        auto dataset = mMainWindow->GetBinaryDataSet("DropSet");
+        if(dataset)
         {
-            result.insert(value);
+            auto source = std::make_shared<ReferenceSource>();
+            source->Key = "DropSet";
+
+            for(auto obj : dataset->GetObjects())
+            {
+                source->DropSets.push_back(std::dynamic_pointer_cast<
+                    objects::DropSet>(obj));
+            }
+
+            sources.push_back(source);
+            scope.insert(source->Key);
         }
     }
-    else
+
+    index->Update(sources);
+
+    // Drop anything that is no longer loaded
+    for(auto& key : index->GetSources())
     {
-        // Gather all IDs between min and max in the set
-        for(uint32_t val = value; val <= maxValue; val++)
+        if((!eventsOnly || key.Left(6) == "Event:") &&
+            scope.find(key) == scope.end())
         {
-            if(ids.find(val) != ids.end())
-            {
-                result.insert(val);
-            }
+            index->Remove(key);
         }
     }
 
-    return result;
+    return scope;
+}
+
+void FindRefWindow::AddResult(uint32_t id, const libcomp::String& location,
+    const libcomp::String& section)
+{
+    int row = ui->results->rowCount();
+
+    ui->results->setRowCount(++row);
+    ui->results->setItem(row - 1, 0, new QTableWidgetItem(
+        QString::number(id)));
+
+    if(!location.IsEmpty())
+    {
+        ui->results->setItem(row - 1, 1, new QTableWidgetItem(qs(location)));
+    }
+
+    if(!section.IsEmpty())
+    {
+        ui->results->setItem(row - 1, 2, new QTableWidgetItem(qs(section)));
+    }
 }
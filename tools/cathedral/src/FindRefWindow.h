@@ -27,31 +27,17 @@
 
 // Standard C++11 Includes
 #include <memory>
+#include <set>
+#include <unordered_map>
 
 // libcomp Includes
 #include <CString.h>
-#include <EnumMap.h>
-
-// objects Includes
-#include <Action.h>
-#include <Event.h>
-#include <EventCondition.h>
 
 // Qt Includes
 #include <PushIgnore.h>
 #include "ui_FindRefWindow.h"
 #include <PopIgnore.h>
 
-namespace objects
-{
-
-class DropSet;
-class ServerZone;
-class ServerZonePartial;
-class Spawn;
-
-} // namespace objects
-
 class MainWindow;
 
 class FindRefWindow : public QMainWindow
@@ -74,64 +60,25 @@ private slots:
     void ToggleZoneDirectory();
 
 private:
-    void BuildDropSetFilters();
-    void BuildCEventMessageDataFilters();
-    void BuildCHouraiDataFilters();
-    void BuildCHouraiMessageDataFilters();
-    void BuildCItemDataFilters();
-    void BuildCKeyItemDataFilters();
-    void BuildCQuestDataFilters();
-    void BuildCSoundDataFilters();
-    void BuildCTitleDataFilters();
-    void BuildCValuablesDataFilters();
-    void BuildDevilDataFilters();
-    void BuildHNPCDataFilters();
-    void BuildONPCDataFilters();
-    void BuildShopProductDataFilters();
-    void BuildStatusDataFilters();
-    void BuildZoneDataFilters();
-
-    void GetValue1(const std::shared_ptr<objects::EventCondition>& c,
-        std::set<uint32_t>& ids);
-
     void FindAsync();
 
+    /**
+     * Update the shared reference index with everything that can currently
+     * be searched. Objects open in the editors may have unsaved changes so
+     * they are always indexed again but zone files in the zone directory are
+     * only loaded again if they changed on disk.
+     * @param eventsOnly Only update the current event files.
+     * @returns Keys of the sources in scope for the search.
+     */
+    std::set<libcomp::String> RefreshIndex(bool eventsOnly);
+
     void AddResult(uint32_t id, const libcomp::String& location,
         const libcomp::String& section);
 
-    void FilterActionIDs(
-        const std::list<std::shared_ptr<objects::Action>>& actions,
-        std::set<uint32_t>& ids);
-
-    std::set<uint32_t> GetFilteredIDs(const std::set<uint32_t>& ids,
-        uint32_t value, uint32_t maxValue);
-
     MainWindow *mMainWindow;
 
-    libcomp::EnumMap<objects::Action::ActionType_t,
-        std::function<void(const std::shared_ptr<objects::Action>&,
-            std::set<uint32_t>&)>> mActionFilters;
-
-    libcomp::EnumMap<objects::Event::EventType_t,
-        std::function<void(const std::shared_ptr<objects::Event>&,
-            std::set<uint32_t>&)>> mEventFilters;
-
-    libcomp::EnumMap<objects::EventCondition::Type_t,
-        std::function<void(FindRefWindow&,
-            const std::shared_ptr<objects::EventCondition>&,
-            std::set<uint32_t>&)>> mEventConditionFilters;
-
-    std::function<void(const std::shared_ptr<objects::DropSet>&,
-        std::set<uint32_t>&)> mDropSetFilter;
-
-    std::function<void(const std::shared_ptr<objects::Spawn>&,
-        std::set<uint32_t>&)> mSpawnFilter;
-
-    std::function<void(const std::shared_ptr<objects::ServerZone>&,
-        std::set<uint32_t>&)> mZoneFilter;
-
-    std::function<void(const std::shared_ptr<objects::ServerZonePartial>&,
-        std::set<uint32_t>&)> mZonePartialFilter;
+    /// Modification time of each indexed zone directory file
+    std::unordered_map<libcomp::String, int64_t> mZoneFileTimes;
 
     libcomp::String mObjType;
 
@@ -33,6 +33,9 @@
 #include "SettingsWindow.h"
 #include "ZoneWindow.h"
 
+// refindex Includes
+#include <ReferenceIndex.h>
+
 // objects Includes
 #include <MiAIData.h>
 #include <MiCancelData.h>
@@ -109,6 +112,8 @@ MainWindow::MainWindow(QWidget *pParent) : QMainWindow(pParent)
     mEventWindow = new EventWindow(this);
     mZoneWindow = new ZoneWindow(this);
 
+    mReferenceIndex = std::make_shared<ReferenceIndex>();
+
     ui = new Ui::MainWindow;
     ui->setupUi(this);
 
@@ -738,6 +743,11 @@ std::shared_ptr<libcomp::DefinitionManager> MainWindow::GetDefinitions() const
     return mDefinitions;
 }
 
+std::shared_ptr<ReferenceIndex> MainWindow::GetReferenceIndex() const
+{
+    return mReferenceIndex;
+}
+
 DropSetWindow* MainWindow::GetDropSets() const
 {
     return mDropSetWindow;
@@ -53,6 +53,7 @@ class MainWindow;
 class DropSetWindow;
 class EventWindow;
 class ObjectSelectorWindow;
+class ReferenceIndex;
 class ZoneWindow;
 
 class MainWindow : public QMainWindow
@@ -67,6 +68,7 @@ public:
 
     std::shared_ptr<libcomp::DataStore> GetDatastore() const;
     std::shared_ptr<libcomp::DefinitionManager> GetDefinitions() const;
+    std::shared_ptr<ReferenceIndex> GetReferenceIndex() const;
 
     DropSetWindow* GetDropSets() const;
     EventWindow* GetEvents() const;
@@ -127,7 +129,10 @@ private:
 
     std::shared_ptr<libcomp::DataStore> mDatastore;
     std::shared_ptr<libcomp::DefinitionManager> mDefinitions;
-    
+
+    /// Index of definition references shared by every find window
+    std::shared_ptr<ReferenceIndex> mReferenceIndex;
+
     std::unordered_map<libcomp::String,
         std::shared_ptr<libcomp::BinaryDataSet>> mBinaryDataSets;
 
@@ -0,0 +1,167 @@
+/**
+ * @file tools/cryptstream/src/BatchTransform.cpp
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Parallel directory mode shared by the file crypt tools.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BatchTransform.h"
+
+// cryptstream Includes
+#include "CryptStream.h"
+
+// libcomp Includes
+#include <DataStore.h>
+
+// Standard C++11 Includes
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else // _WIN32
+#include <sys/stat.h>
+#endif // _WIN32
+
+using namespace cryptstream;
+
+bool cryptstream::MakeParentPath(const char *szPath)
+{
+    std::string path(szPath);
+    bool exists = true;
+
+    for(size_t i = 1; i < path.size(); ++i)
+    {
+        if('/' != path[i] && '\\' != path[i])
+        {
+            continue;
+        }
+
+        std::string dir = path.substr(0, i);
+
+#ifdef _WIN32
+        int result = _mkdir(dir.c_str());
+#else // _WIN32
+        int result = mkdir(dir.c_str(), 0755);
+#endif // _WIN32
+
+        exists = 0 == result || EEXIST == errno;
+    }
+
+    return exists;
+}
+
+int cryptstream::TransformDirectory(const char *szInDir,
+    const char *szOutDir, const FileTransform_t& transform)
+{
+    std::list<libcomp::String> files;
+    std::list<libcomp::String> dirs;
+    std::list<libcomp::String> symLinks;
+
+    libcomp::DataStore store(NULL);
+
+    if(!store.AddSearchPath(szInDir) ||
+        !store.GetListing("/", files, dirs, symLinks, true, true))
+    {
+        fprintf(stderr, "Failed to read directory: %s\n", szInDir);
+
+        return EXIT_FAILURE;
+    }
+
+    // Listed paths start with a slash so they can be appended directly.
+    std::vector<libcomp::String> work(files.begin(), files.end());
+
+    std::atomic<size_t> nextFile(0);
+    std::atomic<size_t> processed(0);
+    std::atomic<uint64_t> totalBytes(0);
+    std::mutex outputLock;
+
+    auto worker = [&]()
+    {
+        for(size_t i = nextFile++; i < work.size(); i = nextFile++)
+        {
+            std::string inPath = libcomp::String("%1%2").Arg(
+                szInDir).Arg(work[i]).ToUtf8();
+            std::string outPath = libcomp::String("%1%2").Arg(
+                szOutDir).Arg(work[i]).ToUtf8();
+
+            uint64_t size = 0;
+            {
+                auto pIn = OpenFile(inPath.c_str(), "rb");
+
+                if(!pIn || !RemainingSize(pIn.get(), size))
+                {
+                    size = 0;
+                }
+            }
+
+            if(MakeParentPath(outPath.c_str()) &&
+                EXIT_SUCCESS == transform(inPath.c_str(), outPath.c_str()))
+            {
+                processed++;
+                totalBytes += size;
+            }
+            else
+            {
+                std::lock_guard<std::mutex> lock(outputLock);
+
+                fprintf(stderr, "Failed to process file: %s\n",
+                    inPath.c_str());
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::list<std::thread*> threads;
+
+    uint32_t threadCount = std::max(1U, std::thread::hardware_concurrency());
+    for(uint32_t i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(new std::thread(worker));
+    }
+
+    for(auto thread : threads)
+    {
+        thread->join();
+
+        delete thread;
+    }
+
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    double megabytes = (double)totalBytes / (1024.0 * 1024.0);
+
+    printf("Processed %u of %u files (%.1f MiB) in %.2f seconds "
+        "(%.1f MiB/s) with %u workers.\n", (uint32_t)processed,
+        (uint32_t)work.size(), megabytes, seconds,
+        0.0 < seconds ? megabytes / seconds : 0.0, threadCount);
+
+    return processed == work.size() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
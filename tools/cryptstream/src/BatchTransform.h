@@ -0,0 +1,60 @@
+/**
+ * @file tools/cryptstream/src/BatchTransform.h
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Parallel directory mode shared by the file crypt tools.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOOLS_CRYPTSTREAM_SRC_BATCHTRANSFORM_H
+#define TOOLS_CRYPTSTREAM_SRC_BATCHTRANSFORM_H
+
+// Standard C++11 Includes
+#include <functional>
+
+namespace cryptstream
+{
+
+/// Transform from an input file path to an output file path that returns
+/// a standard exit code
+typedef std::function<int(const char*, const char*)> FileTransform_t;
+
+/**
+ * Create every missing directory leading up to a file.
+ * @param szPath Path to the file that will be written.
+ * @returns true if the parent directory exists, false otherwise.
+ */
+bool MakeParentPath(const char *szPath);
+
+/**
+ * Apply a file transform to every file under a directory, writing each
+ * output to the same relative path under another directory. Files are
+ * handed out to one worker per hardware thread and a summary with the
+ * total throughput is printed when all workers finish.
+ * @param szInDir Directory to read input files from recursively.
+ * @param szOutDir Directory to write output files to.
+ * @param transform Transform to apply to each file.
+ * @returns Standard exit code which is a failure if any file failed.
+ */
+int TransformDirectory(const char *szInDir, const char *szOutDir,
+    const FileTransform_t& transform);
+
+} // namespace cryptstream
+
+#endif // TOOLS_CRYPTSTREAM_SRC_BATCHTRANSFORM_H
@@ -0,0 +1,146 @@
+/**
+ * @file tools/cryptstream/src/CryptStream.cpp
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Chunked streaming transforms shared by the file crypt tools.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CryptStream.h"
+
+// Standard C++11 Includes
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CRYPTSTREAM_SSE2
+#include <emmintrin.h>
+#endif // SSE2
+
+using namespace cryptstream;
+
+File_t cryptstream::OpenFile(const char *szPath, const char *szMode)
+{
+    return File_t(fopen(szPath, szMode), &fclose);
+}
+
+bool cryptstream::RemainingSize(FILE *pFile, uint64_t& size)
+{
+    long start = ftell(pFile);
+
+    if(0 > start || 0 != fseek(pFile, 0, SEEK_END))
+    {
+        return false;
+    }
+
+    long end = ftell(pFile);
+
+    if(end < start || 0 != fseek(pFile, start, SEEK_SET))
+    {
+        return false;
+    }
+
+    size = (uint64_t)(end - start);
+
+    return true;
+}
+
+void cryptstream::XorKey32(uint8_t *pData, size_t size, uint32_t key,
+    uint64_t offset)
+{
+    // Lay out the key bytes as they apply to the start of the data. The
+    // pattern repeats every 4 bytes so a 16 byte block can be XORed with
+    // the same pattern no matter where it is in the data.
+    uint8_t pattern[16];
+
+    for(size_t i = 0; i < sizeof(pattern); ++i)
+    {
+        pattern[i] = (uint8_t)(key >> (8 * ((offset + i) % 4)));
+    }
+
+    size_t i = 0;
+
+#ifdef CRYPTSTREAM_SSE2
+    __m128i wideKey = _mm_loadu_si128((const __m128i*)pattern);
+
+    for(; i + 16 <= size; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(pData + i));
+        _mm_storeu_si128((__m128i*)(pData + i),
+            _mm_xor_si128(block, wideKey));
+    }
+#endif // CRYPTSTREAM_SSE2
+
+    uint64_t wordKey;
+    memcpy(&wordKey, pattern, sizeof(wordKey));
+
+    for(; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, pData + i, sizeof(word));
+        word ^= wordKey;
+        memcpy(pData + i, &word, sizeof(word));
+    }
+
+    for(; i < size; ++i)
+    {
+        pData[i] ^= pattern[i % 16];
+    }
+}
+
+bool cryptstream::TransformStream(FILE *pIn, FILE *pOut, uint64_t size,
+    const ChunkTransform_t& transform)
+{
+    // Batch workers call this for every file so keep the buffer around.
+    static thread_local std::vector<uint8_t> buffer;
+
+    if(buffer.size() < CHUNK_SIZE)
+    {
+        buffer.resize(CHUNK_SIZE);
+    }
+
+    uint64_t offset = 0;
+
+    while(offset < size)
+    {
+        size_t chunk = (size_t)std::min((uint64_t)CHUNK_SIZE, size - offset);
+
+        if(1 != fread(&buffer[0], chunk, 1, pIn))
+        {
+            fprintf(stderr, "Failed to read input file.\n");
+
+            return false;
+        }
+
+        transform(&buffer[0], chunk, offset);
+
+        if(1 != fwrite(&buffer[0], chunk, 1, pOut))
+        {
+            fprintf(stderr, "Failed to write output file.\n");
+
+            return false;
+        }
+
+        offset += chunk;
+    }
+
+    return true;
+}
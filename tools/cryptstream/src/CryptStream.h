@@ -0,0 +1,92 @@
+/**
+ * @file tools/cryptstream/src/CryptStream.h
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Chunked streaming transforms shared by the file crypt tools.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOOLS_CRYPTSTREAM_SRC_CRYPTSTREAM_H
+#define TOOLS_CRYPTSTREAM_SRC_CRYPTSTREAM_H
+
+// Standard C++11 Includes
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <stdint.h>
+
+namespace cryptstream
+{
+
+/// Number of bytes read, transformed and written at a time. This must be
+/// a multiple of 16 so every chunk starts on a key boundary.
+const size_t CHUNK_SIZE = 1024 * 1024;
+
+/// File handle that is closed when it goes out of scope
+typedef std::unique_ptr<FILE, int(*)(FILE*)> File_t;
+
+/// Transform applied in place to each chunk of a stream given the chunk
+/// data, chunk size and offset of the chunk from the start of the stream
+typedef std::function<void(uint8_t*, size_t, uint64_t)> ChunkTransform_t;
+
+/**
+ * Open a file that will be closed when the returned handle is destroyed.
+ * @param szPath Path to the file to open.
+ * @param szMode Mode to pass to fopen.
+ * @returns Handle to the file which is empty if it failed to open.
+ */
+File_t OpenFile(const char *szPath, const char *szMode);
+
+/**
+ * Get the number of bytes from the current position to the end of a file.
+ * The current position is restored before returning.
+ * @param pFile File to check.
+ * @param size Output parameter set to the number of remaining bytes.
+ * @returns true if the size was determined, false if a seek failed.
+ */
+bool RemainingSize(FILE *pFile, uint64_t& size);
+
+/**
+ * XOR data with a repeating 32-bit little endian key. The data is
+ * processed 16 bytes at a time with SSE2 when it is available or 8 bytes
+ * at a time otherwise, instead of one word at a time.
+ * @param pData Data to transform in place.
+ * @param size Number of bytes to transform.
+ * @param key Key to XOR the data with.
+ * @param offset Offset of the data from the start of the stream which
+ *  determines which key byte the data starts on.
+ */
+void XorKey32(uint8_t *pData, size_t size, uint32_t key, uint64_t offset);
+
+/**
+ * Read a number of bytes from one file, transform them in fixed size
+ * chunks and write them to another file. Each calling thread reuses its
+ * own chunk buffer so only one chunk per thread is ever held in memory.
+ * @param pIn File to read from at its current position.
+ * @param pOut File to write to at its current position.
+ * @param size Number of bytes to transform.
+ * @param transform Transform to apply to each chunk.
+ * @returns true if every byte was read and written, false otherwise.
+ */
+bool TransformStream(FILE *pIn, FILE *pOut, uint64_t size,
+    const ChunkTransform_t& transform);
+
+} // namespace cryptstream
+
+#endif // TOOLS_CRYPTSTREAM_SRC_CRYPTSTREAM_H
@@ -24,22 +24,27 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// cryptstream Includes
+#include <BatchTransform.h>
+
+// libcomp Includes
 #include <Crypto.h>
 
+// Standard C++11 Includes
 #include <fstream>
 #include <iostream>
 #include <cstdlib>
+#include <string>
 
-int main(int argc, char *argv[])
+/**
+ * Decrypt a Blowfish encrypted file.
+ * @param szIn Path to the input file to decrypt.
+ * @param szOut Path to the output file to write.
+ * @returns Standard exit code.
+ */
+int DecryptFile(const char *szIn, const char *szOut)
 {
-    if(3 != argc)
-    {
-        std::cerr << "USAGE: " << argv[0] << " IN OUT" << std::endl;
-
-        return EXIT_FAILURE;
-    }
-
-    std::vector<char> data = libcomp::Crypto::LoadFile(argv[1]);
+    std::vector<char> data = libcomp::Crypto::LoadFile(szIn);
 
     if(data.empty())
     {
@@ -56,7 +61,7 @@ int main(int argc, char *argv[])
     }
 
     std::ofstream out;
-    out.open(argv[2], std::ofstream::out | std::ofstream::binary);
+    out.open(szOut, std::ofstream::out | std::ofstream::binary);
     out.write(&data[0], static_cast<std::streamsize>(data.size()));
 
     if(!out.good())
@@ -68,3 +73,23 @@ int main(int argc, char *argv[])
 
     return EXIT_SUCCESS;
 }
+
+int main(int argc, char *argv[])
+{
+    if(4 == argc && std::string("-r") == argv[1])
+    {
+        return cryptstream::TransformDirectory(argv[2], argv[3],
+            DecryptFile);
+    }
+
+    if(3 != argc)
+    {
+        std::cerr << "USAGE: " << argv[0] << " IN OUT" << std::endl;
+        std::cerr << "       " << argv[0] << " -r IN_DIR OUT_DIR"
+            << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    return DecryptFile(argv[1], argv[2]);
+}
@@ -22,15 +22,20 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+// cryptstream Includes
+#include <BatchTransform.h>
+#include <CryptStream.h>
+
+// libcomp Includes
+#include <Compress.h>
+
+// Standard C++11 Includes
 #include <algorithm>
 #include <cstdio>
 #include <cstdlib>
-#include <cstring>
 #include <stdint.h>
 #include <string>
-
-// libcomp Includes
-#include <Compress.h>
+#include <vector>
 
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 // Edit these to match if you need to work with the original magic and key!
@@ -66,16 +71,18 @@
     ((uint32_t)NIF_MAGIC2 << 8) | \
      (uint32_t)NIF_MAGIC1)
 
+/// Largest decompressed or compressed NIF file that will be processed
+#define NIF_MAX_SIZE (30000000)
+
 /**
- * Encrypt a background music file.
+ * Encrypt a NIF file.
  * @param szIn Path to the input file to encrypt.
  * @param szOut Path to the output file to write.
  * @returns Standard exit code.
  */
 int EncryptFile(const char *szIn, const char *szOut)
 {
-    FILE *pIn = fopen(szIn, "rb");
-    FILE *pOut = fopen(szOut, "wb");
+    auto pIn = cryptstream::OpenFile(szIn, "rb");
 
     if(!pIn)
     {
@@ -84,66 +91,48 @@ int EncryptFile(const char *szIn, const char *szOut)
         return EXIT_FAILURE;
     }
 
-    if(!pOut)
-    {
-        fprintf(stderr, "Failed to open input file.\n");
-
-        return EXIT_FAILURE;
-    }
+    // Get the size of the file.
+    uint64_t fileSize = 0;
 
-    if(0 != fseek(pIn, 0, SEEK_END))
+    if(!cryptstream::RemainingSize(pIn.get(), fileSize))
     {
         fprintf(stderr, "Seek error in input file.\n");
 
         return EXIT_FAILURE;
     }
 
-    // Get the size of the file.
-    uint32_t sz = (uint32_t)ftell(pIn);
-
     // Check the size of the file.
-    if(sz > 30000000)
+    if(fileSize > NIF_MAX_SIZE)
     {
         fprintf(stderr, "Input file is too big!\n");
 
         return EXIT_FAILURE;
     }
 
-    // Start over now that we have the size.
-    if(0 != fseek(pIn, 0, SEEK_SET))
-    {
-        fprintf(stderr, "Seek error in input file.\n");
-
-        return EXIT_FAILURE;
-    }
-
-    // Allocate the buffer.
-    uint8_t *pData = new uint8_t[sz];
-    memset(pData, 0, sz);
+    uint32_t sz = (uint32_t)fileSize;
 
     // Calculate the max size of the compressed data.
     int32_t maxSize = (int)((float)sz * 0.001f + 0.5f);
     maxSize += (int32_t)sz + 12;
 
-    // Allocate the output buffer.
-    uint8_t *pDataOut = new uint8_t[(uint32_t)maxSize];
+    // The compressed data has to be held in full since the compressed size
+    // is part of the header. Reuse the buffers in directory mode.
+    static thread_local std::vector<uint8_t> data;
+    static thread_local std::vector<uint8_t> dataOut;
+
+    data.resize(std::max(sz, (uint32_t)1));
+    dataOut.resize((size_t)maxSize);
 
     // Read the file.
-    if(1 != fread(pData, sz, 1, pIn))
+    if(1 != fread(&data[0], sz, 1, pIn.get()))
     {
         fprintf(stderr, "Failed to read input file.\n");
 
-        // Free the input and output buffers.
-        delete[] pData;
-        delete[] pDataOut;
-        pDataOut = 0;
-        pData = 0;
-
         return EXIT_FAILURE;
     }
 
     // Attempt to compress the file.
-    int32_t compSize = libcomp::Compress::Compress(pData, pDataOut,
+    int32_t compSize = libcomp::Compress::Compress(&data[0], &dataOut[0],
         (int32_t)sz, maxSize, 9);
 
     // Check if it compressed.
@@ -152,128 +141,60 @@ int EncryptFile(const char *szIn, const char *szOut)
         fprintf(stderr, "Failed to compress NIF file!\n");
         fprintf(stderr, "Size: %d\n", compSize);
 
-        // Free the input and output buffers.
-        delete[] pData;
-        delete[] pDataOut;
-        pDataOut = 0;
-        pData = 0;
-
-        return EXIT_FAILURE;
-    }
-
-    // Check the size of the file.
-    if(compSize > 30000000)
-    {
-        fprintf(stderr, "Input file is too big!\n");
-
-        // Free the input and output buffers.
-        delete[] pData;
-        delete[] pDataOut;
-        pDataOut = 0;
-        pData = 0;
-
         return EXIT_FAILURE;
     }
 
     // Sanity check here.
-    if(compSize > (int32_t)sz)
+    if(compSize > NIF_MAX_SIZE || compSize > (int32_t)sz)
     {
         fprintf(stderr, "Input file is too big!\n");
 
-        // Free the input and output buffers.
-        delete[] pData;
-        delete[] pDataOut;
-        pDataOut = 0;
-        pData = 0;
-
         return EXIT_FAILURE;
     }
 
-    // Encrypt the sizes.
-    uint32_t cryptDecompSize = sz ^ NIF_XOR_KEY1;
-    int32_t cryptCompSize = compSize ^ (int32_t)NIF_XOR_KEY2;
+    auto pOut = cryptstream::OpenFile(szOut, "wb");
 
-    // Write the magic.
-    uint32_t magic = NIF_MAGIC;
-
-    if(1 != fwrite(&magic, 4, 1, pOut))
+    if(!pOut)
     {
-        fprintf(stderr, "Failed to write output file.\n");
-
-        // Free the input and output buffers.
-        delete[] pData;
-        delete[] pDataOut;
-        pDataOut = 0;
-        pData = 0;
+        fprintf(stderr, "Failed to open output file.\n");
 
         return EXIT_FAILURE;
     }
 
-    // Write the uncompressed size.
-    if(1 != fwrite(&cryptDecompSize, 4, 1, pOut))
-    {
-        fprintf(stderr, "Failed to write output file.\n");
-
-        // Free the input and output buffers.
-        delete[] pData;
-        delete[] pDataOut;
-        pDataOut = 0;
-        pData = 0;
-
-        return EXIT_FAILURE;
-    }
+    // Write the magic and the encrypted sizes.
+    uint32_t header[3] = {
+        NIF_MAGIC,
+        sz ^ NIF_XOR_KEY1,
+        (uint32_t)compSize ^ NIF_XOR_KEY2,
+    };
 
-    // Write the compressed size.
-    if(1 != fwrite(&cryptCompSize, 4, 1, pOut))
+    if(1 != fwrite(header, sizeof(header), 1, pOut.get()))
     {
         fprintf(stderr, "Failed to write output file.\n");
 
-        // Free the input and output buffers.
-        delete[] pData;
-        delete[] pDataOut;
-        pDataOut = 0;
-        pData = 0;
-
         return EXIT_FAILURE;
     }
 
     // Write the compressed data.
-    if(1 != fwrite(pDataOut, (size_t)compSize, 1, pOut))
+    if(1 != fwrite(&dataOut[0], (size_t)compSize, 1, pOut.get()))
     {
         fprintf(stderr, "Failed to write output file.\n");
 
-        // Free the input and output buffers.
-        delete[] pData;
-        delete[] pDataOut;
-        pDataOut = 0;
-        pData = 0;
-
         return EXIT_FAILURE;
     }
 
-    // Free the input and output buffers.
-    delete[] pData;
-    delete[] pDataOut;
-    pDataOut = 0;
-    pData = 0;
-
-    // Close the files and cleanup.
-    fclose(pIn);
-    fclose(pOut);
-
     return EXIT_SUCCESS;
 }
 
 /**
- * Decrypt a background music file.
+ * Decrypt a NIF file.
  * @param szIn Path to the input file to decrypt.
  * @param szOut Path to the output file to write.
  * @returns Standard exit code.
  */
 int DecryptFile(const char *szIn, const char *szOut)
 {
-    FILE *pIn = fopen(szIn, "rb");
-    FILE *pOut = fopen(szOut, "wb");
+    auto pIn = cryptstream::OpenFile(szIn, "rb");
 
     if(!pIn)
     {
@@ -282,170 +203,119 @@ int DecryptFile(const char *szIn, const char *szOut)
         return EXIT_FAILURE;
     }
 
-    if(!pOut)
-    {
-        fprintf(stderr, "Failed to open input file.\n");
+    // Read the magic and the encrypted sizes.
+    uint32_t header[3] = { 0, 0, 0 };
 
-        return EXIT_FAILURE;
-    }
-
-    // Read and check the magic is correct.
-    uint32_t magic = 0;
-
-    if(1 != fread(&magic, 4, 1, pIn))
+    if(1 != fread(header, sizeof(header), 1, pIn.get()))
     {
         fprintf(stderr, "Failed to read input file.\n");
 
         return EXIT_FAILURE;
     }
 
-    if(NIF_MAGIC != magic)
+    // Check the magic is correct.
+    if(NIF_MAGIC != header[0])
     {
         fprintf(stderr, "ERROR: File is not encrypted!\n");
 
         return EXIT_FAILURE;
     }
 
-    // Get the decompressed size.
-    uint32_t decompSize = 0;
-
-    if(1 != fread(&decompSize, 4, 1, pIn))
-    {
-        fprintf(stderr, "Failed to read input file.\n");
-
-        return EXIT_FAILURE;
-    }
-
-    // Decrypt the size and check it.
-    decompSize ^= NIF_XOR_KEY1;
+    // Decrypt the sizes and check them.
+    uint32_t decompSize = header[1] ^ NIF_XOR_KEY1;
+    uint32_t compSize = header[2] ^ NIF_XOR_KEY2;
 
-    if(decompSize > 30000000)
+    if(decompSize > NIF_MAX_SIZE)
     {
         fprintf(stderr, "Input file is too big!\n");
 
         return EXIT_FAILURE;
     }
 
-    // Get the compressed size.
-    uint32_t compSize = 0;
+    // Get the size of the data after the header.
+    uint64_t sz = 0;
 
-    if(1 != fread(&compSize, 4, 1, pIn))
-    {
-        fprintf(stderr, "Failed to read input file.\n");
-
-        return EXIT_FAILURE;
-    }
-
-    if(0 != fseek(pIn, 0, SEEK_END))
+    if(!cryptstream::RemainingSize(pIn.get(), sz))
     {
         fprintf(stderr, "Seek error in input file.\n");
 
         return EXIT_FAILURE;
     }
 
-    // Get the size of the file.
-    uint32_t sz = (uint32_t)ftell(pIn);
-
-    // We don't read the magic, size and key as part of the file.
-    sz -= 4 * 3;
-
-    // Check the size of the file.
-    if(sz > 30000000)
+    if(sz > NIF_MAX_SIZE || compSize > sz)
     {
         fprintf(stderr, "Input file is too big!\n");
 
         return EXIT_FAILURE;
     }
 
-    // Decrypt and check the compressed size.
-    compSize ^= NIF_XOR_KEY2;
+    // Reuse the buffers in directory mode.
+    static thread_local std::vector<uint8_t> data;
+    static thread_local std::vector<uint8_t> dataOut;
 
-    if(compSize > sz)
-    {
-        fprintf(stderr, "Input file is too big!\n");
-
-        return EXIT_FAILURE;
-    }
-
-    // Start over now that we have the key.
-    if(0 != fseek(pIn, 4 * 3, SEEK_SET))
-    {
-        fprintf(stderr, "Seek error in input file.\n");
-
-        return EXIT_FAILURE;
-    }
-
-    // Allocate the buffer.
-    uint8_t *pData = new uint8_t[compSize];
-    memset(pData, 0, compSize);
-
-    // Allocate the output buffer.
-    uint8_t *pDataOut = new uint8_t[decompSize];
+    data.resize(std::max(compSize, (uint32_t)1));
+    dataOut.resize(std::max(decompSize, (uint32_t)1));
 
     // Read the file.
-    if(1 != fread(pData, compSize, 1, pIn))
+    if(1 != fread(&data[0], compSize, 1, pIn.get()))
     {
         fprintf(stderr, "Failed to read input file.\n");
 
-        // Free the input and output buffers.
-        delete[] pData;
-        delete[] pDataOut;
-        pDataOut = 0;
-        pData = 0;
-
         return EXIT_FAILURE;
     }
 
     // Attempt to decompress the file.
-    if((int32_t)decompSize != libcomp::Compress::Decompress(pData, pDataOut,
-        (int32_t)compSize, (int32_t)decompSize))
+    if((int32_t)decompSize != libcomp::Compress::Decompress(&data[0],
+        &dataOut[0], (int32_t)compSize, (int32_t)decompSize))
     {
         fprintf(stderr, "Failed to decompress NIF file!\n");
 
-        // Free the input and output buffers.
-        delete[] pData;
-        delete[] pDataOut;
-        pDataOut = 0;
-        pData = 0;
+        return EXIT_FAILURE;
+    }
+
+    auto pOut = cryptstream::OpenFile(szOut, "wb");
+
+    if(!pOut)
+    {
+        fprintf(stderr, "Failed to open output file.\n");
 
         return EXIT_FAILURE;
     }
 
     // Write the output file contents.
-    if(1 != fwrite(pDataOut, decompSize, 1, pOut))
+    if(1 != fwrite(&dataOut[0], decompSize, 1, pOut.get()))
     {
         fprintf(stderr, "Failed to write output file.\n");
 
-        // Free the input and output buffers.
-        delete[] pData;
-        delete[] pDataOut;
-        pDataOut = 0;
-        pData = 0;
-
         return EXIT_FAILURE;
     }
 
-    // Free the input and output buffers.
-    delete[] pData;
-    delete[] pDataOut;
-    pDataOut = 0;
-    pData = 0;
-
-    // Close the files and cleanup.
-    fclose(pIn);
-    fclose(pOut);
-
     return EXIT_SUCCESS;
 }
 
 /**
- * Encrypt or decrypt a NIF file.
+ * Encrypt or decrypt a NIF file or every file in a directory.
  * @param argc Number of command line arguments.
  * @param argv Array of command line arguments.
  * @returns Standard exit code.
  */
 int main(int argc, char *argv[])
 {
+    // Detect directory mode.
+    if(argc >= 4 && std::string("-r") == argv[1])
+    {
+        if(argc == 5 && std::string("-d") == argv[2])
+        {
+            return cryptstream::TransformDirectory(argv[3], argv[4],
+                DecryptFile);
+        }
+        else if(argc == 4)
+        {
+            return cryptstream::TransformDirectory(argv[2], argv[3],
+                EncryptFile);
+        }
+    }
+
     // Detect encrypt or decrypt mode or print usage.
     if(argc == 4 && std::string("-d") == argv[1])
     {
@@ -458,6 +328,7 @@ int main(int argc, char *argv[])
     else
     {
         fprintf(stderr, "USAGE: %s [-d] IN OUT\n", argv[0]);
+        fprintf(stderr, "       %s -r [-d] IN_DIR OUT_DIR\n", argv[0]);
     }
 
     return EXIT_FAILURE;
@@ -0,0 +1,890 @@
+/**
+ * @file tools/refindex/src/ReferenceIndex.cpp
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Inverted index of the definitions referenced by server data.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ReferenceIndex.h"
+
+// objects Includes
+#include <ActionAddRemoveItems.h>
+#include <ActionAddRemoveStatus.h>
+#include <ActionCreateLoot.h>
+#include <ActionDelay.h>
+#include <ActionDisplayMessage.h>
+#include <ActionPlayBGM.h>
+#include <ActionPlaySoundEffect.h>
+#include <ActionSetHomepoint.h>
+#include <ActionSpawn.h>
+#include <ActionStageEffect.h>
+#include <ActionUpdateCOMP.h>
+#include <ActionUpdateFlag.h>
+#include <ActionUpdatePoints.h>
+#include <ActionUpdateQuest.h>
+#include <ActionZoneChange.h>
+#include <DropSet.h>
+#include <EventChoice.h>
+#include <EventCondition.h>
+#include <EventExNPCMessage.h>
+#include <EventITime.h>
+#include <EventNPCMessage.h>
+#include <EventPerformActions.h>
+#include <EventPrompt.h>
+#include <ItemDrop.h>
+#include <PlasmaSpawn.h>
+#include <ServerNPC.h>
+#include <ServerObject.h>
+#include <ServerZone.h>
+#include <ServerZonePartial.h>
+#include <ServerZoneSpot.h>
+#include <ServerZoneTrigger.h>
+#include <Spawn.h>
+#include <SpawnGroup.h>
+
+#include <PushIgnore.h>
+#include <tinyxml2.h>
+#include <PopIgnore.h>
+
+// Standard C++11 Includes
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <tuple>
+
+/// Definition types references can be found for
+static const std::set<libcomp::String> SUPPORTED_TYPES = {
+    "CEventMessageData",
+    "CHouraiData",
+    "CHouraiMessageData",
+    "CItemData",
+    "CKeyItemData",
+    "CQuestData",
+    "CSoundData",
+    "CTitleData",
+    "CValuablesData",
+    "DevilData",
+    "DropSet",
+    "hNPCData",
+    "oNPCData",
+    "ShopProductData",
+    "StatusData",
+    "ZoneData",
+};
+
+/**
+ * Collects the references of a single source, ignoring any reference
+ * already found in the same section.
+ */
+class ReferenceCollector
+{
+public:
+    ReferenceCollector(const libcomp::String& source) : mSource(source)
+    {
+    }
+
+    /**
+     * Set the location and section of the references added next.
+     * @param location Object containing the references.
+     * @param section Part of the object containing the references.
+     */
+    void SetSection(const libcomp::String& location,
+        const libcomp::String& section)
+    {
+        mLocation = location;
+        mSection = section;
+    }
+
+    /**
+     * Add a reference to the current section.
+     * @param objType Type of the referenced definition.
+     * @param id ID of the referenced definition.
+     */
+    void Add(const libcomp::String& objType, uint32_t id)
+    {
+        if(!mSeen.insert(std::make_tuple(objType, id, mLocation,
+            mSection)).second)
+        {
+            return;
+        }
+
+        Reference ref;
+        ref.ObjectType = objType;
+        ref.ID = id;
+        ref.Source = mSource;
+        ref.Location = mLocation;
+        ref.Section = mSection;
+
+        mReferences.push_back(ref);
+    }
+
+    std::list<Reference>& GetReferences()
+    {
+        return mReferences;
+    }
+
+private:
+    libcomp::String mSource;
+    libcomp::String mLocation;
+    libcomp::String mSection;
+
+    std::set<std::tuple<libcomp::String, uint32_t, libcomp::String,
+        libcomp::String>> mSeen;
+    std::list<Reference> mReferences;
+};
+
+static void ExtractActions(
+    const std::list<std::shared_ptr<objects::Action>>& actions,
+    ReferenceCollector& refs)
+{
+    auto currentActions = actions;
+
+    std::list<std::shared_ptr<objects::Action>> newActions;
+    while(currentActions.size() > 0)
+    {
+        // Actions can't nest forever so loop until we're done
+        for(auto action : currentActions)
+        {
+            switch(action->GetActionType())
+            {
+            case objects::Action::ActionType_t::ADD_REMOVE_ITEMS:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionAddRemoveItems>(action);
+                    bool post = act->GetMode() ==
+                        objects::ActionAddRemoveItems::Mode_t::POST;
+                    for(auto& pair : act->GetItems())
+                    {
+                        if(act->GetFromDropSet())
+                        {
+                            refs.Add("DropSet", pair.first);
+                        }
+
+                        refs.Add(post ? "ShopProductData" : "CItemData",
+                            pair.first);
+                    }
+                }
+                break;
+            case objects::Action::ActionType_t::ADD_REMOVE_STATUS:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionAddRemoveStatus>(action);
+                    for(auto& pair : act->GetStatusStacks())
+                    {
+                        refs.Add("StatusData", pair.first);
+                    }
+
+                    for(auto& pair : act->GetStatusTimes())
+                    {
+                        refs.Add("StatusData", pair.first);
+                    }
+                }
+                break;
+            case objects::Action::ActionType_t::CREATE_LOOT:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionCreateLoot>(action);
+                    for(uint32_t dropSetID : act->GetDropSetIDs())
+                    {
+                        refs.Add("DropSet", dropSetID);
+                    }
+
+                    for(auto drop : act->GetDrops())
+                    {
+                        refs.Add("CItemData", drop->GetItemType());
+                    }
+                }
+                break;
+            case objects::Action::ActionType_t::DELAY:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionDelay>(action);
+                    for(auto act2 : act->GetActions())
+                    {
+                        newActions.push_back(act2);
+                    }
+                }
+                break;
+            case objects::Action::ActionType_t::DISPLAY_MESSAGE:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionDisplayMessage>(action);
+                    for(int32_t messageID : act->GetMessageIDs())
+                    {
+                        refs.Add("CEventMessageData", (uint32_t)messageID);
+                    }
+                }
+                break;
+            case objects::Action::ActionType_t::PLAY_BGM:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionPlayBGM>(action);
+                    refs.Add("CSoundData", (uint32_t)act->GetMusicID());
+                }
+                break;
+            case objects::Action::ActionType_t::PLAY_SOUND_EFFECT:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionPlaySoundEffect>(action);
+                    refs.Add("CSoundData", (uint32_t)act->GetSoundID());
+                }
+                break;
+            case objects::Action::ActionType_t::SET_HOMEPOINT:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionSetHomepoint>(action);
+                    refs.Add("ZoneData", act->GetZoneID());
+                }
+                break;
+            case objects::Action::ActionType_t::SPAWN:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionSpawn>(action);
+                    for(auto act2 : act->GetDefeatActions())
+                    {
+                        newActions.push_back(act2);
+                    }
+                }
+                break;
+            case objects::Action::ActionType_t::STAGE_EFFECT:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionStageEffect>(action);
+                    refs.Add("CEventMessageData",
+                        (uint32_t)act->GetMessageID());
+                }
+                break;
+            case objects::Action::ActionType_t::UPDATE_COMP:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionUpdateCOMP>(action);
+                    for(auto& pair : act->GetAddDemons())
+                    {
+                        refs.Add("DevilData", pair.first);
+                    }
+
+                    for(auto& pair : act->GetRemoveDemons())
+                    {
+                        refs.Add("DevilData", pair.first);
+                    }
+                }
+                break;
+            case objects::Action::ActionType_t::UPDATE_FLAG:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionUpdateFlag>(action);
+                    switch(act->GetFlagType())
+                    {
+                    case objects::ActionUpdateFlag::FlagType_t::PLUGIN:
+                        refs.Add("CKeyItemData", (uint32_t)act->GetID());
+                        break;
+                    case objects::ActionUpdateFlag::FlagType_t::VALUABLE:
+                        refs.Add("CValuablesData", (uint32_t)act->GetID());
+                        break;
+                    default:
+                        break;
+                    }
+                }
+                break;
+            case objects::Action::ActionType_t::UPDATE_POINTS:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionUpdatePoints>(action);
+                    if(act->GetPointType() ==
+                        objects::ActionUpdatePoints::PointType_t::ITIME)
+                    {
+                        refs.Add("CHouraiData", (uint32_t)act->GetModifier());
+                    }
+                }
+                break;
+            case objects::Action::ActionType_t::UPDATE_QUEST:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionUpdateQuest>(action);
+                    refs.Add("CQuestData", (uint32_t)act->GetQuestID());
+                }
+                break;
+            case objects::Action::ActionType_t::ZONE_CHANGE:
+                {
+                    auto act = std::dynamic_pointer_cast<
+                        objects::ActionZoneChange>(action);
+                    refs.Add("ZoneData", act->GetZoneID());
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        currentActions = newActions;
+        newActions.clear();
+    }
+}
+
+static void ExtractCondition(
+    const std::shared_ptr<objects::EventCondition>& c,
+    ReferenceCollector& refs)
+{
+    uint32_t value1 = (uint32_t)c->GetValue1();
+
+    switch(c->GetType())
+    {
+    case objects::EventCondition::Type_t::CLAN_HOME:
+        refs.Add("ZoneData", value1);
+        break;
+    case objects::EventCondition::Type_t::COMP_DEMON:
+    case objects::EventCondition::Type_t::SUMMONED:
+        refs.Add("DevilData", value1);
+        break;
+    case objects::EventCondition::Type_t::DEMON_BOOK:
+        if(c->GetCompareMode() ==
+            objects::EventCondition::CompareMode_t::EXISTS)
+        {
+            refs.Add("DevilData", value1);
+        }
+        break;
+    case objects::EventCondition::Type_t::EQUIPPED:
+    case objects::EventCondition::Type_t::ITEM:
+    case objects::EventCondition::Type_t::MATERIAL:
+        refs.Add("CItemData", value1);
+        break;
+    case objects::EventCondition::Type_t::PLUGIN:
+        refs.Add("CKeyItemData", value1);
+        break;
+    case objects::EventCondition::Type_t::QUEST_ACTIVE:
+    case objects::EventCondition::Type_t::QUEST_AVAILABLE:
+    case objects::EventCondition::Type_t::QUEST_COMPLETE:
+    case objects::EventCondition::Type_t::QUEST_FLAGS:
+    case objects::EventCondition::Type_t::QUEST_PHASE:
+    case objects::EventCondition::Type_t::QUEST_PHASE_REQUIREMENTS:
+    case objects::EventCondition::Type_t::QUEST_SEQUENCE:
+        refs.Add("CQuestData", value1);
+        break;
+    case objects::EventCondition::Type_t::STATUS_ACTIVE:
+        refs.Add("StatusData", value1);
+        break;
+    case objects::EventCondition::Type_t::VALUABLE:
+        refs.Add("CValuablesData", value1);
+        break;
+    default:
+        break;
+    }
+}
+
+static void ExtractEvent(const std::shared_ptr<objects::Event>& e,
+    ReferenceCollector& refs)
+{
+    // Gather all conditions and actions
+    auto conditions = e->GetConditions();
+    for(auto b : e->GetBranches())
+    {
+        for(auto c : b->GetConditions())
+        {
+            conditions.push_back(c);
+        }
+    }
+
+    switch(e->GetEventType())
+    {
+    case objects::Event::EventType_t::EX_NPC_MESSAGE:
+        {
+            auto ev = std::dynamic_pointer_cast<objects::EventExNPCMessage>(e);
+            refs.Add("CEventMessageData", (uint32_t)ev->GetMessageID());
+        }
+        break;
+    case objects::Event::EventType_t::ITIME:
+        {
+            auto ev = std::dynamic_pointer_cast<objects::EventITime>(e);
+            refs.Add("CHouraiData", (uint32_t)ev->GetITimeID());
+            refs.Add("CHouraiMessageData", (uint32_t)ev->GetMessageID());
+
+            for(auto choice : ev->GetChoices())
+            {
+                refs.Add("CHouraiMessageData",
+                    (uint32_t)choice->GetMessageID());
+            }
+        }
+        break;
+    case objects::Event::EventType_t::NPC_MESSAGE:
+        {
+            auto ev = std::dynamic_pointer_cast<objects::EventNPCMessage>(e);
+            for(int32_t messageID : ev->GetMessageIDs())
+            {
+                refs.Add("CEventMessageData", (uint32_t)messageID);
+            }
+        }
+        break;
+    case objects::Event::EventType_t::PERFORM_ACTIONS:
+        ExtractActions(std::dynamic_pointer_cast<
+            objects::EventPerformActions>(e)->GetActions(), refs);
+        break;
+    case objects::Event::EventType_t::PROMPT:
+        {
+            auto ev = std::dynamic_pointer_cast<objects::EventPrompt>(e);
+            refs.Add("CEventMessageData", (uint32_t)ev->GetMessageID());
+
+            for(auto choice : ev->GetChoices())
+            {
+                refs.Add("CEventMessageData",
+                    (uint32_t)choice->GetMessageID());
+
+                for(auto c : choice->GetConditions())
+                {
+                    conditions.push_back(c);
+                }
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    for(auto c : conditions)
+    {
+        ExtractCondition(c, refs);
+    }
+}
+
+static void ExtractSpawn(const std::shared_ptr<objects::Spawn>& spawn,
+    ReferenceCollector& refs)
+{
+    refs.Add("CTitleData", spawn->GetVariantType());
+    refs.Add("DevilData", spawn->GetEnemyType());
+
+    for(uint32_t dropSetID : spawn->GetDropSetIDs())
+    {
+        refs.Add("DropSet", dropSetID);
+    }
+
+    for(uint32_t dropSetID : spawn->GetGiftSetIDs())
+    {
+        refs.Add("DropSet", dropSetID);
+    }
+
+    for(auto drop : spawn->GetDrops())
+    {
+        refs.Add("CItemData", drop->GetItemType());
+    }
+
+    for(auto drop : spawn->GetGifts())
+    {
+        refs.Add("CItemData", drop->GetItemType());
+    }
+}
+
+/**
+ * Extract the references shared by zones and zone partials.
+ * @param zone Zone or zone partial to extract.
+ * @param location Location of the references.
+ * @param refs Collector to add the references to.
+ */
+template<typename T>
+static void ExtractZoneObjects(const std::shared_ptr<T>& zone,
+    const libcomp::String& location, ReferenceCollector& refs)
+{
+    refs.SetSection(location, "");
+
+    for(uint32_t dropSetID : zone->GetDropSetIDs())
+    {
+        refs.Add("DropSet", dropSetID);
+    }
+
+    for(auto npc : zone->GetNPCs())
+    {
+        refs.SetSection(location, "");
+        refs.Add("hNPCData", npc->GetID());
+
+        refs.SetSection(location, libcomp::String("NPC %1")
+            .Arg(npc->GetID()));
+        ExtractActions(npc->GetActions(), refs);
+    }
+
+    for(auto obj : zone->GetObjects())
+    {
+        refs.SetSection(location, "");
+        refs.Add("oNPCData", obj->GetID());
+
+        refs.SetSection(location, libcomp::String("Object %1")
+            .Arg(obj->GetID()));
+        ExtractActions(obj->GetActions(), refs);
+    }
+
+    for(auto& spawnPair : zone->GetSpawns())
+    {
+        refs.SetSection(location, libcomp::String("Spawn %1")
+            .Arg(spawnPair.first));
+        ExtractSpawn(spawnPair.second, refs);
+    }
+
+    for(auto& sgPair : zone->GetSpawnGroups())
+    {
+        refs.SetSection(location, libcomp::String("Spawn Group %1")
+            .Arg(sgPair.first));
+        ExtractActions(sgPair.second->GetSpawnActions(), refs);
+        ExtractActions(sgPair.second->GetDefeatActions(), refs);
+    }
+
+    for(auto& spotPair : zone->GetSpots())
+    {
+        refs.SetSection(location, libcomp::String("Spot %1")
+            .Arg(spotPair.first));
+        ExtractActions(spotPair.second->GetActions(), refs);
+        ExtractActions(spotPair.second->GetLeaveActions(), refs);
+    }
+
+    refs.SetSection(location, "Trigger");
+    for(auto trigger : zone->GetTriggers())
+    {
+        ExtractActions(trigger->GetActions(), refs);
+    }
+}
+
+void ReferenceIndex::Update(
+    const std::list<std::shared_ptr<ReferenceSource>>& sources)
+{
+    std::vector<std::shared_ptr<ReferenceSource>> work(sources.begin(),
+        sources.end());
+    std::atomic<size_t> nextSource(0);
+
+    auto worker = [&]()
+    {
+        for(size_t i = nextSource++; i < work.size(); i = nextSource++)
+        {
+            auto refs = Extract(*work[i]);
+
+            std::lock_guard<std::mutex> lock(mLock);
+            SetReferences(work[i]->Key, refs);
+        }
+    };
+
+    std::list<std::thread*> threads;
+
+    size_t threadCount = std::min(work.size(), (size_t)std::max(1U,
+        std::thread::hardware_concurrency()));
+    for(size_t i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(new std::thread(worker));
+    }
+
+    for(auto thread : threads)
+    {
+        thread->join();
+
+        delete thread;
+    }
+}
+
+size_t ReferenceIndex::LoadFiles(const std::list<libcomp::String>& paths,
+    const ReferenceFileReader_t& reader, std::list<libcomp::String>& errors,
+    const libcomp::String& keyPrefix)
+{
+    std::vector<libcomp::String> work(paths.begin(), paths.end());
+    std::atomic<size_t> nextFile(0);
+    std::atomic<size_t> loaded(0);
+
+    auto worker = [&]()
+    {
+        for(size_t i = nextFile++; i < work.size(); i = nextFile++)
+        {
+            ReferenceSource source;
+            source.Key = keyPrefix + work[i];
+            source.Path = work[i];
+
+            auto data = reader(work[i]);
+            if(data.empty() || !LoadXml(data, source))
+            {
+                std::lock_guard<std::mutex> lock(mLock);
+                errors.push_back(work[i]);
+
+                continue;
+            }
+
+            auto refs = Extract(source);
+
+            std::lock_guard<std::mutex> lock(mLock);
+            SetReferences(source.Key, refs);
+            loaded++;
+        }
+    };
+
+    std::list<std::thread*> threads;
+
+    size_t threadCount = std::min(work.size(), (size_t)std::max(1U,
+        std::thread::hardware_concurrency()));
+    for(size_t i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(new std::thread(worker));
+    }
+
+    for(auto thread : threads)
+    {
+        thread->join();
+
+        delete thread;
+    }
+
+    return loaded;
+}
+
+void ReferenceIndex::Remove(const libcomp::String& key)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    RemoveReferences(key);
+}
+
+void ReferenceIndex::Clear()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    mReferences.clear();
+    mSourceReferences.clear();
+}
+
+std::set<libcomp::String> ReferenceIndex::GetSources() const
+{
+    std::set<libcomp::String> keys;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    for(auto& pair : mSourceReferences)
+    {
+        keys.insert(pair.first);
+    }
+
+    return keys;
+}
+
+std::list<Reference> ReferenceIndex::Find(const libcomp::String& objType,
+    uint32_t value, uint32_t maxValue) const
+{
+    std::list<Reference> result;
+
+    std::lock_guard<std::mutex> lock(mLock);
+
+    auto it = mReferences.find(objType);
+    if(it == mReferences.end())
+    {
+        return result;
+    }
+
+    auto& ids = it->second;
+    auto idIter = ids.lower_bound(value);
+    auto idEnd = maxValue ? ids.upper_bound(maxValue) : ids.upper_bound(value);
+    for(; idIter != idEnd; idIter++)
+    {
+        result.insert(result.end(), idIter->second.begin(),
+            idIter->second.end());
+    }
+
+    return result;
+}
+
+std::set<uint32_t> ReferenceIndex::GetReferencedIDs(
+    const libcomp::String& objType) const
+{
+    std::set<uint32_t> result;
+
+    std::lock_guard<std::mutex> lock(mLock);
+
+    auto it = mReferences.find(objType);
+    if(it != mReferences.end())
+    {
+        for(auto& pair : it->second)
+        {
+            result.insert(pair.first);
+        }
+    }
+
+    return result;
+}
+
+bool ReferenceIndex::IsSupportedType(const libcomp::String& objType)
+{
+    return SUPPORTED_TYPES.find(objType) != SUPPORTED_TYPES.end();
+}
+
+bool ReferenceIndex::LoadXml(const std::vector<char>& data,
+    ReferenceSource& source)
+{
+    tinyxml2::XMLDocument doc;
+    if(tinyxml2::XML_SUCCESS != doc.Parse(data.data(), data.size()))
+    {
+        return false;
+    }
+
+    auto rootElem = doc.RootElement();
+    if(!rootElem)
+    {
+        return false;
+    }
+
+    auto objNode = rootElem->FirstChildElement("object");
+    while(objNode)
+    {
+        libcomp::String objType(objNode->Attribute("name") ?
+            objNode->Attribute("name") : "");
+
+        if(objType == "ServerZone")
+        {
+            auto zone = std::make_shared<objects::ServerZone>();
+            if(!zone->Load(doc, *objNode))
+            {
+                return false;
+            }
+
+            source.Zones.push_back(zone);
+        }
+        else if(objType == "ServerZonePartial")
+        {
+            auto partial = std::make_shared<objects::ServerZonePartial>();
+            if(!partial->Load(doc, *objNode))
+            {
+                return false;
+            }
+
+            source.Partials.push_back(partial);
+        }
+        else if(objType == "DropSet")
+        {
+            auto dropSet = std::make_shared<objects::DropSet>();
+            if(!dropSet->Load(doc, *objNode))
+            {
+                return false;
+            }
+
+            source.DropSets.push_back(dropSet);
+        }
+        else if(objType.Left(5) == "Event")
+        {
+            auto event = objects::Event::InheritedConstruction(objType);
+            if(!event || !event->Load(doc, *objNode))
+            {
+                return false;
+            }
+
+            source.Events.push_back(event);
+        }
+
+        // Any other object type cannot reference anything indexed
+
+        objNode = objNode->NextSiblingElement("object");
+    }
+
+    return true;
+}
+
+std::list<Reference> ReferenceIndex::Extract(const ReferenceSource& source)
+{
+    ReferenceCollector refs(source.Key);
+
+    for(auto e : source.Events)
+    {
+        refs.SetSection(source.Path, libcomp::String("Event %1")
+            .Arg(e->GetID()));
+        ExtractEvent(e, refs);
+    }
+
+    for(auto zone : source.Zones)
+    {
+        auto location = libcomp::String("Zone %1 (%2)")
+            .Arg(zone->GetID()).Arg(zone->GetDynamicMapID());
+
+        ExtractZoneObjects(zone, location, refs);
+
+        refs.SetSection(location, "");
+        for(auto& pPair : zone->GetPlasmaSpawns())
+        {
+            refs.Add("DropSet", pPair.second->GetDropSetID());
+        }
+
+        for(auto& pPair : zone->GetPlasmaSpawns())
+        {
+            refs.SetSection(location, libcomp::String("Plasma %1")
+                .Arg(pPair.first));
+            ExtractActions(pPair.second->GetSuccessActions(), refs);
+            ExtractActions(pPair.second->GetFailActions(), refs);
+        }
+    }
+
+    for(auto partial : source.Partials)
+    {
+        ExtractZoneObjects(partial, libcomp::String("Zone Partial %1")
+            .Arg(partial->GetID()), refs);
+    }
+
+    for(auto dropSet : source.DropSets)
+    {
+        refs.SetSection(libcomp::String("Drop Set %1").Arg(dropSet->GetID()),
+            "");
+        for(auto drop : dropSet->GetDrops())
+        {
+            refs.Add("CItemData", drop->GetItemType());
+        }
+    }
+
+    return refs.GetReferences();
+}
+
+void ReferenceIndex::SetReferences(const libcomp::String& key,
+    std::list<Reference>& refs)
+{
+    RemoveReferences(key);
+
+    auto& sourceRefs = mSourceReferences[key];
+    for(auto& ref : refs)
+    {
+        sourceRefs.insert(std::make_pair(ref.ObjectType, ref.ID));
+        mReferences[ref.ObjectType][ref.ID].push_back(ref);
+    }
+}
+
+void ReferenceIndex::RemoveReferences(const libcomp::String& key)
+{
+    auto it = mSourceReferences.find(key);
+    if(it == mSourceReferences.end())
+    {
+        return;
+    }
+
+    for(auto& pair : it->second)
+    {
+        auto typeIter = mReferences.find(pair.first);
+        if(typeIter == mReferences.end())
+        {
+            continue;
+        }
+
+        auto idIter = typeIter->second.find(pair.second);
+        if(idIter == typeIter->second.end())
+        {
+            continue;
+        }
+
+        idIter->second.remove_if([key](const Reference& ref)
+            {
+                return ref.Source == key;
+            });
+
+        if(idIter->second.empty())
+        {
+            typeIter->second.erase(idIter);
+        }
+    }
+
+    mSourceReferences.erase(it);
+}
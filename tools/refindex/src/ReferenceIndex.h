@@ -0,0 +1,210 @@
+/**
+ * @file tools/refindex/src/ReferenceIndex.h
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Inverted index of the definitions referenced by server data.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOOLS_REFINDEX_SRC_REFERENCEINDEX_H
+#define TOOLS_REFINDEX_SRC_REFERENCEINDEX_H
+
+// libcomp Includes
+#include <CString.h>
+
+// Standard C++11 Includes
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace objects
+{
+class DropSet;
+class Event;
+class ServerZone;
+class ServerZonePartial;
+}
+
+/**
+ * Single use of a definition by a server data object.
+ */
+class Reference
+{
+public:
+    /// Type of the referenced definition (ex: "CItemData")
+    libcomp::String ObjectType;
+
+    /// ID of the referenced definition
+    uint32_t ID = 0;
+
+    /// Key of the source the reference was read from
+    libcomp::String Source;
+
+    /// Object containing the reference (ex: "Zone 1 (1)" or a file path)
+    libcomp::String Location;
+
+    /// Part of the object containing the reference (ex: "Spawn 3")
+    libcomp::String Section;
+};
+
+/**
+ * Group of server data objects indexed and replaced together, normally
+ * everything loaded from one file.
+ */
+class ReferenceSource
+{
+public:
+    /// Unique key of the source, replacing any source with the same key
+    libcomp::String Key;
+
+    /// Path of the file the objects were loaded from, used as the location
+    /// of event references
+    libcomp::String Path;
+
+    std::list<std::shared_ptr<objects::Event>> Events;
+    std::list<std::shared_ptr<objects::ServerZone>> Zones;
+    std::list<std::shared_ptr<objects::ServerZonePartial>> Partials;
+    std::list<std::shared_ptr<objects::DropSet>> DropSets;
+};
+
+/// Function used to read the contents of a file to index
+typedef std::function<std::vector<char>(
+    const libcomp::String& path)> ReferenceFileReader_t;
+
+/**
+ * Inverted index from a definition type and ID to every event, zone, zone
+ * partial and drop set that references it. Sources are extracted in
+ * parallel and can be replaced or removed one at a time so an edited file
+ * only has to be indexed again by itself. All functions are thread safe.
+ */
+class ReferenceIndex
+{
+public:
+    /**
+     * Index a set of sources, replacing any sources already indexed with
+     * the same keys. Each source is extracted by a separate worker.
+     * @param sources Sources to index.
+     */
+    void Update(const std::list<std::shared_ptr<ReferenceSource>>& sources);
+
+    /**
+     * Load and index server data XML files, replacing any sources already
+     * indexed for the same paths. Each file is read, parsed and extracted
+     * by a separate worker.
+     * @param paths Paths of the files to index.
+     * @param reader Function used to read each file.
+     * @param errors Output parameter for any file that failed to load.
+     * @param keyPrefix Prefix added to each path to make its source key.
+     * @returns Number of files indexed.
+     */
+    size_t LoadFiles(const std::list<libcomp::String>& paths,
+        const ReferenceFileReader_t& reader,
+        std::list<libcomp::String>& errors,
+        const libcomp::String& keyPrefix = "");
+
+    /**
+     * Remove all references read from a source.
+     * @param key Key of the source to remove.
+     */
+    void Remove(const libcomp::String& key);
+
+    /**
+     * Remove everything from the index.
+     */
+    void Clear();
+
+    /**
+     * Get the keys of every indexed source.
+     * @returns Set of source keys.
+     */
+    std::set<libcomp::String> GetSources() const;
+
+    /**
+     * Find the references to a definition or a range of definitions.
+     * @param objType Type of the definition (ex: "CItemData").
+     * @param value ID of the definition or start of the range.
+     * @param maxValue End of the range or 0 to find a single ID.
+     * @returns References ordered by ID.
+     */
+    std::list<Reference> Find(const libcomp::String& objType,
+        uint32_t value, uint32_t maxValue = 0) const;
+
+    /**
+     * Get every ID of a definition type that is referenced at least once.
+     * @param objType Type of the definition (ex: "CItemData").
+     * @returns Set of referenced IDs.
+     */
+    std::set<uint32_t> GetReferencedIDs(const libcomp::String& objType) const;
+
+    /**
+     * Check if references to a definition type are indexed.
+     * @param objType Type of the definition.
+     * @returns true if the type is indexed, false otherwise.
+     */
+    static bool IsSupportedType(const libcomp::String& objType);
+
+    /**
+     * Parse the objects of a server data XML file into a source.
+     * @param data Contents of the file.
+     * @param source Source to add the objects to.
+     * @returns true if the file was parsed, false otherwise.
+     */
+    static bool LoadXml(const std::vector<char>& data,
+        ReferenceSource& source);
+
+    /**
+     * Extract every reference in a source.
+     * @param source Source to extract.
+     * @returns References read from the source.
+     */
+    static std::list<Reference> Extract(const ReferenceSource& source);
+
+private:
+    /**
+     * Replace the references of a source. The lock must be held.
+     * @param key Key of the source.
+     * @param refs New references of the source.
+     */
+    void SetReferences(const libcomp::String& key,
+        std::list<Reference>& refs);
+
+    /**
+     * Remove the references of a source. The lock must be held.
+     * @param key Key of the source.
+     */
+    void RemoveReferences(const libcomp::String& key);
+
+    /// Map of definition type to referenced ID to references
+    std::unordered_map<libcomp::String, std::map<uint32_t,
+        std::list<Reference>>> mReferences;
+
+    /// Map of source key to the definition types and IDs it references
+    std::unordered_map<libcomp::String, std::set<std::pair<libcomp::String,
+        uint32_t>>> mSourceReferences;
+
+    /// Lock for the index maps
+    mutable std::mutex mLock;
+};
+
+#endif // TOOLS_REFINDEX_SRC_REFERENCEINDEX_H
@@ -31,14 +31,26 @@
 #include <Crypto.h>
 
 // Standard C++11 Includes
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
-#include <regex>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 // Standard C Includes
+#include <cstdio>
 #include <ctime>
+#include <sys/stat.h>
+
+/// Size of each block compared when generating a delta
+const uint32_t DELTA_BLOCK_SIZE = 64 * 1024;
+
+/// Block index marking literal data in a delta
+const uint32_t DELTA_LITERAL = 0xFFFFFFFF;
 
 class FileData
 {
@@ -47,38 +59,146 @@ public:
     libcomp::String compressed_hash;
     libcomp::String uncompressed_hash;
 
-    int compressed_size;
-    int uncompressed_size;
+    int compressed_size = 0;
+    int uncompressed_size = 0;
 };
 
-std::unordered_map<libcomp::String, FileData*> ParseFileList(
-    const std::vector<char> data)
+/**
+ * Cached result of processing an overlay file in a previous run.
+ */
+class CacheEntry
 {
-    std::unordered_map<libcomp::String, FileData*> files;
+public:
+    /// Size of the overlay file when it was processed
+    uint64_t size = 0;
 
-    std::list<libcomp::String> lines = libcomp::String(&data[0], data.size()).Split("\n");
+    /// Modification time of the overlay file when it was processed
+    int64_t mtime = 0;
+
+    /// Uncompressed hash of the base file in the base hashlist a delta
+    /// was generated against or "-" if no delta was requested
+    libcomp::String base_hash;
+
+    /// Hashlist entry generated for the file
+    FileData data;
+};
+
+/**
+ * Overlay file waiting to be hashed and compressed by a worker.
+ */
+class WorkItem
+{
+public:
+    /// Path relative to the overlay directory
+    libcomp::String shortName;
 
-    static const std::regex fileMatcher("FILE : (.+),([0-9a-fA-F]{32}),([0-9]+),"
-        "([0-9a-fA-F]{32}),([0-9]+)");
+    /// Uncompressed hash of the file in the base hashlist to generate a
+    /// delta against or "-" if no delta should be generated
+    libcomp::String baseHash;
+
+    /// Size of the file
+    uint64_t size = 0;
+
+    /// Modification time of the file
+    int64_t mtime = 0;
+
+    /// Generated hashlist entry
+    FileData data;
+
+    /// Indicates the file was processed and should be in the hashlist
+    bool success = false;
+
+    /// Indicates the cached entry was used instead of processing the file
+    bool cached = false;
+};
+
+/**
+ * Check if a string is a hexadecimal MD5 hash.
+ * @param str String to check.
+ * @returns true if the string is a hash, false otherwise.
+ */
+static bool IsHash(const std::string& str)
+{
+    return 32 == str.size() && str.end() == std::find_if(str.begin(),
+        str.end(), [](char c) { return !isxdigit((unsigned char)c); });
+}
+
+/**
+ * Check if a string is a non-empty decimal number.
+ * @param str String to check.
+ * @returns true if the string is a number, false otherwise.
+ */
+static bool IsNumber(const std::string& str)
+{
+    return !str.empty() && str.end() == std::find_if(str.begin(),
+        str.end(), [](char c) { return !isdigit((unsigned char)c); });
+}
+
+/**
+ * Parse a single "FILE : PATH,HASH,SIZE,HASH,SIZE" hashlist line. The path
+ * may contain commas so the other fields are read from the end.
+ * @param line Trimmed line to parse.
+ * @param info Output parameter to store the entry in.
+ * @returns true if the line is a file entry, false otherwise.
+ */
+static bool ParseFileLine(const std::string& line, FileData& info)
+{
+    static const std::string prefix = "FILE : ";
+
+    if(0 != line.compare(0, prefix.size(), prefix))
+    {
+        return false;
+    }
+
+    std::string fields[4];
+    size_t fieldEnd = line.size();
+
+    for(int i = 3; i >= 0; i--)
+    {
+        size_t comma = line.rfind(',', fieldEnd - 1);
+
+        if(std::string::npos == comma || comma <= prefix.size())
+        {
+            return false;
+        }
+
+        fields[i] = line.substr(comma + 1, fieldEnd - comma - 1);
+        fieldEnd = comma;
+    }
+
+    if(!IsHash(fields[0]) || !IsNumber(fields[1]) ||
+        !IsHash(fields[2]) || !IsNumber(fields[3]))
+    {
+        return false;
+    }
+
+    info.path = libcomp::String(line.substr(prefix.size(),
+        fieldEnd - prefix.size())).Mid(2).Replace("\\", "/");
+    info.compressed_hash = libcomp::String(fields[0]).ToUpper();
+    info.compressed_size = libcomp::String(fields[1]).ToInteger<int>();
+    info.uncompressed_hash = libcomp::String(fields[2]).ToUpper();
+    info.uncompressed_size = libcomp::String(fields[3]).ToInteger<int>();
+
+    return true;
+}
+
+std::unordered_map<libcomp::String, FileData> ParseFileList(
+    const std::vector<char>& data)
+{
+    std::unordered_map<libcomp::String, FileData> files;
+
+    std::list<libcomp::String> lines = libcomp::String(&data[0], data.size()).Split("\n");
 
     // Parse each line of the hashlist.dat file.
     for(auto line : lines)
     {
-        std::string cleanLine = line.Trimmed().ToUtf8();
-        std::smatch match;
+        FileData info;
 
-        if(!std::regex_match(cleanLine, match, fileMatcher))
+        if(!ParseFileLine(line.Trimmed().ToUtf8(), info))
             continue;
 
         // Add each file entry to the map.
-        FileData *info = new FileData;
-        info->path = libcomp::String(match[1]).Mid(2).Replace("\\", "/");
-        info->compressed_hash = libcomp::String(match[2]).ToUpper();
-        info->compressed_size = libcomp::String(match[3]).ToInteger<int>();
-        info->uncompressed_hash = libcomp::String(match[4]).ToUpper();
-        info->uncompressed_size = libcomp::String(match[5]).ToInteger<int>();
-
-        files[info->path] = info;
+        files[info.path] = info;
     }
 
     return files;
@@ -106,23 +226,358 @@ std::list<libcomp::String> RecursiveEntryList(const libcomp::String& dir)
     return files;
 }
 
+/**
+ * Check if a path ends with a suffix (and has something before it).
+ * @param path Path to check.
+ * @param suffix Suffix to look for.
+ * @returns true if the path ends with the suffix, false otherwise.
+ */
+static bool HasSuffix(const std::string& path, const std::string& suffix)
+{
+    return path.size() > suffix.size() && 0 == path.compare(
+        path.size() - suffix.size(), suffix.size(), suffix);
+}
+
+/**
+ * Get the size and modification time of a file.
+ * @param path Path to the file.
+ * @param size Output parameter for the size of the file.
+ * @param mtime Output parameter for the modification time of the file.
+ * @returns true if the file exists, false otherwise.
+ */
+static bool GetFileStats(const libcomp::String& path, uint64_t& size,
+    int64_t& mtime)
+{
+    struct stat info;
+
+    if(0 != stat(path.C(), &info))
+    {
+        return false;
+    }
+
+    size = (uint64_t)info.st_size;
+    mtime = (int64_t)info.st_mtime;
+
+    return true;
+}
+
+/**
+ * Load the cache written by a previous run. Each line is
+ * "SIZE MTIME BASE_HASH COMP_HASH COMP_SIZE UNCOMP_HASH UNCOMP_SIZE PATH"
+ * where PATH is relative to the overlay and is last as it may contain
+ * spaces.
+ * @param path Path to the cache file.
+ * @returns Map of overlay relative paths to cache entries.
+ */
+static std::unordered_map<libcomp::String, CacheEntry> LoadCache(
+    const libcomp::String& path)
+{
+    std::unordered_map<libcomp::String, CacheEntry> cache;
+
+    std::ifstream in;
+    in.open(path.C(), std::ifstream::binary);
+
+    std::string line;
+    while(std::getline(in, line))
+    {
+        std::istringstream fields(line);
+
+        CacheEntry entry;
+        std::string baseHash, compHash, uncompHash, relPath;
+
+        if(!(fields >> entry.size >> entry.mtime >> baseHash >> compHash >>
+            entry.data.compressed_size >> uncompHash >>
+            entry.data.uncompressed_size) || !std::getline(fields, relPath) ||
+            relPath.size() < 2)
+        {
+            continue;
+        }
+
+        entry.base_hash = baseHash;
+        entry.data.compressed_hash = compHash;
+        entry.data.uncompressed_hash = uncompHash;
+        entry.data.path = libcomp::String("%1.compressed").Arg(
+            relPath.substr(1));
+
+        cache[relPath.substr(1)] = entry;
+    }
+
+    return cache;
+}
+
+/**
+ * Save the results of this run so unchanged files can be skipped next time.
+ * @param path Path to the cache file.
+ * @param work Files processed in this run.
+ * @returns true if the cache was written, false otherwise.
+ */
+static bool SaveCache(const libcomp::String& path,
+    const std::vector<WorkItem>& work)
+{
+    std::ofstream out;
+    out.open(path.C(), std::ofstream::binary);
+
+    for(auto& item : work)
+    {
+        if(!item.success)
+        {
+            continue;
+        }
+
+        out << item.size << " " << item.mtime << " " << item.baseHash.C()
+            << " " << item.data.compressed_hash.C() << " "
+            << item.data.compressed_size << " "
+            << item.data.uncompressed_hash.C() << " "
+            << item.data.uncompressed_size << " " << item.shortName.C()
+            << "\n";
+    }
+
+    return out.good();
+}
+
+/**
+ * Write a block delta that rebuilds a file from the base version of it.
+ * The file is split into DELTA_BLOCK_SIZE blocks and each block is either
+ * a copy of a matching block anywhere in the base file or literal data.
+ * The delta is only kept if it is smaller than the compressed file. The
+ * format (little endian) is:
+ *   "CDLT", uint32 block size, uint32 base size, uint32 new size,
+ *   char[32] base MD5, char[32] new MD5, uint32 block count and then for
+ *   each block a uint32 base block index or DELTA_LITERAL followed by
+ *   the block data.
+ * @param basePath Path to the base version of the file.
+ * @param data Contents of the new version of the file.
+ * @param newHash Uncompressed hash of the new version of the file.
+ * @param outPath Path to write the delta to.
+ * @param compressedSize Size of the compressed copy of the new file.
+ * @returns true if a delta was written, false otherwise.
+ */
+static bool WriteDelta(const libcomp::String& basePath,
+    const std::vector<char>& data, const libcomp::String& newHash,
+    const libcomp::String& outPath, int32_t compressedSize)
+{
+    std::vector<char> baseData = libcomp::Crypto::LoadFile(
+        basePath.ToUtf8());
+
+    if(baseData.empty())
+    {
+        return false;
+    }
+
+    auto blockHash = [](const std::vector<char>& src, size_t block)
+    {
+        size_t start = block * DELTA_BLOCK_SIZE;
+        size_t end = std::min(start + DELTA_BLOCK_SIZE, src.size());
+
+        return libcomp::Crypto::MD5(std::vector<char>(src.begin() +
+            (std::ptrdiff_t)start, src.begin() + (std::ptrdiff_t)end));
+    };
+
+    // Index the base blocks by hash (first match wins).
+    std::unordered_map<libcomp::String, uint32_t> baseBlocks;
+    uint32_t baseBlockCount = (uint32_t)((baseData.size() +
+        DELTA_BLOCK_SIZE - 1) / DELTA_BLOCK_SIZE);
+
+    for(uint32_t i = 0; i < baseBlockCount; ++i)
+    {
+        baseBlocks.emplace(blockHash(baseData, i), i);
+    }
+
+    libcomp::String baseHash = libcomp::Crypto::MD5(baseData).ToUpper();
+
+    std::vector<char> delta;
+
+    auto append = [&delta](const void *pData, size_t size)
+    {
+        delta.insert(delta.end(), (const char*)pData,
+            (const char*)pData + size);
+    };
+
+    uint32_t blockCount = (uint32_t)((data.size() + DELTA_BLOCK_SIZE - 1) /
+        DELTA_BLOCK_SIZE);
+    uint32_t header[3] = { DELTA_BLOCK_SIZE, (uint32_t)baseData.size(),
+        (uint32_t)data.size() };
+
+    append("CDLT", 4);
+    append(header, sizeof(header));
+    append(baseHash.C(), 32);
+    append(newHash.C(), 32);
+    append(&blockCount, sizeof(blockCount));
+
+    for(uint32_t i = 0; i < blockCount; ++i)
+    {
+        auto it = baseBlocks.find(blockHash(data, i));
+
+        if(baseBlocks.end() != it)
+        {
+            append(&it->second, sizeof(it->second));
+        }
+        else
+        {
+            size_t start = (size_t)i * DELTA_BLOCK_SIZE;
+            size_t end = std::min(start + DELTA_BLOCK_SIZE, data.size());
+
+            append(&DELTA_LITERAL, sizeof(DELTA_LITERAL));
+            append(&data[start], end - start);
+        }
+
+        // No point continuing if the delta will not be used.
+        if(delta.size() >= (size_t)compressedSize)
+        {
+            return false;
+        }
+    }
+
+    std::ofstream out;
+    out.open(outPath.C(), std::ofstream::binary);
+    out.write(&delta[0], (std::streamsize)delta.size());
+
+    return out.good();
+}
+
+/**
+ * Hash and compress a single overlay file.
+ * @param base Path to the base directory.
+ * @param overlay Path to the overlay directory.
+ * @param item File to process.
+ * @param generateDelta Indicates a delta against the base should be made.
+ */
+static void ProcessFile(const libcomp::String& base,
+    const libcomp::String& overlay, WorkItem& item, bool generateDelta)
+{
+    libcomp::String file = libcomp::String("%1/%2").Arg(overlay).Arg(
+        item.shortName);
+
+    // Create a new entry for the file.
+    FileData& d = item.data;
+    d.path = libcomp::String("%1.compressed").Arg(item.shortName);
+
+    // Get the original file contents.
+    std::vector<char> uncomp_data = libcomp::Crypto::LoadFile(
+        file.ToUtf8());
+
+    // Ignore empty files
+    if (uncomp_data.empty())
+    {
+        return;
+    }
+
+    // Hash the original file.
+    d.uncompressed_hash = libcomp::Crypto::MD5(uncomp_data).ToUpper();
+    d.uncompressed_size = (int)uncomp_data.size();
+
+    //
+    // Process the compressed copy now.
+    //
+
+    // Calculate max size.
+    int out_size = (int)((float)uncomp_data.size() * 0.001f + 0.5f);
+    out_size += (int32_t)uncomp_data.size() + 12;
+
+    std::vector<char> out_buffer((size_t)out_size);
+
+    // Compress the file.
+    int32_t sz = libcomp::Compress::Compress(&uncomp_data[0], &out_buffer[0],
+        (int32_t)uncomp_data.size(), out_size, 9);
+
+    if(0 >= sz)
+    {
+        return;
+    }
+
+    out_buffer.resize((size_t)sz);
+
+    // Write the compressed copy
+    {
+        std::ofstream file_comp;
+        file_comp.open(libcomp::String(file + ".compressed").C(),
+            std::ofstream::binary);
+        file_comp.write(&out_buffer[0], (std::streamsize)sz);
+        file_comp.close();
+
+        if(!file_comp)
+        {
+            return;
+        }
+    }
+
+    // Get the hash for the compressed copy.
+    d.compressed_hash = libcomp::Crypto::MD5(out_buffer).ToUpper();
+    d.compressed_size = sz;
+
+    // Replace or remove any delta from a previous run.
+    libcomp::String deltaPath = file + ".delta";
+    std::remove(deltaPath.C());
+
+    if(generateDelta && "-" != item.baseHash &&
+        item.baseHash != d.uncompressed_hash)
+    {
+        WriteDelta(libcomp::String("%1/%2").Arg(base).Arg(item.shortName),
+            uncomp_data, d.uncompressed_hash, deltaPath, sz);
+    }
+
+    item.success = true;
+}
+
 int main(int argc, char *argv[])
 {
+    libcomp::String base;
+    libcomp::String overlay;
+    libcomp::String cachePath;
+    bool generateDelta = false;
+    uint32_t threadCount = std::max(1U, std::thread::hardware_concurrency());
+
+    // Parse the arguments.
+    bool badArgs = false;
+
+    for(int i = 1; i < argc && !badArgs; i++)
+    {
+        libcomp::String arg = argv[i];
+
+        if("--delta" == arg)
+        {
+            generateDelta = true;
+        }
+        else if(i + 1 >= argc)
+        {
+            badArgs = true;
+        }
+        else if("--base" == arg)
+        {
+            base = argv[++i];
+        }
+        else if("--overlay" == arg)
+        {
+            overlay = argv[++i];
+        }
+        else if("--cache" == arg)
+        {
+            cachePath = argv[++i];
+        }
+        else if("--threads" == arg)
+        {
+            bool ok = false;
+            threadCount = libcomp::String(argv[++i]).ToInteger<uint32_t>(
+                &ok);
+            badArgs = !ok || 0 == threadCount;
+        }
+        else
+        {
+            badArgs = true;
+        }
+    }
+
     // Check the arguments and print the usage.
-    if(argc != 5 || libcomp::String(argv[1]) != "--base" ||
-        libcomp::String(argv[3]) != "--overlay")
+    if(badArgs || base.IsEmpty() || overlay.IsEmpty())
     {
-        std::cerr << "SYNTAX: comp_rehash --base BASE --overlay OVERLAY"
-            << std::endl;
+        std::cerr << "SYNTAX: comp_rehash --base BASE --overlay OVERLAY "
+            "[--cache FILE] [--threads N] [--delta]" << std::endl;
 
         return -1;
     }
 
-    libcomp::String base = argv[2];
-    libcomp::String overlay = argv[4];
-
     // Read in the original file list
-    std::unordered_map<libcomp::String, FileData*> files;
+    std::unordered_map<libcomp::String, FileData> files;
 
     {
         // Open and read the hashlist.dat file.
@@ -141,29 +596,24 @@ int main(int argc, char *argv[])
         files = ParseFileList(hashlist);
     }
 
-    static const std::regex compressedRx("^.+\\.compressed$");
+    auto cache = cachePath.IsEmpty()
+        ? std::unordered_map<libcomp::String, CacheEntry>()
+        : LoadCache(cachePath);
+
+    // Find each file in the overlay and queue it.
+    std::vector<WorkItem> work;
 
-    // Find each file in the overlay and handle it.
     for(auto filePath : RecursiveEntryList(overlay))
     {
-        std::smatch match;
-
-        auto file = filePath;
-        auto fileString = file.ToUtf8();
+        auto fileString = filePath.ToUtf8();
 
-        // See if the file is an *.compressed file and ignore it.
-        if(std::regex_match(fileString, match, compressedRx))
+        // See if the file is an *.compressed or *.delta file and ignore it.
+        if(HasSuffix(fileString, ".compressed") ||
+            HasSuffix(fileString, ".delta"))
             continue;
 
         // Get the relative path.
-        libcomp::String shortName = file.Mid(1);
-
-        // Make the path absolute.
-        file = overlay + file;
-
-        // Relative path for the compressed file.
-        libcomp::String shortComp = libcomp::String("%1.compressed").Arg(
-            shortName);
+        libcomp::String shortName = filePath.Mid(1);
 
         // Ignore the hashlist.dat and hashlist.ver files.
         if(shortName == "hashlist.dat")
@@ -171,74 +621,97 @@ int main(int argc, char *argv[])
         if(shortName == "hashlist.ver")
             continue;
 
+        WorkItem item;
+        item.shortName = shortName;
+        item.baseHash = "-";
+
+        std::string compPath = libcomp::String("%1%2.compressed").Arg(
+            overlay).Arg(filePath).ToUtf8();
+
         // Check if the file is in the original hashlist.dat file.
-        auto it = files.find(shortComp);
+        auto it = files.find(libcomp::String("%1.compressed").Arg(
+            shortName));
 
         // If the file is in the base, remove the entry.
         if(files.end() != it)
         {
-            delete it->second;
+            if(generateDelta)
+            {
+                item.baseHash = it->second.uncompressed_hash;
+            }
+
+            files.erase(it);
         }
 
-        it = files.find(shortName);
+        files.erase(shortName);
 
-        if(files.end() != it)
-        {
-            delete it->second;
+        if(!GetFileStats(overlay + filePath, item.size, item.mtime))
+            continue;
 
-            files.erase(it);
+        // Skip files that have not changed since the last run.
+        auto cIter = cache.find(shortName);
+
+        if(cache.end() != cIter && cIter->second.size == item.size &&
+            cIter->second.mtime == item.mtime &&
+            cIter->second.base_hash == item.baseHash &&
+            std::ifstream(compPath.c_str()).good())
+        {
+            item.data = cIter->second.data;
+            item.success = true;
+            item.cached = true;
         }
 
-        // Create a new entry for the file.
-        FileData *d = new FileData;
-        d->path = shortComp;
+        work.push_back(item);
+    }
 
-        // Get the original file contents.
-        std::vector<char> uncomp_data = libcomp::Crypto::LoadFile(
-            file.ToUtf8());
+    // Hash and compress everything that changed.
+    std::atomic<size_t> nextFile(0);
 
-        // Ignore empty files
-        if (uncomp_data.empty())
+    auto worker = [&]()
+    {
+        for(size_t i = nextFile++; i < work.size(); i = nextFile++)
         {
-            continue;
+            if(!work[i].cached)
+            {
+                ProcessFile(base, overlay, work[i], generateDelta);
+            }
         }
+    };
 
-        // Hash the original file.
-        d->uncompressed_hash = libcomp::Crypto::MD5(uncomp_data).ToUpper();
-        d->uncompressed_size = (int)uncomp_data.size();
+    std::list<std::thread*> threads;
 
-        //
-        // Process the compressed copy now.
-        //
+    for(uint32_t i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(new std::thread(worker));
+    }
 
-        // Calculate max size.
-        int out_size = (int)((float)uncomp_data.size() * 0.001f + 0.5f);
-        out_size += (int32_t)uncomp_data.size() + 12;
+    for(auto thread : threads)
+    {
+        thread->join();
 
-        char *out_buffer = new char[(size_t)out_size];
+        delete thread;
+    }
 
-        // Compress the file.
-        int32_t sz = libcomp::Compress::Compress(&uncomp_data[0], out_buffer,
-            (int32_t)uncomp_data.size(), out_size, 9);
+    size_t processed = 0;
+    size_t cached = 0;
 
-        // Write the compressed copy
+    // Save each entry.
+    for(auto& item : work)
+    {
+        if(item.success)
         {
-            std::ofstream file_comp;
-            file_comp.open(libcomp::String(file + ".compressed").C(),
-                std::ofstream::binary);
-            file_comp.write(out_buffer, (std::streamsize)sz);
-            file_comp.close();
-        }
+            files[item.data.path] = item.data;
 
-        // Get the hash for the compressed copy.
-        d->compressed_hash = libcomp::Crypto::MD5(std::vector<char>(
-            out_buffer, out_buffer + sz)).ToUpper();
-        d->compressed_size = sz;
+            (item.cached ? cached : processed)++;
+        }
+    }
 
-        // Save the entry.
-        files[shortComp] = d;
+    std::cout << "Processed " << processed << " and skipped " << cached
+        << " unchanged of " << work.size() << " files." << std::endl;
 
-        delete[] out_buffer;
+    if(!cachePath.IsEmpty() && !SaveCache(cachePath, work))
+    {
+        std::cerr << "Failed to save the cache file." << std::endl;
     }
 
     // Write the overlay hashlist.dat file now.
@@ -247,9 +720,9 @@ int main(int argc, char *argv[])
         std::ofstream::binary);
 
     // Add each file in the list.
-    for(auto file : files)
+    for(auto& file : files)
     {
-        FileData *d = file.second;
+        FileData *d = &file.second;
 
 
         libcomp::String line = "FILE : .\\%1,%2,%3,%4,%5 ";
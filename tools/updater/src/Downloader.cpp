@@ -33,10 +33,13 @@
 #include <QRegExp>
 #include <QFileInfo>
 #include <QMetaType>
+#include <QtEndian>
+#include <QDateTime>
 #include <QCoreApplication>
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QNetworkAccessManager>
+#include <QtConcurrent>
 #include <PopIgnore.h>
 
 #if defined(COMP_HACK_HEADLESS) || defined(Q_OS_UNIX)
@@ -49,12 +52,88 @@
 
 #include <zlib.h>
 
-bool Downloader::checkFile(const FileData *info)
+#include <algorithm>
+#include <cctype>
+#include <functional>
+
+/// File with the size, modification time and hash of checked local files
+static const char *HASH_INDEX_PATH = "ImagineUpdate2.idx";
+
+/// Block index marking literal data in a delta
+static const quint32 DELTA_LITERAL = 0xFFFFFFFF;
+
+/// Size of the delta header: magic, block size, base size, new size, base
+/// hash, new hash and block count
+static const int DELTA_HEADER_SIZE = 4 + 4 * 3 + 32 * 2 + 4;
+
+static QString localPath(const QString& path)
+{
+    if(path.endsWith(".compressed"))
+        return path.left(path.length() - 11);
+
+    return path;
+}
+
+static bool isHash(const QString& str)
+{
+    if(32 != str.length())
+        return false;
+
+    foreach(QChar c, str)
+    {
+        if(!isxdigit(c.toLatin1()))
+            return false;
+    }
+
+    return true;
+}
+
+static bool isNumber(const QString& str)
 {
-    QString path = info->path;
-    QRegExp compMatch("(.+).compressed");
-    if( compMatch.exactMatch(info->path) )
-        path = compMatch.cap(1);
+    if(str.isEmpty())
+        return false;
+
+    foreach(QChar c, str)
+    {
+        if(!c.isDigit())
+            return false;
+    }
+
+    return true;
+}
+
+QString Downloader::hashFile(const QString& path) const
+{
+    QFileInfo fi(path);
+
+    if(!fi.isFile())
+        return QString();
+
+    // Reuse the hash from the last check if the file has not changed.
+    auto it = mHashIndex.constFind(path);
+
+    if(mHashIndex.constEnd() != it && it->size == fi.size() &&
+        it->mtime == fi.lastModified().toMSecsSinceEpoch())
+    {
+        return it->hash;
+    }
+
+    QFile file(path);
+
+    if(!file.open(QIODevice::ReadOnly))
+        return QString();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    if(!hash.addData(&file))
+        return QString();
+
+    return hash.result().toHex();
+}
+
+bool Downloader::checkFile(const FileData *info) const
+{
+    QString path = localPath(info->path);
 
     if(path == "ImagineUpdate.dat")
         return true;
@@ -62,40 +141,185 @@ bool Downloader::checkFile(const FileData *info)
     if(QFileInfo(path).size() != info->uncompressed_size)
         return false;
 
-    QFile file(path);
-    file.open(QIODevice::ReadOnly);
+    return hashFile(path) == info->uncompressed_hash;
+}
 
-    QByteArray d = file.readAll();
-    file.close();
+void Downloader::verifyFiles()
+{
+    mVerifyCandidates.clear();
 
-    QString checksum = QCryptographicHash::hash(d,
-        QCryptographicHash::Md5).toHex();
+    // Files in the last hashlist are trusted so only check the rest.
+    foreach(QSharedPointer<FileData> info, mFiles)
+    {
+        if(isWhiteListed(info.data()) && !mOldFiles.contains(info->path))
+            mVerifyCandidates.append(info);
+    }
 
-    if(checksum != info->uncompressed_hash)
-        return false;
+    if(mVerifyCandidates.isEmpty())
+        return advanceToNextFile();
 
-    return true;
+    log(tr("Verifying %1 files").arg(mVerifyCandidates.size()));
+
+    emit statusChanged(tr("Verifying files..."));
+    emit downloadSizeChanged(mVerifyCandidates.size());
+    emit downloadProgressChanged(0);
+
+    // Hash on the global thread pool so the thread running this
+    // downloader keeps processing events (and kill requests) meanwhile.
+    // Nothing writes to the hash index until the check is finished.
+    std::function<bool(const QSharedPointer<FileData>&)> check =
+        [this](const QSharedPointer<FileData>& info)
+        {
+            return checkFile(info.data());
+        };
+
+    if(!mVerifyWatcher)
+    {
+        mVerifyWatcher = new QFutureWatcher<bool>(this);
+
+        connect(mVerifyWatcher, SIGNAL(progressValueChanged(int)),
+            this, SLOT(verifyProgress(int)));
+        connect(mVerifyWatcher, SIGNAL(finished()),
+            this, SLOT(verifyFinished()));
+    }
+
+    mVerifyWatcher->setFuture(QtConcurrent::mapped(mVerifyCandidates,
+        check));
+}
+
+void Downloader::verifyProgress(int done)
+{
+    emit downloadProgressChanged(done);
 }
 
-QMap<QString, FileData*> Downloader::parseFileList(const QByteArray& d)
+void Downloader::verifyFinished()
 {
-    QMap<QString, FileData*> files;
+    QFuture<bool> results = mVerifyWatcher->future();
+
+    if(mKill || results.isCanceled())
+    {
+        mVerifyCandidates.clear();
+
+        return expressFinish();
+    }
+
+    for(int i = 0; i < mVerifyCandidates.size(); ++i)
+    {
+        const FileData *info = mVerifyCandidates.at(i).data();
+
+        if(results.resultAt(i))
+        {
+            mVerifiedFiles.insert(info->path);
+
+            updateHashIndex(localPath(info->path), info->uncompressed_hash);
+        }
+    }
+
+    log(tr("Verified %1 of %2 files").arg(mVerifiedFiles.size()).arg(
+        mVerifyCandidates.size()));
+
+    mVerifyCandidates.clear();
+
+    saveHashIndex();
+
+    advanceToNextFile();
+}
+
+void Downloader::loadHashIndex()
+{
+    QFile file(HASH_INDEX_PATH);
+
+    if(!file.open(QIODevice::ReadOnly))
+        return;
+
+    // Each line is "SIZE MTIME HASH PATH" with the path last as it may
+    // contain spaces.
+    while(!file.atEnd())
+    {
+        QString line = QString::fromUtf8(file.readLine()).trimmed();
+
+        HashIndexEntry entry;
+        bool sizeOk = false, mtimeOk = false;
+
+        entry.size = line.section(' ', 0, 0).toLongLong(&sizeOk);
+        entry.mtime = line.section(' ', 1, 1).toLongLong(&mtimeOk);
+        entry.hash = line.section(' ', 2, 2);
+
+        QString path = line.section(' ', 3);
+
+        if(sizeOk && mtimeOk && isHash(entry.hash) && !path.isEmpty())
+            mHashIndex[path] = entry;
+    }
+}
+
+void Downloader::saveHashIndex()
+{
+    if(!mSaveFiles)
+        return;
+
+    QFile file(HASH_INDEX_PATH);
+
+    if(!file.open(QIODevice::WriteOnly))
+        return;
+
+    for(auto it = mHashIndex.constBegin(); it != mHashIndex.constEnd(); ++it)
+    {
+        file.write(QString("%1 %2 %3 %4\n").arg(it->size).arg(
+            it->mtime).arg(it->hash).arg(it.key()).toUtf8());
+    }
+}
+
+void Downloader::updateHashIndex(const QString& path, const QString& hash)
+{
+    QFileInfo fi(path);
+
+    HashIndexEntry entry;
+    entry.size = fi.size();
+    entry.mtime = fi.lastModified().toMSecsSinceEpoch();
+    entry.hash = hash;
+
+    mHashIndex[path] = entry;
+}
+
+QMap<QString, QSharedPointer<FileData>> Downloader::parseFileList(
+    const QByteArray& d)
+{
+    QMap<QString, QSharedPointer<FileData>> files;
 
     QStringList lines = QString::fromUtf8(d).split("\n");
     foreach(QString line, lines)
     {
-        QRegExp fileMatcher("FILE : (.+),([0-9a-fA-F]{32}),([0-9]+),"
-            "([0-9a-fA-F]{32}),([0-9]+)");
+        // Read "FILE : PATH,HASH,SIZE,HASH,SIZE" from the end since the
+        // path may contain commas.
+        line = line.trimmed();
+
+        if(!line.startsWith("FILE : "))
+            continue;
+
+        QStringList fields = line.mid(7).split(",");
+
+        if(5 > fields.size())
+            continue;
+
+        QString uncompressedSize = fields.takeLast();
+        QString uncompressedHash = fields.takeLast();
+        QString compressedSize = fields.takeLast();
+        QString compressedHash = fields.takeLast();
+        QString path = fields.join(",");
 
-        if( !fileMatcher.exactMatch( line.trimmed() ) )
+        if(path.isEmpty() || !isHash(compressedHash) ||
+            !isNumber(compressedSize) || !isHash(uncompressedHash) ||
+            !isNumber(uncompressedSize))
+        {
             continue;
+        }
 
-        FileData *info = new FileData;
-        info->path = fileMatcher.cap(1).mid(2).replace("\\", "/");
-        info->compressed_hash = fileMatcher.cap(2).toLower();
-        info->compressed_size = fileMatcher.cap(3).toInt();
-        info->uncompressed_hash = fileMatcher.cap(4).toLower();
-        info->uncompressed_size = fileMatcher.cap(5).toInt();
+        QSharedPointer<FileData> info(new FileData);
+        info->path = path.mid(2).replace("\\", "/");
+        info->compressed_hash = compressedHash.toLower();
+        info->compressed_size = compressedSize.toInt();
+        info->uncompressed_hash = uncompressedHash.toLower();
+        info->uncompressed_size = uncompressedSize.toInt();
 
         files[info->path] = info;
     }
@@ -103,8 +327,142 @@ QMap<QString, FileData*> Downloader::parseFileList(const QByteArray& d)
     return files;
 }
 
+bool Downloader::isWhiteListed(const FileData *info) const
+{
+    if( mWhiteList.isEmpty() )
+        return true;
+
+    foreach(QString pattern, mWhiteList)
+    {
+        if(info->path.left( pattern.length() ) == pattern)
+            return true;
+    }
+
+    return false;
+}
+
+bool Downloader::applyDelta(const QByteArray& delta)
+{
+    auto read32 = [&delta](int offset)
+    {
+        return qFromLittleEndian<quint32>(
+            (const uchar*)delta.constData() + offset);
+    };
+
+    if(DELTA_HEADER_SIZE > delta.size() || !delta.startsWith("CDLT"))
+        return false;
+
+    quint32 blockSize = read32(4);
+    quint32 baseSize = read32(8);
+    quint32 newSize = read32(12);
+    QByteArray baseHash = delta.mid(16, 32).toLower();
+    QByteArray newHash = delta.mid(48, 32).toLower();
+    quint32 blockCount = read32(80);
+
+    if(0 == blockSize || (int)newSize != mCurrentFile->uncompressed_size ||
+        newHash != mCurrentFile->uncompressed_hash.toLatin1() ||
+        blockCount != (quint32)(((quint64)newSize + blockSize - 1) /
+            blockSize))
+    {
+        return false;
+    }
+
+    // The delta only applies to the exact file it was generated from.
+    QString path = localPath(mCurrentFile->path);
+    QFile baseFile(path);
+
+    if(!baseFile.open(QIODevice::ReadOnly))
+        return false;
+
+    QByteArray base = baseFile.readAll();
+    baseFile.close();
+
+    if((quint32)base.size() != baseSize || QCryptographicHash::hash(base,
+        QCryptographicHash::Md5).toHex() != baseHash)
+    {
+        return false;
+    }
+
+    QByteArray out;
+    out.reserve((int)newSize);
+
+    int pos = DELTA_HEADER_SIZE;
+
+    for(quint32 i = 0; i < blockCount; ++i)
+    {
+        if(pos + 4 > delta.size())
+            return false;
+
+        quint32 index = read32(pos);
+        pos += 4;
+
+        int len = (int)std::min(blockSize, newSize - i * blockSize);
+
+        if(DELTA_LITERAL == index)
+        {
+            if(pos + len > delta.size())
+                return false;
+
+            out.append(delta.constData() + pos, len);
+            pos += len;
+        }
+        else
+        {
+            qint64 offset = (qint64)index * blockSize;
+
+            if(offset + len > base.size())
+                return false;
+
+            out.append(base.constData() + offset, len);
+        }
+    }
+
+    if(QCryptographicHash::hash(out, QCryptographicHash::Md5).toHex() !=
+        newHash)
+    {
+        return false;
+    }
+
+    QFile file(path);
+
+    if(!file.open(QIODevice::WriteOnly) || out.size() != file.write(out))
+        return false;
+
+    file.close();
+
+    updateHashIndex(path, mCurrentFile->uncompressed_hash);
+
+    log(tr("Applied delta of %1 bytes to %2").arg(delta.size()).arg(path));
+
+    return true;
+}
+
+void Downloader::startFileDownload()
+{
+    mDeltaRequest = false;
+
+    startDownload(QString("%1/%2").arg(mURL).arg(
+        mCurrentFile->path), mCurrentFile->path);
+}
+
+void Downloader::recordFile(const FileData *info)
+{
+    if(!mSaveFiles)
+        return;
+
+    QFile last("ImagineUpdate2.dat");
+    last.open(QIODevice::WriteOnly | QIODevice::Append);
+    last.write( QString("FILE : ./%1,%2,%3,%4,%5\n").arg(
+        info->path).arg(info->compressed_hash).arg(
+        info->compressed_size).arg(
+        info->uncompressed_hash).arg(
+        info->uncompressed_size).toUtf8() );
+    last.close();
+}
+
 Downloader::Downloader(const QString& url, QObject *p) : QObject(p),
-    mTotalFiles(0), mCurrentReq(0), mHaveVersion(false), mCurrentFile(0),
+    mTotalFiles(0), mCurrentReq(0), mHaveVersion(false),
+    mDeltaRequest(false), mConnection(0), mVerifyWatcher(0),
     mActiveRetries(0), mLog("ImagineUpdate.log")
 {
     mLog.open(QIODevice::WriteOnly);
@@ -119,8 +477,10 @@ Downloader::Downloader(const QString& url, QObject *p) : QObject(p),
 
 #ifdef COMP_HACK_HEADLESS
     mUseClassic = true;
+    mUseDeltas = false;
 #else // COMP_HACK_HEADLESS
     mUseClassic = false;
+    mUseDeltas = true;
 #endif // COMP_HACK_HEADLESS
 
     QStringList args = QCoreApplication::instance()->arguments();
@@ -141,21 +501,31 @@ Downloader::Downloader(const QString& url, QObject *p) : QObject(p),
             mURL = args.takeFirst();
         else if(arg == "--bare")
             mBare = true;
+        else if(arg == "--delta")
+            mUseDeltas = true;
+        else if(arg == "--no-delta")
+            mUseDeltas = false;
     }
 }
 
 Downloader::~Downloader()
 {
+    // The hash workers read from this object so they must be done first.
+    if(mVerifyWatcher)
+    {
+        mVerifyWatcher->cancel();
+        mVerifyWatcher->waitForFinished();
+    }
+
     delete mFileHash;
     delete mConnection;
-    delete mCurrentFile;
-
-    foreach(FileData *info, mFiles)
-        delete info;
 }
 
 void Downloader::triggerKill()
 {
+    if(mVerifyWatcher)
+        mVerifyWatcher->cancel();
+
     emit updateKilled();
 
     deleteLater();
@@ -169,6 +539,8 @@ void Downloader::startUpdate()
 
     log(tr("Starting update"));
 
+    loadHashIndex();
+
     if(mUseClassic)
     {
         startDownload(tr("%1/hashlist.dat").arg(mURL));
@@ -183,6 +555,19 @@ void Downloader::requestError(QNetworkReply::NetworkError code)
 {
     (void)code;
 
+    // If the server has no usable delta get the whole file instead.
+    if(mDeltaRequest)
+    {
+        log(tr("Delta not available: downloading full file"));
+
+        mCurrentReq->disconnect(this);
+        mCurrentReq->deleteLater();
+        mCurrentReq = 0;
+
+        startFileDownload();
+        return;
+    }
+
     // If there was a timeout, try again before reporting the error.
     if(mActiveRetries && QNetworkReply::TimeoutError == mCurrentReq->error())
     {
@@ -312,12 +697,17 @@ void Downloader::requestFinished()
         return;
     }
 
-    mCurrentReq->deleteLater();
+    QNetworkReply *req = mCurrentReq;
+    req->deleteLater();
 
-    if(QNetworkReply::NoError != mCurrentReq->error())
+    if(QNetworkReply::NoError != req->error())
     {
-        requestError(mCurrentReq->error());
-        mCurrentReq = 0;
+        requestError(req->error());
+
+        // Keep any retry or fallback request started by the handler.
+        if(mCurrentReq == req)
+            mCurrentReq = 0;
+
         return;
     }
 
@@ -395,6 +785,9 @@ void Downloader::requestFinished()
 
         last.close();
         last.remove();
+
+        // Downloads start once the local files are verified.
+        return verifyFiles();
     }
     else
     {
@@ -409,6 +802,22 @@ void Downloader::requestFinished()
             return expressFinish("Download failed: No current file");
         }
 
+        if(mDeltaRequest)
+        {
+            mDeltaRequest = false;
+
+            if(!applyDelta(mData))
+            {
+                log(tr("Delta could not be applied: downloading full file"));
+
+                return startFileDownload();
+            }
+
+            recordFile(mCurrentFile.data());
+
+            return advanceToNextFile();
+        }
+
         if(mData.size() != mCurrentFile->compressed_size)
         {
 #ifdef COMP_HACK_LOGSTDOUT
@@ -478,6 +887,9 @@ void Downloader::requestFinished()
                 file.open(QIODevice::WriteOnly);
                 file.write(uncomp);
                 file.close();
+
+                updateHashIndex(compMatch.cap(1),
+                    mCurrentFile->uncompressed_hash);
             }
         }
         else
@@ -488,17 +900,7 @@ void Downloader::requestFinished()
             file.close();
         }
 
-        if(mSaveFiles)
-        {
-            QFile last("ImagineUpdate2.dat");
-            last.open(QIODevice::WriteOnly | QIODevice::Append);
-            last.write( QString("FILE : ./%1,%2,%3,%4,%5\n").arg(
-                mCurrentFile->path).arg(mCurrentFile->compressed_hash).arg(
-                mCurrentFile->compressed_size).arg(
-                mCurrentFile->uncompressed_hash).arg(
-                mCurrentFile->uncompressed_size).toUtf8() );
-            last.close();
-        }
+        recordFile(mCurrentFile.data());
     }
 
     advanceToNextFile();
@@ -514,28 +916,15 @@ void Downloader::expressFinish(const QString& msg)
 
     while( !mFiles.isEmpty() )
     {
-        FileData *info = mFiles.takeFirst();
+        QSharedPointer<FileData> info = mFiles.takeFirst();
 
-        if( !mWhiteList.isEmpty() )
-        {
-            bool good = false;
-            foreach(QString pattern, mWhiteList)
-            {
-                if(info->path.left( pattern.length() ) != pattern)
-                    continue;
-
-                good = true;
-                break;
-            }
-
-            if(!good)
-                continue;
-        }
+        if( !isWhiteListed(info.data()) )
+            continue;
 
         if( !mOldFiles.contains(info->path) )
             continue;
 
-        FileData *old = mOldFiles.value(info->path);
+        QSharedPointer<FileData> old = mOldFiles.value(info->path);
         if(old->uncompressed_hash != info->uncompressed_hash)
             continue;
 
@@ -552,6 +941,8 @@ void Downloader::expressFinish(const QString& msg)
     // Make sure this is gone
     QFile("ImagineUpdate2.ver").remove();
 
+    saveHashIndex();
+
     // Emit the error message
     if( !msg.isEmpty() )
         emit errorMessage(msg);
@@ -573,27 +964,14 @@ void Downloader::advanceToNextFile()
         if(mKill)
             return expressFinish();
 
-        FileData *info = mFiles.takeFirst();
+        QSharedPointer<FileData> info = mFiles.takeFirst();
 
-        if( !mWhiteList.isEmpty() )
-        {
-            bool good = false;
-            foreach(QString pattern, mWhiteList)
-            {
-                if(info->path.left( pattern.length() ) != pattern)
-                    continue;
-
-                good = true;
-                break;
-            }
-
-            if(!good)
-                continue;
-        }
+        if( !isWhiteListed(info.data()) )
+            continue;
 
         if( mOldFiles.contains(info->path) )
         {
-            FileData *old = mOldFiles.value(info->path);
+            QSharedPointer<FileData> old = mOldFiles.value(info->path);
             if(old->uncompressed_hash == info->uncompressed_hash)
             {
                 if(mSaveFiles)
@@ -610,7 +988,7 @@ void Downloader::advanceToNextFile()
         }
         else
         {
-            if( checkFile(info) )
+            if( mVerifiedFiles.contains(info->path) )
             {
                 if(mSaveFiles)
                 {
@@ -637,7 +1015,6 @@ void Downloader::advanceToNextFile()
 
         QDir::current().mkpath( QFileInfo(info->path).path() );
 
-        delete mCurrentFile;
         mCurrentFile = info;
 
         QString filename = info->path;
@@ -650,9 +1027,22 @@ void Downloader::advanceToNextFile()
         emit downloadSizeChanged(info->compressed_size);
         emit downloadProgressChanged(0);
 
-        // Download the new version
-        startDownload(QString("%1/%2").arg(mURL).arg(
-            info->path), info->path);
+        // Try to fetch only the changed blocks of an existing file first.
+        QString path = localPath(info->path);
+
+        if(mUseDeltas && !mBare && path != info->path &&
+            QFileInfo(path).isFile())
+        {
+            mDeltaRequest = true;
+
+            startDownload(QString("%1/%2.delta").arg(mURL).arg(path),
+                info->path);
+        }
+        else
+        {
+            // Download the new version
+            startFileDownload();
+        }
 
         startedFile = true;
 
@@ -667,6 +1057,8 @@ void Downloader::advanceToNextFile()
 
         log(tr("Update finished"));
 
+        saveHashIndex();
+
         if(mSaveFiles && !mUseClassic)
         {
             QFile ver("ImagineUpdate2.ver");
@@ -685,7 +1077,9 @@ void Downloader::startDownload(const QString& url, const QString& path)
 
     mStatusCode = 0;
 
-    if(mActiveURL == url || mActivePath == path)
+    // Only a repeat of the same request uses up a retry. The delta and the
+    // full download of a file share a path but are separate requests.
+    if(mActiveURL == url)
     {
         mActiveRetries--;
     }
@@ -29,9 +29,12 @@
 
 #include <PushIgnore.h>
 #include <QFile>
+#include <QFutureWatcher>
 #include <QMap>
 #include <QList>
 #include <QObject>
+#include <QSet>
+#include <QSharedPointer>
 #include <QString>
 #include <QStringList>
 #include <QCryptographicHash>
@@ -47,8 +50,16 @@ public:
     QString compressed_hash;
     QString uncompressed_hash;
 
-    int compressed_size;
-    int uncompressed_size;
+    int compressed_size = 0;
+    int uncompressed_size = 0;
+};
+
+class HashIndexEntry
+{
+public:
+    qint64 size = 0;
+    qint64 mtime = 0;
+    QString hash;
 };
 
 class Downloader : public QObject
@@ -86,6 +97,9 @@ protected slots:
     void requestReadyRead();
     void requestFinished();
 
+    void verifyProgress(int done);
+    void verifyFinished();
+
 protected:
     void startDownload(const QString& url, const QString& path = QString());
 
@@ -93,8 +107,18 @@ protected:
     QByteArray uncompressHashlist(const QByteArray& data) const;
     int uncompressChunk(const void *src, void *dest,
         int in_size, int chunk_size) const;
-    QMap<QString, FileData*> parseFileList(const QByteArray& d);
-    bool checkFile(const FileData *info);
+    QMap<QString, QSharedPointer<FileData>> parseFileList(
+        const QByteArray& d);
+    bool isWhiteListed(const FileData *info) const;
+    QString hashFile(const QString& path) const;
+    bool checkFile(const FileData *info) const;
+    void verifyFiles();
+    void loadHashIndex();
+    void saveHashIndex();
+    void updateHashIndex(const QString& path, const QString& hash);
+    bool applyDelta(const QByteArray& delta);
+    void startFileDownload();
+    void recordFile(const FileData *info);
     void log(const QString& msg);
 
     int mStatusCode;
@@ -116,13 +140,21 @@ protected:
     bool mKill;
     bool mSaveFiles;
     bool mUseClassic;
+    bool mUseDeltas;
+    bool mDeltaRequest;
     QStringList mWhiteList;
 
     QNetworkAccessManager *mConnection;
-    FileData *mCurrentFile;
+    QSharedPointer<FileData> mCurrentFile;
+
+    QList<QSharedPointer<FileData>> mFiles;
+    QMap<QString, QSharedPointer<FileData>> mOldFiles;
+
+    QMap<QString, HashIndexEntry> mHashIndex;
+    QSet<QString> mVerifiedFiles;
 
-    QList<FileData*> mFiles;
-    QMap<QString, FileData*> mOldFiles;
+    QList<QSharedPointer<FileData>> mVerifyCandidates;
+    QFutureWatcher<bool> *mVerifyWatcher;
 
     QString mActiveURL;
     QString mActivePath;
@@ -0,0 +1,465 @@
+/**
+ * @file tools/updater/tests/Downloader.cpp
+ * @ingroup tools
+ *
+ * @author COMP Omega <compomega@tutanota.com>
+ *
+ * @brief Run the headless downloader against a local HTTP server.
+ *
+ * Copyright (C) 2012-2020 COMP_hack Team <compomega@tutanota.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <PushIgnore.h>
+#include <gtest/gtest.h>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QMap>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QtEndian>
+#include <PopIgnore.h>
+
+#include "Downloader.h"
+
+#include <zlib.h>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+/// Size of a delta block, matching comp_rehash --delta
+const int BLOCK_SIZE = 64 * 1024;
+
+/// Size of each synthetic client file
+const int FILE_SIZE = 4 * BLOCK_SIZE;
+
+/**
+ * Minimal HTTP server answering GET requests from a map of paths to file
+ * contents. Unknown paths get a 404.
+ */
+class TestServer
+{
+public:
+    TestServer()
+    {
+        QObject::connect(&mServer, &QTcpServer::newConnection, [this]()
+        {
+            while(mServer.hasPendingConnections())
+            {
+                Accept(mServer.nextPendingConnection());
+            }
+        });
+    }
+
+    bool Listen()
+    {
+        return mServer.listen(QHostAddress::LocalHost);
+    }
+
+    QString URL() const
+    {
+        return QString("http://127.0.0.1:%1").arg(mServer.serverPort());
+    }
+
+    /// Contents served for each path without the leading slash
+    QMap<QString, QByteArray> Files;
+
+    /// Number of requests for each path
+    QMap<QString, int> Requests;
+
+    /// Body bytes sent since the last reset
+    qint64 BytesServed = 0;
+
+    void ResetCounters()
+    {
+        Requests.clear();
+        BytesServed = 0;
+    }
+
+private:
+    void Accept(QTcpSocket *socket)
+    {
+        QSharedPointer<QByteArray> buffer(new QByteArray);
+
+        QObject::connect(socket, &QTcpSocket::disconnected,
+            socket, &QObject::deleteLater);
+        QObject::connect(socket, &QTcpSocket::readyRead,
+            [this, socket, buffer]()
+        {
+            buffer->append(socket->readAll());
+
+            if(!buffer->contains("\r\n\r\n"))
+            {
+                return;
+            }
+
+            // "GET /path HTTP/1.1"
+            QList<QByteArray> request = buffer->left(
+                buffer->indexOf("\r\n")).split(' ');
+            buffer->clear();
+
+            QString path = request.size() > 1 ?
+                QString::fromUtf8(request.at(1)).mid(1) : QString();
+
+            Requests[path]++;
+
+            QByteArray response;
+            if(Files.contains(path))
+            {
+                const QByteArray& body = Files[path];
+
+                response = QByteArray("HTTP/1.1 200 OK\r\nContent-Length: ") +
+                    QByteArray::number(body.size()) +
+                    "\r\nConnection: close\r\n\r\n" + body;
+
+                BytesServed += body.size();
+            }
+            else
+            {
+                response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n"
+                    "Connection: close\r\n\r\n";
+            }
+
+            socket->write(response);
+            socket->disconnectFromHost();
+        });
+    }
+
+    QTcpServer mServer;
+};
+
+/**
+ * Downloader with access to its retry accounting.
+ */
+class TestDownloader : public Downloader
+{
+public:
+    TestDownloader(const QString& url) : Downloader(url)
+    {
+    }
+
+    int ActiveRetries() const
+    {
+        return mActiveRetries;
+    }
+};
+
+QByteArray Md5(const QByteArray& data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex();
+}
+
+QByteArray Compress(const QByteArray& data)
+{
+    uLongf size = compressBound((uLong)data.size());
+    QByteArray out((int)size, 0);
+
+    compress2((Bytef*)out.data(), &size, (const Bytef*)data.constData(),
+        (uLong)data.size(), Z_BEST_SPEED);
+    out.resize((int)size);
+
+    return out;
+}
+
+QByteArray Write32(quint32 value)
+{
+    QByteArray out(4, 0);
+    qToLittleEndian<quint32>(value, (uchar*)out.data());
+
+    return out;
+}
+
+/// Build a delta like comp_rehash --delta, reusing unchanged blocks
+QByteArray MakeDelta(const QByteArray& base, const QByteArray& next)
+{
+    quint32 blockCount = (quint32)((next.size() + BLOCK_SIZE - 1) /
+        BLOCK_SIZE);
+
+    QByteArray delta("CDLT");
+    delta += Write32(BLOCK_SIZE);
+    delta += Write32((quint32)base.size());
+    delta += Write32((quint32)next.size());
+    delta += Md5(base);
+    delta += Md5(next);
+    delta += Write32(blockCount);
+
+    for(quint32 i = 0; i < blockCount; ++i)
+    {
+        QByteArray block = next.mid((int)i * BLOCK_SIZE, BLOCK_SIZE);
+
+        if(block == base.mid((int)i * BLOCK_SIZE, BLOCK_SIZE))
+        {
+            delta += Write32(i);
+        }
+        else
+        {
+            delta += Write32(0xFFFFFFFF);
+            delta += block;
+        }
+    }
+
+    return delta;
+}
+
+QByteArray RandomData(std::mt19937& rng, int size)
+{
+    QByteArray data(size, 0);
+    for(int i = 0; i < size; ++i)
+    {
+        data[i] = (char)(rng() & 0xFF);
+    }
+
+    return data;
+}
+
+bool WriteFile(const QString& path, const QByteArray& data)
+{
+    QDir::current().mkpath(QFileInfo(path).path());
+
+    QFile file(path);
+
+    return file.open(QIODevice::WriteOnly) && data.size() == file.write(data);
+}
+
+QByteArray ReadFile(const QString& path)
+{
+    QFile file(path);
+
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+/// Run an update to completion and return any error reported
+QString RunUpdate(const QString& url, int *retries = nullptr)
+{
+    TestDownloader dl(url);
+
+    QString error;
+    QEventLoop loop;
+
+    QObject::connect(&dl, &Downloader::errorMessage,
+        [&error](const QString& msg) { error = msg; });
+    QObject::connect(&dl, &Downloader::updateFinished,
+        &loop, &QEventLoop::quit);
+    QTimer::singleShot(0, &dl, SLOT(startUpdate()));
+    QTimer::singleShot(120000, &loop, [&]()
+    {
+        error = "timeout";
+        loop.quit();
+    });
+
+    loop.exec();
+
+    if(retries)
+    {
+        *retries = dl.ActiveRetries();
+    }
+
+    return error;
+}
+
+} // namespace
+
+TEST(Downloader, SyntheticClientTree)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    QString oldDir = QDir::currentPath();
+    ASSERT_TRUE(QDir::setCurrent(dir.path()));
+
+    TestServer server;
+    ASSERT_TRUE(server.Listen());
+
+    std::mt19937 rng(39);
+
+    // Build the server files and the local tree:
+    //  - files 0-15 are already up to date
+    //  - files 16-31 changed one block and have a delta
+    //  - files 32-39 are missing
+    //  - files 40-47 changed one block and have no delta
+    //  - the last file changed and has no delta so it is downloaded after
+    //    a failed delta request
+    QStringList paths;
+    for(int i = 0; i < 48; ++i)
+    {
+        paths.append(QString("data/file%1.bin").arg(i, 2, 10, QChar('0')));
+    }
+    paths.append("data/zz_last.bin");
+
+    QByteArray hashlist;
+    QMap<QString, QByteArray> expected;
+
+    for(int i = 0; i < paths.size(); ++i)
+    {
+        const QString& path = paths.at(i);
+
+        QByteArray content = RandomData(rng, FILE_SIZE);
+        expected[path] = content;
+
+        QByteArray compressed = Compress(content);
+        server.Files[path + ".compressed"] = compressed;
+
+        hashlist += QString("FILE : ./%1.compressed,%2,%3,%4,%5\n").arg(path)
+            .arg(QString(Md5(compressed))).arg(compressed.size())
+            .arg(QString(Md5(content))).arg(content.size()).toUtf8();
+
+        if(i < 16)
+        {
+            ASSERT_TRUE(WriteFile(path, content));
+        }
+        else if(i < 32 || i >= 40)
+        {
+            QByteArray old = content;
+            old.replace(BLOCK_SIZE, 16, RandomData(rng, 16));
+            ASSERT_TRUE(WriteFile(path, old));
+
+            if(i < 32)
+            {
+                server.Files[path + ".delta"] = MakeDelta(old, content);
+            }
+        }
+    }
+
+    // The hashlist is read up to the first NUL.
+    hashlist.append('\0');
+
+    server.Files["hashlist.ver"] = "synthetic-version-0000000000000001";
+    server.Files["hashlist.dat.compressed"] = Compress(hashlist);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int retries = 0;
+    EXPECT_EQ(QString(), RunUpdate(server.URL(), &retries));
+
+    qint64 updateTime = timer.elapsed();
+    qint64 updateBytes = server.BytesServed;
+
+    for(auto it = expected.constBegin(); it != expected.constEnd(); ++it)
+    {
+        EXPECT_EQ(Md5(it.value()), Md5(ReadFile(it.key()))) << it.key()
+            .toStdString();
+    }
+
+    for(int i = 0; i < paths.size(); ++i)
+    {
+        const QString& path = paths.at(i);
+        int full = server.Requests.value(path + ".compressed");
+        int delta = server.Requests.value(path + ".delta");
+
+        if(i < 16)
+        {
+            EXPECT_EQ(0, full + delta) << path.toStdString();
+        }
+        else if(i < 32)
+        {
+            EXPECT_EQ(1, delta) << path.toStdString();
+            EXPECT_EQ(0, full) << path.toStdString();
+        }
+        else if(i < 40)
+        {
+            EXPECT_EQ(0, delta) << path.toStdString();
+            EXPECT_EQ(1, full) << path.toStdString();
+        }
+        else
+        {
+            EXPECT_EQ(1, delta) << path.toStdString();
+            EXPECT_EQ(1, full) << path.toStdString();
+        }
+    }
+
+    // The full download after a failed delta is a new request so it must
+    // start with all of its retries.
+    EXPECT_EQ(5, retries);
+
+    // Run again with every file checked locally, first using the hash
+    // index and then hashing every file.
+    server.ResetCounters();
+    QFile::remove("ImagineUpdate2.dat");
+    QFile::remove("ImagineUpdate2.ver");
+
+    timer.restart();
+    EXPECT_EQ(QString(), RunUpdate(server.URL()));
+    qint64 indexedTime = timer.elapsed();
+
+    EXPECT_EQ(server.Files["hashlist.dat.compressed"].size() +
+        server.Files["hashlist.ver"].size(), server.BytesServed);
+
+    server.ResetCounters();
+    QFile::remove("ImagineUpdate2.dat");
+    QFile::remove("ImagineUpdate2.ver");
+    QFile::remove("ImagineUpdate2.idx");
+
+    timer.restart();
+    EXPECT_EQ(QString(), RunUpdate(server.URL()));
+    qint64 hashedTime = timer.elapsed();
+
+    EXPECT_EQ(server.Files["hashlist.dat.compressed"].size() +
+        server.Files["hashlist.ver"].size(), server.BytesServed);
+
+    qint64 fullBytes = 0;
+    for(const QString& path : paths)
+    {
+        fullBytes += server.Files[path + ".compressed"].size();
+    }
+
+    std::cout << "Update of " << paths.size() << " files: " << updateTime
+        << " ms, " << updateBytes << " bytes served (" << fullBytes
+        << " bytes without verification or deltas)" << std::endl;
+    std::cout << "Verify with hash index: " << indexedTime << " ms"
+        << std::endl;
+    std::cout << "Verify by hashing every file: " << hashedTime << " ms"
+        << std::endl;
+
+    EXPECT_LT(updateBytes, fullBytes);
+
+    QDir::setCurrent(oldDir);
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        // The downloader reads its options from the application arguments.
+        std::vector<char*> args(argv, argv + argc);
+
+        char modern[] = "--modern";
+        char delta[] = "--delta";
+        args.push_back(modern);
+        args.push_back(delta);
+
+        int appArgc = (int)args.size();
+        QCoreApplication app(appArgc, args.data());
+
+        ::testing::InitGoogleTest(&argc, argv);
+
+        return RUN_ALL_TESTS();
+    }
+    catch(...)
+    {
+        return EXIT_FAILURE;
+    }
+}
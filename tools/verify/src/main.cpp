@@ -25,6 +25,7 @@
 // Standard C++11 Includes
 #include <fstream>
 #include <iostream>
+#include <set>
 
 // libcomp Includes
 #include <DataStore.h>
@@ -32,16 +33,22 @@
 #include <Log.h>
 #include <ServerDataManager.h>
 
+// refindex Includes
+#include <ReferenceIndex.h>
+
 int UsageMisc(const char *szAppName)
 {
     std::cerr << "USAGE: " << szAppName << " MODE ..." << std::endl;
     std::cerr << std::endl;
     std::cerr << "MODE indicates execution mode. Valid modes contain:"
-        " server_data." << std::endl;
+        " server_data, references." << std::endl;
     std::cerr << std::endl;
     std::cerr << "server_data mode verifies data loaded by the channel"
         " server from the binary data and xml files in the datastore."
         << std::endl;
+    std::cerr << "references mode lists the events, zones, zone partials and"
+        " drop sets in the datastore that reference a definition."
+        << std::endl;
 
     return EXIT_FAILURE;
 }
@@ -62,6 +69,24 @@ int Usage(const char *szAppName, const char *mode)
         std::cerr << "STORE indicates a list of paths to use when loading the"
             " datastore." << std::endl;
     }
+    else if(mode == std::string("references"))
+    {
+        std::cerr << "USAGE: " << szAppName << " references TYPE VALUE"
+            " MAXVALUE STORE" << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "TYPE indicates the definition type to find references"
+            " to (ex: CItemData, DevilData, DropSet or ZoneData)."
+            << std::endl;
+        std::cerr << "VALUE indicates the ID of the definition to find."
+            << std::endl;
+        std::cerr << "MAXVALUE indicates the last ID of a range starting at"
+            " VALUE or 0 to only find VALUE." << std::endl;
+        std::cerr << "STORE indicates a list of paths to use when loading the"
+            " datastore." << std::endl;
+        std::cerr << std::endl;
+        std::cerr << "Each reference is printed as a tab separated line of"
+            " the ID, location and section." << std::endl;
+    }
 
     return EXIT_FAILURE;
 }
@@ -139,6 +164,90 @@ int VerifyServerData(int argc, char *argv[])
     return fail ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
+int FindReferences(int argc, char *argv[])
+{
+    if(argc < 6)
+    {
+        return Usage(argv[0], argv[1]);
+    }
+
+    libcomp::String objType(argv[2]);
+    if(!ReferenceIndex::IsSupportedType(objType))
+    {
+        std::cerr << "Unsupported definition type: " << argv[2] << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    bool ok = false;
+    uint32_t value = libcomp::String(argv[3]).ToInteger<uint32_t>(&ok);
+    uint32_t maxValue = ok ? libcomp::String(argv[4]).ToInteger<uint32_t>(
+        &ok) : 0;
+    if(!ok || (maxValue && value > maxValue))
+    {
+        return Usage(argv[0], argv[1]);
+    }
+
+    libcomp::DataStore datastore(argv[0]);
+    for(int i = 5; i < argc; i++)
+    {
+        if(!datastore.AddSearchPath(argv[i]))
+        {
+            std::cerr << "Failed to add datastore path: " << argv[i]
+                << std::endl;
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::list<libcomp::String> files;
+    std::list<libcomp::String> dirs;
+    std::list<libcomp::String> symLinks;
+
+    if(!datastore.GetListing("/", files, dirs, symLinks, true, true))
+    {
+        std::cerr << "Failed to list the datastore." << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    files.remove_if([](const libcomp::String& path)
+        {
+            return path.Right(4).ToLower() != ".xml";
+        });
+
+    // Every file is parsed and indexed in parallel so the index can be
+    // queried for any definition without walking the files again
+    ReferenceIndex index;
+    std::list<libcomp::String> errors;
+
+    index.LoadFiles(files, [&datastore](const libcomp::String& path)
+        {
+            return datastore.ReadFile(path);
+        }, errors);
+
+    for(auto& path : errors)
+    {
+        std::cerr << "Failed to load file: " << path.C() << std::endl;
+    }
+
+    std::set<libcomp::String> sources;
+
+    auto refs = index.Find(objType, value, maxValue);
+    for(auto& ref : refs)
+    {
+        std::cout << ref.ID << "\t" << ref.Location.C() << "\t"
+            << ref.Section.C() << std::endl;
+
+        sources.insert(ref.Source);
+    }
+
+    std::cerr << refs.size() << " reference(s) found in " << sources.size()
+        << " of " << files.size() << " file(s)." << std::endl;
+
+    return errors.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int main(int argc, char *argv[])
 {
     if(argc < 2)
@@ -150,6 +259,10 @@ int main(int argc, char *argv[])
     {
         return VerifyServerData(argc, argv);
     }
+    else if(argv[1] == std::string("references"))
+    {
+        return FindReferences(argc, argv);
+    }
     else
     {
         UsageMisc(argv[0]);